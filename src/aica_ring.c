@@ -0,0 +1,54 @@
+// aica_ring.c - ADPCM ring bookkeeping (see aica_ring.h)
+
+#include "aica_ring.h"
+
+int aica_ring_init(aica_ring_t *r, uint32_t size, uint32_t chunk) {
+    // Powers of two, so the byte counts can wrap around 32 bits
+    if (chunk < AICA_RING_ALIGN || (chunk & (chunk - 1)) || (size & (size - 1)) || size < 2 * chunk)
+        return -1;
+    r->size = size;
+    r->chunk = chunk;
+    r->refills = r->underruns = 0;
+    aica_ring_reset(r);
+    return 0;
+}
+
+void aica_ring_reset(aica_ring_t *r) {
+    r->written = r->played = 0;
+    r->cursor = 0;
+}
+
+uint32_t aica_ring_advance(aica_ring_t *r, uint32_t pos, uint32_t elapsed) {
+    pos %= r->size;
+    uint32_t delta = (pos + r->size - r->cursor) % r->size;
+    // Whole laps the position cannot show, to the nearest one
+    if (elapsed > delta + r->size / 2)
+        delta += (elapsed - delta + r->size / 2) / r->size * r->size;
+    r->cursor = pos;
+    r->played += delta;
+    if ((int32_t)(r->played - r->written) > 0) {
+        // Played past the data: carry on from the next aligned byte after it
+        r->underruns++;
+        r->written = (r->played + AICA_RING_ALIGN - 1) & ~(uint32_t)(AICA_RING_ALIGN - 1);
+    }
+    return delta;
+}
+
+uint32_t aica_ring_next(const aica_ring_t *r, uint32_t *offset) {
+    uint32_t off = r->written % r->size;
+    uint32_t len = r->chunk - off % r->chunk;     // up to the next chunk boundary
+    // The chunk the channel is in stays untouched, so it can be mid-read
+    uint32_t limit = r->played - r->played % r->chunk + r->size;
+    if ((int32_t)(r->written + len - limit) > 0) return 0;
+    *offset = off;
+    return len;
+}
+
+void aica_ring_commit(aica_ring_t *r, uint32_t len) {
+    r->written += len;
+    r->refills++;
+}
+
+uint32_t aica_ring_buffered(const aica_ring_t *r) {
+    return r->written - r->played;
+}
@@ -0,0 +1,50 @@
+// aica_ring.h - bookkeeping for an ADPCM ring in SPU RAM
+//
+// In direct AICA mode the engine plays each channel as a looping sample over
+// a ring in SPU RAM and refills it itself, a chunk at a time, by G2 DMA. The
+// only thing the SH4 can see of the channel is its play position, so this
+// tracks what has been written and played as free-running byte counts: the
+// position moving on is bytes played, and a refill may overwrite what has
+// been played. If the position passes what was written, the channel played
+// stale data; that is counted as an underrun and writing resumes past it.
+// A position read after more than a lap looks like less, so the caller also
+// passes what the clock says was played, which picks the number of laps.
+//
+// Plain C with no hardware access, so the same code runs in the engine and in
+// host tools. Not thread-safe: one thread services a ring.
+#ifndef AICA_RING_H
+#define AICA_RING_H
+
+#include <stdint.h>
+
+#define AICA_RING_ALIGN 32               // G2 DMA granularity
+
+typedef struct {
+    uint32_t size;                       // bytes per channel, power of two, >= 2 chunks
+    uint32_t chunk;                      // bytes per refill, power of two >= AICA_RING_ALIGN
+    uint32_t written, played;            // bytes since the last reset
+    uint32_t cursor;                     // last play position, bytes into the ring
+    uint32_t refills, underruns;         // since init
+} aica_ring_t;
+
+// -1 if the sizes do not fit the rules above.
+int aica_ring_init(aica_ring_t *r, uint32_t size, uint32_t chunk);
+
+// Empty, with the channel about to start from offset 0. Counters stay.
+void aica_ring_reset(aica_ring_t *r);
+
+// The channel is at byte `pos` of the ring, and by the clock has played about
+// `elapsed` bytes since the last call (0 if unknown). Returns bytes played.
+uint32_t aica_ring_advance(aica_ring_t *r, uint32_t pos, uint32_t elapsed);
+
+// Length of the refill that may be written now (0 if none) and its offset in
+// the ring. Never wraps and never reaches the chunk being played.
+uint32_t aica_ring_next(const aica_ring_t *r, uint32_t *offset);
+
+// `len` bytes from aica_ring_next were written.
+void aica_ring_commit(aica_ring_t *r, uint32_t len);
+
+// Bytes written and not yet played.
+uint32_t aica_ring_buffered(const aica_ring_t *r);
+
+#endif // AICA_RING_H
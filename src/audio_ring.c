@@ -0,0 +1,77 @@
+// audio_ring.c - SPSC byte ring (see audio_ring.h)
+
+#include "audio_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+int audio_ring_init(audio_ring_t *r, uint32_t size) {
+    if (size == 0 || (size & (size - 1)) != 0) return -1;
+    r->buf = memalign(32, size);
+    if (!r->buf) return -1;
+    r->size = size;
+    atomic_store(&r->head, 0);
+    atomic_store(&r->tail, 0);
+    return 0;
+}
+
+void audio_ring_destroy(audio_ring_t *r) {
+    free(r->buf);
+    r->buf = NULL;
+    r->size = 0;
+}
+
+void audio_ring_reset(audio_ring_t *r) {
+    atomic_store(&r->head, 0);
+    atomic_store(&r->tail, 0);
+}
+
+uint32_t audio_ring_used(const audio_ring_t *r) {
+    return atomic_load_explicit(&((audio_ring_t *)r)->head, memory_order_acquire) -
+           atomic_load_explicit(&((audio_ring_t *)r)->tail, memory_order_acquire);
+}
+
+uint32_t audio_ring_space(const audio_ring_t *r) {
+    return r->size - audio_ring_used(r);
+}
+
+uint32_t audio_ring_write(audio_ring_t *r, const void *src, uint32_t len) {
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    uint32_t space = r->size - (head - tail);
+    if (len > space) len = space;
+
+    uint32_t at = head & (r->size - 1);
+    uint32_t first = r->size - at;
+    if (first > len) first = len;
+    memcpy(r->buf + at, src, first);
+    memcpy(r->buf, (const uint8_t *)src + first, len - first);
+
+    atomic_store_explicit(&r->head, head + len, memory_order_release);
+    return len;
+}
+
+uint32_t audio_ring_read(audio_ring_t *r, void *dst, uint32_t len) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    uint32_t used = head - tail;
+    if (len > used) len = used;
+
+    uint32_t at = tail & (r->size - 1);
+    uint32_t first = r->size - at;
+    if (first > len) first = len;
+    memcpy(dst, r->buf + at, first);
+    memcpy((uint8_t *)dst + first, r->buf, len - first);
+
+    atomic_store_explicit(&r->tail, tail + len, memory_order_release);
+    return len;
+}
+
+uint32_t audio_ring_skip(audio_ring_t *r, uint32_t len) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (len > head - tail) len = head - tail;
+    atomic_store_explicit(&r->tail, tail + len, memory_order_release);
+    return len;
+}
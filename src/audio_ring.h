@@ -0,0 +1,41 @@
+// audio_ring.h - single-producer/single-consumer byte ring for ADPCM
+//
+// One ring per channel holds ADPCM as it comes off the disc. The producer
+// depends on the movie layout: audio_reader_thread reads the planar audio
+// files, and the worker copies the audio out of interleaved packets. Only
+// one of them ever writes a given ring; the other never starts for that
+// movie. The audio thread pulls (audio_cb, or the direct AICA refill), so it
+// never touches the filesystem. Sizes are powers of two; head/tail are
+// free-running counters.
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t size;              // power of two
+    atomic_uint head;           // total bytes written
+    atomic_uint tail;           // total bytes read
+} audio_ring_t;
+
+int  audio_ring_init(audio_ring_t *r, uint32_t size);
+void audio_ring_destroy(audio_ring_t *r);
+
+// Producer/consumer must both be stopped while resetting.
+void audio_ring_reset(audio_ring_t *r);
+
+uint32_t audio_ring_used(const audio_ring_t *r);
+uint32_t audio_ring_space(const audio_ring_t *r);
+
+// Producer side. Writes at most the free space, returns bytes written.
+uint32_t audio_ring_write(audio_ring_t *r, const void *src, uint32_t len);
+
+// Consumer side. Reads at most what is buffered, returns bytes read.
+uint32_t audio_ring_read(audio_ring_t *r, void *dst, uint32_t len);
+
+// Consumer side. Drops up to len bytes, returns bytes dropped.
+uint32_t audio_ring_skip(audio_ring_t *r, uint32_t len);
+
+#endif // AUDIO_RING_H
@@ -0,0 +1,1494 @@
+// dcmv.c - DCMV movie reader (see dcmv.h)
+
+#include "dcmv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdatomic.h>
+
+#ifdef _arch_dreamcast
+#include <kos/fs.h>
+#include <kos/thread.h>
+#define DCMV_HAVE_MMAP 0
+#define dcmv_yield() thd_pass()
+#else
+#include <sched.h>
+#define dcmv_yield() sched_yield()
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define DCMV_HAVE_MMAP 1
+#endif
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd/zstd.h>
+
+#ifdef _arch_dreamcast
+#define LZ4_FAST_DEC_LOOP 1
+#define LZ4_FREESTANDING 1
+#define LZ4_memcpy(d,s,n)  memcpy_fast((d),(s),(n))
+#define LZ4_memmove(d,s,n) memmove_fast((d),(s),(n))
+#define LZ4_memset(d,v,n)  memset_fast((d),(v),(n))
+#endif
+#include <lz4/lz4.h>
+
+// One decoded page of a paged table (PTBL)
+typedef struct {
+    int page;                     // -1 free, -2 being filled
+    uint32_t last_use;
+    uint32_t *offsets;            // page_frames + 1
+    uint16_t *durations;          // page_frames
+    uint32_t *totals;             // first total frame of every DCMV_TOTAL_SAMPLE frames
+} dcmv_page_t;
+
+// An extra rendition (REND)
+typedef struct {
+    dcmv_rendition_t info;
+    uint32_t *offsets;            // num_unique + 1
+} dcmv_rend_t;
+
+struct dcmv {
+    char *path;
+    int backend;
+    dcmv_header_t hdr;
+
+    uint32_t *frame_offsets;      // num_unique + 1
+    uint16_t *frame_durations;    // num_unique
+
+    // Prefix sums of frame_durations, one per DCMV_TOTAL_SAMPLE unique frames:
+    // total -> unique is a binary search here plus a short scan
+    uint32_t *total_starts;
+    int total_samples;
+
+    // Paged tables (PTBL): the page index stays resident (3 words per page:
+    // page file offset, first frame offset, first total frame), pages go
+    // through a small LRU. The cache is shared by the worker and the main
+    // thread, so lookups hold page_lock; loads are serialised by the io lock.
+    uint32_t *page_index;
+    int page_frames, page_count;
+    uint8_t *page_raw;
+    uint32_t page_raw_size;
+    dcmv_page_t pages[DCMV_PAGE_CACHE];
+    int page_pinned[2];           // pages the LRU keeps (dcmv_pin_pages), -1 none
+    uint32_t page_clock;
+    atomic_flag page_lock;
+    uint32_t page_loads;
+
+    // Interleaved layout (AVIL), packet_count + 1 entries of 4 words
+    uint32_t *packets;
+    int packet_count;
+    uint32_t max_packet_size;
+
+    // Multi-frame blocks (BLKS), block_count + 1 first_unique values
+    uint32_t *blocks;
+    int block_count;
+    int max_block_frames;
+    uint8_t *scratch;             // sink for unwanted frames of a block
+
+    // Delta frames (DLTA)
+    uint8_t *delta_bits;
+    uint8_t *ref;                 // last reconstructed frame
+    int ref_unique;
+    uint8_t *delta_buf;           // decompressed delta payload
+
+    // Codebook runs (CBTB), cb_run_count + 1 first_unique values
+    uint32_t *cb_runs;
+    int cb_run_count;
+    uint8_t *cb;                  // codebook of run cb_cached
+    int cb_cached;
+
+    // Frames stored out of unique order (ORDR), 2 words per run: first_unique, end
+    uint32_t *runs;
+    int run_count;
+
+    // Extra renditions; their own DCtx so the primary's DDict stays referenced
+    dcmv_rend_t rends[DCMV_MAX_RENDITIONS - 1];
+    int rend_count;
+    ZSTD_DCtx *rend_zstd;
+
+#ifdef _arch_dreamcast
+    file_t fd;
+#else
+    int fd;
+#endif
+    uint64_t last_end;            // file position after the last read
+    uint64_t tail_start;          // first chunk/extension byte past audio_offset
+    const uint8_t *map;           // MMAP backend
+
+    uint8_t *staging;             // FILE backend, max_compressed_size
+    ZSTD_DCtx *zstd;
+    ZSTD_DDict *ddict;            // ZDIC
+    uint8_t *dict;
+    uint32_t dict_size;
+
+    dcmv_lock_fn lock, unlock;
+    void *lock_arg;
+    dcmv_read_fn read_hook;
+    void *read_hook_arg;
+};
+
+// ---------------------------------------------------------------------------
+// Low level I/O
+// ---------------------------------------------------------------------------
+static inline uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void io_lock(dcmv_t *d)   { if (d->lock) d->lock(d->lock_arg); }
+static inline void io_unlock(dcmv_t *d) { if (d->unlock) d->unlock(d->lock_arg); }
+
+static inline int sector_aligned(const dcmv_t *d) { return (d->hdr.flags & DCMV_FLAG_SECTOR_ALIGNED) != 0; }
+static inline uint32_t sector_round(uint32_t n) {
+    return (n + DCMV_SECTOR_SIZE - 1) & ~(uint32_t)(DCMV_SECTOR_SIZE - 1);
+}
+
+static int io_open(dcmv_t *d) {
+#ifdef _arch_dreamcast
+    d->fd = fs_open(d->path, O_RDONLY);
+#else
+    d->fd = open(d->path, O_RDONLY);
+#endif
+    d->last_end = 0;
+    return d->fd < 0 ? -1 : 0;
+}
+
+static void io_close(dcmv_t *d) {
+    if (d->fd < 0) return;
+#ifdef _arch_dreamcast
+    fs_close(d->fd);
+#else
+    close(d->fd);
+#endif
+    d->fd = -1;
+}
+
+static uint64_t io_size(dcmv_t *d) {
+#ifdef _arch_dreamcast
+    return (uint64_t)fs_total(d->fd);
+#else
+    struct stat st;
+    return fstat(d->fd, &st) < 0 ? 0 : (uint64_t)st.st_size;
+#endif
+}
+
+// Caller holds the io lock. Skips the seek when the read continues where the
+// previous one ended, which is the common case for sequential playback.
+static int io_read_at(dcmv_t *d, uint64_t offset, void *buf, uint32_t size) {
+    if (d->read_hook) d->read_hook(d->read_hook_arg, offset, size);
+    if (d->map) {
+        if (offset + size > d->hdr.file_size) return -1;
+        memcpy(buf, d->map + offset, size);
+        return 0;
+    }
+#ifdef _arch_dreamcast
+    if (d->last_end != offset) {
+        if (fs_seek(d->fd, (off_t)offset, SEEK_SET) < 0) return -1;
+    }
+    ssize_t got = fs_read(d->fd, buf, size);
+#else
+    ssize_t got = pread(d->fd, buf, size, (off_t)offset);
+#endif
+    if (got != (ssize_t)size) {
+        d->last_end = (uint64_t)-1;
+        return -1;
+    }
+    d->last_end = offset + size;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Open / close
+// ---------------------------------------------------------------------------
+static int parse_header(dcmv_t *d, const uint8_t *p) {
+    if (memcmp(p, DCMV_MAGIC, 4) != 0) {
+        printf("[DCMV] %s: bad magic\n", d->path);
+        return -1;
+    }
+
+    dcmv_header_t *h = &d->hdr;
+    h->version             = rd32(p + 4);
+    h->frame_type          = p[8];
+    h->width               = rd16(p + 9);
+    h->height              = rd16(p + 11);
+    h->content_width       = rd16(p + 13);
+    h->content_height      = rd16(p + 15);
+    uint32_t fps_bits      = rd32(p + 17);
+    memcpy(&h->fps, &fps_bits, sizeof(float));
+    h->sample_rate         = rd16(p + 21);
+    h->audio_channels      = rd16(p + 23);
+    h->num_unique_frames   = (int)rd32(p + 25);
+    h->num_total_frames    = (int)rd32(p + 29);
+    h->video_frame_size    = (int)rd32(p + 33);
+    h->max_compressed_size = (int)rd32(p + 37);
+    h->audio_offset        = rd32(p + 41);
+    h->compression         = (p[45] == 1) ? DCMV_COMPRESSION_ZSTD : DCMV_COMPRESSION_LZ4;
+    h->ext_offset          = (h->version >= DCMV_VERSION_EXT) ? rd32(p + 46) : 0;
+
+    if (h->num_unique_frames <= 0 || h->num_total_frames <= 0 ||
+        h->video_frame_size <= 0 || h->max_compressed_size <= 0 || h->fps <= 0.0f) {
+        printf("[DCMV] %s: corrupt header\n", d->path);
+        return -1;
+    }
+    return 0;
+}
+
+static int load_tables(dcmv_t *d) {
+    int n = d->hdr.num_unique_frames;
+    size_t offsets_bytes = (size_t)(n + 1) * sizeof(uint32_t);
+    size_t durations_bytes = (size_t)n * sizeof(uint16_t);
+
+    d->frame_offsets = malloc(offsets_bytes);
+    d->frame_durations = malloc(durations_bytes);
+    if (!d->frame_offsets || !d->frame_durations) return -1;
+
+    // The tables sit back to back right after the header: two reads, no seek.
+    io_lock(d);
+    int r = io_read_at(d, DCMV_HEADER_SIZE, d->frame_offsets, (uint32_t)offsets_bytes);
+    if (r == 0)
+        r = io_read_at(d, DCMV_HEADER_SIZE + offsets_bytes, d->frame_durations, (uint32_t)durations_bytes);
+    io_unlock(d);
+    if (r < 0) return -1;
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int i = 0; i <= n; i++) d->frame_offsets[i] = rd32((uint8_t *)&d->frame_offsets[i]);
+    for (int i = 0; i < n; i++) d->frame_durations[i] = rd16((uint8_t *)&d->frame_durations[i]);
+#endif
+
+    d->total_samples = (n + DCMV_TOTAL_SAMPLE - 1) / DCMV_TOTAL_SAMPLE;
+    d->total_starts = malloc(sizeof(uint32_t) * (size_t)(d->total_samples + 1));
+    if (!d->total_starts) return -1;
+    uint32_t t = 0;
+    for (int i = 0; i < n; i++) {
+        if (i % DCMV_TOTAL_SAMPLE == 0) d->total_starts[i / DCMV_TOTAL_SAMPLE] = t;
+        t += d->frame_durations[i];
+    }
+    d->total_starts[d->total_samples] = t;
+    return 0;
+}
+
+static int load_avil(dcmv_t *d, uint32_t offset, uint32_t size) {
+    uint8_t head[8];
+    if (size < 8 || io_read_at(d, offset, head, 8) < 0) return -1;
+
+    d->packet_count = (int)rd32(head);
+    d->max_packet_size = rd32(head + 4);
+    uint32_t bytes = (uint32_t)(d->packet_count + 1) * 16;
+    if (d->packet_count <= 0 || 8 + bytes > size) return -1;
+
+    d->packets = malloc(bytes);
+    if (!d->packets || io_read_at(d, offset + 8, d->packets, bytes) < 0) return -1;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int i = 0; i < (d->packet_count + 1) * 4; i++) d->packets[i] = rd32((uint8_t *)&d->packets[i]);
+#endif
+    return 0;
+}
+
+static int load_blks(dcmv_t *d, uint32_t offset, uint32_t size) {
+    uint8_t head[8];
+    if (size < 8 || io_read_at(d, offset, head, 8) < 0) return -1;
+
+    d->block_count = (int)rd32(head);
+    d->max_block_frames = (int)rd32(head + 4);
+    uint32_t bytes = (uint32_t)(d->block_count + 1) * 4;
+    if (d->block_count <= 0 || 8 + bytes > size ||
+        d->max_block_frames < 1 || d->max_block_frames > DCMV_MAX_PACKET_FRAMES) return -1;
+
+    d->blocks = malloc(bytes);
+    if (!d->blocks || io_read_at(d, offset + 8, d->blocks, bytes) < 0) return -1;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int i = 0; i <= d->block_count; i++) d->blocks[i] = rd32((uint8_t *)&d->blocks[i]);
+#endif
+    if (d->blocks[0] != 0 || d->blocks[d->block_count] != (uint32_t)d->hdr.num_unique_frames)
+        return -1;
+    return 0;
+}
+
+static int load_dlta(dcmv_t *d, uint32_t offset, uint32_t size) {
+    uint8_t head[4];
+    uint32_t bytes = ((uint32_t)d->hdr.num_unique_frames + 7) / 8;
+    if (size < 4 + bytes || io_read_at(d, offset, head, 4) < 0 ||
+        rd32(head) != (uint32_t)d->hdr.num_unique_frames) return -1;
+
+    d->delta_bits = malloc(bytes);
+    if (!d->delta_bits || io_read_at(d, offset + 4, d->delta_bits, bytes) < 0) return -1;
+    if (d->delta_bits[0] & 1) return -1;   // frame 0 must be a key frame
+    return 0;
+}
+
+static int load_cbtb(dcmv_t *d, uint32_t offset, uint32_t size) {
+    uint8_t head[4];
+    if (size < 4 || io_read_at(d, offset, head, 4) < 0) return -1;
+
+    d->cb_run_count = (int)rd32(head);
+    uint32_t bytes = (uint32_t)(d->cb_run_count + 1) * 4;
+    if (d->cb_run_count <= 0 || 4 + bytes > size ||
+        d->hdr.video_frame_size <= DCMV_CODEBOOK_SIZE) return -1;
+
+    d->cb_runs = malloc(bytes);
+    if (!d->cb_runs || io_read_at(d, offset + 4, d->cb_runs, bytes) < 0) return -1;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int i = 0; i <= d->cb_run_count; i++) d->cb_runs[i] = rd32((uint8_t *)&d->cb_runs[i]);
+#endif
+    if (d->cb_runs[0] != 0 || d->cb_runs[d->cb_run_count] != (uint32_t)d->hdr.num_unique_frames)
+        return -1;
+    return 0;
+}
+
+static int load_ptbl(dcmv_t *d, uint32_t offset, uint32_t size) {
+    uint8_t head[8];
+    if (size < 8 || io_read_at(d, offset, head, 8) < 0) return -1;
+
+    d->page_frames = (int)rd32(head);
+    d->page_count = (int)rd32(head + 4);
+    uint32_t bytes = (uint32_t)(d->page_count + 1) * 12;
+    int n = d->hdr.num_unique_frames;
+    if (d->page_frames < 1 || d->page_frames > 0xFFFF || 8 + bytes > size ||
+        d->page_count != (n + d->page_frames - 1) / d->page_frames) return -1;
+
+    d->page_index = malloc(bytes);
+    if (!d->page_index || io_read_at(d, offset + 8, d->page_index, bytes) < 0) return -1;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int i = 0; i < (d->page_count + 1) * 3; i++) d->page_index[i] = rd32((uint8_t *)&d->page_index[i]);
+#endif
+
+    // Frame offsets only grow page to page in unique-order files; checked
+    // in load_extensions once it is known whether there is an ORDR chunk
+    for (int p = 0; p < d->page_count; p++) {
+        const uint32_t *e = d->page_index + p * 3;
+        if (e[3] < e[0] || e[5] < e[2]) return -1;
+        if (e[3] - e[0] > d->page_raw_size) d->page_raw_size = e[3] - e[0];
+    }
+    d->page_raw = malloc(d->page_raw_size ? d->page_raw_size : 1);
+    if (!d->page_raw) return -1;
+    for (int i = 0; i < DCMV_PAGE_CACHE; i++) {
+        d->pages[i].page = -1;
+        d->pages[i].offsets = malloc(sizeof(uint32_t) * ((size_t)d->page_frames + 1));
+        d->pages[i].durations = malloc(sizeof(uint16_t) * (size_t)d->page_frames);
+        d->pages[i].totals = malloc(sizeof(uint32_t) * ((size_t)d->page_frames / DCMV_TOTAL_SAMPLE + 1));
+        if (!d->pages[i].offsets || !d->pages[i].durations || !d->pages[i].totals) return -1;
+    }
+    d->page_pinned[0] = d->page_pinned[1] = -1;
+    return 0;
+}
+
+static int load_ordr(dcmv_t *d, uint32_t offset, uint32_t size) {
+    uint8_t head[4];
+    if (size < 4 || io_read_at(d, offset, head, 4) < 0) return -1;
+    d->run_count = (int)rd32(head);
+    uint32_t bytes = (uint32_t)d->run_count * 8;
+    if (d->run_count < 1 || d->run_count > d->hdr.num_unique_frames || 4 + bytes > size) return -1;
+
+    d->runs = malloc(bytes);
+    if (!d->runs || io_read_at(d, offset + 4, d->runs, bytes) < 0) return -1;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int i = 0; i < d->run_count * 2; i++) d->runs[i] = rd32((uint8_t *)&d->runs[i]);
+#endif
+    if (d->runs[0] != 0) return -1;
+    for (int r = 1; r < d->run_count; r++)
+        if (d->runs[r * 2] <= d->runs[r * 2 - 2] || d->runs[r * 2] >= (uint32_t)d->hdr.num_unique_frames)
+            return -1;
+    return 0;
+}
+
+// Descriptor and offset table sit at the end of the chunk, after the frames
+static int load_rend(dcmv_t *d, uint32_t offset, uint32_t size) {
+    if (d->rend_count >= DCMV_MAX_RENDITIONS - 1) return 0;   // ignore extras
+    uint32_t n = (uint32_t)d->hdr.num_unique_frames;
+    uint32_t tail = DCMV_REND_DESC_SIZE + (n + 1) * 4;
+    if (size < tail) return -1;
+
+    uint8_t p[DCMV_REND_DESC_SIZE];
+    uint32_t desc = offset + size - tail;
+    if (io_read_at(d, desc, p, sizeof(p)) < 0) return -1;
+    dcmv_rend_t *r = &d->rends[d->rend_count];
+    r->info.width               = rd16(p);
+    r->info.height              = rd16(p + 2);
+    r->info.content_width       = rd16(p + 4);
+    r->info.content_height      = rd16(p + 6);
+    r->info.frame_type          = p[8];
+    r->info.compression         = p[9] == 1 ? DCMV_COMPRESSION_ZSTD : DCMV_COMPRESSION_LZ4;
+    r->info.video_frame_size    = (int)rd32(p + 12);
+    r->info.max_compressed_size = (int)rd32(p + 16);
+    if (r->info.video_frame_size <= 0 || r->info.max_compressed_size <= 0) return -1;
+
+    r->offsets = malloc(sizeof(uint32_t) * (n + 1));
+    if (!r->offsets || io_read_at(d, desc + DCMV_REND_DESC_SIZE, r->offsets, (n + 1) * 4) < 0) {
+        free(r->offsets);
+        return -1;
+    }
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (uint32_t i = 0; i <= n; i++) r->offsets[i] = rd32((uint8_t *)&r->offsets[i]);
+#endif
+    for (uint32_t i = 0; i < n; i++) {
+        if (r->offsets[i] < offset || r->offsets[i + 1] < r->offsets[i] || r->offsets[i + 1] > desc ||
+            r->offsets[i + 1] - r->offsets[i] > (uint32_t)r->info.max_compressed_size) {
+            free(r->offsets);
+            return -1;
+        }
+    }
+    r->info.bytes = r->offsets[n] - r->offsets[0];
+    d->rend_count++;
+    return 0;
+}
+
+static int load_zdic(dcmv_t *d, uint32_t offset, uint32_t size) {
+    d->dict = malloc(size);
+    d->dict_size = size;
+    if (!d->dict || io_read_at(d, offset, d->dict, size) < 0) return -1;
+    return 0;
+}
+
+// v3 extension block: flags plus a chunk directory
+static int load_extensions(dcmv_t *d) {
+    uint8_t head[12];
+    if (io_read_at(d, d->hdr.ext_offset, head, sizeof(head)) < 0 ||
+        memcmp(head, DCMV_EXT_MAGIC, 4) != 0) {
+        printf("[DCMV] %s: bad extension block\n", d->path);
+        return -1;
+    }
+    d->hdr.flags = rd32(head + 4);
+    uint32_t count = rd32(head + 8);
+    d->tail_start = d->hdr.ext_offset;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t e[12];
+        if (io_read_at(d, d->hdr.ext_offset + 12 + i * 12, e, sizeof(e)) < 0) return -1;
+        uint32_t fourcc = rd32(e), offset = rd32(e + 4), size = rd32(e + 8);
+        if (offset >= d->hdr.audio_offset && offset < d->tail_start)
+            d->tail_start = offset;
+
+        if (fourcc == DCMV_CHUNK_AVIL) {
+            if (load_avil(d, offset, size) < 0) {
+                printf("[DCMV] %s: bad AVIL chunk\n", d->path);
+                return -1;
+            }
+        } else if (fourcc == DCMV_CHUNK_BLKS) {
+            if (load_blks(d, offset, size) < 0) {
+                printf("[DCMV] %s: bad BLKS chunk\n", d->path);
+                return -1;
+            }
+        } else if (fourcc == DCMV_CHUNK_DLTA) {
+            if (load_dlta(d, offset, size) < 0) {
+                printf("[DCMV] %s: bad DLTA chunk\n", d->path);
+                return -1;
+            }
+        } else if (fourcc == DCMV_CHUNK_CBTB) {
+            if (load_cbtb(d, offset, size) < 0) {
+                printf("[DCMV] %s: bad CBTB chunk\n", d->path);
+                return -1;
+            }
+        } else if (fourcc == DCMV_CHUNK_PTBL) {
+            if (load_ptbl(d, offset, size) < 0) {
+                printf("[DCMV] %s: bad PTBL chunk\n", d->path);
+                return -1;
+            }
+        } else if (fourcc == DCMV_CHUNK_REND) {
+            if (load_rend(d, offset, size) < 0) {
+                printf("[DCMV] %s: bad REND chunk\n", d->path);
+                return -1;
+            }
+        } else if (fourcc == DCMV_CHUNK_ORDR) {
+            if (load_ordr(d, offset, size) < 0) {
+                printf("[DCMV] %s: bad ORDR chunk\n", d->path);
+                return -1;
+            }
+        } else if (fourcc == DCMV_CHUNK_ZDIC) {
+            if (load_zdic(d, offset, size) < 0) {
+                printf("[DCMV] %s: bad ZDIC chunk\n", d->path);
+                return -1;
+            }
+        }
+        // Unknown chunks are skipped so newer files still open
+    }
+
+    if ((d->hdr.flags & DCMV_FLAG_PAGED_TABLES) && !d->page_index) {
+        printf("[DCMV] %s: paged tables flag without PTBL chunk\n", d->path);
+        return -1;
+    }
+    for (int p = 0; p < d->page_count && !d->runs; p++) {
+        if (d->page_index[p * 3 + 4] < d->page_index[p * 3 + 1]) {
+            printf("[DCMV] %s: bad PTBL chunk\n", d->path);
+            return -1;
+        }
+    }
+    if ((d->hdr.flags & DCMV_FLAG_INTERLEAVED) && !d->packets) {
+        printf("[DCMV] %s: interleaved flag without packet index\n", d->path);
+        return -1;
+    }
+    if ((d->blocks || d->dict) && d->hdr.compression != DCMV_COMPRESSION_ZSTD) {
+        printf("[DCMV] %s: blocks and dictionaries need Zstd\n", d->path);
+        return -1;
+    }
+    if (d->blocks && d->delta_bits) {
+        printf("[DCMV] %s: delta frames inside blocks are not supported\n", d->path);
+        return -1;
+    }
+    if (d->cb_runs && (d->blocks || d->delta_bits)) {
+        printf("[DCMV] %s: codebook runs cannot be combined with blocks or deltas\n", d->path);
+        return -1;
+    }
+    if (d->rend_count && d->packets) {
+        printf("[DCMV] %s: renditions need the planar layout\n", d->path);
+        return -1;
+    }
+    if (d->runs && d->packets) {
+        printf("[DCMV] %s: frame runs need the planar layout\n", d->path);
+        return -1;
+    }
+    return 0;
+}
+
+dcmv_t *dcmv_open(const char *path, int backend) {
+    dcmv_t *d = calloc(1, sizeof(*d));
+    if (!d) return NULL;
+    d->fd = -1;
+    d->path = strdup(path);
+    d->backend = DCMV_HAVE_MMAP ? backend : DCMV_BACKEND_FILE;
+
+    if (io_open(d) < 0) {
+        printf("[DCMV] %s: open failed\n", path);
+        goto fail;
+    }
+    d->hdr.file_size = io_size(d);
+
+#if DCMV_HAVE_MMAP
+    if (d->backend == DCMV_BACKEND_MMAP) {
+        void *m = mmap(NULL, d->hdr.file_size, PROT_READ, MAP_PRIVATE, d->fd, 0);
+        if (m == MAP_FAILED) {
+            printf("[DCMV] %s: mmap failed, using file reads\n", path);
+            d->backend = DCMV_BACKEND_FILE;
+        } else {
+            d->map = m;
+        }
+    }
+#endif
+
+    uint8_t raw[DCMV_HEADER_SIZE];
+    if (io_read_at(d, 0, raw, sizeof(raw)) < 0 || parse_header(d, raw) < 0)
+        goto fail;
+
+    // Extensions first: with paged tables there are no inline ones to read
+    d->tail_start = d->hdr.file_size;
+    if (d->hdr.ext_offset && load_extensions(d) < 0)
+        goto fail;
+    if (!d->page_index && load_tables(d) < 0) {
+        printf("[DCMV] %s: failed to read frame tables\n", path);
+        goto fail;
+    }
+
+    if (d->hdr.flags & DCMV_FLAG_INTERLEAVED) {
+        d->hdr.audio_channel_size = d->packets[d->packet_count * 4 + 2];
+    } else {
+        // Planar audio runs up to the first extension chunk (or EOF)
+        uint64_t audio_bytes = d->tail_start > d->hdr.audio_offset
+                             ? d->tail_start - d->hdr.audio_offset : 0;
+        d->hdr.audio_channel_size = (uint32_t)(d->hdr.audio_channels == 2 ? audio_bytes / 2 : audio_bytes);
+    }
+
+    if (sector_aligned(d)) {
+        // Packets are read up to the padding that follows them
+        d->max_packet_size = sector_round(d->max_packet_size);
+    }
+
+    uint32_t staging = (uint32_t)d->hdr.max_compressed_size;
+    if (sector_aligned(d)) staging = sector_round(staging);
+    for (int r = 0; r < d->rend_count; r++) {
+        if ((uint32_t)d->rends[r].info.max_compressed_size > staging)
+            staging = (uint32_t)d->rends[r].info.max_compressed_size;
+        if (d->rends[r].info.compression == DCMV_COMPRESSION_ZSTD && !d->rend_zstd) {
+            d->rend_zstd = ZSTD_createDCtx();
+            if (!d->rend_zstd) goto fail;
+            ZSTD_DCtx_setParameter(d->rend_zstd, ZSTD_d_format, ZSTD_f_zstd1_magicless);
+        }
+    }
+
+    if (d->backend == DCMV_BACKEND_FILE) {
+        d->staging = memalign(32, staging);
+        if (!d->staging) goto fail;
+    }
+
+    d->ref_unique = -1;
+    if (d->delta_bits) {
+        d->ref = memalign(32, d->hdr.video_frame_size);
+        d->delta_buf = malloc(d->hdr.video_frame_size);
+        if (!d->ref || !d->delta_buf) goto fail;
+    }
+
+    d->cb_cached = -1;
+    if (d->cb_runs) {
+        d->cb = malloc(DCMV_CODEBOOK_SIZE);
+        if (!d->cb) goto fail;
+    }
+
+    if (!d->blocks) {
+        d->block_count = d->hdr.num_unique_frames;
+        d->max_block_frames = 1;
+    } else {
+        d->scratch = memalign(32, d->hdr.video_frame_size);
+        if (!d->scratch) goto fail;
+    }
+
+    if (d->hdr.compression == DCMV_COMPRESSION_ZSTD) {
+        d->zstd = ZSTD_createDCtx();
+        if (!d->zstd) goto fail;
+        ZSTD_DCtx_setParameter(d->zstd, ZSTD_d_format, ZSTD_f_zstd1_magicless);
+        if (d->dict) {
+            // Digest the dictionary once; every frame then only references it
+            d->ddict = ZSTD_createDDict(d->dict, d->dict_size);
+            if (!d->ddict || ZSTD_isError(ZSTD_DCtx_refDDict(d->zstd, d->ddict))) {
+                printf("[DCMV] %s: bad dictionary\n", path);
+                goto fail;
+            }
+            free(d->dict);
+            d->dict = NULL;
+        }
+    }
+    return d;
+
+fail:
+    dcmv_close(d);
+    return NULL;
+}
+
+void dcmv_close(dcmv_t *d) {
+    if (!d) return;
+#if DCMV_HAVE_MMAP
+    if (d->map) munmap((void *)d->map, d->hdr.file_size);
+#endif
+    io_close(d);
+    if (d->zstd) ZSTD_freeDCtx(d->zstd);
+    if (d->rend_zstd) ZSTD_freeDCtx(d->rend_zstd);
+    for (int r = 0; r < d->rend_count; r++) free(d->rends[r].offsets);
+    if (d->ddict) ZSTD_freeDDict(d->ddict);
+    free(d->dict);
+    free(d->staging);
+    free(d->scratch);
+    free(d->blocks);
+    free(d->runs);
+    free(d->delta_bits);
+    free(d->ref);
+    free(d->delta_buf);
+    free(d->cb_runs);
+    free(d->cb);
+    free(d->frame_offsets);
+    free(d->frame_durations);
+    free(d->total_starts);
+    free(d->page_index);
+    free(d->page_raw);
+    for (int i = 0; i < DCMV_PAGE_CACHE; i++) {
+        free(d->pages[i].offsets);
+        free(d->pages[i].durations);
+        free(d->pages[i].totals);
+    }
+    free(d->packets);
+    free(d->path);
+    free(d);
+}
+
+int dcmv_reopen(dcmv_t *d) {
+    if (d->map) return 0;
+    io_lock(d);
+    io_close(d);
+    int r = io_open(d);
+    io_unlock(d);
+    return r;
+}
+
+void dcmv_set_io_lock(dcmv_t *d, dcmv_lock_fn lock, dcmv_lock_fn unlock, void *arg) {
+    d->lock = lock;
+    d->unlock = unlock;
+    d->lock_arg = arg;
+}
+
+void dcmv_set_read_hook(dcmv_t *d, dcmv_read_fn fn, void *arg) {
+    d->read_hook = fn;
+    d->read_hook_arg = arg;
+}
+
+const dcmv_header_t *dcmv_header(const dcmv_t *d) {
+    return &d->hdr;
+}
+
+// ---------------------------------------------------------------------------
+// Paged tables
+// ---------------------------------------------------------------------------
+static inline void page_lock(dcmv_t *d) {
+    while (atomic_flag_test_and_set_explicit(&d->page_lock, memory_order_acquire))
+        dcmv_yield();
+}
+
+static inline void page_unlock(dcmv_t *d) {
+    atomic_flag_clear_explicit(&d->page_lock, memory_order_release);
+}
+
+static uint32_t read_varint(const uint8_t *p, uint32_t size, uint32_t *pos, int *ok) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*pos >= size) break;
+        uint8_t b = p[(*pos)++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    *ok = 0;
+    return 0;
+}
+
+static int page_is_pinned(const dcmv_t *d, int page) {
+    return page >= 0 && (page == d->page_pinned[0] || page == d->page_pinned[1]);
+}
+
+// Cached slot holding `page`, or -1. Call with page_lock held.
+static int page_find(dcmv_t *d, int page) {
+    for (int i = 0; i < DCMV_PAGE_CACHE; i++) {
+        if (d->pages[i].page == page) {
+            d->pages[i].last_use = ++d->page_clock;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Read and decode a page into the least recently used slot. Returns the slot
+// with page_lock held, or -1 (lock not held).
+static int page_load(dcmv_t *d, int page) {
+    io_lock(d);
+    page_lock(d);
+    int slot = page_find(d, page);   // another thread may have beaten us to it
+    if (slot >= 0) {
+        io_unlock(d);
+        return slot;
+    }
+    int victim = -1;
+    for (int i = 0; i < DCMV_PAGE_CACHE; i++) {
+        if (d->pages[i].page == -2 || page_is_pinned(d, d->pages[i].page)) continue;
+        if (victim < 0 || d->pages[i].last_use < d->pages[victim].last_use) victim = i;
+    }
+    if (victim < 0) {                // cannot happen: two pins in four slots
+        page_unlock(d);
+        io_unlock(d);
+        return -1;
+    }
+    dcmv_page_t *pg = &d->pages[victim];
+    pg->page = -2;   // invisible to lookups while it is rewritten
+    page_unlock(d);
+
+    const uint32_t *e = d->page_index + page * 3;
+    uint32_t bytes = e[3] - e[0];
+    int first = page * d->page_frames;
+    int count = d->hdr.num_unique_frames - first < d->page_frames ? d->hdr.num_unique_frames - first : d->page_frames;
+    int ok = io_read_at(d, e[0], d->page_raw, bytes) == 0;
+
+    // Per frame: varint size (offset delta), varint duration. page_raw is
+    // shared, so the io lock stays held until it has been decoded.
+    uint32_t pos = 0, total = e[2];
+    pg->offsets[0] = e[1];
+    for (int i = 0; i < count && ok; i++) {
+        if (i % DCMV_TOTAL_SAMPLE == 0) pg->totals[i / DCMV_TOTAL_SAMPLE] = total;
+        pg->offsets[i + 1] = pg->offsets[i] + read_varint(d->page_raw, bytes, &pos, &ok);
+        pg->durations[i] = (uint16_t)read_varint(d->page_raw, bytes, &pos, &ok);
+        total += pg->durations[i];
+    }
+    if (ok && (pg->offsets[count] != e[4] || total != e[5])) ok = 0;
+
+    // Republished before the io lock goes, so no slot is -2 when the next
+    // load picks its victim.
+    page_lock(d);
+    pg->page = ok ? page : -1;
+    pg->last_use = ++d->page_clock;
+    d->page_loads++;
+    io_unlock(d);
+    if (!ok) {
+        page_unlock(d);
+        printf("[DCMV] %s: bad table page %d\n", d->path, page);
+        return -1;
+    }
+    return victim;
+}
+
+// Slot holding `page`, with page_lock held; -1 on failure (lock not held).
+// The cache is logically part of the (const) tables, hence the cast.
+static int page_get(const dcmv_t *cd, int page) {
+    dcmv_t *d = (dcmv_t *)cd;
+    page_lock(d);
+    int slot = page_find(d, page);
+    if (slot >= 0) return slot;
+    page_unlock(d);
+    return page_load(d, page);
+}
+
+// frame_offsets[unique], unique in [0, num_unique]. Page starts come straight
+// from the index.
+static int frame_offset(const dcmv_t *d, int unique, uint32_t *out) {
+    if (!d->page_index) {
+        *out = d->frame_offsets[unique];
+        return 0;
+    }
+    int page = unique == d->hdr.num_unique_frames ? d->page_count : unique / d->page_frames;
+    if (page == d->page_count || unique % d->page_frames == 0) {
+        *out = d->page_index[page * 3 + 1];
+        return 0;
+    }
+    int slot = page_get(d, page);
+    if (slot < 0) return -1;
+    *out = d->pages[slot].offsets[unique % d->page_frames];
+    page_unlock((dcmv_t *)d);
+    return 0;
+}
+
+int dcmv_table_bytes(const dcmv_t *d) {
+    if (!d->page_index)
+        return (d->hdr.num_unique_frames + 1) * 4 + d->hdr.num_unique_frames * 2 + (d->total_samples + 1) * 4;
+    return (d->page_count + 1) * 12 + (int)d->page_raw_size +
+           DCMV_PAGE_CACHE * (d->page_frames * 6 + 4 + (d->page_frames / DCMV_TOTAL_SAMPLE + 1) * 4);
+}
+
+uint32_t dcmv_table_page_loads(const dcmv_t *d) {
+    return d->page_loads;
+}
+
+// ---------------------------------------------------------------------------
+// Frames
+// ---------------------------------------------------------------------------
+int dcmv_block_of(const dcmv_t *d, int unique, int *first, int *count) {
+    if (!d->blocks) {
+        *first = unique;
+        *count = 1;
+        return unique;
+    }
+    int lo = 0, hi = d->block_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if ((int)d->blocks[mid] <= unique) lo = mid;
+        else hi = mid - 1;
+    }
+    *first = (int)d->blocks[lo];
+    *count = (int)(d->blocks[lo + 1] - d->blocks[lo]);
+    return lo;
+}
+
+int dcmv_block_count(const dcmv_t *d) {
+    return d->block_count;
+}
+
+int dcmv_max_block_frames(const dcmv_t *d) {
+    return d->max_block_frames;
+}
+
+int dcmv_has_dictionary(const dcmv_t *d) {
+    return d->ddict != NULL;
+}
+
+// Run (ORDR) holding `unique`
+static int run_of(const dcmv_t *d, int unique) {
+    int lo = 0, hi = d->run_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if ((int)d->runs[mid * 2] <= unique) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+// What frame_offsets[next] means for the payload before it: the next frame's
+// offset, unless that frame lives in another run
+static int next_offset(const dcmv_t *d, int next, uint32_t *out) {
+    if (d->runs) {
+        int r = run_of(d, next - 1);
+        int run_end = r + 1 < d->run_count ? (int)d->runs[r * 2 + 2] : d->hdr.num_unique_frames;
+        if (next == run_end) {
+            *out = d->runs[r * 2 + 1];
+            return 0;
+        }
+    }
+    return frame_offset(d, next, out);
+}
+
+int dcmv_frame_range(const dcmv_t *d, int unique, uint32_t *offset, uint32_t *size) {
+    if ((unsigned)unique >= (unsigned)d->hdr.num_unique_frames) return -1;
+    int first, count;
+    dcmv_block_of(d, unique, &first, &count);
+    uint32_t start, end;
+    if (frame_offset(d, first, &start) < 0 || next_offset(d, first + count, &end) < 0) return -1;
+    if (sector_aligned(d) && !d->packets) {
+        // Low bits: padding after the previous payload
+        uint32_t mask = DCMV_SECTOR_SIZE - 1;
+        start &= ~mask;
+        end = (end & ~mask) - (end & mask);
+    }
+    if (d->packets) {
+        // The next offset may sit past this packet's audio
+        const uint32_t *e = d->packets + dcmv_find_packet(d, unique) * 4;
+        if (end > e[0] + e[3]) end = e[0] + e[3];
+    }
+    if (end < start || end - start > (uint32_t)d->hdr.max_compressed_size) return -1;
+    *offset = start;
+    *size = end - start;
+    return 0;
+}
+
+int dcmv_frame_duration(const dcmv_t *d, int unique) {
+    if ((unsigned)unique >= (unsigned)d->hdr.num_unique_frames) return 1;
+    if (!d->page_index) return d->frame_durations[unique];
+
+    int slot = page_get(d, unique / d->page_frames);
+    if (slot < 0) return 1;
+    int dur = d->pages[slot].durations[unique % d->page_frames];
+    page_unlock((dcmv_t *)d);
+    return dur;
+}
+
+// Page holding total frame `total_frame` (below the total duration), from
+// the resident page index
+static int page_of_total(const dcmv_t *d, uint32_t total_frame) {
+    int lo = 0, hi = d->page_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (d->page_index[mid * 3 + 2] <= total_frame) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+// The same two steps inside page `page`, cached in `slot` with page_lock
+// held; releases it
+static int page_total_to_unique(const dcmv_t *d, int slot, int page, uint32_t total_frame) {
+    int n = d->hdr.num_unique_frames;
+    int u = page * d->page_frames;
+    const dcmv_page_t *pg = &d->pages[slot];
+    int count = n - u < d->page_frames ? n - u : d->page_frames;
+    int a = 0, b = (count - 1) / DCMV_TOTAL_SAMPLE;
+    while (a < b) {
+        int mid = (a + b + 1) / 2;
+        if (pg->totals[mid] <= total_frame) a = mid;
+        else b = mid - 1;
+    }
+    int i = a * DCMV_TOTAL_SAMPLE;
+    uint32_t t = pg->totals[a];
+    while (u + i < n - 1 && i < count - 1 && t + pg->durations[i] <= total_frame)
+        t += pg->durations[i++];
+    page_unlock((dcmv_t *)d);
+    return u + i;
+}
+
+// Paged variant: page index first, then one page
+static int paged_total_to_unique(const dcmv_t *d, uint32_t total_frame) {
+    if (total_frame >= d->page_index[d->page_count * 3 + 2]) return d->hdr.num_unique_frames - 1;
+    int page = page_of_total(d, total_frame);
+    int slot = page_get(d, page);
+    if (slot < 0) return page * d->page_frames;
+    return page_total_to_unique(d, slot, page, total_frame);
+}
+
+int dcmv_total_to_unique_nowait(const dcmv_t *d, int total_frame) {
+    if (!d->page_index || total_frame <= 0 || d->hdr.num_unique_frames <= 0)
+        return dcmv_total_to_unique(d, total_frame);
+    if ((uint32_t)total_frame >= d->page_index[d->page_count * 3 + 2]) return d->hdr.num_unique_frames - 1;
+    int page = page_of_total(d, (uint32_t)total_frame);
+    page_lock((dcmv_t *)d);
+    int slot = page_find((dcmv_t *)d, page);
+    if (slot < 0) {
+        page_unlock((dcmv_t *)d);
+        return -1;
+    }
+    return page_total_to_unique(d, slot, page, (uint32_t)total_frame);
+}
+
+void dcmv_pin_pages(dcmv_t *d, int total_frame) {
+    if (!d->page_index) return;
+    uint32_t end = d->page_index[d->page_count * 3 + 2];
+    int page = total_frame <= 0 ? 0 : (uint32_t)total_frame >= end ? d->page_count - 1
+             : page_of_total(d, (uint32_t)total_frame);
+    int pin[2] = { page, page + 1 < d->page_count ? page + 1 : -1 };
+    page_lock(d);
+    d->page_pinned[0] = pin[0];
+    d->page_pinned[1] = pin[1];
+    page_unlock(d);
+    for (int i = 0; i < 2; i++) {
+        if (pin[i] < 0) continue;
+        int slot = page_get(d, pin[i]);   // a lookup when it is resident already
+        if (slot >= 0) page_unlock(d);
+    }
+}
+
+int dcmv_total_to_unique(const dcmv_t *d, int total_frame) {
+    int n = d->hdr.num_unique_frames;
+    if (total_frame <= 0 || n <= 0) return 0;
+    if (d->page_index) return paged_total_to_unique(d, (uint32_t)total_frame);
+    if ((uint32_t)total_frame >= d->total_starts[d->total_samples]) return n - 1;
+
+    int lo = 0, hi = d->total_samples - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (d->total_starts[mid] <= (uint32_t)total_frame) lo = mid;
+        else hi = mid - 1;
+    }
+    int u = lo * DCMV_TOTAL_SAMPLE;
+    uint32_t t = d->total_starts[lo];
+    while (u < n - 1 && t + d->frame_durations[u] <= (uint32_t)total_frame)
+        t += d->frame_durations[u++];
+    return u;
+}
+
+int dcmv_unique_to_total(const dcmv_t *d, int unique) {
+    if (unique <= 0) return 0;
+    if (d->page_index) {
+        int page = unique >= d->hdr.num_unique_frames ? d->page_count : unique / d->page_frames;
+        uint32_t t = d->page_index[page * 3 + 2];
+        if (page == d->page_count || unique % d->page_frames == 0) return (int)t;
+        int slot = page_get(d, page);
+        if (slot < 0) return (int)t;
+        for (int i = 0; i < unique % d->page_frames; i++) t += d->pages[slot].durations[i];
+        page_unlock((dcmv_t *)d);
+        return (int)t;
+    }
+    if (unique >= d->hdr.num_unique_frames) return (int)d->total_starts[d->total_samples];
+    int u = unique / DCMV_TOTAL_SAMPLE * DCMV_TOTAL_SAMPLE;
+    uint32_t t = d->total_starts[unique / DCMV_TOTAL_SAMPLE];
+    while (u < unique) t += d->frame_durations[u++];
+    return (int)t;
+}
+
+int dcmv_read_frame(dcmv_t *d, int unique, const uint8_t **data, uint32_t *size) {
+    uint32_t offset, len;
+    if (dcmv_frame_range(d, unique, &offset, &len) < 0) return -1;
+
+    if (d->map) {
+        if ((uint64_t)offset + len > d->hdr.file_size) return -1;
+        *data = d->map + offset;
+        *size = len;
+        return 0;
+    }
+
+    // Aligned files: through the end of the padding, so the driver can DMA
+    // whole sectors into staging instead of bouncing the last one
+    uint32_t read = sector_aligned(d) && !d->packets ? sector_round(len) : len;
+    io_lock(d);
+    int r = io_read_at(d, offset, d->staging, read);
+    io_unlock(d);
+    if (r < 0) return -1;
+
+    *data = d->staging;
+    *size = len;
+    return 0;
+}
+
+int dcmv_decompress(dcmv_t *d, const uint8_t *src, uint32_t size, void *dst) {
+    if (d->hdr.compression == DCMV_COMPRESSION_ZSTD) {
+        // One-shot: decodes straight into dst, no window buffer round trip.
+        // Uses the referenced DDict, if any.
+        size_t ret = ZSTD_decompressDCtx(d->zstd, dst, (size_t)d->hdr.video_frame_size, src, size);
+        return (!ZSTD_isError(ret) && ret == (size_t)d->hdr.video_frame_size) ? 0 : -1;
+    }
+
+    int res = LZ4_decompress_fast((const char *)src, (char *)dst, d->hdr.video_frame_size);
+    return res < 0 ? -1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Codebook runs
+// ---------------------------------------------------------------------------
+int dcmv_codebook_run(const dcmv_t *d, int unique) {
+    if (!d->cb_runs || (unsigned)unique >= (unsigned)d->hdr.num_unique_frames) return -1;
+    int lo = 0, hi = d->cb_run_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if ((int)d->cb_runs[mid] <= unique) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+int dcmv_codebook_runs(const dcmv_t *d) {
+    return d->cb_run_count;
+}
+
+// Index data only, written after the codebook
+static int decompress_indices(dcmv_t *d, const uint8_t *src, uint32_t size, uint8_t *dst) {
+    int n = d->hdr.video_frame_size - DCMV_CODEBOOK_SIZE;
+    if (d->hdr.compression == DCMV_COMPRESSION_ZSTD) {
+        size_t ret = ZSTD_decompressDCtx(d->zstd, dst + DCMV_CODEBOOK_SIZE, (size_t)n, src, size);
+        return (!ZSTD_isError(ret) && ret == (size_t)n) ? 0 : -1;
+    }
+    int res = LZ4_decompress_safe((const char *)src, (char *)dst + DCMV_CODEBOOK_SIZE, (int)size, n);
+    return res == n ? 0 : -1;
+}
+
+// Pull the codebook of `run` from the tail of its first frame's payload.
+static int fetch_codebook(dcmv_t *d, int run) {
+    uint32_t offset, size;
+    if (dcmv_frame_range(d, (int)d->cb_runs[run], &offset, &size) < 0 || size <= DCMV_CODEBOOK_SIZE)
+        return -1;
+    io_lock(d);
+    int r = io_read_at(d, offset + size - DCMV_CODEBOOK_SIZE, d->cb, DCMV_CODEBOOK_SIZE);
+    io_unlock(d);
+    if (r < 0) {
+        d->cb_cached = -1;
+        return -1;
+    }
+    d->cb_cached = run;
+    return 0;
+}
+
+int dcmv_decompress_frame(dcmv_t *d, int unique, const uint8_t *src, uint32_t size, void *dst,
+                          int keep_codebook) {
+    if (!d->cb_runs) return dcmv_decompress(d, src, size, dst);
+
+    int run = dcmv_codebook_run(d, unique);
+    if (run < 0) return -1;
+    if (unique == (int)d->cb_runs[run]) {
+        // First frame of the run: compressed indices, then the raw codebook
+        if (size <= DCMV_CODEBOOK_SIZE) return -1;
+        size -= DCMV_CODEBOOK_SIZE;
+        memcpy(d->cb, src + size, DCMV_CODEBOOK_SIZE);
+        d->cb_cached = run;
+    } else if (!keep_codebook && d->cb_cached != run && fetch_codebook(d, run) < 0) {
+        return -1;
+    }
+
+    if (!keep_codebook) memcpy(dst, d->cb, DCMV_CODEBOOK_SIZE);
+    return decompress_indices(d, src, size, dst);
+}
+
+int dcmv_decompress_block(dcmv_t *d, const uint8_t *src, uint32_t size, void *const *dst, int count) {
+    if (count == 1) return dcmv_decompress(d, src, size, dst[0]);
+    if (d->hdr.compression != DCMV_COMPRESSION_ZSTD) return -1;
+
+    // One Zstd frame spread over several outputs: stream it, switching the
+    // output buffer every video_frame_size bytes.
+    ZSTD_DCtx_reset(d->zstd, ZSTD_reset_session_only);
+    ZSTD_inBuffer in = { src, size, 0 };
+    size_t ret = 1;
+    for (int i = 0; i < count; i++) {
+        ZSTD_outBuffer out = { dst[i], (size_t)d->hdr.video_frame_size, 0 };
+        while (out.pos < out.size) {
+            size_t in_pos = in.pos, out_pos = out.pos;
+            ret = ZSTD_decompressStream(d->zstd, &out, &in);
+            if (ZSTD_isError(ret)) return -1;
+            if (out.pos < out.size && (ret == 0 || (in.pos == in_pos && out.pos == out_pos)))
+                return -1;   // frame ended early or stalled
+        }
+    }
+    // The last output can fill up before the frame epilogue is consumed
+    while (ret != 0) {
+        ZSTD_outBuffer none = { NULL, 0, 0 };
+        size_t in_pos = in.pos;
+        ret = ZSTD_decompressStream(d->zstd, &none, &in);
+        if (ZSTD_isError(ret) || (ret != 0 && in.pos == in_pos)) return -1;
+    }
+    return 0;
+}
+
+int dcmv_decode_into(dcmv_t *d, int unique, void *dst) {
+    if (d->delta_bits)
+        return dcmv_decode_frame(d, unique, dst, NULL, 0, NULL);
+
+    const uint8_t *data;
+    uint32_t size;
+    if (dcmv_read_frame(d, unique, &data, &size) < 0) return -1;
+
+    int first, count;
+    dcmv_block_of(d, unique, &first, &count);
+    if (count == 1) return dcmv_decompress_frame(d, unique, data, size, dst, 0);
+
+    void *out[DCMV_MAX_PACKET_FRAMES];
+    for (int i = 0; i < count; i++)
+        out[i] = (first + i == unique) ? dst : d->scratch;
+    return dcmv_decompress_block(d, data, size, out, count);
+}
+
+// ---------------------------------------------------------------------------
+// Delta frames
+// ---------------------------------------------------------------------------
+int dcmv_has_deltas(const dcmv_t *d) {
+    return d->delta_bits != NULL;
+}
+
+int dcmv_is_delta(const dcmv_t *d, int unique) {
+    if (!d->delta_bits || (unsigned)unique >= (unsigned)d->hdr.num_unique_frames) return 0;
+    return (d->delta_bits[unique >> 3] >> (unique & 7)) & 1;
+}
+
+int dcmv_key_frame(const dcmv_t *d, int unique) {
+    while (unique > 0 && dcmv_is_delta(d, unique)) unique--;
+    return unique;
+}
+
+// Variable-size output, for delta payloads
+static long decompress_raw(dcmv_t *d, const uint8_t *src, uint32_t size, void *dst, uint32_t cap) {
+    if (d->hdr.compression == DCMV_COMPRESSION_ZSTD) {
+        size_t ret = ZSTD_decompressDCtx(d->zstd, dst, cap, src, size);
+        return ZSTD_isError(ret) ? -1 : (long)ret;
+    }
+    int res = LZ4_decompress_safe((const char *)src, (char *)dst, (int)size, (int)cap);
+    return res < 0 ? -1 : res;
+}
+
+// Bring d->ref to `unique` from the payload of that frame.
+static int apply_payload(dcmv_t *d, int unique, const uint8_t *src, uint32_t size,
+                         dcmv_span_t *runs, int max_runs, int *run_count) {
+    int count = -1;
+    if (!dcmv_is_delta(d, unique)) {
+        if (dcmv_decompress(d, src, size, d->ref) < 0) goto fail;
+    } else {
+        long n = decompress_raw(d, src, size, d->delta_buf, (uint32_t)d->hdr.video_frame_size);
+        if (n < 0) goto fail;
+        int r = dcmv_delta_apply(d->ref, d->hdr.video_frame_size, d->delta_buf, (uint32_t)n, runs, max_runs);
+        if (r < 0) goto fail;
+        count = r <= max_runs ? r : -1;
+    }
+    d->ref_unique = unique;
+    if (run_count) *run_count = count;
+    return 0;
+
+fail:
+    d->ref_unique = -1;
+    return -1;
+}
+
+// Make d->ref hold `target`, continuing from the current reference when it
+// lies on the same chain, otherwise replaying from the key frame.
+static int ensure_ref(dcmv_t *d, int target) {
+    if (d->ref_unique == target) return 0;
+    int key = dcmv_key_frame(d, target);
+    int start = (d->ref_unique >= key && d->ref_unique < target) ? d->ref_unique + 1 : key;
+
+    for (int u = start; u <= target; u++) {
+        const uint8_t *data;
+        uint32_t size;
+        if (dcmv_read_frame(d, u, &data, &size) < 0 ||
+            apply_payload(d, u, data, size, NULL, 0, NULL) < 0) return -1;
+    }
+    return 0;
+}
+
+int dcmv_decode_payload(dcmv_t *d, int unique, const uint8_t *src, uint32_t size, void *dst,
+                        dcmv_span_t *runs, int max_runs, int *run_count) {
+    if (!d->delta_bits) {
+        if (run_count) *run_count = -1;
+        return dst ? dcmv_decompress_frame(d, unique, src, size, dst, 0) : 0;
+    }
+    if (dcmv_is_delta(d, unique) && ensure_ref(d, unique - 1) < 0) return -1;
+    if (apply_payload(d, unique, src, size, runs, max_runs, run_count) < 0) return -1;
+    if (dst) memcpy(dst, d->ref, (size_t)d->hdr.video_frame_size);
+    return 0;
+}
+
+int dcmv_decode_frame(dcmv_t *d, int unique, void *dst, dcmv_span_t *runs, int max_runs, int *run_count) {
+    if (!d->delta_bits) {
+        if (run_count) *run_count = -1;
+        return dst ? dcmv_decode_into(d, unique, dst) : 0;
+    }
+
+    // Replay the chain first: it reuses the staging buffer
+    if (dcmv_is_delta(d, unique) && ensure_ref(d, unique - 1) < 0) return -1;
+
+    const uint8_t *data;
+    uint32_t size;
+    if (dcmv_read_frame(d, unique, &data, &size) < 0) return -1;
+    return dcmv_decode_payload(d, unique, data, size, dst, runs, max_runs, run_count);
+}
+
+// ---------------------------------------------------------------------------
+// Renditions
+// ---------------------------------------------------------------------------
+int dcmv_rendition_count(const dcmv_t *d) {
+    return 1 + d->rend_count;
+}
+
+int dcmv_rendition_info(const dcmv_t *d, int r, dcmv_rendition_t *out) {
+    if (r < 0 || r > d->rend_count) return -1;
+    if (r > 0) {
+        *out = d->rends[r - 1].info;
+        return 0;
+    }
+    const dcmv_header_t *h = &d->hdr;
+    out->width               = h->width;
+    out->height              = h->height;
+    out->content_width       = h->content_width;
+    out->content_height      = h->content_height;
+    out->frame_type          = h->frame_type;
+    out->compression         = h->compression;
+    out->video_frame_size    = h->video_frame_size;
+    out->max_compressed_size = h->max_compressed_size;
+    uint32_t first = 0, end = 0;
+    frame_offset(d, 0, &first);
+    frame_offset(d, h->num_unique_frames, &end);
+    out->bytes = end - first;
+    if (d->runs) {
+        uint32_t mask = sector_aligned(d) ? DCMV_SECTOR_SIZE - 1 : 0;
+        out->bytes = 0;
+        for (int r = 0; r < d->run_count; r++) {
+            frame_offset(d, (int)d->runs[r * 2], &first);
+            end = d->runs[r * 2 + 1];
+            out->bytes += ((end & ~mask) - (end & mask)) - (first & ~mask);
+        }
+    }
+    if (d->packets) {
+        out->bytes = 0;
+        for (int k = 0; k < d->packet_count; k++) out->bytes += d->packets[k * 4 + 3];
+    }
+    return 0;
+}
+
+int dcmv_read_rendition_frame(dcmv_t *d, int r, int unique, const uint8_t **data, uint32_t *size) {
+    if (r == 0) return dcmv_read_frame(d, unique, data, size);
+    if (r < 0 || r > d->rend_count || (unsigned)unique >= (unsigned)d->hdr.num_unique_frames) return -1;
+    const dcmv_rend_t *rd = &d->rends[r - 1];
+    uint32_t offset = rd->offsets[unique];
+    uint32_t len = rd->offsets[unique + 1] - offset;
+
+    if (d->map) {
+        *data = d->map + offset;
+        *size = len;
+        return 0;
+    }
+    io_lock(d);
+    int res = io_read_at(d, offset, d->staging, len);
+    io_unlock(d);
+    if (res < 0) return -1;
+    *data = d->staging;
+    *size = len;
+    return 0;
+}
+
+int dcmv_decode_rendition(dcmv_t *d, int r, int unique, void *dst) {
+    if (r == 0) return dcmv_decode_into(d, unique, dst);
+    const uint8_t *data;
+    uint32_t size;
+    if (dcmv_read_rendition_frame(d, r, unique, &data, &size) < 0) return -1;
+
+    const dcmv_rendition_t *info = &d->rends[r - 1].info;
+    if (info->compression == DCMV_COMPRESSION_ZSTD) {
+        size_t ret = ZSTD_decompressDCtx(d->rend_zstd, dst, (size_t)info->video_frame_size, data, size);
+        return (!ZSTD_isError(ret) && ret == (size_t)info->video_frame_size) ? 0 : -1;
+    }
+    int res = LZ4_decompress_fast((const char *)data, (char *)dst, info->video_frame_size);
+    return res < 0 ? -1 : 0;
+}
+
+int dcmv_read_range(dcmv_t *d, uint64_t offset, void *dst, uint32_t size) {
+    io_lock(d);
+    int r = io_read_at(d, offset, dst, size);
+    io_unlock(d);
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Interleaved packets
+// ---------------------------------------------------------------------------
+int dcmv_packet_count(const dcmv_t *d) {
+    return d->packet_count;
+}
+
+uint32_t dcmv_max_packet_size(const dcmv_t *d) {
+    return d->max_packet_size;
+}
+
+int dcmv_packet_info(const dcmv_t *d, int packet, dcmv_packet_t *out) {
+    if ((unsigned)packet >= (unsigned)d->packet_count) return -1;
+    const uint32_t *e = d->packets + packet * 4;
+    const uint32_t *n = e + 4;
+    int channels = d->hdr.audio_channels == 2 ? 2 : 1;
+
+    out->offset       = e[0];
+    out->size         = n[0] - e[0];
+    out->first_unique = (int)e[1];
+    out->unique_count = (int)(n[1] - e[1]);
+    out->video_bytes  = e[3];
+    out->audio_start  = e[2];
+    out->audio_bytes  = n[2] - e[2];
+    out->read_size    = out->size;
+    if (sector_aligned(d)) {
+        // The padding up to the next packet is not part of it
+        out->size = out->video_bytes + out->audio_bytes * channels;
+        out->read_size = sector_round(out->size);
+        if (e[0] % DCMV_SECTOR_SIZE || out->read_size != n[0] - e[0]) return -1;
+    }
+    if (out->video_bytes + out->audio_bytes * channels != out->size) return -1;
+    uint32_t first_offset;
+    if (out->unique_count && (frame_offset(d, (int)e[1], &first_offset) < 0 || first_offset != e[0]))
+        return -1;
+    return 0;
+}
+
+// Last packet whose first_unique <= unique. Audio-only packets share the
+// first_unique of the packet that follows them, so this lands on the packet
+// that actually carries the frame.
+int dcmv_find_packet(const dcmv_t *d, int unique) {
+    int lo = 0, hi = d->packet_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if ((int)d->packets[mid * 4 + 1] <= unique) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+int dcmv_find_audio_packet(const dcmv_t *d, uint32_t pos) {
+    int lo = 0, hi = d->packet_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (d->packets[mid * 4 + 2] <= pos) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+// ---------------------------------------------------------------------------
+// Audio
+// ---------------------------------------------------------------------------
+uint32_t dcmv_audio_stream_pos(const dcmv_t *d, int total_frame) {
+    const dcmv_header_t *h = &d->hdr;
+    if (total_frame < 0) total_frame = 0;
+
+    double samples_exact = ((double)total_frame * (double)h->sample_rate) / (double)h->fps;
+    uint32_t samples_i = (uint32_t)(samples_exact + 0.5);
+    uint32_t bytes_per_channel = samples_i / 2;    // 4-bit ADPCM
+    bytes_per_channel = (bytes_per_channel + 15) & ~0xFu;
+    if (bytes_per_channel > h->audio_channel_size)
+        bytes_per_channel = h->audio_channel_size;
+    return bytes_per_channel;
+}
+
+long dcmv_audio_byte_offset(const dcmv_t *d, int total_frame, int channel) {
+    const dcmv_header_t *h = &d->hdr;
+    if (h->flags & DCMV_FLAG_INTERLEAVED) return -1;
+
+    long base = (long)h->audio_offset;
+    if (channel == 1 && h->audio_channels == 2)
+        base += (long)h->audio_channel_size;
+    return base + (long)dcmv_audio_stream_pos(d, total_frame);
+}
+
+long dcmv_read_audio(dcmv_t *d, int channel, uint32_t pos, void *dst, uint32_t size) {
+    const dcmv_header_t *h = &d->hdr;
+    if (pos >= h->audio_channel_size) return 0;
+    if (size > h->audio_channel_size - pos) size = h->audio_channel_size - pos;
+    if (channel == 1 && h->audio_channels != 2) channel = 0;
+
+    if (!(h->flags & DCMV_FLAG_INTERLEAVED)) {
+        uint64_t off = h->audio_offset + (uint64_t)channel * h->audio_channel_size + pos;
+        return dcmv_read_range(d, off, dst, size) < 0 ? -1 : (long)size;
+    }
+
+    // Interleaved: walk the packets that cover [pos, pos + size)
+    uint32_t done = 0;
+    for (int k = dcmv_find_audio_packet(d, pos); done < size && k < d->packet_count; k++) {
+        dcmv_packet_t pk;
+        if (dcmv_packet_info(d, k, &pk) < 0) return -1;
+        uint32_t at = pos + done;
+        if (at < pk.audio_start || at >= pk.audio_start + pk.audio_bytes) continue;
+
+        uint32_t in_pkt = at - pk.audio_start;
+        uint32_t n = pk.audio_bytes - in_pkt;
+        if (n > size - done) n = size - done;
+        uint64_t off = (uint64_t)pk.offset + pk.video_bytes + (uint64_t)channel * pk.audio_bytes + in_pkt;
+        if (dcmv_read_range(d, off, (uint8_t *)dst + done, n) < 0) return -1;
+        done += n;
+    }
+    return (long)done;
+}
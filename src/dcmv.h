@@ -0,0 +1,325 @@
+// dcmv.h - DCMV movie reader
+//
+// One place that knows the .dcmv container: header parsing, the unique-frame
+// offset/duration tables, LZ4/Zstd frame decompression and the audio offset
+// math used when seeking. The engine, host tools and benchmarks all go
+// through this API.
+//
+// File layout (little-endian):
+//   0   "DCMV"            4   version             8   frame_type (u8)
+//   9   width (u16)       11  height (u16)        13  content_width (u16)
+//   15  content_height    17  fps (f32)           21  sample_rate (u16)
+//   23  channels (u16)    25  num_unique (u32)    29  num_total (u32)
+//   33  frame_size (u32)  37  max_compressed (u32) 41 audio_offset (u32)
+//   45  compression (u8, 1 = Zstd magicless, otherwise LZ4)
+//   50  u32 frame_offsets[num_unique + 1], u16 frame_durations[num_unique]
+//   ... compressed VQ frames ...
+//   audio_offset: ADPCM, all of the left channel then all of the right
+//
+// Version 3 adds an extension block. Bytes 46..49 (reserved in v2) hold its
+// file offset; the block itself is
+//   "DCMX", u32 flags, u32 chunk_count, chunk_count x { fourcc, u32 offset, u32 size }
+// and every new feature lives in a chunk so older chunks stay readable.
+//
+// DCMV_FLAG_INTERLEAVED ("AVIL" chunk): video and audio are stored as packets,
+// each holding a run of compressed frames followed by the matching ADPCM for
+// the left and then the right channel. The chunk is u32 packet_count,
+// u32 max_packet_size, then packet_count + 1 entries of
+//   { u32 file_offset, u32 first_unique, u32 audio_start, u32 video_bytes }
+// (the last entry is a sentinel). Packets may carry audio only, so long held
+// frames do not produce huge packets. frame_offsets[] still points at every
+// frame, so random access works exactly as in v2; the last frame of a packet
+// ends at file_offset + video_bytes rather than at the next offset.
+//
+// "ZDIC" chunk: a Zstd dictionary trained on the movie. Every frame or block
+// is compressed against it; the reader loads it once into a DDict.
+//
+// "BLKS" chunk (Zstd only): consecutive frames compressed as one Zstd frame.
+// u32 block_count, u32 max_block_frames, then block_count + 1 u32
+// first_unique values (sentinel = num_unique). Every frame of a block has the
+// block's offset in frame_offsets[], and max_compressed_size is the largest
+// block. Without the chunk each frame is a block of one.
+//
+// "DLTA" chunk: u32 num_unique, then a bitset (LSB first) marking delta
+// frames. A delta frame decompresses to a dcmv_delta.h run list against the
+// previous unique frame instead of a full texture; frame 0 is always a key
+// frame. Not combined with BLKS.
+//
+// "CBTB" chunk: codebook runs. u32 run_count, then run_count + 1 u32
+// first_unique values (sentinel = num_unique). Frames of a run share one VQ
+// codebook (the first DCMV_CODEBOOK_SIZE bytes of the texture), so their
+// payloads decompress to the index data only; the first frame of a run
+// stores the codebook raw after its compressed indices. Not combined with
+// BLKS or DLTA.
+//
+// DCMV_FLAG_PAGED_TABLES ("PTBL" chunk): the offset/duration tables are not
+// stored after the header (frames start at byte 50) but as pages of
+// page_frames frames. The chunk is u32 page_frames, u32 page_count, then
+// page_count + 1 entries of
+//   { u32 page_offset, u32 first_frame_offset, u32 first_total_frame }
+// (the last one a sentinel: end of the pages, end of the frames, total
+// duration). A page is, per frame, a LEB128 varint of the distance to the next
+// frame offset and a varint duration. Only the index is read at open; pages
+// load on first use into a DCMV_PAGE_CACHE-entry LRU, so open time and table
+// memory do not grow with the movie.
+//
+// DCMV_FLAG_SECTOR_ALIGNED: the GD-ROM driver DMAs whole 2048-byte sectors
+// straight into a 32-byte aligned buffer and bounces everything else through
+// its sector cache, so the read units start on sector boundaries. Planar files
+// align every frame (block) and audio_offset; the zero padding after a payload
+// is stored in the low 11 bits of the next frame_offsets[] entry, which are
+// otherwise always zero (a frame starts at offset & ~2047 and ends at
+// (next & ~2047) - (next & 2047)). Interleaved files align every packet
+// instead; the padding follows its audio. Readers issue whole-sector reads.
+//
+// "REND" chunk, one per extra rendition (planar files only): the same
+// timeline at another resolution, e.g. 320x240 next to a 640x480 primary, as a
+// fallback when the drive cannot sustain the primary's bitrate. The chunk
+// holds the rendition's frames (one LZ4 or Zstd frame per unique frame; no
+// blocks, deltas, codebook runs or dictionary, no sector alignment) followed
+// by a DCMV_REND_DESC_SIZE descriptor
+//   u16 width, u16 height, u16 content_width, u16 content_height,
+//   u8 frame_type, u8 compression, u16 reserved,
+//   u32 video_frame_size, u32 max_compressed_size
+// and u32 frame_offsets[num_unique + 1]. Durations, audio and frame numbers
+// are the primary's.
+//
+// "ORDR" chunk (planar files only): the frames are not stored in unique order
+// but as runs of consecutive frames placed where playback traces say they are
+// read next to each other (dcmv-relayout). u32 run_count, then run_count
+// entries { u32 first_unique, u32 end } sorted by first_unique; a run covers
+// frames up to the next entry's first_unique and `end` is what the next
+// frame_offsets[] entry would hold after its last frame (sector padding bits
+// included). frame_offsets[] still holds every frame's own start, so only the
+// last frame of a run needs the chunk; frame numbers do not change.
+#ifndef DCMV_H
+#define DCMV_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "dcmv_delta.h"
+
+#define DCMV_MAGIC       "DCMV"
+#define DCMV_EXT_MAGIC   "DCMX"
+#define DCMV_HEADER_SIZE 50
+#define DCMV_VERSION_EXT 3
+
+#define DCMV_FOURCC(a,b,c,d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+#define DCMV_CHUNK_AVIL DCMV_FOURCC('A','V','I','L')
+#define DCMV_CHUNK_ZDIC DCMV_FOURCC('Z','D','I','C')
+#define DCMV_CHUNK_BLKS DCMV_FOURCC('B','L','K','S')
+#define DCMV_CHUNK_DLTA DCMV_FOURCC('D','L','T','A')
+#define DCMV_CHUNK_CBTB DCMV_FOURCC('C','B','T','B')
+#define DCMV_CHUNK_PTBL DCMV_FOURCC('P','T','B','L')
+#define DCMV_CHUNK_REND DCMV_FOURCC('R','E','N','D')
+#define DCMV_CHUNK_ORDR DCMV_FOURCC('O','R','D','R')
+
+// 256 entries x 2x2 texels x 16 bits at the start of every VQ texture
+#define DCMV_CODEBOOK_SIZE 2048
+
+#define DCMV_FLAG_INTERLEAVED  0x00000001u
+#define DCMV_FLAG_PAGED_TABLES 0x00000002u
+#define DCMV_FLAG_SECTOR_ALIGNED 0x00000004u
+
+#define DCMV_SECTOR_SIZE 2048
+
+// Renditions, the primary included
+#define DCMV_MAX_RENDITIONS 4
+#define DCMV_REND_DESC_SIZE 24
+
+// Unique frames per interleaved packet (and per block). The engine decodes a
+// whole packet at once, so this must stay below its frame slot count.
+#define DCMV_MAX_PACKET_FRAMES 16
+
+// Unique frames per prefix-sum sample of the total -> unique map
+#define DCMV_TOTAL_SAMPLE 32
+
+// Paged tables: default frames per page (writer) and pages kept decoded
+#define DCMV_PAGE_FRAMES 512
+#define DCMV_PAGE_CACHE  4
+
+#define DCMV_COMPRESSION_LZ4  0
+#define DCMV_COMPRESSION_ZSTD 1
+
+// Backends. MMAP maps the whole file (POSIX only, falls back to FILE on KOS).
+#define DCMV_BACKEND_FILE 0
+#define DCMV_BACKEND_MMAP 1
+
+typedef struct {
+    uint32_t version;
+    int      frame_type;          // 0 = RGB565 VQ, 1 = YUV422 VQ
+    int      width, height;
+    int      content_width, content_height;
+    float    fps;
+    int      sample_rate;
+    int      audio_channels;
+    int      num_unique_frames;
+    int      num_total_frames;
+    int      video_frame_size;
+    int      max_compressed_size;
+    uint32_t audio_offset;
+    int      compression;         // DCMV_COMPRESSION_*
+    uint32_t ext_offset;          // v3+: extension block, 0 if none
+    uint32_t flags;               // DCMV_FLAG_*
+    // Derived at open
+    uint64_t file_size;
+    uint32_t audio_channel_size;  // bytes per channel
+} dcmv_header_t;
+
+// One A/V packet of an interleaved file.
+typedef struct {
+    uint32_t offset;              // file offset of the packet
+    uint32_t size;                // video_bytes + 2 * audio_bytes (or 1x for mono)
+    int      first_unique;
+    int      unique_count;        // may be 0 for audio-only packets
+    uint32_t video_bytes;
+    uint32_t audio_start;         // per-channel stream position of the audio
+    uint32_t audio_bytes;         // per channel
+    uint32_t read_size;           // size, rounded up to whole sectors when aligned
+} dcmv_packet_t;
+
+// One rendition of the movie (0 = the primary, described by the header).
+typedef struct {
+    int      width, height;
+    int      content_width, content_height;
+    int      frame_type;
+    int      compression;
+    int      video_frame_size;
+    int      max_compressed_size;
+    uint64_t bytes;               // compressed video, for bitrate estimates
+} dcmv_rendition_t;
+
+typedef struct dcmv dcmv_t;
+typedef void (*dcmv_lock_fn)(void *arg);
+typedef void (*dcmv_read_fn)(void *arg, uint64_t offset, uint32_t size);
+
+dcmv_t *dcmv_open(const char *path, int backend);
+void    dcmv_close(dcmv_t *d);
+
+// Drop and reopen the underlying file handle (the GD-ROM driver likes a
+// fresh handle after a long jump). No-op for the mmap backend.
+int dcmv_reopen(dcmv_t *d);
+
+// Every read the reader issues is bracketed by lock/unlock, so the engine can
+// share its io_lock with the audio path.
+void dcmv_set_io_lock(dcmv_t *d, dcmv_lock_fn lock, dcmv_lock_fn unlock, void *arg);
+
+// Called (under the io lock) for every range the reader reads from the file,
+// including table pages and chunks. For tools that model the device.
+void dcmv_set_read_hook(dcmv_t *d, dcmv_read_fn fn, void *arg);
+
+const dcmv_header_t *dcmv_header(const dcmv_t *d);
+
+// Compressed payload location of a unique frame (of its block, see BLKS).
+int dcmv_frame_range(const dcmv_t *d, int unique, uint32_t *offset, uint32_t *size);
+
+// Block holding `unique`: returns the block index and its frame span.
+int dcmv_block_of(const dcmv_t *d, int unique, int *first, int *count);
+int dcmv_block_count(const dcmv_t *d);      // num_unique when there is no BLKS chunk
+int dcmv_max_block_frames(const dcmv_t *d);
+int dcmv_has_dictionary(const dcmv_t *d);   // ZDIC
+
+// How many total (display) frames a unique frame is shown for.
+int dcmv_frame_duration(const dcmv_t *d, int unique);
+
+// Total (display) frame <-> unique frame, from sampled prefix sums of the
+// durations (4 bytes per DCMV_TOTAL_SAMPLE unique frames): a binary search
+// plus at most DCMV_TOTAL_SAMPLE - 1 additions. Totals past the last frame map
+// to the last unique frame; unique_to_total returns the first total frame.
+int dcmv_total_to_unique(const dcmv_t *d, int total_frame);
+int dcmv_unique_to_total(const dcmv_t *d, int unique);
+
+// Paged tables: dcmv_total_to_unique without reading, -1 when the page it
+// needs is not loaded (the same as dcmv_total_to_unique otherwise). And
+// keeping the pages of `total_frame` and the one after it loaded, reading
+// them now if need be, until the next call: the LRU evicts around them.
+int  dcmv_total_to_unique_nowait(const dcmv_t *d, int total_frame);
+void dcmv_pin_pages(dcmv_t *d, int total_frame);
+
+// Resident bytes of the frame tables, and how many pages were read so far
+// (always 0 for inline tables).
+int      dcmv_table_bytes(const dcmv_t *d);
+uint32_t dcmv_table_page_loads(const dcmv_t *d);
+
+// Fetch the compressed payload. *data points into the reader's staging
+// buffer (FILE) or the mapping (MMAP) and stays valid until the next call.
+// Sector-aligned files are read in whole sectors.
+int dcmv_read_frame(dcmv_t *d, int unique, const uint8_t **data, uint32_t *size);
+
+// Decompress one single-frame payload into dst (video_frame_size bytes,
+// 32-byte aligned).
+int dcmv_decompress(dcmv_t *d, const uint8_t *src, uint32_t size, void *dst);
+
+// Decompress a block payload in one pass, frame i into dst[i]. Entries may
+// repeat (e.g. a scratch buffer for frames the caller does not want).
+int dcmv_decompress_block(dcmv_t *d, const uint8_t *src, uint32_t size, void *const *dst, int count);
+
+// read + decompress one frame (decodes through its block or its delta
+// chain if needed).
+int dcmv_decode_into(dcmv_t *d, int unique, void *dst);
+
+// Codebook runs (CBTB). dcmv_codebook_run returns the run of a frame, or -1
+// when the file has no table (every frame carries its own codebook).
+int dcmv_codebook_run(const dcmv_t *d, int unique);
+int dcmv_codebook_runs(const dcmv_t *d);
+
+// Decompress one single-frame payload of frame `unique`. With codebook runs,
+// keep_codebook = 1 means dst already holds the run's codebook and only the
+// index data is written; otherwise the codebook comes from the payload or the
+// reader's copy of the current run (one small read after a jump). Without
+// runs this is dcmv_decompress.
+int dcmv_decompress_frame(dcmv_t *d, int unique, const uint8_t *src, uint32_t size, void *dst,
+                          int keep_codebook);
+
+// Delta frames (DLTA). The reader keeps the last reconstructed frame, so
+// decoding in order costs one delta apply plus one copy per frame; anything
+// else replays from the nearest key frame.
+int dcmv_has_deltas(const dcmv_t *d);
+int dcmv_is_delta(const dcmv_t *d, int unique);
+int dcmv_key_frame(const dcmv_t *d, int unique);   // last key frame <= unique
+
+// Full frame into dst (may be NULL to only advance the reference). For delta
+// frames *run_count receives the spans that changed since unique - 1 (copied
+// to runs[] if they fit), otherwise -1: upload the whole frame.
+int dcmv_decode_frame(dcmv_t *d, int unique, void *dst, dcmv_span_t *runs, int max_runs, int *run_count);
+
+// Same, for a payload the caller already read (e.g. from an A/V packet).
+// src must not point into the reader's own staging buffer.
+int dcmv_decode_payload(dcmv_t *d, int unique, const uint8_t *src, uint32_t size, void *dst,
+                        dcmv_span_t *runs, int max_runs, int *run_count);
+
+// Renditions (REND). dcmv_rendition_count is 1 + the number of chunks. For
+// r >= 1 the read and decode calls work like dcmv_read_frame and
+// dcmv_decode_into on that rendition's frames (r = 0 forwards to them).
+int dcmv_rendition_count(const dcmv_t *d);
+int dcmv_rendition_info(const dcmv_t *d, int r, dcmv_rendition_t *out);
+int dcmv_read_rendition_frame(dcmv_t *d, int r, int unique, const uint8_t **data, uint32_t *size);
+int dcmv_decode_rendition(dcmv_t *d, int r, int unique, void *dst);
+
+// Raw read of any byte range (takes the io lock).
+int dcmv_read_range(dcmv_t *d, uint64_t offset, void *dst, uint32_t size);
+
+// Per-channel ADPCM stream position of total frame `total_frame`, rounded to
+// the 16-byte boundary the stream uses. Valid for every layout.
+uint32_t dcmv_audio_stream_pos(const dcmv_t *d, int total_frame);
+
+// Copy per-channel audio bytes [pos, pos + size) of channel into dst, for
+// either layout. Returns bytes copied.
+long dcmv_read_audio(dcmv_t *d, int channel, uint32_t pos, void *dst, uint32_t size);
+
+// File offset of the ADPCM for channel (0 = left, 1 = right) at the start of
+// total frame `total_frame`, rounded to the 16-byte boundary the stream uses.
+// Planar (v2-style) layouts only; returns -1 for interleaved files.
+long dcmv_audio_byte_offset(const dcmv_t *d, int total_frame, int channel);
+
+// Interleaved layout. dcmv_find_packet returns the packet holding `unique`
+// (or the last packet starting before it), dcmv_find_audio_packet the packet
+// whose audio covers stream position `pos`.
+int      dcmv_packet_count(const dcmv_t *d);
+uint32_t dcmv_max_packet_size(const dcmv_t *d);   // largest read_size
+int      dcmv_packet_info(const dcmv_t *d, int packet, dcmv_packet_t *out);
+int      dcmv_find_packet(const dcmv_t *d, int unique);
+int      dcmv_find_audio_packet(const dcmv_t *d, uint32_t pos);
+
+#endif // DCMV_H
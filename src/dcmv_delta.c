@@ -0,0 +1,88 @@
+// dcmv_delta.c - inter-frame deltas for DCMV VQ frames (see dcmv_delta.h)
+
+#include "dcmv_delta.h"
+
+#include <string.h>
+
+static inline uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline void wr16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+
+static inline int span_bytes(int span, int count, int frame_size) {
+    int start = span * DCMV_DELTA_SPAN;
+    int end = start + count * DCMV_DELTA_SPAN;
+    if (end > frame_size) end = frame_size;   // last span may be short
+    return end - start;
+}
+
+int dcmv_delta_apply(uint8_t *frame, int frame_size, const uint8_t *delta, uint32_t delta_size,
+                     dcmv_span_t *runs, int max_runs) {
+    if (delta_size < 4) return -1;
+    int count = rd16(delta);
+    uint32_t pos = 4 + (uint32_t)count * 4;
+    if (pos > delta_size) return -1;
+
+    int spans = (frame_size + DCMV_DELTA_SPAN - 1) / DCMV_DELTA_SPAN;
+    const uint8_t *table = delta + 4;
+    for (int i = 0; i < count; i++) {
+        int first = rd16(table + i * 4);
+        int n = rd16(table + i * 4 + 2);
+        if (n == 0 || first + n > spans) return -1;
+
+        int bytes = span_bytes(first, n, frame_size);
+        if (pos + (uint32_t)bytes > delta_size) return -1;
+        memcpy(frame + first * DCMV_DELTA_SPAN, delta + pos, (size_t)bytes);
+        pos += (uint32_t)bytes;
+
+        if (runs && i < max_runs) {
+            runs[i].first = (uint16_t)first;
+            runs[i].count = (uint16_t)n;
+        }
+    }
+    return count;
+}
+
+uint32_t dcmv_delta_encode(const uint8_t *prev, const uint8_t *cur, int frame_size,
+                           uint8_t *out, uint32_t out_cap, int merge_gap) {
+    int spans = (frame_size + DCMV_DELTA_SPAN - 1) / DCMV_DELTA_SPAN;
+    if (spans > 0xFFFF || out_cap < 4) return 0;
+
+    // Pass 1: the run table
+    int count = 0;
+    uint32_t data = 0;
+    for (int s = 0; s < spans; ) {
+        if (!memcmp(prev + s * DCMV_DELTA_SPAN, cur + s * DCMV_DELTA_SPAN,
+                    (size_t)span_bytes(s, 1, frame_size))) {
+            s++;
+            continue;
+        }
+        int first = s, last = s;
+        for (int t = s + 1; t < spans && t - last <= merge_gap + 1; t++) {
+            if (memcmp(prev + t * DCMV_DELTA_SPAN, cur + t * DCMV_DELTA_SPAN,
+                       (size_t)span_bytes(t, 1, frame_size)))
+                last = t;
+        }
+        int n = last - first + 1;
+        if (4 + (uint32_t)(count + 1) * 4 > out_cap) return 0;
+        wr16(out + 4 + count * 4, (uint16_t)first);
+        wr16(out + 4 + count * 4 + 2, (uint16_t)n);
+        data += (uint32_t)span_bytes(first, n, frame_size);
+        count++;
+        s = last + 1;
+    }
+
+    uint32_t size = 4 + (uint32_t)count * 4 + data;
+    if (size > out_cap || count > 0xFFFF) return 0;
+    wr16(out, (uint16_t)count);
+    wr16(out + 2, 0);
+
+    // Pass 2: the changed bytes
+    uint32_t pos = 4 + (uint32_t)count * 4;
+    for (int i = 0; i < count; i++) {
+        int first = rd16(out + 4 + i * 4);
+        int n = rd16(out + 4 + i * 4 + 2);
+        int bytes = span_bytes(first, n, frame_size);
+        memcpy(out + pos, cur + first * DCMV_DELTA_SPAN, (size_t)bytes);
+        pos += (uint32_t)bytes;
+    }
+    return size;
+}
@@ -0,0 +1,38 @@
+// dcmv_delta.h - inter-frame deltas for DCMV VQ frames
+//
+// A delta frame lists the 32-byte spans of the texture (codebook and index
+// data alike) that differ from the previous unique frame. 32 bytes is the
+// store-queue/DMA granule, so each run can be uploaded straight into VRAM.
+//
+// Decompressed payload (little-endian):
+//   u16 run_count, u16 reserved
+//   run_count x { u16 first_span, u16 span_count }
+//   the changed bytes of every run, back to back
+#ifndef DCMV_DELTA_H
+#define DCMV_DELTA_H
+
+#include <stdint.h>
+
+#define DCMV_DELTA_SPAN 32
+
+// Runs a player keeps per decoded frame; a longer list means a full upload.
+#define DCMV_DELTA_MAX_RUNS 256
+
+typedef struct {
+    uint16_t first;               // span index (byte offset / DCMV_DELTA_SPAN)
+    uint16_t count;               // spans
+} dcmv_span_t;
+
+// Patch frame (frame_size bytes) in place. Copies the run list into runs[]
+// when it fits in max_runs. Returns the run count, or -1 if the payload is
+// malformed.
+int dcmv_delta_apply(uint8_t *frame, int frame_size, const uint8_t *delta, uint32_t delta_size,
+                     dcmv_span_t *runs, int max_runs);
+
+// Encode cur against prev. Runs separated by at most merge_gap unchanged
+// spans are joined (fewer, longer uploads). Returns the payload size, or 0
+// if it would not fit in out_cap (store a key frame instead).
+uint32_t dcmv_delta_encode(const uint8_t *prev, const uint8_t *cur, int frame_size,
+                           uint8_t *out, uint32_t out_cap, int merge_gap);
+
+#endif // DCMV_DELTA_H
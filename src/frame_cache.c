@@ -0,0 +1,156 @@
+// frame_cache.c - associative frame slots (see frame_cache.h)
+
+#include "frame_cache.h"
+
+void frame_cache_init(frame_cache_t *c, int slots) {
+    c->slots = slots < 1 ? 1 : slots > FRAME_CACHE_MAX ? FRAME_CACHE_MAX : slots;
+    for (int s = 0; s < FRAME_CACHE_MAX; s++) {
+        atomic_store(&c->state[s], FRAME_EMPTY);
+        atomic_store(&c->unique[s], -1);
+        atomic_store(&c->used[s], 0);
+        atomic_store(&c->shown[s], 0);
+    }
+    atomic_store(&c->clock, 0);
+    c->displayed = -1;
+    atomic_store(&c->playhead, 0);
+    atomic_store(&c->hits, 0);
+    atomic_store(&c->misses, 0);
+    atomic_store(&c->evictions, 0);
+}
+
+void frame_cache_clear(frame_cache_t *c) {
+    for (int s = 0; s < c->slots; s++) {
+        int expected = FRAME_READY;
+        atomic_compare_exchange_strong(&c->state[s], &expected, FRAME_EMPTY);
+    }
+}
+
+int frame_cache_find(frame_cache_t *c, int unique) {
+    for (int s = 0; s < c->slots; s++) {
+        if (atomic_load(&c->unique[s]) == unique && FRAME_PHASE(atomic_load(&c->state[s])) != FRAME_EMPTY)
+            return s;
+    }
+    return -1;
+}
+
+int frame_cache_claim(frame_cache_t *c, int unique) {
+    // A lost race only means another pass over the slots
+    for (int attempt = 0; attempt < 4; attempt++) {
+        if (frame_cache_find(c, unique) >= 0) return -1;
+        int head = atomic_load(&c->playhead);
+        int victim = -1, kind = 3, state = FRAME_EMPTY, furthest = unique;
+        uint32_t oldest = 0;
+        for (int s = 0; s < c->slots; s++) {
+            int st = atomic_load(&c->state[s]);
+            int u = atomic_load(&c->unique[s]);
+            if (st == FRAME_EMPTY) {
+                victim = s, kind = 0, state = st;
+                break;
+            }
+            if (st != FRAME_READY) continue;         // loading, or held by the renderer or a DMA
+            uint32_t used = atomic_load(&c->used[s]);
+            if (u < head) {
+                if (kind > 1 || used < oldest) victim = s, kind = 1, state = st, oldest = used;
+            } else if (kind >= 2 && u > furthest) {
+                victim = s, kind = 2, state = st, furthest = u;
+            }
+        }
+        if (victim < 0) return -1;
+        // Fails if the renderer took a reference in between
+        if (!atomic_compare_exchange_strong(&c->state[victim], &state, FRAME_LOADING)) continue;
+        if (state == FRAME_READY) atomic_fetch_add(&c->evictions, 1);
+        atomic_store(&c->unique[victim], unique);
+        atomic_store(&c->shown[victim], 0);
+        atomic_store(&c->used[victim], atomic_fetch_add(&c->clock, 1) + 1);
+        return victim;
+    }
+    return -1;
+}
+
+void frame_cache_done(frame_cache_t *c, int slot, int ok) {
+    atomic_store(&c->state[slot], ok ? FRAME_READY : FRAME_EMPTY);
+}
+
+int frame_cache_room(frame_cache_t *c, int end) {
+    int head = atomic_load(&c->playhead), room = 0;
+    for (int s = 0; s < c->slots; s++) {
+        int st = atomic_load(&c->state[s]);
+        int u = atomic_load(&c->unique[s]);
+        if (st == FRAME_EMPTY || (st == FRAME_READY && (u < head || u >= end)))
+            room++;
+    }
+    return room;
+}
+
+int frame_cache_ready(frame_cache_t *c, int unique) {
+    for (int s = 0; s < c->slots; s++) {
+        if (atomic_load(&c->unique[s]) != unique || FRAME_PHASE(atomic_load(&c->state[s])) < FRAME_READY)
+            continue;
+        // A claimer may have finished another frame here in between
+        if (atomic_load(&c->unique[s]) == unique) return s;
+    }
+    return -1;
+}
+
+// Drop one reference. The DMA's leaves the renderer's (DISPLAYING), the
+// renderer's leaves a pending DMA as it is; the last one makes it READY.
+static void unref(frame_cache_t *c, int slot, int dma) {
+    int w = atomic_load(&c->state[slot]), n;
+    do {
+        int refs = FRAME_REFS(w) - 1;
+        int phase = refs == 0 ? FRAME_READY : dma ? FRAME_DISPLAYING : FRAME_PHASE(w);
+        n = refs << FRAME_REF_SHIFT | phase;
+    } while (!atomic_compare_exchange_weak(&c->state[slot], &w, n));
+}
+
+int frame_cache_acquire(frame_cache_t *c, int unique) {
+    int prev = c->displayed;
+    // Held slots cannot be reloaded, so the unique frame there is stable
+    if (prev >= 0 && atomic_load(&c->unique[prev]) == unique) return prev;
+
+    int slot = -1;
+    for (int attempt = 0; attempt < 4 && slot < 0; attempt++) {
+        int s = frame_cache_ready(c, unique);
+        if (s < 0) break;
+        int w = atomic_load(&c->state[s]), n;
+        do {
+            if (FRAME_PHASE(w) < FRAME_READY) break;
+            n = (FRAME_REFS(w) + 1) << FRAME_REF_SHIFT |
+                (FRAME_PHASE(w) == FRAME_READY ? FRAME_DISPLAYING : FRAME_PHASE(w));
+        } while (!atomic_compare_exchange_weak(&c->state[s], &w, n));
+        if (FRAME_PHASE(w) < FRAME_READY) continue;     // claimed from under us
+        if (atomic_load(&c->unique[s]) == unique) {
+            slot = s;
+        } else {
+            unref(c, s, 0);                               // reloaded with another frame
+        }
+    }
+    if (prev >= 0) unref(c, prev, 0);
+    c->displayed = slot;
+    return slot;
+}
+
+void frame_cache_dma_begin(frame_cache_t *c, int slot) {
+    int w = atomic_load(&c->state[slot]);
+    while (!atomic_compare_exchange_weak(&c->state[slot], &w,
+                                         (FRAME_REFS(w) + 1) << FRAME_REF_SHIFT | FRAME_DMA_PENDING))
+        ;
+}
+
+void frame_cache_dma_done(frame_cache_t *c, int slot) {
+    unref(c, slot, 1);
+}
+
+int frame_cache_refs(frame_cache_t *c, int slot) {
+    return FRAME_REFS(atomic_load(&c->state[slot]));
+}
+
+void frame_cache_show(frame_cache_t *c, int slot) {
+    atomic_store(&c->used[slot], atomic_fetch_add(&c->clock, 1) + 1);
+    if (atomic_exchange(&c->shown[slot], 1)) atomic_fetch_add(&c->hits, 1);
+    else atomic_fetch_add(&c->misses, 1);
+}
+
+void frame_cache_set_playhead(frame_cache_t *c, int unique) {
+    atomic_store(&c->playhead, unique);
+}
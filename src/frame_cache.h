@@ -0,0 +1,101 @@
+// frame_cache.h - decoded frame slots keyed by unique frame number
+//
+// Any slot can hold any unique frame, so the frames the preload window needs
+// never collide on a slot, and a loop back into frames played a few seconds
+// ago finds them still decoded. A claim reuses, in order: an empty slot, the
+// least recently used frame behind the play head, then the frame furthest
+// ahead if it is further ahead than the one asked for.
+//
+// Slot lifecycle:
+//
+//   EMPTY -claim-> LOADING -done-> READY -acquire-> DISPLAYING
+//                                    ^                  | dma_begin
+//                                    |                  v
+//                                    +-- last ref -- DMA_PENDING
+//
+// A decoded slot carries a reference count next to its phase, in one word:
+// the renderer holds one for the frame on screen until it acquires another,
+// a texture upload one until its completion callback. Only EMPTY and READY
+// slots (no references) can be claimed, so nobody decodes into a buffer the
+// DMA engine is still reading, and a slot is free again as soon as the last
+// reference goes instead of after a fixed delay.
+//
+// Lock-free: slots change hands by compare-and-swap. Any thread may claim;
+// one thread (the renderer) acquires and moves the play head; dma_done may
+// run in an interrupt.
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define FRAME_CACHE_MAX 64
+
+enum {
+    FRAME_EMPTY = 0,
+    FRAME_LOADING = 1,
+    FRAME_READY = 2,
+    FRAME_DISPLAYING = 3,
+    FRAME_DMA_PENDING = 4
+};
+
+#define FRAME_REF_SHIFT 4
+#define FRAME_PHASE(w)  ((w) & ((1 << FRAME_REF_SHIFT) - 1))
+#define FRAME_REFS(w)   ((w) >> FRAME_REF_SHIFT)
+
+typedef struct {
+    int slots;
+    atomic_int state[FRAME_CACHE_MAX];     // refs << FRAME_REF_SHIFT | phase
+    atomic_int unique[FRAME_CACHE_MAX];
+    atomic_uint used[FRAME_CACHE_MAX];     // LRU stamp
+    atomic_int shown[FRAME_CACHE_MAX];     // displayed since it was loaded
+    atomic_uint clock;
+    int displayed;                         // slot the renderer holds, -1 = none; renderer only
+    atomic_int playhead;                   // unique frame being played
+    atomic_uint hits, misses;              // frames displayed again without a reload / after one
+    atomic_uint evictions;                 // READY frames given up for another
+} frame_cache_t;
+
+void frame_cache_init(frame_cache_t *c, int slots);
+
+// Every READY slot back to EMPTY; loading and held ones stay.
+void frame_cache_clear(frame_cache_t *c);
+
+// Slot holding or loading `unique`, or -1.
+int frame_cache_find(frame_cache_t *c, int unique);
+
+// Slot to load `unique` into, now LOADING and owned by the caller; -1 if the
+// frame is already cached or every slot is worth more.
+int frame_cache_claim(frame_cache_t *c, int unique);
+
+// Hand a claimed slot back: READY if the load worked, else EMPTY.
+void frame_cache_done(frame_cache_t *c, int slot, int ok);
+
+// Slots a claim could take right now for frames between the play head and
+// `end` (exclusive).
+int frame_cache_room(frame_cache_t *c, int end);
+
+// Slot holding `unique` decoded (READY or held), or -1. Takes no reference.
+int frame_cache_ready(frame_cache_t *c, int unique);
+
+// Renderer side. Returns the slot of `unique` with a reference held until the
+// next acquire of another frame, or -1 if it is not decoded. Either way the
+// previous frame's reference is dropped.
+int frame_cache_acquire(frame_cache_t *c, int unique);
+
+// Renderer side: a DMA from a slot it holds is starting. The slot keeps a
+// reference until frame_cache_dma_done, which the completion callback calls.
+// One upload per slot at a time.
+void frame_cache_dma_begin(frame_cache_t *c, int slot);
+void frame_cache_dma_done(frame_cache_t *c, int slot);
+
+// References on a slot right now, for checks and logs.
+int frame_cache_refs(frame_cache_t *c, int slot);
+
+// Renderer side: a slot from frame_cache_acquire went on screen for the first
+// time at this play head. Counts a hit if it had been shown before.
+void frame_cache_show(frame_cache_t *c, int slot);
+
+void frame_cache_set_playhead(frame_cache_t *c, int unique);
+
+#endif // FRAME_CACHE_H
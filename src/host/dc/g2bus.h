@@ -0,0 +1,5 @@
+// dc/g2bus.h - host shim, see kos.h
+#ifndef SINGE_HOST_DC_G2BUS_H
+#define SINGE_HOST_DC_G2BUS_H
+#include <kos.h>
+#endif
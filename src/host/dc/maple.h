@@ -0,0 +1,5 @@
+// dc/maple.h - host shim, see kos.h
+#ifndef SINGE_HOST_DC_MAPLE_H
+#define SINGE_HOST_DC_MAPLE_H
+#include <kos.h>
+#endif
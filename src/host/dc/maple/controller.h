@@ -0,0 +1,5 @@
+// dc/maple/controller.h - host shim, see kos.h
+#ifndef SINGE_HOST_DC_MAPLE_CONTROLLER_H
+#define SINGE_HOST_DC_MAPLE_CONTROLLER_H
+#include <kos.h>
+#endif
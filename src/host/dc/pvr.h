@@ -0,0 +1,5 @@
+// dc/pvr.h - host shim, see kos.h
+#ifndef SINGE_HOST_DC_PVR_H
+#define SINGE_HOST_DC_PVR_H
+#include <kos.h>
+#endif
@@ -0,0 +1,5 @@
+// dc/sound/aica_comm.h - host shim, see kos.h
+#ifndef SINGE_HOST_DC_SOUND_AICA_COMM_H
+#define SINGE_HOST_DC_SOUND_AICA_COMM_H
+#include <kos.h>
+#endif
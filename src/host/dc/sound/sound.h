@@ -0,0 +1,5 @@
+// dc/sound/sound.h - host shim, see kos.h
+#ifndef SINGE_HOST_DC_SOUND_SOUND_H
+#define SINGE_HOST_DC_SOUND_SOUND_H
+#include <kos.h>
+#endif
@@ -0,0 +1,5 @@
+// dc/sound/stream.h - host shim, see kos.h
+#ifndef SINGE_HOST_DC_SOUND_STREAM_H
+#define SINGE_HOST_DC_SOUND_STREAM_H
+#include <kos.h>
+#endif
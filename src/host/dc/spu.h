@@ -0,0 +1,5 @@
+// dc/spu.h - host shim, see kos.h
+#ifndef SINGE_HOST_DC_SPU_H
+#define SINGE_HOST_DC_SPU_H
+#include <kos.h>
+#endif
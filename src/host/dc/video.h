@@ -0,0 +1,5 @@
+// dc/video.h - host shim, see kos.h
+#ifndef SINGE_HOST_DC_VIDEO_H
+#define SINGE_HOST_DC_VIDEO_H
+#include <kos.h>
+#endif
@@ -0,0 +1,12 @@
+// host_internal.h - shared bits between the host shim translation units
+#ifndef SINGE_HOST_INTERNAL_H
+#define SINGE_HOST_INTERNAL_H
+
+void host_fs_report(void);
+void host_pvr_report(void);
+void host_snd_report(void);
+
+// SPU RAM and AICA channel registers behind g2_read_32
+uint32_t host_spu_read_32(uintptr_t address);
+
+#endif
@@ -0,0 +1,354 @@
+// kos.h - Linux host stand-in for the KallistiOS API used by DCSinge
+//
+// Only the parts of KOS the engine actually touches live here. Files go to
+// POSIX, threads and mutexes to pthreads, the PVR records what it is fed
+// (pvr_host.c) and the sound stream pulls audio_cb at the real ADPCM rate
+// (snd_host.c). Everything else is a harmless stub so singe_dreamcast.c
+// compiles unchanged for perf/valgrind/TSan runs on a desktop.
+#ifndef SINGE_HOST_KOS_H
+#define SINGE_HOST_KOS_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <malloc.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#define SINGE_HOST 1
+
+// ---------------------------------------------------------------------------
+// Host runtime knobs (environment)
+//   SINGE_HOST_ROOT    directory that /pc, /cd and /rd map to (default ".")
+//   SINGE_HOST_FRAMES  exit cleanly after this many PVR scenes (0 = never)
+//   SINGE_HOST_TRACE   file that receives one line per submitted primitive
+// ---------------------------------------------------------------------------
+void host_report(void);
+
+// --- Filesystem (kos_host.c) ------------------------------------------------
+typedef int file_t;
+#define FILEHND_INVALID ((file_t)-1)
+
+file_t  fs_open(const char *fn, int mode);
+int     fs_close(file_t fd);
+ssize_t fs_read(file_t fd, void *buf, size_t cnt);
+ssize_t fs_write(file_t fd, const void *buf, size_t cnt);
+off_t   fs_seek(file_t fd, off_t offset, int whence);
+off_t   fs_tell(file_t fd);
+size_t  fs_total(file_t fd);
+int     fs_chdir(const char *fn);
+
+// --- Threads / mutexes (kos_host.c) ----------------------------------------
+typedef struct kthread kthread_t;
+
+kthread_t *thd_create(bool detach, void *(*routine)(void *param), void *param);
+int  thd_join(kthread_t *thd, void **value_ptr);
+int  thd_destroy(kthread_t *thd);
+void thd_sleep(unsigned int ms);
+void thd_pass(void);
+
+// Priorities are recorded only; the host scheduler treats threads alike
+typedef int prio_t;
+#define PRIO_DEFAULT 10
+int  thd_set_prio(kthread_t *thd, prio_t prio);
+
+// CPU time a thread has been scheduled for, in ns (the thread's CPU clock)
+kthread_t *thd_get_current(void);
+uint64_t thd_get_cpu_time(kthread_t *thd);
+
+typedef pthread_mutex_t mutex_t;
+#define MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+
+static inline int mutex_lock(mutex_t *m)    { return pthread_mutex_lock(m); }
+static inline int mutex_unlock(mutex_t *m)  { return pthread_mutex_unlock(m); }
+static inline int mutex_trylock(mutex_t *m) { return pthread_mutex_trylock(m); }
+
+typedef pthread_cond_t condvar_t;
+#define COND_INITIALIZER PTHREAD_COND_INITIALIZER
+
+static inline int cond_signal(condvar_t *cv)    { return pthread_cond_signal(cv); }
+static inline int cond_broadcast(condvar_t *cv) { return pthread_cond_broadcast(cv); }
+// Waits at most timeout ms (0 = forever); -1 with errno ETIMEDOUT when it ran out
+int cond_wait_timed(condvar_t *cv, mutex_t *m, int timeout);
+
+// --- Timers / G2 bus (kos_host.c) ------------------------------------------
+// psTimer() reads the AICA sample clock at SPU RAM 0x21000; the host backs
+// that word with a monotonic clock ticking at the same 4410 Hz.
+#define SPU_RAM_BASE          0x00800000
+#define SPU_RAM_UNCACHED_BASE 0xa0800000
+
+uint32_t g2_read_32(uintptr_t address);
+void     g2_write_32(uintptr_t address, uint32_t value);
+uint64_t timer_ms_gettime64(void);
+uint64_t timer_us_gettime64(void);
+
+// --- Misc arch -------------------------------------------------------------
+#define DBG_INFO 6
+void dbglog(int level, const char *fmt, ...);
+void arch_exit(void) __attribute__((noreturn));
+
+static inline void *memcpy_fast(void *d, const void *s, size_t n)  { return memcpy(d, s, n); }
+static inline void *memmove_fast(void *d, const void *s, size_t n) { return memmove(d, s, n); }
+static inline void *memset_fast(void *d, int v, size_t n)          { return memset(d, v, n); }
+
+static inline float fsin(float x)   { return sinf(x); }
+static inline float fcos(float x)   { return cosf(x); }
+static inline float frsqrt(float x) { return 1.0f / sqrtf(x); }
+
+#define FLASHROM_REGION_UNKNOWN 0
+#define FLASHROM_REGION_JAPAN   1
+#define FLASHROM_REGION_US      2
+#define FLASHROM_REGION_EUROPE  3
+int flashrom_get_region(void);
+
+// --- Video -------------------------------------------------------------------
+#define DM_640x480_NTSC_IL 1
+#define DM_640x480_PAL_IL  2
+#define PM_RGB565          1
+#define CT_VGA             0
+#define CT_RGB             2
+#define CT_COMPOSITE       3
+
+extern uint16_t *vram_s;
+void vid_set_mode(int dm, int pm);
+int  vid_check_cable(void);
+int  vid_screen_shot(const char *destfn);
+void bfont_draw_str(void *buffer, uint32_t bufwidth, bool opaque, const char *str);
+
+// --- PVR (pvr_host.c) --------------------------------------------------------
+typedef void *pvr_ptr_t;
+
+typedef struct {
+    uint32_t cmd, mode1, mode2, mode3;
+    uint32_t d1, d2, d3, d4;
+} pvr_poly_hdr_t;
+
+typedef struct {
+    uint32_t flags;
+    float x, y, z;
+    float u, v;
+    uint32_t argb, oargb;
+} pvr_vertex_t;
+
+typedef struct {
+    int list_type;
+    struct {
+        int alpha, shading, fog_type, culling, color_clamp;
+        int clip_mode, modifier_mode, specular, alpha2, fog_type2, color_clamp2;
+    } gen;
+    struct {
+        int src, dst, src_enable, dst_enable;
+        int src2, dst2, src_enable2, dst_enable2;
+    } blend;
+    struct { int color, uv, modifier; } fmt;
+    struct { int comparison, write; } depth;
+    struct {
+        int enable, filter, mipmap, mipmap_bias, uv_flip, uv_clamp;
+        int alpha, env, width, height, format;
+        pvr_ptr_t base;
+    } txr;
+} pvr_poly_cxt_t;
+
+typedef struct { int list; } pvr_dr_state_t;
+typedef void (*pvr_dma_callback_t)(void *data);
+
+#define PVR_LIST_OP_POLY  0
+#define PVR_LIST_OP_MOD   1
+#define PVR_LIST_TR_POLY  2
+#define PVR_LIST_TR_MOD   3
+#define PVR_LIST_PT_POLY  4
+
+#define PVR_CMD_POLYHDR    0x80840000
+#define PVR_CMD_VERTEX     0xe0000000
+#define PVR_CMD_VERTEX_EOL 0xf0000000
+
+#define PVR_TXRFMT_ARGB1555    (0 << 27)
+#define PVR_TXRFMT_RGB565      (1 << 27)
+#define PVR_TXRFMT_ARGB4444    (2 << 27)
+#define PVR_TXRFMT_YUV422      (3 << 27)
+#define PVR_TXRFMT_TWIDDLED    (0 << 26)
+#define PVR_TXRFMT_NONTWIDDLED (1 << 26)
+#define PVR_TXRFMT_VQ_ENABLE   (1 << 30)
+
+#define PVR_FILTER_NONE     0
+#define PVR_FILTER_BILINEAR 2
+#define PVR_ALPHA_DISABLE   0
+#define PVR_ALPHA_ENABLE    1
+#define PVR_CULLING_NONE    0
+#define PVR_BLEND_DISABLE   0
+#define PVR_BLEND_ENABLE    1
+#define PVR_BLEND_SRCALPHA    4
+#define PVR_BLEND_INVSRCALPHA 5
+
+#define PVR_TEXTURE_MODULO 0x00e4
+#define PVR_SET(reg, value) pvr_host_set_reg((reg), (uint32_t)(value))
+void pvr_host_set_reg(uint32_t reg, uint32_t value);
+
+// The TA input window; SQ copies aimed here are recorded instead of copied.
+#define PVR_TA_INPUT       ((uintptr_t)0x10000000)
+#define SQ_MASK_DEST(dest) ((void *)(uintptr_t)(dest))
+void *sq_fast_cpy(void *dest, const void *src, size_t n);
+
+int  pvr_init_defaults(void);
+int  pvr_scene_begin(void);
+int  pvr_scene_finish(void);
+int  pvr_list_begin(int list);
+int  pvr_list_finish(void);
+int  pvr_prim(const void *data, size_t size);
+void pvr_dr_init(pvr_dr_state_t *state);
+void pvr_dr_commit(void *addr);
+
+void pvr_poly_cxt_col(pvr_poly_cxt_t *dst, int list);
+void pvr_poly_cxt_txr(pvr_poly_cxt_t *dst, int list, int textureformat,
+                      int tw, int th, pvr_ptr_t textureaddr, int filtering);
+void pvr_poly_compile(pvr_poly_hdr_t *dst, const pvr_poly_cxt_t *src);
+
+pvr_ptr_t pvr_mem_malloc(size_t size);
+void pvr_mem_free(pvr_ptr_t chunk);
+void pvr_txr_load(const void *src, pvr_ptr_t dst, size_t count);
+int  pvr_txr_load_dma(const void *src, pvr_ptr_t dest, size_t count, int block,
+                      pvr_dma_callback_t callback, void *cbdata);
+int  pvr_dma_ready(void);
+
+// --- Sound (snd_host.c) ------------------------------------------------------
+typedef int snd_stream_hnd_t;
+typedef uint32_t sfxhnd_t;
+#define SND_STREAM_INVALID -1
+#define SFXHND_INVALID 0
+
+typedef void *(*snd_stream_callback_t)(snd_stream_hnd_t hnd, int smp_req, int *smp_recv);
+typedef size_t (*snd_stream_callback_direct_t)(snd_stream_hnd_t hnd, uintptr_t left,
+                                               uintptr_t right, size_t size_req);
+
+int  snd_stream_init(void);
+int  snd_stream_init_ex(int channels, size_t buffer_size);
+void snd_stream_shutdown(void);
+snd_stream_hnd_t snd_stream_alloc(snd_stream_callback_t cb, int bufsize);
+void snd_stream_set_callback(snd_stream_hnd_t hnd, snd_stream_callback_t cb);
+void snd_stream_set_callback_direct(snd_stream_hnd_t hnd, snd_stream_callback_direct_t cb);
+void snd_stream_reinit(snd_stream_hnd_t hnd, snd_stream_callback_t cb);
+void snd_stream_queue_enable(snd_stream_hnd_t hnd);
+void snd_stream_start_adpcm(snd_stream_hnd_t hnd, uint32_t freq, int st);
+void snd_stream_stop(snd_stream_hnd_t hnd);
+int  snd_stream_poll(snd_stream_hnd_t hnd);
+
+int      snd_mem_init(uint32_t reserve);
+sfxhnd_t snd_sfx_load(const char *fn);
+sfxhnd_t snd_sfx_load_raw_buf(char *buf, size_t len, uint32_t rate, uint16_t bitsize, uint16_t channels);
+int      snd_sfx_play(sfxhnd_t idx, int vol, int pan);
+
+// --- SPU RAM and AICA channels (snd_host.c) -----------------------------------
+// What direct AICA streaming uses: SPU RAM allocation, G2 DMA into it, channel
+// commands to the sound driver and the play position it reports. The host
+// keeps a simulated 2 MB of SPU RAM and advances each started channel's
+// position in real time, wrapping at its loop end.
+#define SPU_RAM_UNCACHED_BASE 0xa0800000
+#define AICA_MEM_CHANNELS     0x020000
+
+typedef void (*g2_dma_callback_t)(void *data);
+
+typedef struct aica_cmd {
+    uint32_t size;              // in 32-bit words, header included
+    uint32_t cmd;
+    uint32_t timestamp;
+    uint32_t cmd_id;            // channel for AICA_CMD_CHAN
+    uint32_t misc[4];
+    uint8_t  cmd_data[];
+} aica_cmd_t;
+
+typedef struct aica_channel {
+    uint32_t cmd;
+    uint32_t base;              // sample data in SPU RAM
+    uint32_t type;
+    uint32_t length;            // samples
+    uint32_t loop;
+    uint32_t loopstart;
+    uint32_t loopend;
+    uint32_t freq;
+    uint32_t vol;               // 0-255
+    uint32_t pan;               // 0-255
+    uint32_t pos;               // play position in samples, written by the driver
+    uint32_t pad[5];
+} aica_channel_t;
+
+#define AICA_CMD_CHAN       0x00000003
+#define AICA_CH_CMD_START   0x00000001
+#define AICA_CH_CMD_STOP    0x00000002
+#define AICA_CH_START_DELAY 0x00100000
+#define AICA_CH_START_SYNC  0x00200000
+#define AICA_SM_ADPCM_LS    3
+
+#define AICA_CHANNEL(x) (AICA_MEM_CHANNELS + (x) * sizeof(aica_channel_t))
+#define AICA_CMDSTR_CHANNEL(T, CMDR, CHANR) \
+    uint8_t T[sizeof(aica_cmd_t) + sizeof(aica_channel_t)]; \
+    aica_cmd_t *CMDR = (aica_cmd_t *)T; \
+    aica_channel_t *CHANR = (aica_channel_t *)(CMDR->cmd_data)
+#define AICA_CMDSTR_CHANNEL_SIZE ((sizeof(aica_cmd_t) + sizeof(aica_channel_t)) / 4)
+
+uint32_t snd_mem_malloc(size_t size);
+void     snd_mem_free(uint32_t addr);
+int      snd_sfx_chn_alloc(void);
+void     snd_sfx_chn_free(int chn);
+void     snd_sh4_to_aica(void *packet, uint32_t size);
+int      spu_dma_transfer(void *from, uintptr_t dest, size_t length, int block,
+                          g2_dma_callback_t callback, void *cbdata);
+void     spu_memload(uintptr_t to, void *from, size_t length);
+
+// The host's DMA is a memcpy, nothing to write back
+static inline void dcache_flush_range(uintptr_t start, size_t count) { (void)start; (void)count; }
+
+int mp3_init(void);
+int mp3_start(const char *fn, int loop);
+int mp3_stop(void);
+int mp3_shutdown(void);
+
+// --- Maple -------------------------------------------------------------------
+#define MAPLE_FUNC_CONTROLLER 0x01000000
+
+#define CONT_C          (1 << 0)
+#define CONT_B          (1 << 1)
+#define CONT_A          (1 << 2)
+#define CONT_START      (1 << 3)
+#define CONT_DPAD_UP    (1 << 4)
+#define CONT_DPAD_DOWN  (1 << 5)
+#define CONT_DPAD_LEFT  (1 << 6)
+#define CONT_DPAD_RIGHT (1 << 7)
+#define CONT_Z          (1 << 8)
+#define CONT_Y          (1 << 9)
+#define CONT_X          (1 << 10)
+#define CONT_D          (1 << 11)
+
+typedef struct {
+    uint32_t buttons;
+    int ltrig, rtrig;
+    int joyx, joyy;
+    int joy2x, joy2y;
+} cont_state_t;
+
+typedef struct maple_device {
+    bool valid;
+    int port, unit;
+    bool status_valid;
+    cont_state_t status;
+} maple_device_t;
+
+typedef void (*cont_btn_callback_t)(uint8_t addr, uint32_t btns);
+
+maple_device_t *maple_enum_type(int n, uint32_t func);
+void *maple_dev_status(maple_device_t *dev);
+int cont_btn_callback(uint8_t addr, uint32_t btns, cont_btn_callback_t cb);
+
+#endif // SINGE_HOST_KOS_H
@@ -0,0 +1,5 @@
+// kos/fs.h - host shim, see kos.h
+#ifndef SINGE_HOST_KOS_FS_H
+#define SINGE_HOST_KOS_FS_H
+#include <kos.h>
+#endif
@@ -0,0 +1,391 @@
+// kos_host.c - POSIX/pthreads backing for the KOS host shim (see kos.h)
+//
+// /pc/, /cd/ and /rd/ prefixes all resolve under SINGE_HOST_ROOT so the same
+// singe.cfg and data/ layout used with dcload work unchanged on a desktop.
+
+#include <kos.h>
+#include <png/png.h>
+#include "host_internal.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <png.h>
+
+// ---------------------------------------------------------------------------
+// Paths
+// ---------------------------------------------------------------------------
+static char host_cwd[PATH_MAX] = "/";
+
+static const char *host_root(void) {
+    const char *root = getenv("SINGE_HOST_ROOT");
+    return (root && *root) ? root : ".";
+}
+
+// Turn a KOS path (absolute or relative to the fs_chdir() directory) into a
+// host path. "/pc/data/x" and "/cd/data/x" both become "$ROOT/data/x".
+// Fails with ENAMETOOLONG rather than open a truncated path.
+static int host_map_path(const char *fn, char *out, size_t outsz) {
+    char full[PATH_MAX];
+    int n;
+    if (fn[0] == '/')
+        n = snprintf(full, sizeof(full), "%s", fn);
+    else
+        n = snprintf(full, sizeof(full), "%s%s%s", host_cwd,
+                     host_cwd[strlen(host_cwd) - 1] == '/' ? "" : "/", fn);
+    if (n < 0 || (size_t)n >= sizeof(full)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    const char *rest = full;
+    if (!strncmp(rest, "/pc/", 4) || !strncmp(rest, "/cd/", 4) || !strncmp(rest, "/rd/", 4))
+        rest += 4;
+    else if (!strcmp(rest, "/pc") || !strcmp(rest, "/cd") || !strcmp(rest, "/rd"))
+        rest += 3;
+    while (*rest == '/') rest++;
+
+    n = snprintf(out, outsz, "%s/%s", host_root(), rest);
+    if (n < 0 || (size_t)n >= outsz) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Filesystem
+// ---------------------------------------------------------------------------
+static atomic_ulong host_fs_reads;
+static atomic_ulong host_fs_read_bytes;
+static atomic_ulong host_fs_seeks;
+
+file_t fs_open(const char *fn, int mode) {
+    char path[PATH_MAX];
+    if (host_map_path(fn, path, sizeof(path)) < 0)
+        return FILEHND_INVALID;
+    // KOS opens directories with O_DIR; the engine only probes them for
+    // existence, which a plain O_RDONLY open of a directory also answers.
+    // Writes create the file, as /pc does under dcload.
+    int flags = mode & O_ACCMODE;
+    if (flags != O_RDONLY) flags |= O_CREAT | (mode & (O_TRUNC | O_APPEND));
+    int fd = open(path, flags, 0644);
+    return fd < 0 ? FILEHND_INVALID : fd;
+}
+
+int fs_close(file_t fd) {
+    return close(fd);
+}
+
+ssize_t fs_read(file_t fd, void *buf, size_t cnt) {
+    size_t done = 0;
+    while (done < cnt) {
+        ssize_t r = read(fd, (char *)buf + done, cnt - done);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return done ? (ssize_t)done : -1;
+        }
+        if (r == 0) break;
+        done += (size_t)r;
+    }
+    atomic_fetch_add(&host_fs_reads, 1);
+    atomic_fetch_add(&host_fs_read_bytes, done);
+    return (ssize_t)done;
+}
+
+ssize_t fs_write(file_t fd, const void *buf, size_t cnt) {
+    size_t done = 0;
+    while (done < cnt) {
+        ssize_t r = write(fd, (const char *)buf + done, cnt - done);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return done ? (ssize_t)done : -1;
+        }
+        done += (size_t)r;
+    }
+    return (ssize_t)done;
+}
+
+off_t fs_seek(file_t fd, off_t offset, int whence) {
+    atomic_fetch_add(&host_fs_seeks, 1);
+    return lseek(fd, offset, whence);
+}
+
+off_t fs_tell(file_t fd) {
+    return lseek(fd, 0, SEEK_CUR);
+}
+
+size_t fs_total(file_t fd) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) return (size_t)-1;
+    return (size_t)st.st_size;
+}
+
+int fs_chdir(const char *fn) {
+    char next[PATH_MAX];
+    int n;
+    if (fn[0] == '/')
+        n = snprintf(next, sizeof(next), "%s", fn);
+    else
+        n = snprintf(next, sizeof(next), "%s%s%s", host_cwd,
+                     host_cwd[strlen(host_cwd) - 1] == '/' ? "" : "/", fn);
+    if (n < 0 || (size_t)n >= sizeof(next)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memcpy(host_cwd, next, (size_t)n + 1);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Threads
+// ---------------------------------------------------------------------------
+struct kthread {
+    pthread_t tid;
+    bool detached;
+    prio_t prio;
+};
+
+// Each thread learns its kthread_t before running, for thd_get_current
+static __thread kthread_t *host_self;
+
+typedef struct {
+    kthread_t *thd;
+    void *(*routine)(void *param);
+    void *param;
+} host_thread_start_t;
+
+static void *host_thread_start(void *arg) {
+    host_thread_start_t start = *(host_thread_start_t *)arg;
+    free(arg);
+    host_self = start.thd;
+    return start.routine(start.param);
+}
+
+kthread_t *thd_create(bool detach, void *(*routine)(void *param), void *param) {
+    kthread_t *t = calloc(1, sizeof(*t));
+    host_thread_start_t *start = malloc(sizeof(*start));
+    if (!t || !start) {
+        free(t);
+        free(start);
+        return NULL;
+    }
+    *start = (host_thread_start_t){ t, routine, param };
+    if (pthread_create(&t->tid, NULL, host_thread_start, start) != 0) {
+        free(t);
+        free(start);
+        return NULL;
+    }
+    t->detached = detach;
+    t->prio = PRIO_DEFAULT;
+    if (detach) pthread_detach(t->tid);
+    return t;
+}
+
+int thd_join(kthread_t *thd, void **value_ptr) {
+    if (!thd || thd->detached) return -1;
+    int r = pthread_join(thd->tid, value_ptr);
+    free(thd);
+    return r;
+}
+
+int thd_destroy(kthread_t *thd) {
+    // KOS kills the thread outright; the engine never relies on that, so the
+    // host just forgets about it.
+    (void)thd;
+    return 0;
+}
+
+void thd_sleep(unsigned int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {}
+}
+
+void thd_pass(void) {
+    sched_yield();
+}
+
+int thd_set_prio(kthread_t *thd, prio_t prio) {
+    if (!thd) return -1;
+    thd->prio = prio;
+    return 0;
+}
+
+kthread_t *thd_get_current(void) {
+    // The main thread was not made by thd_create
+    static kthread_t main_thread;
+    if (!host_self) {
+        main_thread.tid = pthread_self();
+        main_thread.prio = PRIO_DEFAULT;
+        host_self = &main_thread;
+    }
+    return host_self;
+}
+
+uint64_t thd_get_cpu_time(kthread_t *thd) {
+    clockid_t clock;
+    struct timespec ts;
+    if (!thd) return 0;
+    if (thd == host_self) clock = CLOCK_THREAD_CPUTIME_ID;
+    else if (pthread_getcpuclockid(thd->tid, &clock) != 0) return 0;
+    if (clock_gettime(clock, &ts) != 0) return 0;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int cond_wait_timed(condvar_t *cv, mutex_t *m, int timeout) {
+    if (timeout <= 0) return pthread_cond_wait(cv, m) ? -1 : 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout / 1000;
+    ts.tv_nsec += (long)(timeout % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    int r = pthread_cond_timedwait(cv, m, &ts);
+    if (r == 0) return 0;
+    errno = r;
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// Timers / G2
+// ---------------------------------------------------------------------------
+static struct timespec host_t0;
+static pthread_once_t host_t0_once = PTHREAD_ONCE_INIT;
+
+static void host_init_t0(void) {
+    clock_gettime(CLOCK_MONOTONIC, &host_t0);
+}
+
+static uint64_t host_now_us(void) {
+    pthread_once(&host_t0_once, host_init_t0);
+    struct timespec t0 = host_t0;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(ts.tv_sec - t0.tv_sec) * 1000000ULL +
+           (uint64_t)((ts.tv_nsec - t0.tv_nsec) / 1000);
+}
+
+uint64_t timer_us_gettime64(void) { return host_now_us(); }
+uint64_t timer_ms_gettime64(void) { return host_now_us() / 1000; }
+
+#define AICA_MEM_CLOCK 0x021000
+
+uint32_t g2_read_32(uintptr_t address) {
+    if (address == SPU_RAM_UNCACHED_BASE + AICA_MEM_CLOCK ||
+        address == SPU_RAM_BASE + AICA_MEM_CLOCK)
+        return (uint32_t)(host_now_us() * 441 / 100000);   // 4410 ticks/s
+    return host_spu_read_32(address);
+}
+
+void g2_write_32(uintptr_t address, uint32_t value) {
+    (void)address; (void)value;
+}
+
+// ---------------------------------------------------------------------------
+// Misc arch / video / maple
+// ---------------------------------------------------------------------------
+void dbglog(int level, const char *fmt, ...) {
+    (void)level;
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+void arch_exit(void) {
+    exit(0);
+}
+
+int flashrom_get_region(void) { return FLASHROM_REGION_US; }
+
+static uint16_t host_fb[640 * 480];
+uint16_t *vram_s = host_fb;
+
+void vid_set_mode(int dm, int pm) { (void)dm; (void)pm; }
+int  vid_check_cable(void) { return CT_VGA; }
+int  vid_screen_shot(const char *destfn) { (void)destfn; return 0; }
+
+void bfont_draw_str(void *buffer, uint32_t bufwidth, bool opaque, const char *str) {
+    (void)buffer; (void)bufwidth; (void)opaque;
+    printf("[bfont] %s\n", str);
+}
+
+// No pads on the host; scripts run on their own timeline.
+maple_device_t *maple_enum_type(int n, uint32_t func) {
+    (void)n; (void)func;
+    return NULL;
+}
+
+void *maple_dev_status(maple_device_t *dev) {
+    return dev ? &dev->status : NULL;
+}
+
+int cont_btn_callback(uint8_t addr, uint32_t btns, cont_btn_callback_t cb) {
+    (void)addr; (void)btns; (void)cb;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// PNG -> ARGB4444 texture (mirrors the KOS png port's PNG_FULL_ALPHA path)
+// ---------------------------------------------------------------------------
+int png_load_texture(const char *filename, pvr_ptr_t *tex, uint32_t alpha,
+                     uint32_t *w, uint32_t *h) {
+    char path[PATH_MAX];
+    if (host_map_path(filename, path, sizeof(path)) < 0)
+        return -1;
+
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, path))
+        return -1;
+
+    image.format = PNG_FORMAT_RGBA;
+    uint8_t *rgba = malloc(PNG_IMAGE_SIZE(image));
+    if (!rgba || !png_image_finish_read(&image, NULL, rgba, 0, NULL)) {
+        free(rgba);
+        png_image_free(&image);
+        return -1;
+    }
+
+    uint32_t tw = 1, th = 1;
+    while (tw < image.width)  tw <<= 1;
+    while (th < image.height) th <<= 1;
+
+    uint16_t *txr = calloc(tw * th, sizeof(uint16_t));
+    if (!txr) {
+        free(rgba);
+        return -1;
+    }
+    for (uint32_t y = 0; y < image.height; y++) {
+        for (uint32_t x = 0; x < image.width; x++) {
+            const uint8_t *p = rgba + (y * image.width + x) * 4;
+            uint16_t a = (alpha == PNG_NO_ALPHA) ? 0xf : (p[3] >> 4);
+            if (alpha == PNG_MASK_ALPHA) a = p[3] ? 0xf : 0;
+            txr[y * tw + x] = (uint16_t)((a << 12) | ((p[0] >> 4) << 8) |
+                                         ((p[1] >> 4) << 4) | (p[2] >> 4));
+        }
+    }
+
+    *tex = pvr_mem_malloc(tw * th * 2);
+    if (*tex) pvr_txr_load(txr, *tex, tw * th * 2);
+    *w = tw;
+    *h = th;
+
+    free(txr);
+    free(rgba);
+    return *tex ? 0 : -1;
+}
+
+// ---------------------------------------------------------------------------
+// Exit report
+// ---------------------------------------------------------------------------
+void host_fs_report(void) {
+    printf("[host] fs: %lu reads, %lu bytes, %lu seeks\n",
+           atomic_load(&host_fs_reads), atomic_load(&host_fs_read_bytes),
+           atomic_load(&host_fs_seeks));
+}
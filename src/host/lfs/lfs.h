@@ -0,0 +1,6 @@
+// lfs/lfs.h - host shim for the LuaFileSystem port (lfs_host.c)
+#ifndef SINGE_HOST_LFS_H
+#define SINGE_HOST_LFS_H
+#include <lua.h>
+int luaopen_lfs(lua_State *L);
+#endif
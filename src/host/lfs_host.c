@@ -0,0 +1,48 @@
+// lfs_host.c - minimal LuaFileSystem for the host build
+//
+// The Dreamcast links the lfs port from kos-ports; scripts only use it to
+// probe for files, so the host provides currentdir() and attributes().
+
+#include <kos.h>
+#include <lfs/lfs.h>
+#include <lauxlib.h>
+#include <sys/stat.h>
+
+static int lfs_host_currentdir(lua_State *L) {
+    char buf[1024];
+    if (!getcwd(buf, sizeof(buf))) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushstring(L, buf);
+    return 1;
+}
+
+static int lfs_host_attributes(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        lua_pushnil(L);
+        lua_pushstring(L, "cannot obtain information from file");
+        return 2;
+    }
+    lua_newtable(L);
+    lua_pushstring(L, S_ISDIR(st.st_mode) ? "directory" : "file");
+    lua_setfield(L, -2, "mode");
+    lua_pushinteger(L, (lua_Integer)st.st_size);
+    lua_setfield(L, -2, "size");
+    lua_pushinteger(L, (lua_Integer)st.st_mtime);
+    lua_setfield(L, -2, "modification");
+    return 1;
+}
+
+static const luaL_Reg lfs_host_funcs[] = {
+    { "currentdir", lfs_host_currentdir },
+    { "attributes", lfs_host_attributes },
+    { NULL, NULL }
+};
+
+int luaopen_lfs(lua_State *L) {
+    luaL_newlib(L, lfs_host_funcs);
+    return 1;
+}
@@ -0,0 +1,2 @@
+// lua/lauxlib.h - host shim, forwards to the system Lua headers
+#include <lauxlib.h>
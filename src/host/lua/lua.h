@@ -0,0 +1,2 @@
+// lua/lua.h - host shim, forwards to the system Lua headers
+#include <lua.h>
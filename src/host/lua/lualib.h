@@ -0,0 +1,2 @@
+// lua/lualib.h - host shim, forwards to the system Lua headers
+#include <lualib.h>
@@ -0,0 +1,2 @@
+// lz4/lz4.h - host shim, forwards to the system lz4 headers
+#include <lz4.h>
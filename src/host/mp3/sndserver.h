@@ -0,0 +1,5 @@
+// mp3/sndserver.h - host shim, see kos.h
+#ifndef SINGE_HOST_MP3_SNDSERVER_H
+#define SINGE_HOST_MP3_SNDSERVER_H
+#include <kos.h>
+#endif
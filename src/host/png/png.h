@@ -0,0 +1,12 @@
+// png/png.h - host shim for the KOS libpng port (kos_host.c)
+#ifndef SINGE_HOST_KOS_PNG_H
+#define SINGE_HOST_KOS_PNG_H
+#include <kos.h>
+
+#define PNG_NO_ALPHA   0
+#define PNG_MASK_ALPHA 1
+#define PNG_FULL_ALPHA 2
+
+int png_load_texture(const char *filename, pvr_ptr_t *tex, uint32_t alpha,
+                     uint32_t *w, uint32_t *h);
+#endif
@@ -0,0 +1,295 @@
+// pvr_host.c - recording PVR backend for the host build
+//
+// VRAM is plain heap memory with the same 8 MB budget as the real chip.
+// Everything that would reach the tile accelerator (pvr_prim and SQ copies
+// to PVR_TA_INPUT) is decoded into headers and vertices, counted
+// per scene and optionally written to SINGE_HOST_TRACE so two runs can be
+// diffed. pvr_scene_finish() also drives the SINGE_HOST_FRAMES exit.
+
+#include <kos.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "host_internal.h"
+
+#define HOST_VRAM_SIZE (8 * 1024 * 1024)
+
+// ---------------------------------------------------------------------------
+// Stats / trace
+// ---------------------------------------------------------------------------
+static struct {
+    uint64_t scenes;
+    uint64_t headers;
+    uint64_t vertices;
+    uint64_t strips;
+    uint64_t txr_uploads;
+    uint64_t txr_upload_bytes;
+    uint64_t dma_uploads;
+    size_t   vram_used;
+    size_t   vram_peak;
+} pvr_stats;
+
+static pthread_mutex_t pvr_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *pvr_trace = NULL;
+static uint64_t pvr_exit_after = 0;
+static int pvr_cur_list = -1;
+static int pvr_in_scene = 0;
+
+static void pvr_host_record(const void *data) {
+    uint32_t cmd;
+    memcpy(&cmd, data, sizeof(cmd));
+
+    pthread_mutex_lock(&pvr_lock);
+    if ((cmd & 0xe0000000) == 0xe0000000) {
+        const pvr_vertex_t *v = data;
+        pvr_stats.vertices++;
+        if (cmd == PVR_CMD_VERTEX_EOL) pvr_stats.strips++;
+        if (pvr_trace)
+            fprintf(pvr_trace, "%llu V %s %.2f %.2f %.4f %.4f %.4f %08x\n",
+                    (unsigned long long)pvr_stats.scenes,
+                    cmd == PVR_CMD_VERTEX_EOL ? "eol" : "-",
+                    v->x, v->y, v->z, v->u, v->v, v->argb);
+    } else {
+        const pvr_poly_hdr_t *h = data;
+        pvr_stats.headers++;
+        if (pvr_trace)
+            fprintf(pvr_trace, "%llu H list=%d %08x %08x %08x %08x\n",
+                    (unsigned long long)pvr_stats.scenes, pvr_cur_list,
+                    h->cmd, h->mode1, h->mode2, h->mode3);
+    }
+    pthread_mutex_unlock(&pvr_lock);
+}
+
+void host_pvr_report(void) {
+    printf("[host] pvr: %llu scenes, %llu headers, %llu vertices (%llu strips), "
+           "%llu texture uploads (%llu via DMA, %llu bytes), vram peak %zu KB\n",
+           (unsigned long long)pvr_stats.scenes, (unsigned long long)pvr_stats.headers,
+           (unsigned long long)pvr_stats.vertices, (unsigned long long)pvr_stats.strips,
+           (unsigned long long)pvr_stats.txr_uploads, (unsigned long long)pvr_stats.dma_uploads,
+           (unsigned long long)pvr_stats.txr_upload_bytes, pvr_stats.vram_peak / 1024);
+}
+
+void host_report(void) {
+    host_pvr_report();
+    host_snd_report();
+    host_fs_report();
+    if (pvr_trace) fclose(pvr_trace);
+    pvr_trace = NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Scene / list control
+// ---------------------------------------------------------------------------
+int pvr_init_defaults(void) {
+    const char *frames = getenv("SINGE_HOST_FRAMES");
+    const char *trace = getenv("SINGE_HOST_TRACE");
+
+    if (frames) pvr_exit_after = strtoull(frames, NULL, 10);
+    if (trace && *trace) {
+        pvr_trace = fopen(trace, "w");
+        if (!pvr_trace) printf("[host] could not open trace %s\n", trace);
+    }
+    atexit(host_report);
+    return 0;
+}
+
+int pvr_scene_begin(void) {
+    pvr_in_scene = 1;
+    return 0;
+}
+
+int pvr_scene_finish(void) {
+    pvr_in_scene = 0;
+    pvr_cur_list = -1;
+    pthread_mutex_lock(&pvr_lock);
+    uint64_t scenes = ++pvr_stats.scenes;
+    pthread_mutex_unlock(&pvr_lock);
+
+    if (pvr_exit_after && scenes >= pvr_exit_after) {
+        printf("[host] %llu scenes rendered, exiting\n", (unsigned long long)scenes);
+        exit(0);
+    }
+    return 0;
+}
+
+int pvr_list_begin(int list) {
+    pvr_cur_list = list;
+    return 0;
+}
+
+int pvr_list_finish(void) {
+    pvr_cur_list = -1;
+    return 0;
+}
+
+int pvr_prim(const void *data, size_t size) {
+    (void)size;
+    pvr_host_record(data);
+    return 0;
+}
+
+void *sq_fast_cpy(void *dest, const void *src, size_t n) {
+    if ((uintptr_t)dest == PVR_TA_INPUT) {
+        for (size_t i = 0; i < n; i++)
+            pvr_host_record((const uint8_t *)src + i * 32);
+        return dest;
+    }
+    return memcpy(dest, src, n * 32);
+}
+
+void pvr_dr_init(pvr_dr_state_t *state) {
+    state->list = pvr_cur_list;
+}
+
+// On KOS this is just the "pref" that flushes a store queue; all the data
+// already went through sq_fast_cpy/pvr_prim, so nothing is recorded here.
+void pvr_dr_commit(void *addr) {
+    (void)addr;
+}
+
+void pvr_host_set_reg(uint32_t reg, uint32_t value) {
+    if (pvr_trace)
+        fprintf(pvr_trace, "- R %04x %08x\n", reg, value);
+}
+
+// ---------------------------------------------------------------------------
+// Context compilation (packs enough state into the header to be traceable)
+// ---------------------------------------------------------------------------
+void pvr_poly_cxt_col(pvr_poly_cxt_t *dst, int list) {
+    memset(dst, 0, sizeof(*dst));
+    dst->list_type = list;
+    dst->gen.alpha = (list == PVR_LIST_OP_POLY) ? PVR_ALPHA_DISABLE : PVR_ALPHA_ENABLE;
+    dst->blend.src = (list == PVR_LIST_OP_POLY) ? 1 : PVR_BLEND_SRCALPHA;
+    dst->blend.dst = (list == PVR_LIST_OP_POLY) ? 0 : PVR_BLEND_INVSRCALPHA;
+}
+
+void pvr_poly_cxt_txr(pvr_poly_cxt_t *dst, int list, int textureformat,
+                      int tw, int th, pvr_ptr_t textureaddr, int filtering) {
+    pvr_poly_cxt_col(dst, list);
+    dst->txr.enable = 1;
+    dst->txr.filter = filtering;
+    dst->txr.width = tw;
+    dst->txr.height = th;
+    dst->txr.format = textureformat;
+    dst->txr.base = textureaddr;
+}
+
+static uint32_t pvr_size_code(int n) {
+    uint32_t code = 0;
+    while ((8 << code) < n && code < 7) code++;
+    return code;
+}
+
+void pvr_poly_compile(pvr_poly_hdr_t *dst, const pvr_poly_cxt_t *src) {
+    memset(dst, 0, sizeof(*dst));
+    dst->cmd = PVR_CMD_POLYHDR | ((uint32_t)src->list_type << 24) |
+               (src->txr.enable ? 0x8 : 0);
+    dst->mode1 = ((uint32_t)src->gen.culling << 27);
+    dst->mode2 = ((uint32_t)src->blend.src << 29) | ((uint32_t)src->blend.dst << 26) |
+                 ((uint32_t)src->gen.alpha << 20) | ((uint32_t)src->txr.filter << 13) |
+                 (pvr_size_code(src->txr.width) << 3) | pvr_size_code(src->txr.height);
+    dst->mode3 = (uint32_t)src->txr.format |
+                 ((uint32_t)((uintptr_t)src->txr.base >> 3) & 0x1fffff);
+}
+
+// ---------------------------------------------------------------------------
+// VRAM
+// ---------------------------------------------------------------------------
+typedef struct {
+    size_t size;
+    uint8_t pad[24];    // keep the payload 32-byte aligned
+} vram_block_t;
+
+pvr_ptr_t pvr_mem_malloc(size_t size) {
+    pthread_mutex_lock(&pvr_lock);
+    if (pvr_stats.vram_used + size > HOST_VRAM_SIZE) {
+        pthread_mutex_unlock(&pvr_lock);
+        printf("[host] pvr_mem_malloc(%zu) exceeds VRAM\n", size);
+        return NULL;
+    }
+    pvr_stats.vram_used += size;
+    if (pvr_stats.vram_used > pvr_stats.vram_peak) pvr_stats.vram_peak = pvr_stats.vram_used;
+    pthread_mutex_unlock(&pvr_lock);
+
+    vram_block_t *b = memalign(32, sizeof(vram_block_t) + size);
+    if (!b) return NULL;
+    b->size = size;
+    return b + 1;
+}
+
+void pvr_mem_free(pvr_ptr_t chunk) {
+    if (!chunk) return;
+    vram_block_t *b = (vram_block_t *)chunk - 1;
+    pthread_mutex_lock(&pvr_lock);
+    pvr_stats.vram_used -= b->size;
+    pthread_mutex_unlock(&pvr_lock);
+    free(b);
+}
+
+void pvr_txr_load(const void *src, pvr_ptr_t dst, size_t count) {
+    memcpy(dst, src, count);
+    pthread_mutex_lock(&pvr_lock);
+    pvr_stats.txr_uploads++;
+    pvr_stats.txr_upload_bytes += count;
+    pthread_mutex_unlock(&pvr_lock);
+}
+
+// A transfer started with block == 0 runs on its own thread, copying after
+// roughly the time the real channel takes (~100 MB/s), so code that reuses
+// the source buffer before the completion callback shows up on the host too.
+// Like the real channel, only one transfer is in flight: another returns -1.
+typedef struct {
+    const void *src;
+    pvr_ptr_t dest;
+    size_t count;
+    pvr_dma_callback_t callback;
+    void *cbdata;
+} pvr_dma_job_t;
+
+static atomic_int pvr_dma_busy = 0;
+
+static void pvr_dma_copy(const void *src, pvr_ptr_t dest, size_t count) {
+    memcpy(dest, src, count);
+    pthread_mutex_lock(&pvr_lock);
+    pvr_stats.txr_uploads++;
+    pvr_stats.dma_uploads++;
+    pvr_stats.txr_upload_bytes += count;
+    pthread_mutex_unlock(&pvr_lock);
+}
+
+static void *pvr_dma_thread(void *arg) {
+    pvr_dma_job_t job = *(pvr_dma_job_t *)arg;
+    free(arg);
+    struct timespec ts = { 0, (long)(job.count * 10) + 20000 };
+    nanosleep(&ts, NULL);
+    pvr_dma_copy(job.src, job.dest, job.count);
+    atomic_store(&pvr_dma_busy, 0);
+    if (job.callback) job.callback(job.cbdata);
+    return NULL;
+}
+
+int pvr_txr_load_dma(const void *src, pvr_ptr_t dest, size_t count, int block,
+                     pvr_dma_callback_t callback, void *cbdata) {
+    int idle = 0;
+    if (!atomic_compare_exchange_strong(&pvr_dma_busy, &idle, 1))
+        return -1;
+    if (!block) {
+        pvr_dma_job_t *job = malloc(sizeof(*job));
+        pthread_t t;
+        if (job) {
+            *job = (pvr_dma_job_t){ src, dest, count, callback, cbdata };
+            if (pthread_create(&t, NULL, pvr_dma_thread, job) == 0) {
+                pthread_detach(t);
+                return 0;
+            }
+            free(job);
+        }
+    }
+    pvr_dma_copy(src, dest, count);
+    atomic_store(&pvr_dma_busy, 0);
+    if (callback) callback(cbdata);
+    return 0;
+}
+
+int pvr_dma_ready(void) {
+    return !atomic_load(&pvr_dma_busy);
+}
@@ -0,0 +1,302 @@
+// snd_host.c - sound stream stub for the host build
+//
+// There is no AICA to drain the buffers, so the stub keeps a virtual play
+// cursor that advances with wall time at the stream's ADPCM rate (two
+// samples per byte, per channel). snd_stream_poll() tops the virtual buffer
+// back up through the direct callback exactly like the KOS driver does, which
+// means audio_cb runs at the real rate and with the real request sizes.
+// Polls that come too late to keep the buffer fed are counted as underruns.
+
+#include <kos.h>
+#include "host_internal.h"
+
+static struct {
+    snd_stream_callback_direct_t cb;
+    int      bufsize;          // bytes per channel
+    uint32_t freq;
+    int      stereo;
+    int      running;
+    uint64_t start_us;
+    uint64_t fed_bytes;        // per channel, since start
+    uint8_t *scratch[2];
+} snd_host;
+
+static struct {
+    uint64_t polls;
+    uint64_t callbacks;
+    uint64_t requested_bytes;
+    uint64_t returned_bytes;
+    uint64_t underruns;
+    uint64_t max_poll_gap_us;
+} snd_stats;
+
+static uint64_t snd_last_poll_us;
+
+static struct {
+    uint64_t dmas;
+    uint64_t dma_bytes;
+    uint64_t commands;
+    uint64_t position_reads;
+} spu_stats;
+
+void host_snd_report(void) {
+    printf("[host] snd: %llu polls, %llu callbacks, %llu/%llu bytes returned/requested, "
+           "%llu underruns, worst poll gap %.2f ms\n",
+           (unsigned long long)snd_stats.polls, (unsigned long long)snd_stats.callbacks,
+           (unsigned long long)snd_stats.returned_bytes, (unsigned long long)snd_stats.requested_bytes,
+           (unsigned long long)snd_stats.underruns, snd_stats.max_poll_gap_us / 1000.0);
+    if (spu_stats.commands)
+        printf("[host] spu: %llu channel commands, %llu DMAs (%llu bytes), %llu position reads\n",
+               (unsigned long long)spu_stats.commands, (unsigned long long)spu_stats.dmas,
+               (unsigned long long)spu_stats.dma_bytes, (unsigned long long)spu_stats.position_reads);
+}
+
+int snd_stream_init(void) { return 0; }
+
+int snd_stream_init_ex(int channels, size_t buffer_size) {
+    (void)channels; (void)buffer_size;
+    return 0;
+}
+
+void snd_stream_shutdown(void) {
+    snd_host.running = 0;
+}
+
+snd_stream_hnd_t snd_stream_alloc(snd_stream_callback_t cb, int bufsize) {
+    (void)cb;
+    snd_host.bufsize = bufsize;
+    for (int i = 0; i < 2; i++) {
+        free(snd_host.scratch[i]);
+        snd_host.scratch[i] = memalign(32, bufsize);
+    }
+    return 0;
+}
+
+void snd_stream_set_callback(snd_stream_hnd_t hnd, snd_stream_callback_t cb) {
+    (void)hnd; (void)cb;
+}
+
+void snd_stream_set_callback_direct(snd_stream_hnd_t hnd, snd_stream_callback_direct_t cb) {
+    (void)hnd;
+    snd_host.cb = cb;
+}
+
+void snd_stream_reinit(snd_stream_hnd_t hnd, snd_stream_callback_t cb) {
+    (void)hnd; (void)cb;
+}
+
+void snd_stream_queue_enable(snd_stream_hnd_t hnd) {
+    (void)hnd;
+}
+
+void snd_stream_start_adpcm(snd_stream_hnd_t hnd, uint32_t freq, int st) {
+    (void)hnd;
+    snd_host.freq = freq;
+    snd_host.stereo = st;
+    snd_host.start_us = timer_us_gettime64();
+    snd_host.fed_bytes = 0;
+    snd_host.running = 1;
+    snd_last_poll_us = snd_host.start_us;
+}
+
+void snd_stream_stop(snd_stream_hnd_t hnd) {
+    (void)hnd;
+    snd_host.running = 0;
+}
+
+int snd_stream_poll(snd_stream_hnd_t hnd) {
+    if (!snd_host.running || !snd_host.cb)
+        return -1;
+
+    uint64_t now = timer_us_gettime64();
+    snd_stats.polls++;
+    if (now - snd_last_poll_us > snd_stats.max_poll_gap_us)
+        snd_stats.max_poll_gap_us = now - snd_last_poll_us;
+    snd_last_poll_us = now;
+
+    // 4-bit ADPCM: freq samples/s is freq/2 bytes/s per channel
+    uint64_t played = (now - snd_host.start_us) * snd_host.freq / 2 / 1000000ULL;
+    if (played > snd_host.fed_bytes) {
+        snd_stats.underruns++;
+        snd_host.fed_bytes = played;    // the hardware would have looped stale data
+    }
+
+    // KOS refills half a buffer at a time once the play cursor crosses it
+    size_t half = (size_t)snd_host.bufsize / 2;
+    while (snd_host.fed_bytes - played < (uint64_t)half) {
+        size_t req = half * 2;    // both channels, audio_cb splits it
+        size_t got = snd_host.cb(hnd, (uintptr_t)snd_host.scratch[0],
+                                 (uintptr_t)snd_host.scratch[1], req);
+        snd_stats.callbacks++;
+        snd_stats.requested_bytes += req;
+        snd_stats.returned_bytes += got;
+        snd_host.fed_bytes += half;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// SPU RAM and AICA channels, for direct streaming. Nothing is mixed; a started
+// channel's position runs at its frequency and wraps at its loop end.
+// ---------------------------------------------------------------------------
+#define SPU_RAM_SIZE  (2 * 1024 * 1024)
+#define SPU_RAM_FIRST 0x40000               // the sound driver's own area
+#define AICA_CHANNELS 64
+
+static pthread_mutex_t spu_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t *spu_ram;
+static uint32_t spu_next = SPU_RAM_FIRST;
+static uint64_t spu_chn_used;
+static struct {
+    int armed, playing;
+    uint32_t loopend, freq;
+    uint64_t start_us;
+} aica_chn[AICA_CHANNELS];
+
+uint32_t snd_mem_malloc(size_t size) {
+    pthread_mutex_lock(&spu_lock);
+    uint32_t addr = 0;
+    size = (size + 31) & ~(size_t)31;
+    if (!spu_ram) spu_ram = calloc(1, SPU_RAM_SIZE);
+    if (spu_ram && spu_next + size <= SPU_RAM_SIZE) {
+        addr = spu_next;
+        spu_next += (uint32_t)size;
+    }
+    pthread_mutex_unlock(&spu_lock);
+    return addr;
+}
+
+void snd_mem_free(uint32_t addr) {
+    (void)addr;                             // bump allocator: nothing comes back
+}
+
+int snd_sfx_chn_alloc(void) {
+    pthread_mutex_lock(&spu_lock);
+    int chn = -1;
+    for (int i = 0; i < AICA_CHANNELS && chn < 0; i++) {
+        if (!(spu_chn_used & (1ULL << i))) {
+            spu_chn_used |= 1ULL << i;
+            chn = i;
+        }
+    }
+    pthread_mutex_unlock(&spu_lock);
+    return chn;
+}
+
+void snd_sfx_chn_free(int chn) {
+    if (chn < 0 || chn >= AICA_CHANNELS) return;
+    pthread_mutex_lock(&spu_lock);
+    spu_chn_used &= ~(1ULL << chn);
+    aica_chn[chn].armed = aica_chn[chn].playing = 0;
+    pthread_mutex_unlock(&spu_lock);
+}
+
+void snd_sh4_to_aica(void *packet, uint32_t size) {
+    aica_cmd_t *cmd = packet;
+    if (size < AICA_CMDSTR_CHANNEL_SIZE || cmd->cmd != AICA_CMD_CHAN) return;
+    aica_channel_t *chan = (aica_channel_t *)cmd->cmd_data;
+    uint64_t now = timer_us_gettime64();
+
+    pthread_mutex_lock(&spu_lock);
+    spu_stats.commands++;
+    if ((chan->cmd & 0xff) == AICA_CH_CMD_START && (chan->cmd & AICA_CH_START_SYNC)) {
+        // cmd_id is a mask of the delayed channels to start together
+        for (int i = 0; i < 32; i++) {
+            if ((cmd->cmd_id & (1u << i)) && aica_chn[i].armed) {
+                aica_chn[i].playing = 1;
+                aica_chn[i].start_us = now;
+            }
+        }
+    } else if (cmd->cmd_id < AICA_CHANNELS) {
+        int i = (int)cmd->cmd_id;
+        if ((chan->cmd & 0xff) == AICA_CH_CMD_START) {
+            aica_chn[i].armed = 1;
+            // 16-bit registers: the driver masks them, so a longer loop wraps
+            uint32_t end = chan->loop ? chan->loopend : chan->length;
+            aica_chn[i].loopend = end & 0xffff;
+            if (end > 0xffff)
+                printf("[host] spu: channel %d loop end of %u samples wraps to %u\n", i, end, end & 0xffff);
+            aica_chn[i].freq = chan->freq;
+            aica_chn[i].playing = !(chan->cmd & AICA_CH_START_DELAY);
+            aica_chn[i].start_us = now;
+        } else if ((chan->cmd & 0xff) == AICA_CH_CMD_STOP) {
+            aica_chn[i].armed = aica_chn[i].playing = 0;
+        }
+    }
+    pthread_mutex_unlock(&spu_lock);
+}
+
+int spu_dma_transfer(void *from, uintptr_t dest, size_t length, int block,
+                     g2_dma_callback_t callback, void *cbdata) {
+    (void)block;
+    dest &= SPU_RAM_SIZE - 1;
+    if (((uintptr_t)from | dest | length) & 31 || !spu_ram || dest + length > SPU_RAM_SIZE)
+        return -1;
+    memcpy(spu_ram + dest, from, length);
+    pthread_mutex_lock(&spu_lock);
+    spu_stats.dmas++;
+    spu_stats.dma_bytes += length;
+    pthread_mutex_unlock(&spu_lock);
+    if (callback) callback(cbdata);
+    return 0;
+}
+
+void spu_memload(uintptr_t to, void *from, size_t length) {
+    to &= SPU_RAM_SIZE - 1;
+    pthread_mutex_lock(&spu_lock);
+    if (spu_ram && to + length <= SPU_RAM_SIZE)
+        memcpy(spu_ram + to, from, length);
+    pthread_mutex_unlock(&spu_lock);
+}
+
+uint32_t host_spu_read_32(uintptr_t address) {
+    uintptr_t off = address - SPU_RAM_UNCACHED_BASE;
+    uint32_t value = 0;
+    pthread_mutex_lock(&spu_lock);
+    if (off >= AICA_MEM_CHANNELS && off < AICA_CHANNEL(AICA_CHANNELS)) {
+        int i = (int)((off - AICA_MEM_CHANNELS) / sizeof(aica_channel_t));
+        if (off - AICA_CHANNEL(i) == offsetof(aica_channel_t, pos)) {
+            spu_stats.position_reads++;
+            if (aica_chn[i].playing && aica_chn[i].loopend) {
+                uint64_t samples = (timer_us_gettime64() - aica_chn[i].start_us) * aica_chn[i].freq / 1000000ULL;
+                value = (uint32_t)(samples % aica_chn[i].loopend);
+            }
+        }
+    } else if (spu_ram && off + 4 <= SPU_RAM_SIZE) {
+        memcpy(&value, spu_ram + off, 4);
+    }
+    pthread_mutex_unlock(&spu_lock);
+    return value;
+}
+
+// ---------------------------------------------------------------------------
+// Sound effects / MP3: load bookkeeping only, nothing is mixed
+// ---------------------------------------------------------------------------
+static uint32_t snd_next_sfx = 1;
+
+int snd_mem_init(uint32_t reserve) {
+    (void)reserve;
+    return 0;
+}
+
+sfxhnd_t snd_sfx_load(const char *fn) {
+    file_t fd = fs_open(fn, O_RDONLY);
+    if (fd < 0) return SFXHND_INVALID;
+    fs_close(fd);
+    return snd_next_sfx++;
+}
+
+sfxhnd_t snd_sfx_load_raw_buf(char *buf, size_t len, uint32_t rate, uint16_t bitsize, uint16_t channels) {
+    (void)buf; (void)len; (void)rate; (void)bitsize; (void)channels;
+    return snd_next_sfx++;
+}
+
+int snd_sfx_play(sfxhnd_t idx, int vol, int pan) {
+    (void)idx; (void)vol; (void)pan;
+    return 0;
+}
+
+int mp3_init(void) { return 0; }
+int mp3_start(const char *fn, int loop) { (void)fn; (void)loop; return 0; }
+int mp3_stop(void) { return 0; }
+int mp3_shutdown(void) { return 0; }
@@ -0,0 +1,2 @@
+// zstd/zstd.h - host shim, forwards to the system zstd headers
+#include <zstd.h>
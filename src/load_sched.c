@@ -0,0 +1,66 @@
+// load_sched.c - deadline-driven preload horizon (see load_sched.h)
+
+#include "load_sched.h"
+
+#include <math.h>
+
+static void update(load_sched_t *s) {
+    int frames = atomic_load(&s->base) + atomic_load(&s->boost);
+    if (frames < s->min_frames) frames = s->min_frames;
+    if (frames > s->max_frames) frames = s->max_frames;
+    atomic_store(&s->horizon, frames);
+}
+
+void load_sched_init(load_sched_t *s, float frame_ms, int min_frames, int max_frames) {
+    s->frame_ms = frame_ms > 0 ? frame_ms : 1000.0f / 30.0f;
+    s->min_frames = min_frames < 1 ? 1 : min_frames;
+    s->max_frames = max_frames < s->min_frames ? s->min_frames : max_frames;
+    // Start wide: nothing has been measured yet
+    s->avg_ms = s->frame_ms;
+    s->dev_ms = s->frame_ms;
+    s->peak_ms = s->frame_ms;
+    atomic_store(&s->base, 7);                  // 1 + 4 + 1 frames + 1
+    atomic_store(&s->boost, 0);
+    atomic_store(&s->calm, 0);
+    atomic_store(&s->loads, 0);
+    atomic_store(&s->late, 0);
+    atomic_store(&s->underruns, 0);
+    atomic_store(&s->cold, 0);
+    atomic_store(&s->dropped, 0);
+    update(s);
+}
+
+void load_sched_loaded(load_sched_t *s, float ms, int late) {
+    float err = ms - s->avg_ms;
+    s->avg_ms += err * 0.125f;
+    s->dev_ms += (fabsf(err) - s->dev_ms) * 0.25f;
+    s->peak_ms = ms > s->peak_ms ? ms : s->peak_ms - (s->peak_ms - s->avg_ms) / LOAD_SCHED_PEAK_LOADS;
+    atomic_store(&s->base, (int)ceilf((s->avg_ms + 4.0f * s->dev_ms + s->peak_ms) / s->frame_ms) + 1);
+    atomic_fetch_add(&s->loads, 1);
+    if (late) atomic_fetch_add(&s->late, 1);
+    update(s);
+}
+
+void load_sched_underrun(load_sched_t *s, int cold) {
+    atomic_fetch_add(&s->underruns, 1);
+    if (cold) {
+        // The first frame after a seek: no horizon could have had it
+        atomic_fetch_add(&s->cold, 1);
+        return;
+    }
+    int b = atomic_load(&s->boost) + 2;
+    atomic_store(&s->boost, b > LOAD_SCHED_BOOST_MAX ? LOAD_SCHED_BOOST_MAX : b);
+    atomic_store(&s->calm, 0);
+    update(s);
+}
+
+void load_sched_shown(load_sched_t *s) {
+    if (atomic_fetch_add(&s->calm, 1) + 1 < LOAD_SCHED_CALM || atomic_load(&s->boost) == 0) return;
+    atomic_store(&s->calm, 0);
+    atomic_fetch_sub(&s->boost, 1);
+    update(s);
+}
+
+int load_sched_horizon(load_sched_t *s) {
+    return atomic_load(&s->horizon);
+}
@@ -0,0 +1,48 @@
+// load_sched.h - deadline-driven preload horizon
+//
+// A frame is due when the media clock reaches its first total frame, so the
+// worker plans loads in deadline order from the play head and stops at a
+// horizon: how far ahead decoded frames have to reach to ride out a slow load.
+// The horizon follows the measured load time per frame: the mean plus four
+// mean deviations (as TCP sizes its retransmit timer) plus the slowest recent
+// load, which fades over LOAD_SCHED_PEAK_LOADS loads, and a margin that grows
+// by two frames on every underrun away from a seek and gives one back every
+// LOAD_SCHED_CALM frames shown. Counters are for the logs.
+#ifndef LOAD_SCHED_H
+#define LOAD_SCHED_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define LOAD_SCHED_BOOST_MAX  16      // frames
+#define LOAD_SCHED_CALM       256     // frames shown per margin frame given back
+#define LOAD_SCHED_PEAK_LOADS 1024    // loads over which a slow one is forgotten
+
+typedef struct {
+    float frame_ms;
+    int min_frames, max_frames;
+    float avg_ms, dev_ms, peak_ms;    // load time per frame, loader only
+    atomic_int base;                  // frames the load times call for
+    atomic_int horizon;               // frames ahead of the play head
+    atomic_int boost;                 // margin from underruns
+    atomic_int calm;                  // frames shown since the margin last changed
+    atomic_uint loads, late;          // late: finished after the frame was due
+    atomic_uint underruns;            // due frames that were not decoded
+    atomic_uint cold;                 // of them, the first frame after a seek
+    atomic_uint dropped;              // jobs popped after their deadline
+} load_sched_t;
+
+void load_sched_init(load_sched_t *s, float frame_ms, int min_frames, int max_frames);
+
+// Loader: one frame took `ms`; `late` if the renderer was already waiting.
+void load_sched_loaded(load_sched_t *s, float ms, int late);
+
+// Renderer: the frame due now is not decoded (call once per frame; `cold`
+// for the first frame after a seek, which only counts), or was shown on time.
+void load_sched_underrun(load_sched_t *s, int cold);
+void load_sched_shown(load_sched_t *s);
+
+// Frames ahead of the play head to have loaded.
+int load_sched_horizon(load_sched_t *s);
+
+#endif // LOAD_SCHED_H
@@ -0,0 +1,79 @@
+// preload_queue.c - MPSC preload job queue (see preload_queue.h)
+
+#include "preload_queue.h"
+
+#include <stdlib.h>
+
+int preload_queue_init(preload_queue_t *q, int num_unique) {
+    q->queued = calloc((size_t)(num_unique + 31) / 32, sizeof(atomic_uint));
+    if (!q->queued) return -1;
+    q->num_unique = num_unique;
+    for (unsigned i = 0; i < PRELOAD_QUEUE_SIZE; i++)
+        atomic_store(&q->cells[i].seq, i);
+    atomic_store(&q->head, 0);
+    atomic_store(&q->tail, 0);
+    return 0;
+}
+
+void preload_queue_destroy(preload_queue_t *q) {
+    free(q->queued);
+    q->queued = NULL;
+    q->num_unique = 0;
+}
+
+int preload_queue_push(preload_queue_t *q, int frame, int unique, int generation) {
+    if (unique < 0 || unique >= q->num_unique) return 0;
+    unsigned bit = 1u << (unique & 31);
+    if (atomic_fetch_or(&q->queued[unique >> 5], bit) & bit) return 0;
+
+    unsigned pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    preload_cell_t *c;
+    for (;;) {
+        c = &q->cells[pos & (PRELOAD_QUEUE_SIZE - 1)];
+        unsigned seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            // Full: the consumer has not freed this cell yet
+            atomic_fetch_and(&q->queued[unique >> 5], ~bit);
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+    c->job.frame = frame;
+    c->job.unique = unique;
+    c->job.generation = generation;
+    atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+    return 1;
+}
+
+int preload_queue_pop(preload_queue_t *q, preload_job_t *out) {
+    unsigned pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    preload_cell_t *c = &q->cells[pos & (PRELOAD_QUEUE_SIZE - 1)];
+    if (atomic_load_explicit(&c->seq, memory_order_acquire) != pos + 1) return 0;
+    *out = c->job;
+    atomic_store_explicit(&c->seq, pos + PRELOAD_QUEUE_SIZE, memory_order_release);
+    atomic_store_explicit(&q->tail, pos + 1, memory_order_relaxed);
+    atomic_fetch_and(&q->queued[out->unique >> 5], ~(1u << (out->unique & 31)));
+    return 1;
+}
+
+int preload_queue_drain(preload_queue_t *q) {
+    preload_job_t job;
+    int n = 0;
+    while (preload_queue_pop(q, &job)) n++;
+    return n;
+}
+
+int preload_queue_is_queued(preload_queue_t *q, int unique) {
+    if (unique < 0 || unique >= q->num_unique) return 0;
+    return (atomic_load(&q->queued[unique >> 5]) >> (unique & 31)) & 1;
+}
+
+int preload_queue_count(preload_queue_t *q) {
+    return (int)(atomic_load(&q->head) - atomic_load(&q->tail));
+}
@@ -0,0 +1,52 @@
+// preload_queue.h - multi-producer/single-consumer queue of preload jobs
+//
+// fmv_tick (main thread) and the worker both schedule frames; only the worker
+// loads them. A bounded array queue with a sequence number per cell
+// (Vyukov): producers claim a cell by compare-and-swap on head, the consumer
+// owns tail. A bitmap keyed by unique frame says which frames are queued, so
+// the duplicate check is one fetch-or instead of a scan of the queue.
+#ifndef PRELOAD_QUEUE_H
+#define PRELOAD_QUEUE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define PRELOAD_QUEUE_SIZE 32           // power of two
+
+typedef struct {
+    int frame;                          // total frame
+    int unique;
+    int generation;                     // GSeekGeneration when it was queued
+} preload_job_t;
+
+typedef struct {
+    atomic_uint seq;
+    preload_job_t job;
+} preload_cell_t;
+
+typedef struct {
+    preload_cell_t cells[PRELOAD_QUEUE_SIZE];
+    atomic_uint head;                   // next cell producers claim
+    atomic_uint tail;                   // next cell the consumer reads
+    atomic_uint *queued;                // one bit per unique frame
+    int num_unique;
+} preload_queue_t;
+
+int  preload_queue_init(preload_queue_t *q, int num_unique);
+void preload_queue_destroy(preload_queue_t *q);
+
+// Any thread. 0 if the frame is already queued, out of range or the queue is
+// full; 1 if it was queued.
+int preload_queue_push(preload_queue_t *q, int frame, int unique, int generation);
+
+// Consumer only. 1 and the oldest job, or 0 when empty.
+int preload_queue_pop(preload_queue_t *q, preload_job_t *out);
+
+// Consumer only: drops every queued job. Returns how many.
+int preload_queue_drain(preload_queue_t *q);
+
+// Any thread; a snapshot.
+int preload_queue_is_queued(preload_queue_t *q, int unique);
+int preload_queue_count(preload_queue_t *q);
+
+#endif // PRELOAD_QUEUE_H
@@ -0,0 +1,56 @@
+// readahead_ring.c - read-ahead block index (see readahead_ring.h)
+
+#include "readahead_ring.h"
+
+#include <stddef.h>
+
+void readahead_ring_init(readahead_ring_t *r, uint32_t cap) {
+    r->cap = cap;
+    readahead_ring_clear(r);
+}
+
+void readahead_ring_clear(readahead_ring_t *r) {
+    r->head = 0;
+    r->oldest = r->count = 0;
+}
+
+int64_t readahead_ring_space(const readahead_ring_t *r, uint32_t size) {
+    if (r->count == 0) return size <= r->cap ? 0 : -1;
+    uint32_t tail = r->blocks[r->oldest].pos;
+    if (r->head > tail) {
+        if (r->head + size <= r->cap) return (int64_t)r->head;
+        return size <= tail ? 0 : -1;      // wrap, the end of the buffer stays unused
+    }
+    return r->head + size <= tail ? (int64_t)r->head : -1;
+}
+
+void readahead_ring_push(readahead_ring_t *r, int first, int count, uint32_t pos, uint32_t size) {
+    readahead_block_t *b = &r->blocks[(r->oldest + r->count++) % READAHEAD_RING_MAX_BLOCKS];
+    b->first = first;
+    b->count = count;
+    b->pos = pos;
+    b->size = size;
+    r->head = pos + size;
+}
+
+const readahead_block_t *readahead_ring_oldest(const readahead_ring_t *r) {
+    return r->count ? &r->blocks[r->oldest] : NULL;
+}
+
+void readahead_ring_pop(readahead_ring_t *r) {
+    if (r->count == 0) return;
+    r->oldest = (r->oldest + 1) % READAHEAD_RING_MAX_BLOCKS;
+    if (--r->count == 0) r->head = 0;
+}
+
+const readahead_block_t *readahead_ring_find(const readahead_ring_t *r, int unique) {
+    int lo = 0, hi = r->count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const readahead_block_t *b = &r->blocks[(r->oldest + mid) % READAHEAD_RING_MAX_BLOCKS];
+        if (unique < b->first) hi = mid - 1;
+        else if (unique >= b->first + b->count) lo = mid + 1;
+        else return b;
+    }
+    return NULL;
+}
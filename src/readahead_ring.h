@@ -0,0 +1,49 @@
+// readahead_ring.h - block index of the read-ahead byte ring
+//
+// Compressed blocks sit in one byte buffer in unique order. The writer puts
+// each run of blocks at the head, or back at offset 0 when it does not fit
+// before the end of the buffer; the end then stays unused until the blocks
+// before it are dropped. Blocks are dropped from the oldest. The head goes
+// back to 0 whenever the ring empties.
+//
+// Only the index: the caller owns the bytes. Plain C, so the engine and
+// dcmv-bench share it. Not thread-safe: the engine guards it with g_ra_lock.
+#ifndef READAHEAD_RING_H
+#define READAHEAD_RING_H
+
+#include <stdint.h>
+
+#define READAHEAD_RING_MAX_BLOCKS 2048
+
+typedef struct {
+    int first, count;                    // unique frames of the block
+    uint32_t pos, size;                  // payload in the byte buffer
+} readahead_block_t;
+
+typedef struct {
+    uint32_t cap, head;                  // buffer size, write position
+    readahead_block_t blocks[READAHEAD_RING_MAX_BLOCKS];
+    int oldest, count;                   // circular index of held blocks
+} readahead_ring_t;
+
+// Empty, over a buffer of `cap` bytes.
+void readahead_ring_init(readahead_ring_t *r, uint32_t cap);
+
+// Drop every block.
+void readahead_ring_clear(readahead_ring_t *r);
+
+// Offset where `size` contiguous bytes fit, or -1.
+int64_t readahead_ring_space(const readahead_ring_t *r, uint32_t size);
+
+// Hold a block written at `pos`; the head moves past it. The caller checks
+// readahead_ring_space, and count against READAHEAD_RING_MAX_BLOCKS, first.
+void readahead_ring_push(readahead_ring_t *r, int first, int count, uint32_t pos, uint32_t size);
+
+// Oldest held block (NULL if none), and dropping it.
+const readahead_block_t *readahead_ring_oldest(const readahead_ring_t *r);
+void readahead_ring_pop(readahead_ring_t *r);
+
+// Block holding unique frame `unique`, or NULL.
+const readahead_block_t *readahead_ring_find(const readahead_ring_t *r, int unique);
+
+#endif // READAHEAD_RING_H
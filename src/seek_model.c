@@ -0,0 +1,72 @@
+// seek_model.c - per-segment jump counts (see seek_model.h)
+
+#include "seek_model.h"
+
+#include <string.h>
+
+void seek_model_init(seek_model_t *m) {
+    memset(m, 0, sizeof(*m));
+    m->segment = -1;
+}
+
+int seek_model_predict(const seek_model_t *m, int *out, int max) {
+    int counts[SEEK_MODEL_ENTRIES];
+    int n = 0;
+    for (int i = 0; i < m->count && m->segment >= 0; i++) {
+        const seek_edge_t *e = &m->edges[i];
+        if (e->from != m->segment) continue;
+        // Insertion into the top `max`
+        int k = n < max ? n++ : max;
+        for (; k > 0 && counts[k - 1] < e->count; k--) {
+            if (k < max) {
+                out[k] = out[k - 1];
+                counts[k] = counts[k - 1];
+            }
+        }
+        if (k < max) {
+            out[k] = e->to;
+            counts[k] = e->count;
+        }
+    }
+    return n;
+}
+
+static void age_row(seek_model_t *m, int from) {
+    int w = 0;
+    for (int i = 0; i < m->count; i++) {
+        seek_edge_t e = m->edges[i];
+        if (e.from == from) e.count /= 2;
+        if (e.count > 0) m->edges[w++] = e;
+    }
+    m->count = w;
+}
+
+void seek_model_record(seek_model_t *m, int target, int ranked) {
+    int from = m->segment;
+    if (from >= 0 && ranked > 0) {
+        int top[SEEK_MODEL_ENTRIES];
+        int n = seek_model_predict(m, top, ranked < SEEK_MODEL_ENTRIES ? ranked : SEEK_MODEL_ENTRIES);
+        int hit = 0;
+        for (int i = 0; i < n; i++) hit |= top[i] == target;
+        if (hit) m->predicted++;
+        else m->unpredicted++;
+    }
+    m->segment = target;
+    if (from < 0) return;
+
+    seek_edge_t *e = NULL;
+    for (int i = 0; i < m->count && !e; i++)
+        if (m->edges[i].from == from && m->edges[i].to == target) e = &m->edges[i];
+    if (!e && m->count < SEEK_MODEL_ENTRIES) {
+        e = &m->edges[m->count++];
+        *e = (seek_edge_t){ from, target, 0 };
+    }
+    if (!e) {
+        // Full: replace the rarest transition
+        e = &m->edges[0];
+        for (int i = 1; i < m->count; i++)
+            if (m->edges[i].count < e->count) e = &m->edges[i];
+        *e = (seek_edge_t){ from, target, 0 };
+    }
+    if (++e->count >= SEEK_MODEL_MAX_COUNT) age_row(m, from);
+}
@@ -0,0 +1,38 @@
+// seek_model.h - learned seek targets for the engine's seek cache
+//
+// Playback between two seeks is a segment, named by the frame its seek landed
+// on. Every seek counts one transition from the playing segment to its target,
+// so the targets a segment has jumped to most often are the ones worth having
+// decoded before the script asks. Fixed-size table, no allocation; a row's
+// counts halve when one saturates, so the model follows how the game is played
+// now. Not thread-safe: the engine guards it with a mutex.
+#ifndef SEEK_MODEL_H
+#define SEEK_MODEL_H
+
+#include <stdint.h>
+
+#define SEEK_MODEL_ENTRIES   256
+#define SEEK_MODEL_MAX_COUNT 64
+
+typedef struct {
+    int from, to;                 // segment (total frame it started at), target
+    int count;
+} seek_edge_t;
+
+typedef struct {
+    seek_edge_t edges[SEEK_MODEL_ENTRIES];
+    int count;
+    int segment;                  // current segment, -1 before the first seek
+    uint32_t predicted, unpredicted;   // seeks whose target was / was not predicted
+} seek_model_t;
+
+void seek_model_init(seek_model_t *m);
+
+// Up to max targets of the current segment, most frequent first.
+int seek_model_predict(const seek_model_t *m, int *out, int max);
+
+// Count a seek to total frame `target`, which starts the next segment.
+// `ranked` is how many predictions the caller acts on, for the counters.
+void seek_model_record(seek_model_t *m, int target, int ranked);
+
+#endif // SEEK_MODEL_H
@@ -0,0 +1,70 @@
+// seek_state.c - asynchronous seeks and their latency (see seek_state.h)
+
+#include "seek_state.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void seek_state_init(seek_state_t *s) {
+    memset(s, 0, sizeof(*s));
+    s->phase = SEEK_IDLE;
+    s->target = s->pending = -1;
+}
+
+int seek_state_post(seek_state_t *s, int target, uint64_t now_us) {
+    int replaced = s->phase != SEEK_IDLE;
+    if (replaced)
+        s->replaced++;
+    else
+        s->posted_us = now_us;           // latency counts from the first of a burst
+    s->phase = SEEK_IO;
+    s->target = s->pending = target;
+    return replaced;
+}
+
+int seek_state_take(seek_state_t *s) {
+    int target = s->pending;
+    s->pending = -1;
+    return target;
+}
+
+int seek_state_io_done(seek_state_t *s, uint64_t now_us) {
+    if (s->phase != SEEK_IO || s->pending >= 0) return 0;
+    s->phase = SEEK_PRIMING;
+    s->io_us = now_us;
+    return 1;
+}
+
+int seek_state_land(seek_state_t *s, int ready, uint64_t now_us) {
+    if (s->phase != SEEK_PRIMING) return 0;
+    if (!ready) {
+        if (now_us - s->io_us < SEEK_STATE_BOUND_MS * 1000ULL) return 0;
+        s->bounded++;
+    }
+    uint64_t us = now_us - s->posted_us;
+    s->hist[seek_state_bucket(us)]++;
+    s->total_us += us;
+    if (us > s->worst_us) s->worst_us = us;
+    s->seeks++;
+    s->phase = SEEK_IDLE;
+    return 1;
+}
+
+int seek_state_bucket(uint64_t us) {
+    int b = 0;
+    for (uint64_t ms = us / 1000; ms >= 8 && b < SEEK_HIST_BUCKETS - 1; ms >>= 1) b++;
+    return b;
+}
+
+int seek_state_hist_str(const seek_state_t *s, char *buf, size_t size) {
+    size_t len = 0;
+    if (size) buf[0] = '\0';
+    for (int b = 0; b < SEEK_HIST_BUCKETS; b++) {
+        if (!s->hist[b] || len >= size) continue;
+        int n = b < SEEK_HIST_BUCKETS - 1
+              ? snprintf(buf + len, size - len, "%s<%d:%u", len ? " " : "", 8 << b, s->hist[b])
+              : snprintf(buf + len, size - len, "%s>=%d:%u", len ? " " : "", 8 << (b - 1), s->hist[b]);
+        if (n > 0) len += (size_t)n;
+    }
+    return len < size ? (int)len : (int)size - 1;
+}
@@ -0,0 +1,61 @@
+// seek_state.h - asynchronous seeks and their latency
+//
+// A seek goes through three phases so the renderer never waits on the drive.
+// The renderer posts it and keeps drawing the frame on screen (SEEK_IO). The
+// I/O side takes it, reopens the files and restarts the audio source at the
+// target, and reports it done (SEEK_PRIMING); loads for the target carry on
+// from there. The renderer lands it once the target frame is decoded, or
+// after SEEK_STATE_BOUND_MS of priming at most, and restarts the clock and
+// audio. A seek posted while one is in flight replaces it: the I/O side only
+// reports done for the latest one it took.
+//
+// Latency runs from post to landing and goes into a histogram of power-of-two
+// millisecond buckets. Not thread-safe: the engine guards it with a mutex.
+#ifndef SEEK_STATE_H
+#define SEEK_STATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SEEK_STATE_BOUND_MS 500          // most time priming may hold the clock
+#define SEEK_HIST_BUCKETS   9            // < 8 ms, < 16, ... < 1024, >= 1024
+
+enum {
+    SEEK_IDLE = 0,
+    SEEK_IO = 1,                         // posted, the I/O side has work to do
+    SEEK_PRIMING = 2                     // files at the target, waiting for its frame
+};
+
+typedef struct {
+    int phase;
+    int target;                          // total frame of the seek in flight
+    int pending;                         // target the I/O side has still to take, -1 none
+    uint64_t posted_us, io_us;           // when it was posted, when its I/O finished
+    uint32_t seeks, replaced, bounded;   // landed; posted over another; landed by the bound
+    uint32_t hist[SEEK_HIST_BUCKETS];
+    uint64_t total_us, worst_us;
+} seek_state_t;
+
+void seek_state_init(seek_state_t *s);
+
+// Renderer: seek to total frame `target`. Returns 1 if it replaced a seek
+// still in flight.
+int seek_state_post(seek_state_t *s, int target, uint64_t now_us);
+
+// I/O side: the target to restart the files at, or -1 if none is pending.
+int seek_state_take(seek_state_t *s);
+
+// I/O side: done with what it took. Returns 1 if the seek is priming now,
+// 0 if a newer one was posted meanwhile.
+int seek_state_io_done(seek_state_t *s, uint64_t now_us);
+
+// Renderer: whether the seek in flight lands now, given whether its target
+// frame is decoded. Returns 1 once, when it does.
+int seek_state_land(seek_state_t *s, int ready, uint64_t now_us);
+
+// Bucket of a latency, and the histogram as "<8:n <16:n ... >=1024:n" with
+// empty buckets left out.
+int seek_state_bucket(uint64_t us);
+int seek_state_hist_str(const seek_state_t *s, char *buf, size_t size);
+
+#endif // SEEK_STATE_H
@@ -8,6 +8,9 @@
 #include <kos.h>
 #include <dc/sound/stream.h>
 #include <dc/sound/sound.h>
+#include <dc/sound/aica_comm.h>
+#include <dc/spu.h>
+#include <dc/g2bus.h>
 #include <dc/pvr.h>
 #include <dc/video.h>
 #include <stdatomic.h>
@@ -28,16 +31,15 @@
 #define USE_60HZ 1
 
 static mutex_t io_lock = MUTEX_INITIALIZER;
-#define ZSTD_STATIC_LINKING_ONLY
-#include <zstd/zstd.h>
-static ZSTD_DCtx *g_zstd_dctx = NULL;
-
-#define LZ4_FAST_DEC_LOOP 1 
-#define LZ4_FREESTANDING 1
-#define LZ4_memcpy(d,s,n)  memcpy_fast((d),(s),(n))
-#define LZ4_memmove(d,s,n) memmove_fast((d),(s),(n))
-#define LZ4_memset(d,v,n)  memset_fast((d),(v),(n))
-#include <lz4/lz4.h>
+#include "dcmv.h"
+#include "audio_ring.h"
+#include "seek_model.h"
+#include "frame_cache.h"
+#include "preload_queue.h"
+#include "load_sched.h"
+#include "aica_ring.h"
+#include "seek_state.h"
+#include "readahead_ring.h"
 
 // ---------------------------------------------------------------------------
 // 🎮 Singe Dreamcast runtime configuration (auto-loaded from singe.cfg)
@@ -49,12 +51,18 @@ char G_GAME_NAME[128]   = "Hologram Time Traveler";
 char G_VIDEO_FILE[128]  = "hologram.dcmv";
 char G_SCRIPT_FILE[128] = "Script/timetraveler.singe";
 char G_CHUNK_NAME[128]  = "@timetraveler.singe";
+char G_READ_TRACE[128]  = "";                 // singe.cfg read_trace=, off when empty
+int  G_SEEK_CACHE       = 1;                  // singe.cfg seek_cache=0 saves the pool's RAM
+int  G_PREFETCH_KB      = 1024;               // singe.cfg prefetch_kb=, discPrefetchRange budget
+int  G_READAHEAD_KB     = 0;                  // singe.cfg readahead_kb=, compressed read-ahead ring, 0 = off
+int  G_READAHEAD_S      = 4;                  // singe.cfg readahead_s=, how far ahead the ring reads
+int  G_DECODED_AHEAD    = 16;                 // singe.cfg decoded_ahead=, most frames decoded ahead (2-16)
+int  G_WORKER_POLL      = 0;                  // singe.cfg worker_poll=1, old 1 ms polling worker
+int  G_AUDIO_DIRECT_KB  = 0;                  // singe.cfg audio_direct_kb=, SPU RAM ring per channel, 0 = snd_stream
 
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 
-#define PREFETCH_AHEAD (MIN(NUM_BUFFERS, (int)(fps * 2.5f)))
-
 #define SINGE_FAKE_DISC_LAG_TICKS 800
 
 // Singe input switch constants
@@ -177,10 +185,14 @@ static SingeSprite *GSprites = NULL;
 static SingeSound *GSounds = NULL;
 static lua_State *GLua = NULL;
 
-// Video decoder state (same as Singe)
-#define DCMV_MAGIC "DCMV"
-#define NUM_BUFFERS 24
-#define RING_CAPACITY (NUM_BUFFERS + 1)
+// Video decoder state (same as Singe). Decoded frames live in g_frames, an
+// associative cache keyed by unique frame (frame_cache.h); NUM_BUFFERS is its
+// most slots, singe.cfg frame_slots= picks how many (default 24).
+#define NUM_BUFFERS FRAME_CACHE_MAX
+#define DEFAULT_FRAME_SLOTS 24
+#define PRELOAD_WINDOW 16               // most frames the worker keeps decoded ahead (load_sched.h)
+_Static_assert(PRELOAD_QUEUE_SIZE > PRELOAD_WINDOW, "the preload queue must hold a whole window");
+_Static_assert(DEFAULT_FRAME_SLOTS > DCMV_MAX_PACKET_FRAMES, "a whole interleaved packet must fit in the frame slots");
 
 enum BufState {
     BUF_EMPTY = 0,
@@ -188,24 +200,25 @@ enum BufState {
     BUF_READY = 2
 };
 
-typedef struct {
-    int frame;
-    int generation;
-} PreloadJob;
-
-static PreloadJob preload_ring[RING_CAPACITY];
-static atomic_int preload_ring_head = 0;
-static atomic_int preload_ring_tail = 0;
-
-static file_t video_fd = -1;
+// Frames to load, queued in deadline order by the worker and at seeks (see
+// sched_plan), loaded by the worker. Jobs from before a seek are skipped by
+// generation, jobs for frames the play head has passed are dropped.
+static preload_queue_t g_preload;
+static load_sched_t g_sched;
+static atomic_int g_seek_landed = -1;    // total frame the last seek went to
+
+// Seeks in flight (seek_state.h): fmv_tick posts and lands them, the worker
+// reopens the files. While one is in flight the last frame stays on screen,
+// the clock holds and the audio side treats the stream as muted.
+static seek_state_t g_seek;
+static mutex_t g_seek_lock = MUTEX_INITIALIZER;
+static atomic_int g_seek_holding = 0;
+static atomic_int g_seek_unique = -1;    // target's unique frame once primed (worker resolves it)
+
+static dcmv_t *g_dcmv = NULL;
 static file_t audio_fd_left = -1, audio_fd_right = -1;
-static long left_channel_size = 0;
-static uint8_t *compressed_buffer = NULL;
 static uint8_t *frame_buffer[NUM_BUFFERS];
-static uint32_t *frame_offsets = NULL;
-static uint16_t *frame_durations = NULL;
 static int last_unique_frame_drawn = -1;
-static atomic_int buf_ref_count[NUM_BUFFERS] = { 0 }; 
 static _Atomic int displayed_total_frame = 0; 
 static atomic_int frame_index = 0;
 static float fps;
@@ -223,11 +236,12 @@ static _Atomic double audio_start_time_ms = 0.0;
 static _Atomic int audio_muted = 0;
 static float frame_duration = 1.0f / 30.0f;
 static double frame_timer_anchor = 0.0;
-static _Atomic int buf_state[NUM_BUFFERS] = { BUF_EMPTY };
+static frame_cache_t g_frames;
+int G_FRAME_SLOTS = DEFAULT_FRAME_SLOTS;      // singe.cfg frame_slots=
+static int g_preload_window = PRELOAD_WINDOW; // decoded_ahead=, clamped
 
 int soundbufferalloc = 4096;
 static volatile int audio_started = 0;
-int use_zstd = 0;
 
 static _Atomic int g_audio_left_on  = 1;
 static _Atomic int g_audio_right_on = 1;
@@ -236,11 +250,173 @@ static _Atomic int g_audio_movie_vol = 255;  // 0..255 like KOS volume style
 
 static uint32_t fps_num = 0, fps_den = 0;
 static double frame_duration_ms = 0.0;
-static int *GTotalToUnique = NULL;
-static uint32_t vfd_last_end = 0;
 static long last_audio_left_pos = -1;
 static long last_audio_right_pos = -1;
 
+// audio_cb only copies out of per-channel RAM rings. Planar files fill them
+// from the audio fds with bulk reads on the audio reader thread, interleaved
+// ones from the worker's packet stream.
+#define AUDIO_RING_SIZE    (16 * 1024)   // per channel, ~740 ms of 44.1kHz ADPCM
+#define AUDIO_READ_CHUNK   (8 * 1024)    // one read, once a ring has that much room
+static audio_ring_t g_audio_ring[2];
+static atomic_int g_audio_starved = 0;   // callbacks the rings could not fill
+static uint8_t *g_audio_stage = NULL;    // AUDIO_READ_CHUNK, 32-byte aligned
+static atomic_uint g_audio_reads = 0;
+
+// Interleaved DCMV (DCMV_FLAG_INTERLEAVED): the worker reads A/V packets in
+// file order and fans them out to the frame slots and the audio rings, so the
+// drive streams one region instead of hopping between video and two audio fds.
+#define IL_AUDIO_RING_SIZE (64 * 1024)   // per channel, ~3s of 44.1kHz ADPCM
+#define IL_READ_CHUNK      (32 * 1024)   // check for a seek between chunks
+static int g_interleaved = 0;
+static uint8_t *il_packet_buf = NULL;
+static int il_next_packet = 0;
+static int il_min_unique = 0;            // frames before the seek target are dropped
+static uint32_t il_audio_pos = 0;        // stream position of the next byte to keep
+
+// Multi-frame Zstd blocks (BLKS): frames of a block nobody wants land here
+static uint8_t *g_block_scratch = NULL;
+
+// Delta frames (DLTA): per slot, the spans that changed since the previous
+// unique frame (-1 = whole frame), so the upload can skip the rest.
+#define SLOT_MAX_RUNS DCMV_DELTA_MAX_RUNS
+static int g_has_deltas = 0;
+static dcmv_span_t slot_runs[NUM_BUFFERS][SLOT_MAX_RUNS];
+static int slot_run_count[NUM_BUFFERS];
+static int g_txr_unique = -1;            // unique frame currently in pvr_txr
+
+// Codebook runs (CBTB): which run's codebook each slot and the texture hold
+static int slot_codebook[NUM_BUFFERS];
+static int g_txr_codebook = -1;
+
+// Renditions (REND): the same timeline at other resolutions. The worker picks
+// one per segment of REND_SEGMENT_FRAMES unique frames from how long loads
+// take against the frame budget (and whether the renderer had to wait), and
+// every slot remembers which one it holds. Frame numbers never change, so the
+// Lua side sees one movie at the primary's size.
+#define REND_SEGMENT_FRAMES 32
+#define REND_DOWN_HEADROOM  0.20f   // step down below this, or after a late frame
+#define REND_UP_HEADROOM    0.60f   // step up if the bigger one would keep this
+#define REND_UP_SEGMENTS    2       // ... for this many segments in a row
+typedef struct {
+    int index;                      // reader rendition
+    dcmv_rendition_t info;
+    pvr_poly_hdr_t hdr;
+    pvr_vertex_t vert[4];
+    int strided;
+} rend_view_t;
+static rend_view_t g_rends[DCMV_MAX_RENDITIONS];   // primary, then largest frames first
+static int g_rend_count = 1;
+static int slot_rend[NUM_BUFFERS];
+static int g_txr_rend = 0;                // view in pvr_txr, hdr and vert
+// Worker side
+static int g_rend_level = 0, g_rend_prev_level = 0, g_rend_segment = -1;
+static int g_rend_good_segments = 0;
+static float g_rend_headroom = 1.0f;      // 1 - load time / frame budget, smoothed
+static atomic_int g_rend_late = 0;        // frames the renderer waited for
+static atomic_uint g_render_waits = 0;    // the same, never reset
+static atomic_int g_rend_switches = 0;
+
+// Branch hints (<movie>.hints, written by tools/singe-hints): the jumps the
+// script can take. When the preload window is full the worker decodes the
+// first frames of the likeliest targets into a small pool, and seek_service_io
+// swaps them into the frame slots, so a branch starts without a drive seek.
+#define HINT_MAX_JUMPS     512
+#define HINT_MAX_SEGMENTS  256
+#define HINT_POOL_FRAMES   8
+#define HINT_TARGET_FRAMES 2        // frames decoded per target
+#define HINT_LOOKAHEAD_S   10       // how far ahead to look outside any segment
+typedef struct {
+    int from, to, count;            // from -1: not tied to a frame
+} hint_jump_t;
+typedef struct {
+    uint8_t *buf;
+    int unique, codebook;
+    atomic_int state;               // BUF_EMPTY / BUF_LOADING / BUF_READY
+} hint_frame_t;
+static hint_jump_t g_hint_jumps[HINT_MAX_JUMPS];   // tied by source frame, then untied by count
+static int g_hint_jump_count = 0, g_hint_tied = 0;
+static int g_hint_seg_start[HINT_MAX_SEGMENTS], g_hint_seg_end[HINT_MAX_SEGMENTS];
+static int g_hint_seg_count = 0;
+static hint_frame_t g_hint_pool[HINT_POOL_FRAMES];
+static int g_hints_enabled = 0;            // pool allocated (planar, non-delta movies)
+static atomic_int g_hint_hits = 0, g_hint_misses = 0;
+
+// Seek cache: the same pool also holds the targets the game itself has jumped
+// to from the playing segment (seek_model.h), learned as it is played, so
+// games without a .hints file get warm seeks too. Learned targets go first.
+static seek_model_t g_seek_model;
+static mutex_t g_seek_model_lock = MUTEX_INITIALIZER;
+
+// Script prefetch (discPrefetchRange): compressed payloads of the ranges a
+// script says it may skip to, pinned in RAM within prefetch_kb so a skip into
+// one decodes without touching the disc. The worker fetches a block at a time
+// from each range's start, only while the preload window is full; a higher
+// priority range can take the tail of a lower one, never the other way round.
+// Lua queues requests, the worker applies them and owns the payload memory.
+#define PREFETCH_MAX_RANGES 16
+typedef struct {
+    int first, end;                 // unique frames [first, end); priority 0 = slot free
+    int start, count;               // the request, in total frames
+    int priority;
+    uint32_t order;                 // request sequence, among equals older ranges stay
+    int first_block, blocks;
+    int fetched, next;              // blocks held (a prefix), first unique not held
+    int ready;                      // total frames held from start, for discPrefetchStatus
+    int stuck;                      // no room at this priority until something changes
+    uint8_t **data;                 // per block, worker thread only
+    uint32_t *size;
+    int *block_start;
+    int *total_end;                 // per block, the total frame after it
+} prefetch_range_t;
+typedef struct {
+    int start, count, priority;
+    int first, end;                 // unique frames, looked up by the worker outside g_pf_lock
+} prefetch_request_t;
+static prefetch_range_t g_pf_ranges[PREFETCH_MAX_RANGES];   // metadata under g_pf_lock
+static prefetch_request_t g_pf_pending[PREFETCH_MAX_RANGES];
+static int g_pf_pending_count = 0;
+static mutex_t g_pf_lock = MUTEX_INITIALIZER;
+static uint32_t g_pf_budget = 0, g_pf_used = 0, g_pf_order = 0;
+static int g_pf_enabled = 0;
+static atomic_int g_pf_hits = 0;
+
+// Read-ahead ring (singe.cfg readahead_kb=): compressed payloads from the
+// play head on, read several seconds deep in one byte ring, so the decoded
+// window can shrink to a few frames decompressed just before they are shown
+// (decoded_ahead=). Two stages: the reader thread streams blocks into the
+// ring while the worker decompresses out of it, so drive time and CPU time
+// overlap. The ring's bytes and block slots bound how far the reader gets
+// ahead, the frame cache how far the worker does. Blocks are held in unique
+// order; contiguous ones on disc are read with one command. The reader owns
+// the ring, the worker pins the one block it is decompressing; the index is
+// under g_ra_lock, the read itself is not.
+#define READAHEAD_READ_MAX   (32 * 1024)      // bytes per read, keeps io_lock free for audio
+static uint8_t *g_ra_buf = NULL;
+static readahead_ring_t g_ra;                 // index of the blocks in g_ra_buf
+static int g_ra_base = 0, g_ra_next = 0;      // unique frames [base, next) held
+static int g_ra_reading = 0;                  // [next, reading) being read
+static int g_ra_pinned = -1;                  // first unique of the block the worker decodes
+static mutex_t g_ra_lock = MUTEX_INITIALIZER;
+static int g_ra_enabled = 0;
+static kthread_t *g_reader_thread;
+static mutex_t g_reader_lock = MUTEX_INITIALIZER;
+static condvar_t g_reader_cv = COND_INITIALIZER;
+static int g_reader_pending = 0;              // under g_reader_lock
+static atomic_uint g_ra_hits = 0, g_ra_misses = 0;
+static atomic_uint g_ra_waits = 0;            // worker waited for a read in flight
+static atomic_uint g_ra_held = 0;             // bytes, for the seek log
+static atomic_int g_ra_ahead = 0;             // unique frames read past the play head
+
+// Read trace (singe.cfg read_trace=/pc/...): every unique frame the worker
+// loads and every seek, in order, for tools/dcmv-relayout. Entries collect in
+// RAM and are written out at the next seek, which stalls playback anyway.
+#define TRACE_ENTRIES 16384
+static file_t g_trace_fd = -1;
+static int32_t *g_trace_buf;               // unique frame, or -1 - total frame for a seek
+static atomic_int g_trace_len = 0;
+static atomic_int g_trace_dropped = 0;
+
 // ============================================================================
 // Dreamcast Singe Overlay RTT Implementation (non-twiddled ARGB1555)
 // Maintains original Lua overlay coordinates (GOverlayWidth/GOverlayHeight)
@@ -421,10 +597,21 @@ static void init_timebase_from_fps(float fpsf) {
     frame_duration_ms = (1000.0 * (double)fps_den) / (double)fps_num;
 }
 
+// No per-total-frame table: the reader maps through sampled prefix sums of
+// the duration table it already holds (see dcmv_total_to_unique).
 static inline int total_to_unique_frame(int total_frame) {
     if ((unsigned)total_frame >= (unsigned)num_total_frames)
         return num_unique_frames - 1;
-    return GTotalToUnique[total_frame];
+    return dcmv_total_to_unique(g_dcmv, total_frame);
+}
+
+// Main thread: the same without reading the disc. With paged tables the
+// worker keeps the play head's pages loaded (dcmv_pin_pages); -1 if it has
+// not caught up yet, and the caller keeps the frame on screen.
+static inline int playhead_to_unique_frame(int total_frame) {
+    if ((unsigned)total_frame >= (unsigned)num_total_frames)
+        return num_unique_frames - 1;
+    return dcmv_total_to_unique_nowait(g_dcmv, total_frame);
 }
 
 static SingeSprite *get_sprite_by_hash_id(unsigned long hash_id) {
@@ -441,7 +628,7 @@ static int is_pow2(int n) { return n > 0 && (n & (n - 1)) == 0; }
 
 // Audio callback
 static size_t audio_cb(snd_stream_hnd_t hnd, uintptr_t l, uintptr_t r, size_t req) {
-    if (atomic_load(&audio_muted)) {
+    if (atomic_load(&audio_muted) || atomic_load(&g_seek_holding)) {
         memset((void *)l, 0, req);
         if (audio_channels == 2)
             memset((void *)r, 0, req);
@@ -449,373 +636,1625 @@ static size_t audio_cb(snd_stream_hnd_t hnd, uintptr_t l, uintptr_t r, size_t re
     }
 
     size_t half = req / 2;
-    size_t lbytes = 0, rbytes = 0;
 
-    // Left channel audio
-    if (atomic_load(&g_audio_left_on)) {
-        // If not muted, read from the current position
-        mutex_lock(&io_lock);
-        lbytes = fs_read(audio_fd_left, (void *)l, half);
-        mutex_unlock(&io_lock);
-        last_audio_left_pos += lbytes;  // Update position
-    } else {
-        memset((void *)l, 0, half);  // Mute the left channel
-        lbytes = half;
-        last_audio_left_pos += lbytes;  // Advance the position, even when muted
+    // The rings are filled ahead by the audio reader or the packet stream;
+    // pad with silence on underrun. A muted channel still moves on.
+    for (int ch = 0; ch < 2; ch++) {
+        uint8_t *dst = (uint8_t *)(ch == 0 ? l : r);
+        int on = atomic_load(ch == 0 ? &g_audio_left_on : &g_audio_right_on);
+        size_t got = 0;
+        if (ch == 0 || audio_channels == 2) {
+            if (on) got = audio_ring_read(&g_audio_ring[ch], dst, half);
+            else audio_ring_skip(&g_audio_ring[ch], half);
+        }
+        if (got < half) {
+            memset(dst + got, 0, half - got);
+            if (on && (ch == 0 || audio_channels == 2)) atomic_fetch_add(&g_audio_starved, 1);
+        }
+    }
+    last_audio_left_pos += half;
+    last_audio_right_pos += half;
+    return half * 2;
+}
+
+// --- Audio reader: bulk reads from the audio fds into the rings (planar) ---
+// g_audio_fill_lock is held for a whole fill pass, so a seek that takes it
+// knows the reader is between reads. Lock order: fill, audio, io.
+static kthread_t *g_audio_reader;
+static mutex_t g_audio_fill_lock = MUTEX_INITIALIZER;
+static mutex_t g_audio_reader_lock = MUTEX_INITIALIZER;
+static condvar_t g_audio_reader_cv = COND_INITIALIZER;
+static int g_audio_reader_pending = 0;        // under g_audio_reader_lock
+
+static void audio_fill_wake(void) {
+    if (g_interleaved || !g_audio_reader) return;
+    mutex_lock(&g_audio_reader_lock);
+    g_audio_reader_pending = 1;
+    cond_signal(&g_audio_reader_cv);
+    mutex_unlock(&g_audio_reader_lock);
+}
+
+// Top the rings up a chunk at a time, channels in turn so neither runs ahead
+static void audio_fill(void) {
+    int channels = audio_channels == 2 ? 2 : 1, progress = 1;
+    mutex_lock(&g_audio_fill_lock);
+    while (progress) {
+        progress = 0;
+        for (int ch = 0; ch < channels; ch++) {
+            if (audio_ring_space(&g_audio_ring[ch]) < AUDIO_READ_CHUNK) continue;
+            mutex_lock(&io_lock);
+            ssize_t n = fs_read(ch == 0 ? audio_fd_left : audio_fd_right, g_audio_stage, AUDIO_READ_CHUNK);
+            mutex_unlock(&io_lock);
+            if (n <= 0) continue;             // end of the stream
+            audio_ring_write(&g_audio_ring[ch], g_audio_stage, (uint32_t)n);
+            atomic_fetch_add(&g_audio_reads, 1);
+            progress = 1;
+        }
     }
+    mutex_unlock(&g_audio_fill_lock);
+}
 
-    // Right channel audio
-    if (atomic_load(&g_audio_right_on)) {
-        // If not muted, read from the current position
-        mutex_lock(&io_lock);
-        rbytes = fs_read(audio_fd_right, (void *)r, half);
-        mutex_unlock(&io_lock);
-        last_audio_right_pos += rbytes;  // Update position
-    } else {
-        memset((void *)r, 0, half);  // Mute the right channel
-        rbytes = half;
-        last_audio_right_pos += rbytes;  // Advance the position, even when muted
+static void *audio_reader_thread(void *p) {
+    (void)p;
+    while (1) {
+        audio_fill();
+        // The audio thread wakes us once a ring has room for a chunk
+        mutex_lock(&g_audio_reader_lock);
+        if (!g_audio_reader_pending)
+            cond_wait_timed(&g_audio_reader_cv, &g_audio_reader_lock, 100);
+        g_audio_reader_pending = 0;
+        mutex_unlock(&g_audio_reader_lock);
     }
+    return NULL;
+}
 
-    return lbytes + rbytes;
+// The sound stream is serviced by its own thread at a higher priority than
+// the worker, every AUDIO_SERVICE_MS, so a slow decompression or a read
+// blocked on io_lock no longer starves it. KOS refills half the AICA buffer
+// once playback crosses into the other half: a gap between polls longer than
+// that half's play time means it looped stale samples. g_audio_lock is held
+// around the poll, so code that moves the stream (seeks, il_apply_reset) does
+// not run under a callback. Every AUDIO_REPORT_MS it logs the polls, the
+// worst gap and the late ones.
+#define AUDIO_SERVICE_MS  4
+#define AUDIO_REPORT_MS   10000
+#define AUDIO_THREAD_PRIO (PRIO_DEFAULT - 2)    // KOS runs lower numbers first
+
+static kthread_t *g_audio_thread;
+static mutex_t g_audio_lock = MUTEX_INITIALIZER;
+static struct {
+    uint32_t budget_us;                       // play time of half the stream buffer
+    atomic_uint polls, late;                  // late: gap over budget_us, an underrun
+    atomic_uint worst_gap_us;                 // since startup
+    uint32_t window_polls, window_late, window_worst_us;   // audio thread only
+    uint64_t since_us;
+} g_audio_svc;
+
+static void audio_account(uint64_t now, uint64_t gap) {
+    atomic_fetch_add(&g_audio_svc.polls, 1);
+    g_audio_svc.window_polls++;
+    if (gap > g_audio_svc.budget_us) {
+        atomic_fetch_add(&g_audio_svc.late, 1);
+        g_audio_svc.window_late++;
+    }
+    if (gap > g_audio_svc.window_worst_us) g_audio_svc.window_worst_us = (uint32_t)gap;
+    if (gap > atomic_load(&g_audio_svc.worst_gap_us)) atomic_store(&g_audio_svc.worst_gap_us, (uint32_t)gap);
+
+    if (now - g_audio_svc.since_us >= AUDIO_REPORT_MS * 1000ULL) {
+        DC_log("[Audio] %u polls over %.1f s, worst gap %.1f ms (underrun past %.1f ms), %u late; "
+               "%u since start, worst %.1f ms", g_audio_svc.window_polls, (now - g_audio_svc.since_us) / 1e6,
+               g_audio_svc.window_worst_us / 1000.0, g_audio_svc.budget_us / 1000.0, g_audio_svc.window_late,
+               atomic_load(&g_audio_svc.late), atomic_load(&g_audio_svc.worst_gap_us) / 1000.0);
+        g_audio_svc.window_polls = g_audio_svc.window_late = g_audio_svc.window_worst_us = 0;
+        g_audio_svc.since_us = now;
+    }
 }
 
+// --- Direct AICA streaming (singe.cfg audio_direct_kb=) ---
+// snd_stream plays out of 4 KB per channel, so the SH4 refills 2 KB every
+// ~93 ms. In direct mode the engine programs its own channels to loop over
+// an ADPCM ring of audio_direct_kb per channel in SPU RAM and refills it a
+// quarter at a time by G2 DMA from the RAM rings, half as often with a 16 KB
+// ring, and the audio thread only looks every AICA_DIRECT_SERVICE_MS. aica_ring
+// keeps the books; a mute stops the channels and unmuting primes the ring
+// and starts them again from its start. Audio thread only, under
+// g_audio_lock.
+//
+// The channel's length and loop registers count samples in 16 bits (the
+// driver masks them), two ADPCM samples a byte, so one channel loops over
+// 32 KB less a byte at most: the ring tops out at 16 KB, 32768 samples.
+#define AICA_DIRECT_SERVICE_MS 50
+#define AICA_LOOP_MAX_SAMPLES  0xffff
+#define AICA_DIRECT_MIN_KB     8              // a 2 KB refill outlasts a service period
+#define AICA_DIRECT_MAX_KB     16
+
+static struct {
+    int enabled, playing;
+    int chn[2];
+    uint32_t spu[2];                          // ring per channel in SPU RAM
+    aica_ring_t ring;
+    uint8_t *stage;                           // one chunk, 32-byte aligned
+    uint64_t serviced_us;                     // last position read
+    uint32_t dma_fallbacks;                   // refills copied by the CPU
+} g_aica = { .chn = { -1, -1 } };
+
+// SPU RAM ring per channel for audio_direct_kb, a power of two; 0 when off
+static uint32_t aica_direct_bytes(void) {
+    if (G_AUDIO_DIRECT_KB <= 0) return 0;
+    uint32_t kb = AICA_DIRECT_MIN_KB;
+    while (kb * 2 <= (uint32_t)G_AUDIO_DIRECT_KB && kb < AICA_DIRECT_MAX_KB) kb *= 2;
+    return kb * 1024;
+}
+
+// The RAM rings have to hold two refills
+static uint32_t audio_ring_bytes(uint32_t base) {
+    uint32_t bytes = base;
+    while (bytes < aica_direct_bytes() / 2) bytes *= 2;
+    return bytes;
+}
+
+static int aica_direct_init(void) {
+    uint32_t size = aica_direct_bytes();
+    int channels = audio_channels == 2 ? 2 : 1;
+    if (!size || size * 2 > AICA_LOOP_MAX_SAMPLES || aica_ring_init(&g_aica.ring, size, size / 4) < 0)
+        return -1;
+    g_aica.stage = memalign(32, size / 4);
+    for (int c = 0; c < channels; c++) {
+        g_aica.chn[c] = snd_sfx_chn_alloc();
+        g_aica.spu[c] = snd_mem_malloc(size);
+    }
+    // Starting in sync takes a channel mask of the first 32
+    int ok = g_aica.stage != NULL;
+    for (int c = 0; c < channels; c++)
+        ok &= g_aica.chn[c] >= 0 && g_aica.chn[c] < 32 && g_aica.spu[c] != 0;
+    if (!ok) {
+        for (int c = 0; c < channels; c++) {
+            if (g_aica.chn[c] >= 0) snd_sfx_chn_free(g_aica.chn[c]);
+            if (g_aica.spu[c]) snd_mem_free(g_aica.spu[c]);
+        }
+        free(g_aica.stage);
+        return -1;
+    }
+    g_aica.enabled = 1;
+    return 0;
+}
 
+static void aica_direct_command(int chn, uint32_t what) {
+    int channels = audio_channels == 2 ? 2 : 1;
+    AICA_CMDSTR_CHANNEL(tmp, cmd, chan);
+    memset(tmp, 0, sizeof(tmp));
+    cmd->cmd = AICA_CMD_CHAN;
+    cmd->timestamp = 0;
+    cmd->size = AICA_CMDSTR_CHANNEL_SIZE;
+    cmd->cmd_id = chn;
+    chan->cmd = what;
+    if (what == (AICA_CH_CMD_START | AICA_CH_START_DELAY)) {
+        int c = chn == g_aica.chn[0] ? 0 : 1;
+        int vol = atomic_load(&g_audio_movie_vol);
+        chan->base = g_aica.spu[c];
+        chan->type = AICA_SM_ADPCM_LS;
+        chan->length = g_aica.ring.size * 2;  // samples, two per byte
+        chan->loop = 1;
+        chan->loopstart = 0;
+        chan->loopend = g_aica.ring.size * 2;
+        chan->freq = sample_rate;
+        chan->vol = vol < 0 ? 0 : vol > 255 ? 255 : vol;
+        chan->pan = channels == 1 ? 128 : c == 0 ? 0 : 255;
+    }
+    snd_sh4_to_aica(tmp, cmd->size);
+}
 
-// Frame loading
-static int load_frame(int unique_frame, int buf_index) {
-    uint32_t offset = frame_offsets[unique_frame];
-    uint32_t next_offset = frame_offsets[unique_frame + 1];
-    uint32_t compressed_size = next_offset - offset;
-    
-    if (vfd_last_end != (long)offset) {
-        mutex_lock(&io_lock);
-        fs_seek(video_fd, offset, SEEK_SET);
-        mutex_unlock(&io_lock);
-        vfd_last_end = offset;
+// DMA refills until the ring is full. While SPU RAM still holds a chunk to
+// play, a short RAM ring waits for the reader instead of padding silence.
+static void aica_direct_fill(void) {
+    int channels = audio_channels == 2 ? 2 : 1;
+    uint32_t off, len;
+    while ((len = aica_ring_next(&g_aica.ring, &off)) > 0) {
+        if (audio_ring_used(&g_audio_ring[0]) < len && aica_ring_buffered(&g_aica.ring) >= g_aica.ring.chunk)
+            break;
+        for (int c = 0; c < channels; c++) {
+            int on = atomic_load(c == 0 ? &g_audio_left_on : &g_audio_right_on);
+            uint32_t got = 0;
+            if (on) got = audio_ring_read(&g_audio_ring[c], g_aica.stage, len);
+            else audio_ring_skip(&g_audio_ring[c], len);
+            if (got < len) {
+                memset(g_aica.stage + got, 0, len - got);
+                if (on) atomic_fetch_add(&g_audio_starved, 1);
+            }
+            // G2 DMA reads RAM, not the cache the copy above went through
+            dcache_flush_range((uintptr_t)g_aica.stage, len);
+            if (spu_dma_transfer(g_aica.stage, g_aica.spu[c] + off, len, 1, NULL, NULL) < 0) {
+                spu_memload(g_aica.spu[c] + off, g_aica.stage, len);
+                g_aica.dma_fallbacks++;
+            }
+        }
+        aica_ring_commit(&g_aica.ring, len);
+        last_audio_left_pos += len;
+        last_audio_right_pos += len;
     }
+}
+
+static void aica_direct_tick(int muted) {
+    int channels = audio_channels == 2 ? 2 : 1;
+    if (muted) {
+        if (g_aica.playing) {
+            for (int c = 0; c < channels; c++)
+                aica_direct_command(g_aica.chn[c], AICA_CH_CMD_STOP);
+            g_aica.playing = 0;
+        }
+        return;
+    }
+    if (!g_aica.playing) {
+        aica_ring_reset(&g_aica.ring);
+        aica_direct_fill();
+        uint32_t mask = 0;
+        for (int c = 0; c < channels; c++) {
+            aica_direct_command(g_aica.chn[c], AICA_CH_CMD_START | AICA_CH_START_DELAY);
+            mask |= 1u << g_aica.chn[c];
+        }
+        aica_direct_command(mask, AICA_CH_CMD_START | AICA_CH_START_SYNC);
+        g_aica.playing = 1;
+        g_aica.serviced_us = timer_us_gettime64();
+        return;
+    }
+    // Samples to bytes: two per byte. The clock tells laps the position cannot.
+    uint64_t now = timer_us_gettime64();
+    uint32_t pos = g2_read_32(SPU_RAM_UNCACHED_BASE + AICA_CHANNEL(g_aica.chn[0]) +
+                              offsetof(aica_channel_t, pos));
+    uint32_t elapsed = (uint32_t)((now - g_aica.serviced_us) * (uint64_t)sample_rate / 2000000ULL);
+    g_aica.serviced_us = now;
+    aica_ring_advance(&g_aica.ring, pos / 2, elapsed);
+    aica_direct_fill();
+}
+
+void *audio_thread(void *p) {
+    (void)p;
+    uint64_t last = 0;
+    g_audio_svc.since_us = timer_us_gettime64();
+    while (1) {
+        int muted = atomic_load(&audio_muted) || atomic_load(&g_seek_holding);
+        if (g_aica.enabled) {
+            mutex_lock(&g_audio_lock);
+            aica_direct_tick(muted);
+            mutex_unlock(&g_audio_lock);
+        }
+        if (muted) {
+            last = 0;                         // a muted stream is not due anything
+        } else {
+            uint64_t now = timer_us_gettime64();
+            if (last) audio_account(now, now - last);
+            last = now;
+            if (!g_aica.enabled) {
+                mutex_lock(&g_audio_lock);
+                snd_stream_poll(stream);
+                mutex_unlock(&g_audio_lock);
+            }
+            if (audio_ring_space(&g_audio_ring[0]) >= AUDIO_READ_CHUNK)
+                audio_fill_wake();
+        }
+        thd_sleep(g_aica.enabled ? AICA_DIRECT_SERVICE_MS : AUDIO_SERVICE_MS);
+    }
+    return NULL;
+}
+
+
+
+// io_lock hooks for the DCMV reader
+static void dcmv_io_lock(void *arg)   { mutex_lock((mutex_t *)arg); }
+static void dcmv_io_unlock(void *arg) { mutex_unlock((mutex_t *)arg); }
+
+// Single frame into a slot. With codebook runs the slot remembers whose
+// codebook it holds, so a frame of the same run only decompresses indices.
+static int decompress_frame_into_slot(const uint8_t *payload, uint32_t size, int unique, int buf) {
+    int run = dcmv_codebook_run(g_dcmv, unique);
+    int res = dcmv_decompress_frame(g_dcmv, unique, payload, size, frame_buffer[buf],
+                                    run >= 0 && slot_codebook[buf] == run);
+    slot_codebook[buf] = res == 0 ? run : -1;
+    return res;
+}
+
+// Decompress a block payload holding [first, first + count). Frames from
+// min_unique on are decoded into slots claimed for them when the cache has
+// room; frame `own` goes to own_buf, a slot the caller already holds.
+// Everything else goes to the scratch buffer.
+static int decode_block_into_slots(const uint8_t *payload, uint32_t size, int first, int count,
+                                   int min_unique, int own, int own_buf) {
+    // Zeroed: gcc cannot see that dcmv_decompress_block reads only [0, count)
+    void *dst[DCMV_MAX_PACKET_FRAMES] = { NULL };
+    int bufs[DCMV_MAX_PACKET_FRAMES];
+    if (count < 1 || count > DCMV_MAX_PACKET_FRAMES) return -1;
+
+    for (int i = 0; i < count; i++) {
+        int unique = first + i;
+        bufs[i] = unique == own ? own_buf : unique >= min_unique ? frame_cache_claim(&g_frames, unique) : -1;
+        dst[i] = bufs[i] >= 0 ? frame_buffer[bufs[i]] : g_block_scratch;
+        if (bufs[i] >= 0) slot_rend[bufs[i]] = 0;
+    }
+
+    int res;
+    if (count == 1)
+        res = bufs[0] >= 0 ? decompress_frame_into_slot(payload, size, first, bufs[0]) : 0;
+    else
+        res = dcmv_decompress_block(g_dcmv, payload, size, dst, count);
+    for (int i = 0; i < count; i++) {
+        if (bufs[i] >= 0 && first + i != own)
+            frame_cache_done(&g_frames, bufs[i], res == 0);
+    }
+    return res;
+}
+
+// Delta files: every frame goes through the reader's reference frame in
+// order. Frames before min_unique (or that find no slot) only advance it.
+static int decode_delta_into_slot(const uint8_t *payload, uint32_t size, int unique, int min_unique) {
+    int buf = unique < min_unique ? -1 : frame_cache_claim(&g_frames, unique);
+    if (buf < 0)
+        return dcmv_decode_payload(g_dcmv, unique, payload, size, NULL, NULL, 0, NULL);
+
+    slot_rend[buf] = 0;
+    slot_codebook[buf] = -1;
+    int res = dcmv_decode_payload(g_dcmv, unique, payload, size, frame_buffer[buf],
+                                  slot_runs[buf], SLOT_MAX_RUNS, &slot_run_count[buf]);
+    frame_cache_done(&g_frames, buf, res == 0);
+    return res;
+}
+
+// Rendition for a unique frame; decides at the first load of each segment.
+// Worker thread only.
+static int rend_pick(int unique) {
+    int seg = unique / REND_SEGMENT_FRAMES;
+    if (g_rend_count == 1 || seg == g_rend_segment) return g_rend_level;
+    if (seg == g_rend_segment - 1) return g_rend_prev_level;   // straggler
+
+    int level = g_rend_level;
+    int late = atomic_exchange(&g_rend_late, 0);
+    if ((late || g_rend_headroom < REND_DOWN_HEADROOM) && level + 1 < g_rend_count) {
+        level++;
+        g_rend_good_segments = 0;
+    } else if (level > 0 && !late) {
+        // Load time scales roughly with the frame size
+        float ratio = (float)g_rends[level - 1].info.video_frame_size / (float)g_rends[level].info.video_frame_size;
+        float predicted = 1.0f - (1.0f - g_rend_headroom) * ratio;
+        if (predicted < REND_UP_HEADROOM) g_rend_good_segments = 0;
+        else if (++g_rend_good_segments >= REND_UP_SEGMENTS) {
+            level--;
+            g_rend_good_segments = 0;
+        }
+    }
+    if (level != g_rend_level) {
+        DC_log("[Worker] Rendition %dx%d -> %dx%d at unique %d (headroom %.2f, late %d)",
+               g_rends[g_rend_level].info.width, g_rends[g_rend_level].info.height,
+               g_rends[level].info.width, g_rends[level].info.height, unique, g_rend_headroom, late);
+        atomic_fetch_add(&g_rend_switches, 1);
+    }
+    g_rend_prev_level = seg == g_rend_segment + 1 ? g_rend_level : level;
+    g_rend_level = level;
+    g_rend_segment = seg;
+    return level;
+}
+
+static int load_primary_frame(int unique_frame, int buf_index);
+
+// Worker wake-ups (see worker_wake)
+#define WORKER_HOUSEKEEPING_MS 10
+#define WORKER_STALL_MS        120
+#define WORKER_REPORT_MS       10000
+static void worker_wake(void);
+static void worker_wait(int ms);
+static void reader_wake(void);
+static void seek_stats_report(void);
+
+// Read trace: worker and main thread append, entries past the buffer are counted
+static void trace_add(int32_t v) {
+    if (g_trace_fd < 0) return;
+    int i = atomic_fetch_add(&g_trace_len, 1);
+    if (i < TRACE_ENTRIES) g_trace_buf[i] = v;
+    else atomic_fetch_add(&g_trace_dropped, 1);
+}
+
+// Worker thread, at a seek
+static void trace_flush(void) {
+    if (g_trace_fd < 0) return;
+    int n = MIN(atomic_load(&g_trace_len), TRACE_ENTRIES);
+    char text[4096];
+    int len = 0;
     mutex_lock(&io_lock);
-    fs_read(video_fd, compressed_buffer, compressed_size);
+    for (int i = 0; i < n; i++) {
+        if (len > (int)sizeof(text) - 32) {
+            fs_write(g_trace_fd, text, len);
+            len = 0;
+        }
+        int32_t v = g_trace_buf[i];
+        len += v < 0 ? sprintf(text + len, "seek %d\n", (int)(-1 - v))
+                     : sprintf(text + len, "%d\n", (int)v);
+    }
+    if (len) fs_write(g_trace_fd, text, len);
     mutex_unlock(&io_lock);
-    vfd_last_end = offset + compressed_size;
-    
-    if (use_zstd == 1) {
-        ZSTD_DCtx_reset(g_zstd_dctx, ZSTD_reset_session_only);
-        ZSTD_inBuffer in = { compressed_buffer, compressed_size, 0 };
-        ZSTD_outBuffer out = { frame_buffer[buf_index], (size_t)video_frame_size, 0 };
-        
-        size_t ret = 1;
-        while (ret != 0 && out.pos < out.size) {
-            ret = ZSTD_decompressStream(g_zstd_dctx, &out, &in);
-            if (ZSTD_isError(ret)) return -1;
+    atomic_store(&g_trace_len, 0);
+    int dropped = atomic_exchange(&g_trace_dropped, 0);
+    if (dropped)
+        DC_log("[Trace] buffer full, %d entries dropped", dropped);
+}
+
+static void trace_open(const char *videopath) {
+    if (!G_READ_TRACE[0]) return;
+    g_trace_buf = malloc(TRACE_ENTRIES * sizeof(int32_t));
+    mutex_lock(&io_lock);
+    g_trace_fd = g_trace_buf ? fs_open(G_READ_TRACE, O_WRONLY | O_TRUNC) : -1;
+    if (g_trace_fd >= 0) {
+        char head[300];
+        int len = snprintf(head, sizeof(head), "# dcmv-trace 1 %s\n", videopath);
+        fs_write(g_trace_fd, head, len);
+    }
+    mutex_unlock(&io_lock);
+    if (g_trace_fd < 0) {
+        printf("   Read trace: cannot write %s\n", G_READ_TRACE);
+        free(g_trace_buf);
+        g_trace_buf = NULL;
+        return;
+    }
+    printf("   Read trace: %s\n", G_READ_TRACE);
+}
+
+// --- Script prefetch (worker side; g_pf_lock held where noted) ---
+// The lookup of r->next is done when a block is fetched, so `ready` needs
+// none here.
+static void prefetch_set_ready(prefetch_range_t *r) {
+    int ready = r->fetched == 0 ? 0 : r->next >= r->end ? r->count : r->total_end[r->fetched - 1] - r->start;
+    r->ready = ready < 0 ? 0 : MIN(ready, r->count);
+}
+
+static void prefetch_drop_blocks(prefetch_range_t *r, int keep) {
+    while (r->fetched > keep) {
+        r->fetched--;
+        free(r->data[r->fetched]);
+        g_pf_used -= r->size[r->fetched];
+        r->next = r->block_start[r->fetched];
+    }
+    prefetch_set_ready(r);
+}
+
+// g_pf_lock held
+static void prefetch_release(prefetch_range_t *r) {
+    prefetch_drop_blocks(r, 0);
+    free(r->data);
+    free(r->size);
+    free(r->block_start);
+    free(r->total_end);
+    memset(r, 0, sizeof(*r));
+    for (int i = 0; i < PREFETCH_MAX_RANGES; i++) g_pf_ranges[i].stuck = 0;
+}
+
+// g_pf_lock held. A new range takes a free slot, else the weakest one if it
+// is not above the request.
+static void prefetch_apply(const prefetch_request_t *q) {
+    int first = q->first, end = q->end;
+    prefetch_range_t *r = NULL, *weakest = NULL;
+    for (int i = 0; i < PREFETCH_MAX_RANGES; i++) {
+        prefetch_range_t *c = &g_pf_ranges[i];
+        if (c->priority > 0 && c->start == q->start) r = c;
+        if (!weakest || c->priority < weakest->priority ||
+            (c->priority == weakest->priority && c->order < weakest->order))
+            weakest = c;
+    }
+    if (r && (q->priority <= 0 || r->count != q->count)) {
+        prefetch_release(r);
+        if (q->priority <= 0) return;
+    } else if (r) {
+        r->priority = q->priority;
+        r->order = ++g_pf_order;
+        for (int i = 0; i < PREFETCH_MAX_RANGES; i++) g_pf_ranges[i].stuck = 0;
+        return;
+    }
+    if (q->priority <= 0 || q->count <= 0) return;
+    if (!r) {
+        if (weakest->priority > q->priority) {
+            DC_log("[Prefetch] no slot for frames %d+%d at priority %d", q->start, q->count, q->priority);
+            return;
         }
-        if (out.pos != (size_t)video_frame_size) return -1;
+        if (weakest->priority > 0) prefetch_release(weakest);
+        r = weakest;
+    }
+
+    int last_first, count;
+    r->first_block = dcmv_block_of(g_dcmv, first, &r->next, &count);
+    r->blocks = dcmv_block_of(g_dcmv, end - 1, &last_first, &count) - r->first_block + 1;
+    r->data = calloc((size_t)r->blocks, sizeof(uint8_t *));
+    r->size = calloc((size_t)r->blocks, sizeof(uint32_t));
+    r->block_start = calloc((size_t)r->blocks, sizeof(int));
+    r->total_end = calloc((size_t)r->blocks, sizeof(int));
+    if (!r->data || !r->size || !r->block_start || !r->total_end) {
+        prefetch_release(r);
+        return;
+    }
+    r->first = first;
+    r->end = end;
+    r->start = q->start;
+    r->count = q->count;
+    r->priority = q->priority;
+    r->order = ++g_pf_order;
+}
+
+// Fetch one block of the strongest incomplete range. Returns 1 if it did.
+static int prefetch_service(void) {
+    if (!g_pf_enabled) return 0;
+    // The frame lookups may read a table page: not under g_pf_lock, which
+    // the main thread takes from Lua
+    prefetch_request_t pending[PREFETCH_MAX_RANGES];
+    mutex_lock(&g_pf_lock);
+    int npending = g_pf_pending_count;
+    memcpy(pending, g_pf_pending, sizeof(pending[0]) * (size_t)npending);
+    g_pf_pending_count = 0;
+    mutex_unlock(&g_pf_lock);
+    for (int i = 0; i < npending; i++) {
+        prefetch_request_t *q = &pending[i];
+        if (q->priority <= 0 || q->count <= 0) continue;
+        q->first = total_to_unique_frame(q->start);
+        q->end = total_to_unique_frame(q->start + q->count - 1) + 1;
+    }
+
+    mutex_lock(&g_pf_lock);
+    for (int i = 0; i < npending; i++) prefetch_apply(&pending[i]);
+
+    prefetch_range_t *r = NULL;
+    for (int i = 0; i < PREFETCH_MAX_RANGES; i++) {
+        prefetch_range_t *c = &g_pf_ranges[i];
+        if (c->priority <= 0 || c->stuck || c->fetched == c->blocks) continue;
+        if (!r || c->priority > r->priority || (c->priority == r->priority && c->order < r->order)) r = c;
+    }
+    uint32_t offset, size = 0;
+    if (r && dcmv_frame_range(g_dcmv, r->next, &offset, &size) < 0) r->stuck = 1;
+    // Make room from the tails of weaker ranges
+    while (r && !r->stuck && g_pf_used + size > g_pf_budget) {
+        prefetch_range_t *victim = NULL;
+        for (int i = 0; i < PREFETCH_MAX_RANGES; i++) {
+            prefetch_range_t *c = &g_pf_ranges[i];
+            if (c->priority > 0 && c->priority < r->priority && c->fetched > 0 &&
+                (!victim || c->priority < victim->priority ||
+                 (c->priority == victim->priority && c->order > victim->order)))
+                victim = c;
+        }
+        if (!victim) r->stuck = 1;
+        else {
+            prefetch_drop_blocks(victim, victim->fetched - 1);
+            victim->stuck = 1;
+        }
+    }
+    if (r && r->stuck) r = NULL;
+    mutex_unlock(&g_pf_lock);
+    if (!r) return 0;
+
+    // dcmv_read_frame takes io_lock itself
+    const uint8_t *payload;
+    int first, count;
+    uint8_t *copy = malloc(size);
+    if (!copy || dcmv_read_frame(g_dcmv, r->next, &payload, &size) < 0) {
+        free(copy);
+        mutex_lock(&g_pf_lock);
+        r->stuck = 1;
+        mutex_unlock(&g_pf_lock);
+        return 1;
+    }
+    memcpy(copy, payload, size);
+    dcmv_block_of(g_dcmv, r->next, &first, &count);
+    int total_end = dcmv_unique_to_total(g_dcmv, first + count);
+
+    mutex_lock(&g_pf_lock);
+    r->data[r->fetched] = copy;
+    r->size[r->fetched] = size;
+    r->block_start[r->fetched] = first;
+    r->total_end[r->fetched] = total_end;
+    r->fetched++;
+    r->next = first + count;
+    prefetch_set_ready(r);
+    g_pf_used += size;
+    mutex_unlock(&g_pf_lock);
+    return 1;
+}
+
+// Prefetched payload of the block holding `unique`. Worker thread only; the
+// worker is also the only one that frees payloads.
+static int prefetch_lookup(int unique, const uint8_t **payload, uint32_t *size) {
+    if (!g_pf_enabled) return 0;
+    int found = 0;
+    mutex_lock(&g_pf_lock);
+    for (int i = 0; i < PREFETCH_MAX_RANGES && !found; i++) {
+        prefetch_range_t *r = &g_pf_ranges[i];
+        if (r->priority <= 0 || r->fetched == 0 || unique < r->first || unique >= r->next) continue;
+        int first, count;
+        int b = dcmv_block_of(g_dcmv, unique, &first, &count) - r->first_block;
+        if (b >= 0 && b < r->fetched) {
+            *payload = r->data[b];
+            *size = r->size[b];
+            found = 1;
+        }
+    }
+    mutex_unlock(&g_pf_lock);
+    if (found) atomic_fetch_add(&g_pf_hits, 1);
+    return found;
+}
+
+static void prefetch_init(void) {
+    g_pf_budget = (uint32_t)(G_PREFETCH_KB > 0 ? G_PREFETCH_KB : 0) * 1024u;
+    if (!g_pf_budget || g_interleaved || g_has_deltas) {
+        printf("   Script prefetch off: %s\n", !g_pf_budget ? "prefetch_kb=0" :
+               g_interleaved ? "interleaved layout" : "delta frames");
+        return;
+    }
+    g_pf_enabled = 1;
+    printf("   Script prefetch: %d KB for discPrefetchRange\n", G_PREFETCH_KB);
+}
+
+// --- Read-ahead ring (reader thread, lookups from the worker) ---
+// Under g_ra_lock
+static void readahead_reset(int unique) {
+    int first, count;
+    dcmv_block_of(g_dcmv, unique, &first, &count);
+    readahead_ring_clear(&g_ra);
+    g_ra_base = g_ra_next = g_ra_reading = first;
+    atomic_store(&g_ra_held, 0);
+}
+
+// Drop blocks that are behind the play head, up to the pinned one.
+// Under g_ra_lock
+static void readahead_trim(int unique) {
+    const readahead_block_t *b;
+    while ((b = readahead_ring_oldest(&g_ra)) != NULL) {
+        if (b->first + b->count > unique || b->first == g_ra_pinned) break;
+        atomic_fetch_sub(&g_ra_held, b->size);
+        readahead_ring_pop(&g_ra);
+    }
+    b = readahead_ring_oldest(&g_ra);
+    g_ra_base = b ? b->first : g_ra_next;
+}
+
+// Read the next run of blocks if the ring has room and is not deep enough
+// yet. Returns 1 if it read something.
+static int readahead_service(void) {
+    int cur = atomic_load(&frame_index);
+    int playhead = total_to_unique_frame(cur);
+    int depth = total_to_unique_frame(MIN(cur + (int)(G_READAHEAD_S * fps), num_total_frames - 1));
+
+    mutex_lock(&g_ra_lock);
+    // A seek into what is held keeps it; otherwise the ring starts over at
+    // the play head, once the worker is done with the block it decodes
+    if ((playhead >= g_ra_next && g_ra_next < num_unique_frames) || playhead < g_ra_base) {
+        if (g_ra_pinned >= 0) {
+            mutex_unlock(&g_ra_lock);
+            return 0;
+        }
+        readahead_reset(playhead);
+    }
+    readahead_trim(playhead);
+    atomic_store(&g_ra_ahead, g_ra_next - playhead);
+
+    // One read for the blocks that follow each other on disc
+    uint32_t start = 0, size = 0;
+    int n = 0, first = g_ra_next, next = g_ra_next;
+    while (g_ra.count + n < READAHEAD_RING_MAX_BLOCKS && next < num_unique_frames && next <= depth) {
+        uint32_t off, len;
+        if (dcmv_frame_range(g_dcmv, next, &off, &len) < 0) break;
+        if (n == 0) start = off;
+        else if (off != start + size || size + len > READAHEAD_READ_MAX) break;
+        if (readahead_ring_space(&g_ra, size + len) < 0) break;
+        int bfirst, bcount;
+        dcmv_block_of(g_dcmv, next, &bfirst, &bcount);
+        size += len;
+        next = bfirst + bcount;
+        n++;
+    }
+    uint32_t pos = n ? (uint32_t)readahead_ring_space(&g_ra, size) : 0;
+    g_ra_reading = next;
+    mutex_unlock(&g_ra_lock);
+    if (n == 0) return 0;
+
+    // The bytes past the ring's head are the reader's until published
+    int res = dcmv_read_range(g_dcmv, start, g_ra_buf + pos, size);
+
+    mutex_lock(&g_ra_lock);
+    if (res < 0) {
+        DC_log("[ReadAhead] read of %u bytes at %u failed", size, start);
+        if (g_ra_pinned < 0) readahead_reset(next);
+        else g_ra_reading = g_ra_next;
+    } else {
+        for (int u = first, k = 0; k < n; k++) {
+            int bfirst, bcount;
+            uint32_t off, len;
+            dcmv_block_of(g_dcmv, u, &bfirst, &bcount);
+            dcmv_frame_range(g_dcmv, u, &off, &len);
+            readahead_ring_push(&g_ra, bfirst, bcount, pos + (off - start), len);
+            u = bfirst + bcount;
+        }
+        g_ra_next = next;
+        atomic_fetch_add(&g_ra_held, size);
+    }
+    mutex_unlock(&g_ra_lock);
+    worker_wake();                          // the decompress stage has input
+    return 1;
+}
+
+// Read-ahead payload of the block holding `unique`, pinned until
+// readahead_release. A block the reader is reading right now is waited for
+// rather than read a second time.
+static int readahead_lookup(int unique, const uint8_t **payload, uint32_t *size) {
+    if (!g_ra_enabled) return 0;
+    for (;;) {
+        mutex_lock(&g_ra_lock);
+        const readahead_block_t *b = readahead_ring_find(&g_ra, unique);
+        if (b) {
+            *payload = g_ra_buf + b->pos;
+            *size = b->size;
+            g_ra_pinned = b->first;
+            mutex_unlock(&g_ra_lock);
+            atomic_fetch_add(&g_ra_hits, 1);
+            return 1;
+        }
+        int in_flight = unique >= g_ra_next && unique < g_ra_reading;
+        mutex_unlock(&g_ra_lock);
+        if (!in_flight || atomic_load(&preload_paused)) break;
+        atomic_fetch_add(&g_ra_waits, 1);
+        worker_wait(WORKER_HOUSEKEEPING_MS);
+    }
+    atomic_fetch_add(&g_ra_misses, 1);
+    return 0;
+}
+
+static void readahead_release(void) {
+    if (!g_ra_enabled) return;
+    mutex_lock(&g_ra_lock);
+    int was = g_ra_pinned;
+    g_ra_pinned = -1;
+    mutex_unlock(&g_ra_lock);
+    if (was >= 0) reader_wake();            // a reset may be waiting on it
+}
+
+// --- Reader thread: the I/O stage of the read-ahead pipeline ---
+static void reader_wake(void) {
+    if (!g_ra_enabled) return;
+    mutex_lock(&g_reader_lock);
+    g_reader_pending = 1;
+    cond_signal(&g_reader_cv);
+    mutex_unlock(&g_reader_lock);
+}
+
+static void *reader_thread(void *p) {
+    (void)p;
+    while (1) {
+        if (!atomic_load(&preload_paused) && readahead_service())
+            continue;
+        // Ring full, deep enough or paused: the play head moving on, a seek
+        // or the worker letting go of a block wakes us
+        mutex_lock(&g_reader_lock);
+        if (!g_reader_pending)
+            cond_wait_timed(&g_reader_cv, &g_reader_lock, WORKER_HOUSEKEEPING_MS);
+        g_reader_pending = 0;
+        mutex_unlock(&g_reader_lock);
+    }
+    return NULL;
+}
+
+static void readahead_init(void) {
+    uint32_t cap = (uint32_t)(G_READAHEAD_KB > 0 ? G_READAHEAD_KB : 0) * 1024u;
+    if (cap && !g_interleaved && !g_has_deltas)
+        g_ra_buf = memalign(32, cap);
+    if (!g_ra_buf) {
+        if (cap)
+            printf("   Read-ahead off: %s\n", g_interleaved ? "interleaved layout" :
+                   g_has_deltas ? "delta frames" : "out of memory");
+        return;
+    }
+    readahead_ring_init(&g_ra, cap);
+    g_ra_enabled = 1;
+    double avg = (double)g_rends[0].info.bytes / MAX(num_unique_frames, 1);
+    printf("   Read-ahead: %d KB compressed, up to %d s ahead (room for %.1f s at the average frame size), own reader thread\n",
+           G_READAHEAD_KB, G_READAHEAD_S, avg > 0 ? cap / avg / fps : 0.0);
+}
+
+// Frame loading: the segment's rendition, timed against the frame budget
+static int load_frame(int unique_frame, int buf_index) {
+    int level = rend_pick(unique_frame);
+    trace_add(unique_frame);
+    uint64_t t0 = timer_us_gettime64();
+    int res;
+    slot_rend[buf_index] = level;
+    if (level == 0) {
+        res = load_primary_frame(unique_frame, buf_index);
     } else {
-        int res = LZ4_decompress_fast(
-            (const char *)compressed_buffer,
-            (char *)frame_buffer[buf_index],
-            video_frame_size);
-        if (res < 0){
-            Singe_log("LZ4_decompress_fast failed for frame %d (buf %d)", unique_frame, buf_index);
+        slot_run_count[buf_index] = -1;
+        slot_codebook[buf_index] = -1;
+        res = dcmv_decode_rendition(g_dcmv, g_rends[level].index, unique_frame, frame_buffer[buf_index]);
+        if (res < 0)
+            Singe_log("Rendition %d decode failed for frame %d (buf %d)", g_rends[level].index, unique_frame, buf_index);
+    }
+
+    if (g_rend_count > 1 && res == 0) {
+        float budget = frame_duration * (float)dcmv_frame_duration(g_dcmv, unique_frame);
+        float sample = 1.0f - (float)(timer_us_gettime64() - t0) / 1000.0f / budget;
+        g_rend_headroom += (sample - g_rend_headroom) * 0.125f;
+    }
+    return res;
+}
+
+static int load_primary_frame(int unique_frame, int buf_index) {
+    const uint8_t *payload;
+    uint32_t compressed_size;
+
+    if (g_has_deltas) {
+        // Rebuilds the chain from the last key frame when playback jumped
+        if (dcmv_decode_frame(g_dcmv, unique_frame, frame_buffer[buf_index], slot_runs[buf_index],
+                              SLOT_MAX_RUNS, &slot_run_count[buf_index]) < 0) {
+            Singe_log("Delta decode failed for frame %d (buf %d)", unique_frame, buf_index);
             return -1;
         }
+        return 0;
     }
 
-    // Set buffer state to BUF_READY after successfully loading the frame
-    atomic_store(&buf_state[buf_index], BUF_READY);
+    // Read ahead or prefetched by the script, else from disc.
+    // dcmv_read_frame takes io_lock itself (see dcmv_set_io_lock in startup)
+    if (!readahead_lookup(unique_frame, &payload, &compressed_size) &&
+        !prefetch_lookup(unique_frame, &payload, &compressed_size) &&
+        dcmv_read_frame(g_dcmv, unique_frame, &payload, &compressed_size) < 0) {
+        Singe_log("dcmv_read_frame failed for frame %d (buf %d)", unique_frame, buf_index);
+        return -1;
+    }
 
+    int first, count;
+    dcmv_block_of(g_dcmv, unique_frame, &first, &count);
+    int res;
+    if (count == 1) {
+        res = decompress_frame_into_slot(payload, compressed_size, unique_frame, buf_index);
+    } else {
+        // One call fills the following frames of the block too; earlier
+        // ones are already behind playback
+        res = decode_block_into_slots(payload, compressed_size, first, count,
+                                      unique_frame + 1, unique_frame, buf_index);
+    }
+    readahead_release();
+    if (res < 0) {
+        Singe_log("Decompression failed for frame %d (buf %d)", unique_frame, buf_index);
+        return -1;
+    }
     return 0;
 }
+// Texture uploads finish while the rest of the scene is built: the slot
+// keeps a frame cache reference until the DMA completion callback drops it,
+// so the worker cannot decode into a buffer that is still being read, and
+// can have it back as soon as the transfer is done. One upload at a time.
+// A delta frame's changed runs go one DMA each, each started from the
+// previous one's completion; past UPLOAD_MAX_RUNS runs the whole frame goes
+// in one, which costs less than that many transfers.
+#define UPLOAD_MAX_RUNS 32
+static atomic_int g_dma_slot = -1;            // slot being uploaded, -1 = none
+static int g_dma_run = 0, g_dma_runs = 0;     // next delta run to send, and how many
+static atomic_int g_dma_stalled = 0;          // a chained run would not start
+static atomic_uint g_dma_waits = 0;           // times something waited for it
+static atomic_uint g_dma_copies = 0;          // runs copied by the CPU instead
+
+static void upload_run(int buf, int i, int *off, int *len) {
+    *off = slot_runs[buf][i].first * DCMV_DELTA_SPAN;
+    *len = MIN(slot_runs[buf][i].count * DCMV_DELTA_SPAN, video_frame_size - *off);
+}
+
+// DMA completion: start the next run, else release the slot. This runs in
+// interrupt context, so a run the channel refuses is left to upload_wait
+// rather than copied here with the store queues the main thread uses.
+static void upload_dma_done(void *data) {
+    int buf = (int)(intptr_t)data;
+    if (g_dma_run < g_dma_runs) {
+        int off, len;
+        upload_run(buf, g_dma_run++, &off, &len);
+        if (pvr_txr_load_dma(frame_buffer[buf] + off, (pvr_ptr_t)((uint8_t *)pvr_txr + off), len, 0,
+                             upload_dma_done, data) < 0) {
+            g_dma_run--;
+            atomic_store(&g_dma_stalled, 1);
+        }
+        return;
+    }
+    frame_cache_dma_done(&g_frames, buf);
+    atomic_store(&g_dma_slot, -1);
+}
+
+// Wait for the upload in flight, if any, copying what a stalled chain has
+// left. Until then a stalled upload keeps its slot.
+static void upload_wait(void) {
+    if (atomic_load(&g_dma_slot) < 0) return;
+    atomic_fetch_add(&g_dma_waits, 1);
+    while (atomic_load(&g_dma_slot) >= 0) {
+        if (!atomic_load(&g_dma_stalled)) {
+            thd_pass();
+            continue;
+        }
+        int buf = atomic_load(&g_dma_slot);
+        atomic_store(&g_dma_stalled, 0);
+        for (; g_dma_run < g_dma_runs; g_dma_run++) {
+            int off, len;
+            upload_run(buf, g_dma_run, &off, &len);
+            pvr_txr_load(frame_buffer[buf] + off, (pvr_ptr_t)((uint8_t *)pvr_txr + off), len);
+            atomic_fetch_add(&g_dma_copies, 1);
+        }
+        upload_dma_done((void *)(intptr_t)buf);
+    }
+}
+
+// Start an upload of `runs` delta runs (0: the one piece given). Its
+// completion callback chains the runs and releases the slot; if the channel
+// will not take the first piece, the CPU copies it.
+static void upload_start(int buf, int off, int len, int runs) {
+    atomic_store(&g_dma_slot, buf);
+    frame_cache_dma_begin(&g_frames, buf);
+    g_dma_run = 1;
+    g_dma_runs = runs;
+    if (runs > 0) upload_run(buf, 0, &off, &len);
+    const uint8_t *src = frame_buffer[buf] + off;
+    pvr_ptr_t dst = (pvr_ptr_t)((uint8_t *)pvr_txr + off);
+    if (pvr_txr_load_dma(src, dst, len, 0, upload_dma_done, (void *)(intptr_t)buf) < 0) {
+        pvr_txr_load(src, dst, len);
+        atomic_fetch_add(&g_dma_copies, 1);
+        upload_dma_done((void *)(intptr_t)buf);
+    }
+}
+
+// Upload a decoded frame. A delta frame that directly follows the texture
+// already in VRAM only needs its changed spans, a frame sharing the texture's
+// codebook only its index data.
+static void upload_frame(int buf, int unique) {
+    int runs = g_has_deltas ? slot_run_count[buf] : -1;
+    int codebook = slot_codebook[buf];
+    int rend = slot_rend[buf];
+    upload_wait();
+    if (rend != g_txr_rend) {
+        // Another rendition: new geometry, and nothing in VRAM can be reused
+        rend_view_t *v = &g_rends[rend];
+        hdr = v->hdr;
+        memcpy(vert, v->vert, sizeof(vert));
+        if (v->strided) PVR_SET(PVR_TEXTURE_MODULO, (v->info.width / 32));
+        upload_start(buf, 0, v->info.video_frame_size, 0);
+        g_txr_rend = rend;
+    } else if (codebook >= 0 && codebook == g_txr_codebook) {
+        upload_start(buf, DCMV_CODEBOOK_SIZE, video_frame_size - DCMV_CODEBOOK_SIZE, 0);
+    } else if (runs < 0 || runs > UPLOAD_MAX_RUNS || g_txr_unique < 0 || unique != g_txr_unique + 1) {
+        upload_start(buf, 0, g_rends[rend].info.video_frame_size, 0);
+    } else if (runs > 0) {
+        upload_start(buf, 0, 0, runs);
+    }
+    g_txr_unique = unique;
+    g_txr_codebook = codebook;
+}
+
+// The FMV quad with whatever texture pvr_txr holds
+static void render_submit_quad(void) {
+    pvr_dr_state_t dr;
+    pvr_dr_init(&dr);
+    sq_fast_cpy((void *)SQ_MASK_DEST(PVR_TA_INPUT), &hdr, sizeof(hdr) / 32);
+    sq_fast_cpy((void *)SQ_MASK_DEST(PVR_TA_INPUT), vert, sizeof(vert) / 32);
+    pvr_dr_commit(&dr);
+}
+
 // --- render_current_video(): always mark forward progress ---
 static void render_current_video(void) {
     int cur_total = atomic_load(&frame_index);
-    int unique = total_to_unique_frame(cur_total);
-    int buf = unique % NUM_BUFFERS;
     int cur_gen = atomic_load(&GSeekGeneration);
 
-    int state = atomic_load(&buf_state[buf]);
+    // A seek's target, or the play head, may sit on a table page that is not
+    // loaded yet; the worker resolves it, and until then the last frame stays up
+    int unique = atomic_load(&g_seek_holding) ? atomic_load(&g_seek_unique) : playhead_to_unique_frame(cur_total);
+    if (unique < 0) {
+        render_submit_quad();
+        return;
+    }
+
+    // Hold the frame for as long as it is on screen
+    frame_cache_set_playhead(&g_frames, unique);
+    int buf = frame_cache_acquire(&g_frames, unique);
 
     // Always mark progress, even for repeated unique frames
     atomic_store(&displayed_total_frame, cur_total);
 
     if (unique == last_unique_frame_drawn) {
         // DC_log("[Render] Repeat frame %d (unique=%d)", cur_total, unique);
-    } else if (state == BUF_READY) {
+    } else if (buf >= 0) {
         // Upload new texture only when ready
-        pvr_txr_load_dma(frame_buffer[buf], pvr_txr, video_frame_size, -1, NULL, 0);
+        upload_frame(buf, unique);
+        frame_cache_show(&g_frames, buf);
         last_unique_frame_drawn = unique;
         // DC_log("[Render] Draw frame %d (unique=%d buf=%d gen=%d)", cur_total, unique, buf, cur_gen);
-    } else {
-        DC_log("[Render] Waiting frame %d buf=%d state=%d", cur_total, buf, state);
+    } else if (!atomic_load(&g_seek_holding)) {
+        // While a seek primes, the last frame stays up without a word
+        DC_log("[Render] Waiting frame %d (unique=%d not decoded)", cur_total, unique);
+        // Waits right after a seek are expected, not a sign of a slow drive
+        if (!g_is_paused && last_unique_frame_drawn >= 0) {
+            atomic_fetch_add(&g_rend_late, 1);
+            atomic_fetch_add(&g_render_waits, 1);
+        }
     }
 
-    // Submit quad as before
-    pvr_dr_state_t dr;
-    pvr_dr_init(&dr);
-    sq_fast_cpy((void *)SQ_MASK_DEST(PVR_TA_INPUT), &hdr, sizeof(hdr) / 32);
-    sq_fast_cpy((void *)SQ_MASK_DEST(PVR_TA_INPUT), vert, sizeof(vert) / 32);
-    pvr_dr_commit(&dr);
+    render_submit_quad();
+}
+
+
+// Worker wake-ups. Whatever gives the worker work signals it: a queued job,
+// the play head moving on, a seek, unpausing, a script prefetch. Otherwise it
+// sleeps, waking every WORKER_HOUSEKEEPING_MS to check for a stall.
+// worker_poll=1 in singe.cfg brings back the old 1 ms polling loop, to compare
+// the CPU share the worker logs every WORKER_REPORT_MS. That share is the
+// thread's own CPU time from the scheduler, so time it spends blocked on the
+// drive or preempted by other threads does not count.
+static mutex_t g_worker_lock = MUTEX_INITIALIZER;
+static condvar_t g_worker_cv = COND_INITIALIZER;
+static int g_worker_pending = 0;              // under g_worker_lock
+static struct {
+    uint64_t cpu_ns, since_us;                // worker thread only
+    uint32_t wakeups, timeouts;
+} g_worker_cpu;
+
+static void worker_wake(void) {
+    if (G_WORKER_POLL) return;
+    mutex_lock(&g_worker_lock);
+    g_worker_pending = 1;
+    cond_signal(&g_worker_cv);
+    mutex_unlock(&g_worker_lock);
+}
+
+// Worker thread: sleep until signalled or for at most `ms`
+static void worker_wait(int ms) {
+    uint64_t now = timer_us_gettime64();
+    if (now - g_worker_cpu.since_us >= WORKER_REPORT_MS * 1000ULL) {
+        uint64_t span = now - g_worker_cpu.since_us;
+        uint64_t cpu = thd_get_cpu_time(thd_get_current());
+        DC_log("[Worker] cpu %.1f%% over %.1f s (%s): %u wake-ups, %u of them timeouts",
+               100.0 * (double)(cpu - g_worker_cpu.cpu_ns) / 1000.0 / (double)span, span / 1e6,
+               G_WORKER_POLL ? "1 ms polling" : "event driven", g_worker_cpu.wakeups, g_worker_cpu.timeouts);
+        g_worker_cpu.cpu_ns = cpu;
+        g_worker_cpu.wakeups = g_worker_cpu.timeouts = 0;
+        g_worker_cpu.since_us = now;
+        seek_stats_report();
+    }
+
+    if (G_WORKER_POLL) {
+        thd_sleep(1);
+        g_worker_cpu.timeouts++;
+    } else {
+        mutex_lock(&g_worker_lock);
+        if (!g_worker_pending && cond_wait_timed(&g_worker_cv, &g_worker_lock, ms) < 0)
+            g_worker_cpu.timeouts++;
+        g_worker_pending = 0;
+        mutex_unlock(&g_worker_lock);
+    }
+    g_worker_cpu.wakeups++;
 }
 
+bool schedule_frame_preload_with_generation(int frame, int generation) {
+    if (g_interleaved) return false;   // the packet reader owns the slots
+    if (frame < 0 || frame >= num_total_frames) return false;
+    int unique_frame = total_to_unique_frame(frame);
+
+    if (frame_cache_find(&g_frames, unique_frame) >= 0) return false;
+    if (!preload_queue_push(&g_preload, frame, unique_frame, generation)) return false;
+    worker_wake();
+    return true;
+}
 
 bool schedule_frame_preload(int frame) {
-    if (frame >= num_total_frames) return false;
-    int unique_frame = total_to_unique_frame(frame);
-    int buf = unique_frame % NUM_BUFFERS;
-    
-    if (atomic_load(&buf_state[buf]) != BUF_EMPTY) return false;
-    
-    int head = atomic_load(&preload_ring_head);
-    int tail = atomic_load(&preload_ring_tail);
-    int next_head = (head + 1) % RING_CAPACITY;
-    if (next_head == tail) return false;
-    
-    for (int i = tail; i != head; i = (i + 1) % RING_CAPACITY) {
-        int queued_unique = total_to_unique_frame(preload_ring[i].frame);
-        if (queued_unique == unique_frame) return false;
+    return schedule_frame_preload_with_generation(frame, atomic_load(&GSeekGeneration));
+}
+
+// Queue the frames due within the horizon of total frame `cur`, earliest
+// deadline first. A unique frame is due at its first total frame, so one held
+// on screen for several counts once and the horizon is time, not frames
+// decoded. Returns how many were queued.
+static int sched_plan(int cur, int generation) {
+    int horizon = load_sched_horizon(&g_sched), queued = 0;
+    for (int u = total_to_unique_frame(cur); u < num_unique_frames; u++) {
+        int due = MAX(dcmv_unique_to_total(g_dcmv, u), cur);
+        if (due - cur >= horizon) break;
+        if (frame_cache_find(&g_frames, u) < 0 && schedule_frame_preload_with_generation(due, generation))
+            queued++;
     }
-    
-    preload_ring[head].frame = frame;
-    preload_ring[head].generation = atomic_load(&GSeekGeneration);
-    atomic_store(&preload_ring_head, next_head);
-    return true;
+    return queued;
 }
 
-bool schedule_frame_preload_with_generation(int frame, int generation) {
-    if (frame >= num_total_frames) return false;
-    int unique_frame = total_to_unique_frame(frame);
-    int buf = unique_frame % NUM_BUFFERS;
 
-    if (atomic_load(&buf_state[buf]) != BUF_EMPTY) return false;
 
-    int head = atomic_load(&preload_ring_head);
-    int tail = atomic_load(&preload_ring_tail);
-    int next_head = (head + 1) % RING_CAPACITY;
-    if (next_head == tail) return false;
+kthread_t *worker_thread_id;
+
+// A seek is waiting for the worker to restart the files
+static int seek_io_pending(void) {
+    mutex_lock(&g_seek_lock);
+    int pending = g_seek.pending >= 0;
+    mutex_unlock(&g_seek_lock);
+    return pending;
+}
+
+// Restart the interleaved stream at total_frame. Worker thread only, so the
+// rings' writer is quiet; g_audio_lock keeps audio_cb off their read side.
+static void il_apply_reset(int total_frame) {
+    int unique = total_to_unique_frame(total_frame);
+    uint32_t pos = dcmv_audio_stream_pos(g_dcmv, total_frame);
+
+    mutex_lock(&g_audio_lock);
+    audio_ring_reset(&g_audio_ring[0]);
+    audio_ring_reset(&g_audio_ring[1]);
+    mutex_unlock(&g_audio_lock);
+    il_min_unique = unique;
+    il_audio_pos = pos;
+    il_next_packet = MIN(dcmv_find_packet(g_dcmv, unique), dcmv_find_audio_packet(g_dcmv, pos));
+}
+
+// Read the next packet once the frame cache can take its frames and the audio
+// rings have room for it. Returns 1 if a packet was consumed.
+static int il_service(void) {
+    if (il_next_packet >= dcmv_packet_count(g_dcmv)) return 0;
+
+    dcmv_packet_t pk;
+    if (dcmv_packet_info(g_dcmv, il_next_packet, &pk) < 0) {
+        DC_log("[Worker] Bad packet %d, skipping", il_next_packet);
+        il_next_packet++;
+        return 0;
+    }
+
+    int needed = 0, end = pk.first_unique + pk.unique_count;
+    for (int u = MAX(pk.first_unique, il_min_unique); u < end; u++)
+        needed += frame_cache_find(&g_frames, u) < 0;
+    if (needed > frame_cache_room(&g_frames, end))
+        return 0;
 
-    for (int i = tail; i != head; i = (i + 1) % RING_CAPACITY) {
-        int queued_unique = total_to_unique_frame(preload_ring[i].frame);
-        if (queued_unique == unique_frame) return false;
+    int channels = (audio_channels == 2) ? 2 : 1;
+    uint32_t skip = 0;
+    if (il_audio_pos > pk.audio_start)
+        skip = MIN(il_audio_pos - pk.audio_start, pk.audio_bytes);
+    uint32_t keep = MIN(pk.audio_bytes - skip, (uint32_t)IL_AUDIO_RING_SIZE);
+    for (int ch = 0; ch < channels; ch++) {
+        if (audio_ring_space(&g_audio_ring[ch]) < keep)
+            return 0;
     }
 
-    preload_ring[head].frame = frame;
-    preload_ring[head].generation = generation;
-    atomic_store(&preload_ring_head, next_head);
-    return true;
+    // read_size: whole sectors on aligned files, so every chunk is DMAed
+    // straight into il_packet_buf
+    for (uint32_t done = 0; done < pk.read_size; ) {
+        uint32_t n = MIN((uint32_t)IL_READ_CHUNK, pk.read_size - done);
+        if (dcmv_read_range(g_dcmv, pk.offset + done, il_packet_buf + done, n) < 0) {
+            DC_log("[Worker] Read failed for packet %d", il_next_packet);
+            il_next_packet++;
+            return 0;
+        }
+        done += n;
+
+        // Bail out if a seek came in
+        if (seek_io_pending())
+            return 0;
+    }
+
+    for (int unique = pk.first_unique; unique < pk.first_unique + pk.unique_count; ) {
+        int first, count;
+        uint32_t off, size;
+        dcmv_block_of(g_dcmv, unique, &first, &count);
+        if (first + count <= il_min_unique || dcmv_frame_range(g_dcmv, unique, &off, &size) < 0) {
+            unique = first + count;
+            continue;
+        }
+
+        int res = g_has_deltas
+                ? decode_delta_into_slot(il_packet_buf + (off - pk.offset), size, unique, il_min_unique)
+                : decode_block_into_slots(il_packet_buf + (off - pk.offset), size, first, count,
+                                          il_min_unique, -1, -1);
+        if (res < 0)
+            DC_log("[Worker] Decompression failed for unique=%d (packet %d)", unique, il_next_packet);
+        unique = first + count;
+    }
+
+    const uint8_t *audio = il_packet_buf + pk.video_bytes;
+    for (int ch = 0; ch < channels; ch++)
+        audio_ring_write(&g_audio_ring[ch], audio + ch * pk.audio_bytes + skip, pk.audio_bytes - skip);
+    if (pk.audio_start + pk.audio_bytes > il_audio_pos)
+        il_audio_pos = pk.audio_start + pk.audio_bytes;
+
+    il_next_packet++;
+    return 1;
 }
 
+// Branch targets worth having decoded while playing total frame `cur`: the
+// ones this segment has jumped to most, then the jumps tested for between here
+// and the end of the current segment, nearest first, then the untied ones.
+// Targets the preload horizon covers are skipped.
+static int hint_targets(int cur, int *out, int max) {
+    int window = load_sched_horizon(&g_sched);
+    int learned[HINT_POOL_FRAMES / HINT_TARGET_FRAMES];
+    mutex_lock(&g_seek_model_lock);
+    int nl = seek_model_predict(&g_seek_model, learned, MIN(max, HINT_POOL_FRAMES / HINT_TARGET_FRAMES));
+    mutex_unlock(&g_seek_model_lock);
+    int n = 0;
+    for (int i = 0; i < nl; i++)
+        if (learned[i] < cur || learned[i] >= cur + window) out[n++] = learned[i];
+
+    int horizon = cur + (int)(HINT_LOOKAHEAD_S * fps), best = -1;
+    for (int s = 0; s < g_hint_seg_count; s++) {
+        if (g_hint_seg_start[s] <= cur && (g_hint_seg_end[s] < 0 || cur <= g_hint_seg_end[s]) &&
+            (best < 0 || g_hint_seg_start[s] > g_hint_seg_start[best]))
+            best = s;
+    }
+    if (best >= 0 && g_hint_seg_end[best] >= 0) horizon = g_hint_seg_end[best];
+
+    for (int j = 0; j < g_hint_jump_count && n < max; j++) {
+        const hint_jump_t *h = &g_hint_jumps[j];
+        if (j < g_hint_tied && (h->from < cur || h->from > horizon)) continue;
+        if (h->to >= cur && h->to < cur + window) continue;
+        int dup = 0;
+        for (int i = 0; i < n; i++) dup |= out[i] == h->to;
+        if (!dup) out[n++] = h->to;
+    }
+    return n;
+}
+
+// Decode one missing frame of the current targets into the pool, evicting
+// frames no target needs any more. Worker thread only; returns 1 if it did.
+static int hint_service(void) {
+    if (!g_hints_enabled) return 0;
+
+    int targets[HINT_POOL_FRAMES / HINT_TARGET_FRAMES];
+    int want[HINT_POOL_FRAMES], nwant = 0;
+    int n = hint_targets(atomic_load(&frame_index), targets, HINT_POOL_FRAMES / HINT_TARGET_FRAMES);
+    for (int t = 0; t < n; t++) {
+        int first = total_to_unique_frame(targets[t]);
+        for (int k = 0; k < HINT_TARGET_FRAMES && first + k < num_unique_frames; k++) {
+            // Still in the frame cache from the last time through
+            if (frame_cache_find(&g_frames, first + k) < 0) want[nwant++] = first + k;
+        }
+    }
 
+    for (int w = 0; w < nwant; w++) {
+        int victim = -1, pooled = 0;
+        for (int i = 0; i < HINT_POOL_FRAMES && !pooled; i++) {
+            hint_frame_t *h = &g_hint_pool[i];
+            int state = atomic_load(&h->state);
+            if (state == BUF_READY && h->unique == want[w]) { pooled = 1; break; }
+            int needed = 0;
+            for (int k = 0; k < nwant; k++) needed |= state == BUF_READY && h->unique == want[k];
+            if (victim < 0 && !needed) victim = i;
+        }
+        if (pooled) continue;
+        if (victim < 0) return 0;
+
+        // hint_adopt may take READY entries; only claim what is still ours
+        hint_frame_t *h = &g_hint_pool[victim];
+        int expected = atomic_load(&h->state);
+        if (expected == BUF_LOADING || !atomic_compare_exchange_strong(&h->state, &expected, BUF_LOADING))
+            return 0;
+        int res = dcmv_decode_into(g_dcmv, want[w], h->buf);
+        h->unique = want[w];
+        h->codebook = res == 0 ? dcmv_codebook_run(g_dcmv, want[w]) : -1;
+        atomic_store(&h->state, res == 0 ? BUF_READY : BUF_EMPTY);
+        return 1;
+    }
+    return 0;
+}
 
-kthread_t *worker_thread_id;
+// Move pooled frames of a branch target into the frame cache by swapping
+// buffers. Returns how many frames were taken.
+static int hint_adopt(int total_frame) {
+    if (!g_hints_enabled) return 0;
+    int first = total_to_unique_frame(total_frame), adopted = 0;
+    for (int i = 0; i < HINT_POOL_FRAMES; i++) {
+        hint_frame_t *h = &g_hint_pool[i];
+        int expected = BUF_READY;
+        if (!atomic_compare_exchange_strong(&h->state, &expected, BUF_LOADING)) continue;
+        if (h->unique < first || h->unique >= first + HINT_TARGET_FRAMES) {
+            atomic_store(&h->state, BUF_READY);
+            continue;
+        }
+        int buf = frame_cache_claim(&g_frames, h->unique);
+        if (buf < 0) {
+            // Already cached, or nothing to give up for it
+            atomic_store(&h->state, BUF_READY);
+            continue;
+        }
+        uint8_t *t = frame_buffer[buf];
+        frame_buffer[buf] = h->buf;
+        h->buf = t;
+        slot_codebook[buf] = h->codebook;
+        slot_run_count[buf] = -1;
+        slot_rend[buf] = 0;
+        frame_cache_done(&g_frames, buf, 1);
+        atomic_store(&h->state, BUF_EMPTY);
+        adopted++;
+    }
+    atomic_fetch_add(adopted ? &g_hint_hits : &g_hint_misses, 1);
+    return adopted;
+}
+
+// The worker's part of a seek: reopen the files and restart the audio source
+// at the target, off the main thread. Called at the top of every worker pass;
+// a seek posted meanwhile is taken on the next one.
+static void seek_service_io(void) {
+    mutex_lock(&g_seek_lock);
+    int new_frame = seek_state_take(&g_seek);
+    mutex_unlock(&g_seek_lock);
+    if (new_frame < 0) return;
+
+    // Decoded frames stay: a jump back into a scene played a moment ago
+    // finds them in the cache. The lookup may read a table page, so it is
+    // done here rather than on the main thread, which finds the page pinned.
+    uint64_t t0 = timer_us_gettime64();
+    dcmv_pin_pages(g_dcmv, new_frame);
+    int unique = total_to_unique_frame(new_frame);
+    frame_cache_set_playhead(&g_frames, unique);
+    hint_adopt(new_frame);
 
-// Worker thread for preloading
-// Worker thread for preloading and stream maintenance
+    // Flush/reopen files (important for GD-ROM)
+    dcmv_reopen(g_dcmv);
+    trace_flush();
+    trace_add(-1 - new_frame);
+
+    long left_offset, right_offset;
+    if (g_interleaved) {
+        il_apply_reset(new_frame);
+        left_offset = right_offset = (long)dcmv_audio_stream_pos(g_dcmv, new_frame);
+        DC_log("[Seek] Interleaved restart at packet %d (audio underruns so far: %d)",
+               il_next_packet, atomic_load(&g_audio_starved));
+    } else {
+        // Compute and seek audio; the rings restart empty and the reader
+        // primes them from there while the target frame loads
+        left_offset  = dcmv_audio_byte_offset(g_dcmv, new_frame, 0);
+        right_offset = dcmv_audio_byte_offset(g_dcmv, new_frame, 1);
+
+        mutex_lock(&g_audio_fill_lock);
+        mutex_lock(&g_audio_lock);
+        audio_ring_reset(&g_audio_ring[0]);
+        audio_ring_reset(&g_audio_ring[1]);
+        mutex_lock(&io_lock);
+        fs_close(audio_fd_left);
+        audio_fd_left = fs_open(GGamePath, O_RDONLY);
+        fs_seek(audio_fd_left, left_offset, SEEK_SET);
+
+        if (audio_channels == 2) {
+            fs_close(audio_fd_right);
+            audio_fd_right = fs_open(GGamePath, O_RDONLY);
+            fs_seek(audio_fd_right, right_offset, SEEK_SET);
+        }
+        mutex_unlock(&io_lock);
+        mutex_unlock(&g_audio_lock);
+        mutex_unlock(&g_audio_fill_lock);
+    }
+
+    mutex_lock(&g_audio_lock);
+    last_audio_left_pos  = left_offset;
+    last_audio_right_pos = right_offset;
+    mutex_unlock(&g_audio_lock);
+
+    mutex_lock(&g_seek_lock);
+    int primed = seek_state_io_done(&g_seek, timer_us_gettime64());
+    if (primed) atomic_store(&g_seek_unique, unique);
+    mutex_unlock(&g_seek_lock);
+    DC_log("[Seek] Files at frame %d after %.1f ms%s", new_frame, (timer_us_gettime64() - t0) / 1000.0,
+           primed ? "" : "; a newer seek is waiting");
+    if (primed) {
+        // Queued jobs went stale with the generation seek_to_frame bumped
+        sched_plan(new_frame, atomic_load(&GSeekGeneration));
+        atomic_store(&preload_paused, 0);
+        audio_fill_wake();
+        reader_wake();
+    }
+}
+
+// Worker thread for preloading; audio_thread feeds the sound stream
 void *worker_thread(void *p) {
-    int idle_ticks = 0;
+    uint64_t stalled_since = 0;
+    g_worker_cpu.cpu_ns = thd_get_cpu_time(thd_get_current());
+    g_worker_cpu.since_us = timer_us_gettime64();
 
     while (1) {
+        // Seeks are applied here even while paused
+        seek_service_io();
+
+        // The main thread maps the play head without reading the disc
+        dcmv_pin_pages(g_dcmv, atomic_load(&frame_index));
+
         if (atomic_load(&preload_paused)) {
-            thd_sleep(2);
+            worker_wait(WORKER_HOUSEKEEPING_MS);
             continue;
         }
 
         int cur_gen = atomic_load(&GSeekGeneration);
 
-        // --- Always poll audio, even if idle ---
-        if (!atomic_load(&audio_muted))
-            snd_stream_poll(stream);
-
-        int tail = atomic_load(&preload_ring_tail);
-        int head = atomic_load(&preload_ring_head);
+        // --- Interleaved files: one sequential packet stream feeds everything ---
+        if (g_interleaved) {
+            // Blocked packets wait for frames to be shown or audio to drain
+            if (!il_service())
+                worker_wait(WORKER_HOUSEKEEPING_MS);
+            continue;
+        }
 
         // --- 1. Process one queued preload job if available ---
-        if (tail != head) {
-            PreloadJob job = preload_ring[tail];
-            atomic_store(&preload_ring_tail, (tail + 1) % RING_CAPACITY);
-
+        preload_job_t job;
+        int had_job = preload_queue_pop(&g_preload, &job);
+        if (had_job) {
             // Skip stale generations
             if (job.generation != cur_gen)
                 continue;
 
             int total_frame  = job.frame;
-            int unique_frame = total_to_unique_frame(total_frame);
-            int buf          = unique_frame % NUM_BUFFERS;
+            int unique_frame = job.unique;
 
-            int expected = BUF_EMPTY;
-            if (atomic_compare_exchange_strong(&buf_state[buf], &expected, BUF_LOADING)) {
-                int res = load_frame(unique_frame, buf);
-                if (res == 0) {
-                    atomic_store(&buf_state[buf], BUF_READY);
-                    // DC_log("[Worker] Loaded frame %d (unique=%d buf=%d gen=%d)", total_frame, unique_frame, buf, cur_gen);
-                } else {
-                    atomic_store(&buf_state[buf], BUF_EMPTY);
-                    DC_log("[Worker] load_frame failed for %d (unique=%d buf=%d)",total_frame, unique_frame, buf);
-                }
+            // Past its deadline: the play head has moved beyond it
+            if (unique_frame < total_to_unique_frame(atomic_load(&frame_index))) {
+                atomic_fetch_add(&g_sched.dropped, 1);
+                continue;
             }
+            int buf = frame_cache_claim(&g_frames, unique_frame);
 
-            idle_ticks = 0;
-        }
-
-        // --- 2. Maintain rolling preload window ahead of current frame ---
-        int current = atomic_load(&frame_index);   // use live playback frame
-        int max_preloads = MIN(NUM_BUFFERS, 16);
-        int scheduled = 0;
-
-        for (int i = 1; i <= max_preloads; i++) {
-            int target = current + i;
-            if (target >= num_total_frames)
-                break;
-
-            int unique = total_to_unique_frame(target);
-            int buf = unique % NUM_BUFFERS;
-
-            // If buffer empty, queue a preload job for it
-            if (atomic_load(&buf_state[buf]) == BUF_EMPTY) {
-                if (schedule_frame_preload_with_generation(target, cur_gen)) {
-                    scheduled++;
-                    // Uncomment for detailed queue trace:
-                    // Singe_log("[Worker] Queued frame %d ahead of current=%d", target, current);
-                }
+            if (buf >= 0) {
+                uint64_t t0 = timer_us_gettime64();
+                int res = load_frame(unique_frame, buf);
+                frame_cache_done(&g_frames, buf, res == 0);
+                if (res == 0)
+                    load_sched_loaded(&g_sched, (float)(timer_us_gettime64() - t0) / 1000.0f,
+                                      total_to_unique_frame(atomic_load(&frame_index)) >= unique_frame);
+                if (res != 0)
+                    DC_log("[Worker] load_frame failed for %d (unique=%d buf=%d)",total_frame, unique_frame, buf);
+                // else DC_log("[Worker] Loaded frame %d (unique=%d buf=%d gen=%d)", total_frame, unique_frame, buf, cur_gen);
             }
         }
 
-        // --- 3. Detect idle or starvation and attempt auto-recovery ---
-        if (scheduled == 0 && tail == head) {
-            if (++idle_ticks > 120 && !g_is_paused) {
+        // --- 2. Queue what falls due within the horizon ahead of the live
+        // playback frame, earliest first ---
+        int current = atomic_load(&frame_index);
+        int scheduled = sched_plan(current, cur_gen);
+
+        // --- 3. Window full: fetch what the script asked for, then decode
+        // ahead for its likely branches ---
+        int worked = had_job || scheduled > 0;
+        if (!worked)
+            worked = prefetch_service() || hint_service();
+
+        // --- 4. Detect starvation and attempt auto-recovery ---
+        // A full window with the current frame decoded is just a still scene
+        if (scheduled == 0 && !had_job &&
+            frame_cache_ready(&g_frames, total_to_unique_frame(current)) < 0) {
+            uint64_t now = timer_ms_gettime64();
+            if (!stalled_since) stalled_since = now;
+            if (now - stalled_since > WORKER_STALL_MS && !g_is_paused) {
                 int cur = atomic_load(&frame_index);
                 DC_log("[Worker] Idle/stalled (cur=%d gen=%d). Re-seeding preload window.", cur, cur_gen);
-                idle_ticks = 0;
+                stalled_since = 0;
 
                 // Try to re-seed a few frames ahead to recover from ring starvation
-                for (int j = 0; j < NUM_BUFFERS; j++) {
-                    atomic_store(&buf_state[j], BUF_EMPTY);
-                }
+                frame_cache_clear(&g_frames);
 
-                atomic_store(&preload_ring_head, 0);
-                atomic_store(&preload_ring_tail, 0);
+                preload_queue_drain(&g_preload);
 
-                for (int k = 0; k < MIN(NUM_BUFFERS, 8); k++) {
-                    int target = cur + k;
-                    if (target >= num_total_frames) break;
-                    schedule_frame_preload_with_generation(target, cur_gen);
-                }
+                sched_plan(cur, cur_gen);
             }
         } else {
-            idle_ticks = 0;
+            stalled_since = 0;
         }
 
-        thd_sleep(1);
+        // Busy: let the main thread in, then carry on. Idle: sleep until
+        // something changes
+        if (worked)
+            thd_pass();
+        else
+            worker_wait(WORKER_HOUSEKEEPING_MS);
     }
 }
 
 
 
-// --- seek_to_frame(): flush ring + re-prime fresh preload jobs ---
+
+// Counters of the seek cache, prefetch, scheduler, frame cache, audio and
+// read-ahead. Logged with the worker's periodic report, off the main thread.
+static void seek_stats_report(void) {
+    mutex_lock(&g_seek_model_lock);
+    uint32_t predicted = g_seek_model.predicted, unpredicted = g_seek_model.unpredicted;
+    mutex_unlock(&g_seek_model_lock);
+    mutex_lock(&g_seek_lock);
+    seek_state_t st = g_seek;
+    mutex_unlock(&g_seek_lock);
+    char hist[128];
+    seek_state_hist_str(&st, hist, sizeof(hist));
+    DC_log("[Stats] seeks: %u landed, mean %.1f ms, worst %.1f ms, %u replaced in flight, "
+           "%u landed by the %d ms bound; ms %s", st.seeks, st.seeks ? st.total_us / 1000.0 / st.seeks : 0.0,
+           st.worst_us / 1000.0, st.replaced, st.bounded, SEEK_STATE_BOUND_MS, hist);
+    if (g_hints_enabled)
+        DC_log("[Stats] seek cache: hits %d, misses %d; learned targets %u of %u",
+               atomic_load(&g_hint_hits), atomic_load(&g_hint_misses), predicted, predicted + unpredicted);
+    if (g_pf_enabled) {
+        mutex_lock(&g_pf_lock);
+        uint32_t used = g_pf_used;
+        mutex_unlock(&g_pf_lock);
+        DC_log("[Stats] prefetch: %u of %u KB held, %d frames served from RAM", used / 1024,
+               g_pf_budget / 1024, atomic_load(&g_pf_hits));
+    }
+    DC_log("[Stats] scheduler: %d frames ahead (margin %d); %u loads, %u late, %u underruns "
+           "(%u at a seek), %u jobs past their deadline dropped", load_sched_horizon(&g_sched),
+           atomic_load(&g_sched.boost), atomic_load(&g_sched.loads), atomic_load(&g_sched.late),
+           atomic_load(&g_sched.underruns), atomic_load(&g_sched.cold), atomic_load(&g_sched.dropped));
+    DC_log("[Stats] frame cache: %d slots, %u frames shown again from cache, %u decoded, %u evicted; "
+           "%u waits for a texture upload, %u pieces copied without DMA", g_frames.slots,
+           atomic_load(&g_frames.hits), atomic_load(&g_frames.misses), atomic_load(&g_frames.evictions),
+           atomic_load(&g_dma_waits), atomic_load(&g_dma_copies));
+    DC_log("[Stats] audio: %u polls, %u late (worst gap %.1f ms, underrun past %.1f ms), "
+           "%d ring underruns, %u bulk reads", atomic_load(&g_audio_svc.polls), atomic_load(&g_audio_svc.late),
+           atomic_load(&g_audio_svc.worst_gap_us) / 1000.0, g_audio_svc.budget_us / 1000.0,
+           atomic_load(&g_audio_starved), atomic_load(&g_audio_reads));
+    if (g_aica.enabled) {
+        mutex_lock(&g_audio_lock);
+        uint32_t refills = g_aica.ring.refills, underruns = g_aica.ring.underruns;
+        uint32_t fallbacks = g_aica.dma_fallbacks;
+        mutex_unlock(&g_audio_lock);
+        DC_log("[Stats] direct AICA: %u refills of %u KB, %u underruns in SPU RAM, %u DMAs failed and copied",
+               refills, g_aica.ring.chunk / 1024, underruns, fallbacks);
+    }
+    if (g_ra_enabled)
+        DC_log("[Stats] read-ahead: %u of %u KB held, %d frames ahead; %u loads from RAM, %u from disc; "
+               "worker waited on the reader %u times, renderer on the worker %u times",
+               atomic_load(&g_ra_held) / 1024, g_ra.cap / 1024,
+               atomic_load(&g_ra_ahead), atomic_load(&g_ra_hits), atomic_load(&g_ra_misses),
+               atomic_load(&g_ra_waits), atomic_load(&g_render_waits));
+}
+
+// --- seek_to_frame(): the renderer's part of a seek ---
+// Moves the play head, hands the rest to the worker (seek_service_io) and
+// returns at once: nothing here reads the disc, not even a table page.
+// fmv_tick keeps the last frame on screen, and the overlay running, until
+// seek_land.
 void seek_to_frame(int new_frame) {
     if (new_frame < 0) new_frame = 0;
     if (new_frame >= num_total_frames) new_frame = num_total_frames - 1;
 
     atomic_store(&audio_muted, 1);
+    atomic_store(&g_seek_holding, 1);
     atomic_store(&preload_paused, 1);
 
-    DC_log("[Seek] >>> Begin seek_to_frame(%d)", new_frame);
-
-    // Reset buffers and ring
-    for (int i = 0; i < NUM_BUFFERS; i++)
-        atomic_store(&buf_state[i], BUF_EMPTY);
-    atomic_store(&preload_ring_head, 0);
-    atomic_store(&preload_ring_tail, 0);
-    memset(preload_ring, 0, sizeof(preload_ring));
-
     last_unique_frame_drawn = -1;
     atomic_store(&seek_request, -1);
+    atomic_store(&frame_index, new_frame);
+    atomic_store(&displayed_total_frame, 0);
+    atomic_store(&g_seek_landed, new_frame);
 
-    // Flush/reopen files (important for GD-ROM)
-    mutex_lock(&io_lock);
-    fs_close(video_fd);
-    thd_sleep(10);
-    video_fd = fs_open(GGamePath, O_RDONLY);
-    mutex_unlock(&io_lock);
-
-    int uf = total_to_unique_frame(new_frame);
-    uint32_t off = frame_offsets[uf];
-    mutex_lock(&io_lock);
-    fs_seek(video_fd, off, SEEK_SET);
-    mutex_unlock(&io_lock);
-    vfd_last_end = off;
-
-    // Compute and seek audio
-    double samples_exact = ((double)new_frame * (double)sample_rate) / (double)fps;
-    uint32_t samples_i = (uint32_t)(samples_exact + 0.5);
-    uint32_t bytes_per_channel = (samples_i / 2);
-    bytes_per_channel = (bytes_per_channel + 15) & ~0xF;
-
-    long left_offset = audio_offset + (long)bytes_per_channel;
-    if (left_offset > (audio_offset + left_channel_size))
-        left_offset = audio_offset + left_channel_size;
-
-    long right_offset = audio_offset + left_channel_size + (long)bytes_per_channel;
-    long right_limit  = audio_offset + (long)left_channel_size * 2;
-    if (right_offset > right_limit) right_offset = right_limit;
-
-    mutex_lock(&io_lock);
-    fs_close(audio_fd_left);
-    audio_fd_left = fs_open(GGamePath, O_RDONLY);
-    fs_seek(audio_fd_left, left_offset, SEEK_SET);
-
-    if (audio_channels == 2) {
-        fs_close(audio_fd_right);
-        audio_fd_right = fs_open(GGamePath, O_RDONLY);
-        fs_seek(audio_fd_right, right_offset, SEEK_SET);
-    }
-    mutex_unlock(&io_lock);
-
-    last_audio_left_pos  = left_offset;
-    last_audio_right_pos = right_offset;
-
-// Reset timers
-atomic_store(&frame_index, new_frame);
-atomic_store(&displayed_total_frame, 0);
+    mutex_lock(&g_seek_model_lock);
+    seek_model_record(&g_seek_model, new_frame, HINT_POOL_FRAMES / HINT_TARGET_FRAMES);
+    mutex_unlock(&g_seek_model_lock);
 
-frame_timer_anchor = psTimer();
-
-// ✅ Correct alignment: base time = video frame time
-double frame_ms = (double)new_frame * (1000.0 / (double)fps);
-atomic_store(&audio_start_time_ms, frame_ms);
-
-DC_log("[Seek] anchor=%.2f base=%.2f (frame=%d, fps=%.2f, frame_dur=%.2fms)",
-       frame_timer_anchor, atomic_load(&audio_start_time_ms),
-       new_frame, fps, 1000.0 / fps);
-
-    // Increment generation and clear stale jobs
+    // Increment generation: the worker drops older jobs as it pops them
     atomic_fetch_add(&GSeekGeneration, 1);
-    int cur_gen = atomic_load(&GSeekGeneration);
-
-    for (int i = 0; i < RING_CAPACITY; i++) {
-        preload_ring[i].frame = -1;
-        preload_ring[i].generation = cur_gen;
-    }
 
-    DC_log("[Seek] Incremented GSeekGeneration -> %d (flushed ring)", cur_gen);
-
-    // Prime fresh preload frames
-    int max_preloads = MIN(NUM_BUFFERS / 2, 16);
-    for (int i = 0; i < max_preloads; i++) {
-        int target = new_frame + i;
-        if (target >= num_total_frames) break;
-        schedule_frame_preload(target);
-        // DC_log("[Seek] Scheduled preload for frame %d (gen=%d)", target, cur_gen);
-    }
-
-    thd_sleep(50);
-    atomic_store(&preload_paused, 0);
+    mutex_lock(&g_seek_lock);
+    atomic_store(&g_seek_unique, -1);
+    int replaced = seek_state_post(&g_seek, new_frame, timer_us_gettime64());
+    mutex_unlock(&g_seek_lock);
+    worker_wake();
+
+    DC_log("[Seek] >>> seek_to_frame(%d), generation %u%s", new_frame, atomic_load(&GSeekGeneration),
+           replaced ? ", replacing one in flight" : "");
+}
+
+// fmv_tick: land the seek in flight once its first frame is decoded, or once
+// priming has run SEEK_STATE_BOUND_MS, and restart the clock and the audio
+// at the target. Returns 0 while the seek is still in flight.
+static int seek_land(void) {
+    int target = atomic_load(&g_seek_landed);
+    uint64_t now = timer_us_gettime64();
+    mutex_lock(&g_seek_lock);
+    // The worker publishes the unique frame with the priming phase
+    int unique = atomic_load(&g_seek_unique);
+    int ready = unique >= 0 && frame_cache_ready(&g_frames, unique) >= 0;
+    int landed = seek_state_land(&g_seek, ready, now);
+    uint64_t posted_us = g_seek.posted_us, io_us = g_seek.io_us;
+    mutex_unlock(&g_seek_lock);
+    if (!landed) return 0;
+
+    // Reset timers: base time = video frame time
+    frame_timer_anchor = psTimer();
+    atomic_store(&audio_start_time_ms, (double)target * (1000.0 / (double)fps));
+    atomic_store(&g_seek_holding, 0);
     atomic_store(&audio_muted, 0);
+    worker_wake();
+    reader_wake();
 
-    DC_log("[Seek] <<< Completed seek_to_frame(%d)", new_frame);
+    DC_log("[Seek] <<< Landed at frame %d after %.1f ms (files ready after %.1f ms)%s, base %.2f ms",
+           target, (now - posted_us) / 1000.0, (io_us - posted_us) / 1000.0,
+           ready ? "" : ", first frame still loading", atomic_load(&audio_start_time_ms));
+    return 1;
 }
 
-
-
 static void fmv_tick(uint64_t now_ms) {
     static double accumulated_frame_debt = 0.0;
     static int frames_dropped = 0;
@@ -823,21 +2262,16 @@ static void fmv_tick(uint64_t now_ms) {
     static double max_frame_time = 0.0;
     static double avg_frame_time = 0.0;
     static double frame_time_samples = 0.0;
-    static int unique_display_count = 0;
-    static int expected_display_count = 0;
+    static int underrun_frame = -1;
 
     // Handle seek requests (this is where frame seeking happens)
     int req = atomic_exchange(&seek_request, -1);
-    if (req >= 0) {
+    if (req >= 0)
         seek_to_frame(req);
-        atomic_store(&frame_index, req);
-        atomic_store(&audio_muted, 0);
-        
-        // CRITICAL: Reset timing anchor after seek
-        frame_timer_anchor = psTimer();
-        // ✅ Reset audio base time to the correct aligned position in ms (no *1000)
-        atomic_store(&audio_start_time_ms, (double)req * (1000.0 / fps));
-    }
+
+    // Until the seek lands the last frame stays up and the clock holds
+    if (atomic_load(&g_seek_holding) && !seek_land())
+        return;
 
     // Frame sync and timing
     int current_frame = atomic_load(&frame_index);
@@ -860,10 +2294,9 @@ static void fmv_tick(uint64_t now_ms) {
     if (g_is_paused) {
         // Keep redrawing the last frame if paused
         int current_frame = atomic_load(&frame_index);
-        int unique_id = total_to_unique_frame(current_frame);
-        int buf = unique_id % NUM_BUFFERS;
+        int unique_id = playhead_to_unique_frame(current_frame);
 
-        if (atomic_load(&buf_state[buf]) == BUF_READY) {
+        if (unique_id >= 0 && frame_cache_ready(&g_frames, unique_id) >= 0) {
             // Redraw the current frame (don't clear buffer)
             last_unique_frame_drawn = unique_id;
             // Just draw it again every tick, no frame advance
@@ -896,39 +2329,26 @@ if (expected_frame < 0)
 // ✅ Only draw when audio has reached or passed this frame's time
 if (current_audio_time_ms >= target_time_ms) {
     int draw_total = current_frame;
-    int unique_id = total_to_unique_frame(draw_total);
-    int buf = unique_id % NUM_BUFFERS;
-    int state = atomic_load(&buf_state[buf]);
+    int unique_id = playhead_to_unique_frame(draw_total);
 
-    if (state == BUF_READY) {
-        if (unique_id != last_unique_frame_drawn) {
+    // Slots are not released here: the cache recycles them behind the play head
+    if (unique_id < 0) {
+        worker_wake();                      // its table page is not pinned yet
+    } else if (frame_cache_ready(&g_frames, unique_id) >= 0) {
+        if (unique_id != last_unique_frame_drawn)
             last_unique_frame_drawn = unique_id;
-            unique_display_count = 1;
-            expected_display_count = frame_durations[unique_id];
-        } else {
-            unique_display_count++;
-        }
-
-        if (unique_display_count >= expected_display_count)
-            atomic_store(&buf_state[buf], BUF_EMPTY);
 
-        // advance a single frame per tick
+        // advance a single frame per tick; the horizon moves on
         atomic_store(&frame_index, current_frame + 1);
         atomic_fetch_add(&displayed_total_frame, 1);
-    }
-}
-
-// --- Maintain preload window ---
-int cur_frame = atomic_load(&frame_index);
-int preloads = 0;
-const int window = MIN(NUM_BUFFERS / 2, 8);
-for (int i = 0; i < window; i++) {
-    int target = cur_frame + i;
-    if (target >= num_total_frames) break;
-    int unique = total_to_unique_frame(target);
-    int buf = unique % NUM_BUFFERS;
-    if (atomic_load(&buf_state[buf]) == BUF_EMPTY) {
-        if (schedule_frame_preload(target)) preloads++;
+        load_sched_shown(&g_sched);
+        worker_wake();
+        reader_wake();
+    } else if (draw_total != underrun_frame) {
+        // Due and not decoded: the worker plans further ahead from now on
+        underrun_frame = draw_total;
+        load_sched_underrun(&g_sched, draw_total == atomic_load(&g_seek_landed));
+        worker_wake();
     }
 }
 
@@ -1080,6 +2500,47 @@ static int sep_search(lua_State *L) {
     return 0;
 }
 
+// discPrefetchRange(start, count [, priority]): keep the compressed frames
+// [start, start + count) in RAM once the worker has time. Priority defaults
+// to 1; 0 releases the range. Same start again updates it.
+static int sep_prefetch_range(lua_State *L) {
+    int start = (int)luaL_checknumber(L, 1);
+    int count = (int)luaL_checknumber(L, 2);
+    int priority = (int)luaL_optinteger(L, 3, 1);
+    if (start < 0) start = 0;
+    if (start + count > num_total_frames) count = num_total_frames - start;
+
+    int queued = 0;
+    mutex_lock(&g_pf_lock);
+    if (g_pf_enabled && count > 0 && g_pf_pending_count < PREFETCH_MAX_RANGES) {
+        g_pf_pending[g_pf_pending_count++] = (prefetch_request_t){ start, count, priority, 0, 0 };
+        queued = 1;
+    }
+    mutex_unlock(&g_pf_lock);
+    if (queued) worker_wake();
+    lua_pushboolean(L, queued);
+    return 1;
+}
+
+// discPrefetchStatus(start): frames of the range starting at `start` that are
+// in RAM from its start, and the range's length (0, 0 if there is none). The
+// worker keeps `ready` current, so this never looks up a frame.
+static int sep_prefetch_status(lua_State *L) {
+    int start = (int)luaL_checknumber(L, 1);
+    int ready = 0, count = 0;
+    mutex_lock(&g_pf_lock);
+    for (int i = 0; i < PREFETCH_MAX_RANGES; i++) {
+        prefetch_range_t *r = &g_pf_ranges[i];
+        if (r->priority <= 0 || r->start != start) continue;
+        count = r->count;
+        ready = r->ready;
+    }
+    mutex_unlock(&g_pf_lock);
+    lua_pushinteger(L, ready);
+    lua_pushinteger(L, count);
+    return 2;
+}
+
 static int sep_pause(lua_State *L) {
     // Only pause if not already halted
         // GHalted = 1;  // Pause playback
@@ -1101,6 +2562,8 @@ static int sep_play(lua_State *L) {
     g_is_paused = 0;
     preload_paused = 0;
     atomic_store(&audio_muted, 0);
+    worker_wake();
+    reader_wake();
     compute_global_ratios();
     return 0;
 }
@@ -3910,6 +5373,8 @@ static void setup_lua(void) {
     lua_register(GLua, "discGetFrame", sep_get_current_frame);
     lua_register(GLua, "discSkipToFrame", sep_skip_to_frame);
     lua_register(GLua, "discSearch", sep_search);
+    lua_register(GLua, "discPrefetchRange", sep_prefetch_range);
+    lua_register(GLua, "discPrefetchStatus", sep_prefetch_status);
     lua_register(GLua, "discPause", sep_pause);
     lua_register(GLua, "discPlay", sep_play);
     lua_register(GLua, "discStop", sep_stop);
@@ -4389,6 +5854,9 @@ void singe_tick(uint64_t monotonic_ms) {
 
     pvr_list_finish();
 
+    // The FMV texture upload ran during the overlay; it must be in VRAM
+    // before the scene is rendered
+    upload_wait();
     pvr_scene_finish();
 
     // 3️⃣ Update FMV logic (tick after drawing)
@@ -4422,6 +5890,80 @@ static int pal_menu(void) {
     }
 }
 
+// Branch hints sidecar: movie.dcmv -> movie.hints, optional
+static void hints_load(const char *videopath) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s", videopath);
+    char *dot = strrchr(path, '.');
+    if (dot && !strchr(dot, '/')) *dot = '\0';
+    strncat(path, ".hints", sizeof(path) - strlen(path) - 1);
+
+    mutex_lock(&io_lock);
+    file_t fd = fs_open(path, O_RDONLY);
+    size_t size = fd >= 0 ? fs_total(fd) : 0;
+    char *text = fd >= 0 ? malloc(size + 1) : NULL;
+    int ok = text && fs_read(fd, text, size) == (ssize_t)size;
+    if (fd >= 0) fs_close(fd);
+    mutex_unlock(&io_lock);
+    if (!ok) {
+        free(text);
+        return;
+    }
+    text[size] = '\0';
+
+    // Tied jumps sorted by source frame, then untied ones by how often the
+    // script takes them
+    hint_jump_t untied[HINT_MAX_JUMPS];
+    int untied_count = 0;
+    char *save = NULL;
+    for (char *line = strtok_r(text, "\r\n", &save); line; line = strtok_r(NULL, "\r\n", &save)) {
+        hint_jump_t j;
+        int a, b;
+        if (sscanf(line, "segment %d %d", &a, &b) == 2 && g_hint_seg_count < HINT_MAX_SEGMENTS) {
+            g_hint_seg_start[g_hint_seg_count] = a;
+            g_hint_seg_end[g_hint_seg_count++] = b;
+        } else if (sscanf(line, "jump %d %d %d", &j.from, &j.to, &j.count) == 3 &&
+                   j.to >= 0 && j.to < num_total_frames) {
+            if (j.from < 0 && untied_count < HINT_MAX_JUMPS) {
+                int k = untied_count++;
+                for (; k > 0 && untied[k - 1].count < j.count; k--) untied[k] = untied[k - 1];
+                untied[k] = j;
+            } else if (j.from >= 0 && g_hint_tied < HINT_MAX_JUMPS) {
+                int k = g_hint_tied++;
+                for (; k > 0 && g_hint_jumps[k - 1].from > j.from; k--) g_hint_jumps[k] = g_hint_jumps[k - 1];
+                g_hint_jumps[k] = j;
+            }
+        }
+    }
+    free(text);
+    g_hint_jump_count = g_hint_tied;
+    for (int i = 0; i < untied_count && g_hint_jump_count < HINT_MAX_JUMPS; i++)
+        g_hint_jumps[g_hint_jump_count++] = untied[i];
+    printf("   Branch hints: %d jumps, %d segments from %s\n", g_hint_jump_count, g_hint_seg_count, path);
+}
+
+// Decoded-frame pool shared by the branch hints and the learned seek targets
+static void hint_pool_init(int slot_size) {
+    seek_model_init(&g_seek_model);
+    if (!G_SEEK_CACHE || g_interleaved || g_has_deltas) {
+        // The packet stream owns the slots; delta chains only decode in order
+        printf("   Seek cache off: %s\n", !G_SEEK_CACHE ? "seek_cache=0" :
+               g_interleaved ? "interleaved layout" : "delta frames");
+        return;
+    }
+    for (int i = 0; i < HINT_POOL_FRAMES; i++) {
+        g_hint_pool[i].buf = memalign(32, slot_size);
+        g_hint_pool[i].unique = -1;
+        atomic_store(&g_hint_pool[i].state, BUF_EMPTY);
+        if (!g_hint_pool[i].buf) {
+            printf("   Seek cache off: out of memory\n");
+            return;
+        }
+    }
+    g_hints_enabled = 1;
+    printf("   Seek cache: %d frames, %d per target\n", HINT_POOL_FRAMES, HINT_TARGET_FRAMES);
+}
+
 // Initialization
 void singe_startup(const char *gamedir, const char *videopath) {
     GGameDir = Singe_xstrdup(gamedir);
@@ -4432,44 +5974,31 @@ void singe_startup(const char *gamedir, const char *videopath) {
 
     
     // Open video file
-    video_fd = fs_open(videopath, O_RDONLY);
-    if (video_fd < 0) {
+    g_dcmv = dcmv_open(videopath, DCMV_BACKEND_FILE);
+    if (!g_dcmv) {
         printf("PANIC: Failed to open video file\n");
         exit(1);
     }
-    
-    // Read header (same as Singe)
-    char magic[4];
-    fs_read(video_fd, magic, 4);
-    if (memcmp(magic, DCMV_MAGIC, 4) != 0) {
-        printf("PANIC: Bad DCMV magic\n");
-        exit(1);
-    }
-    
-    uint32_t version;
-    fs_read(video_fd, &version, 4);
-    
-    fs_read(video_fd, &frame_type, 1);
-    fs_read(video_fd, &video_width, 2);
-    fs_read(video_fd, &video_height, 2);
-    fs_read(video_fd, &content_width, 2);
-    fs_read(video_fd, &content_height, 2);
-    fs_read(video_fd, &fps, sizeof(float));
-    fs_read(video_fd, &sample_rate, 2);
-    fs_read(video_fd, &audio_channels, 2);
-    fs_read(video_fd, &num_unique_frames, 4);
-    fs_read(video_fd, &num_total_frames, 4);
-    fs_read(video_fd, &video_frame_size, 4);
-    fs_read(video_fd, &max_compressed_size, 4);
-    fs_read(video_fd, &audio_offset, 4);
-
-    uint8_t compression_type = 0;
-    fs_read(video_fd, &compression_type, 1);
-    const char *compression_str = (compression_type == 1) ? "Zstandard" : "LZ4";
-    use_zstd = (compression_type == 1);
+    dcmv_set_io_lock(g_dcmv, dcmv_io_lock, dcmv_io_unlock, &io_lock);
+
+    const dcmv_header_t *vh = dcmv_header(g_dcmv);
+    frame_type          = vh->frame_type;
+    video_width         = vh->width;
+    video_height        = vh->height;
+    content_width       = vh->content_width;
+    content_height      = vh->content_height;
+    fps                 = vh->fps;
+    sample_rate         = vh->sample_rate;
+    audio_channels      = vh->audio_channels;
+    num_unique_frames   = vh->num_unique_frames;
+    num_total_frames    = vh->num_total_frames;
+    video_frame_size    = vh->video_frame_size;
+    max_compressed_size = vh->max_compressed_size;
+    audio_offset        = (int)vh->audio_offset;
+    const char *compression_str = (vh->compression == DCMV_COMPRESSION_ZSTD) ? "Zstandard" : "LZ4";
     
         printf("📦 Header v%lu: %s %dx%d (content: %dx%d) @ %.2ffps, %dHz, %dch, unique=%d, total=%d\n",
-        (unsigned long)version,
+        (unsigned long)vh->version,
         frame_type == 1 ? "YUV422" : "RGB565",
         video_width, video_height, content_width, content_height,
         fps, sample_rate, audio_channels,
@@ -4481,48 +6010,40 @@ void singe_startup(const char *gamedir, const char *videopath) {
     init_timebase_from_fps(fps);
     frame_duration = 1000.0f / fps;
     
-    // Allocate buffers
-    if (use_zstd) {
-        g_zstd_dctx = ZSTD_createDCtx();
-        ZSTD_DCtx_setParameter(g_zstd_dctx, ZSTD_d_format, ZSTD_f_zstd1_magicless);
-    }
-    
-    compressed_buffer = memalign(32, max_compressed_size);
-    
-    // Load frame tables
-    fs_seek(video_fd, 50, SEEK_SET);
-    
-    frame_offsets = Singe_xmalloc((num_unique_frames + 1) * sizeof(uint32_t));
-    frame_durations = Singe_xmalloc(num_unique_frames * sizeof(uint16_t));
-    
-    fs_read(video_fd, frame_offsets, (num_unique_frames + 1) * sizeof(uint32_t));
-    fs_read(video_fd, frame_durations, num_unique_frames * sizeof(uint16_t));
-    
-    // Build total-to-unique mapping
-    GTotalToUnique = Singe_xmalloc(num_total_frames * sizeof(int));
-    int t = 0;
-    for (int u = 0; u < num_unique_frames; u++) {
-        for (int i = 0; i < frame_durations[u] && t < num_total_frames; i++) {
-            GTotalToUnique[t++] = u;
+    g_interleaved = (vh->flags & DCMV_FLAG_INTERLEAVED) != 0;
+    if (g_interleaved) {
+        // Audio comes out of the packet stream; no separate audio fds
+        if (audio_ring_init(&g_audio_ring[0], audio_ring_bytes(IL_AUDIO_RING_SIZE)) < 0 ||
+            audio_ring_init(&g_audio_ring[1], audio_ring_bytes(IL_AUDIO_RING_SIZE)) < 0) {
+            printf("PANIC: Failed to allocate audio rings\n");
+            exit(1);
         }
-    }
-    
-    // Calculate audio size
-    long curpos = fs_tell(video_fd);
-    fs_seek(video_fd, 0, SEEK_END);
-    long total_size = fs_tell(video_fd);
-    fs_seek(video_fd, curpos, SEEK_SET);
-    
-    long audio_bytes_total = total_size - audio_offset;
-    left_channel_size = (audio_channels == 2) ? (audio_bytes_total / 2) : audio_bytes_total;
-    
-    // Open audio streams
-    audio_fd_left = fs_open(videopath, O_RDONLY);
-    fs_seek(audio_fd_left, audio_offset, SEEK_SET);
-    
-    if (audio_channels == 2) {
-        audio_fd_right = fs_open(videopath, O_RDONLY);
-        fs_seek(audio_fd_right, audio_offset + left_channel_size, SEEK_SET);
+        il_packet_buf = memalign(32, dcmv_max_packet_size(g_dcmv));
+        if (!il_packet_buf) {
+            printf("PANIC: Failed to allocate packet buffer (%lu bytes)\n",
+                   (unsigned long)dcmv_max_packet_size(g_dcmv));
+            exit(1);
+        }
+        il_apply_reset(0);
+        printf("   Interleaved: %d packets, max packet %lu bytes\n",
+               dcmv_packet_count(g_dcmv), (unsigned long)dcmv_max_packet_size(g_dcmv));
+    } else {
+        // Open audio streams; the audio reader copies them into the rings
+        if (audio_ring_init(&g_audio_ring[0], audio_ring_bytes(AUDIO_RING_SIZE)) < 0 ||
+            audio_ring_init(&g_audio_ring[1], audio_ring_bytes(AUDIO_RING_SIZE)) < 0 ||
+            !(g_audio_stage = memalign(32, AUDIO_READ_CHUNK))) {
+            printf("PANIC: Failed to allocate audio rings\n");
+            exit(1);
+        }
+        audio_fd_left = fs_open(videopath, O_RDONLY);
+        fs_seek(audio_fd_left, dcmv_audio_byte_offset(g_dcmv, 0, 0), SEEK_SET);
+
+        if (audio_channels == 2) {
+            audio_fd_right = fs_open(videopath, O_RDONLY);
+            fs_seek(audio_fd_right, dcmv_audio_byte_offset(g_dcmv, 0, 1), SEEK_SET);
+        }
+        printf("   Audio: %d KB ring per channel, read %d KB at a time\n",
+               (int)audio_ring_bytes(AUDIO_RING_SIZE) / 1024, AUDIO_READ_CHUNK / 1024);
     }
     
     // Initialize video/audio
@@ -4537,39 +6058,123 @@ void singe_startup(const char *gamedir, const char *videopath) {
     UI_OFFSET_X = 0;
     UI_OFFSET_Y = 0;
     
+    // Renditions: the primary first, then the others from the largest frames
+    // down, which is the order the worker steps through them
+    g_rend_count = g_interleaved ? 1 : dcmv_rendition_count(g_dcmv);
+    int slot_size = video_frame_size;
+    for (int r = 0; r < g_rend_count; r++) {
+        g_rends[r].index = r;
+        dcmv_rendition_info(g_dcmv, r, &g_rends[r].info);
+        for (int k = r; k > 1 && g_rends[k].info.video_frame_size > g_rends[k - 1].info.video_frame_size; k--) {
+            rend_view_t t = g_rends[k];
+            g_rends[k] = g_rends[k - 1];
+            g_rends[k - 1] = t;
+        }
+        slot_size = MAX(slot_size, g_rends[r].info.video_frame_size);
+    }
+    for (int r = 1; r < g_rend_count; r++)
+        printf("   Rendition %d: %dx%d, %d bytes/frame\n", g_rends[r].index,
+               g_rends[r].info.width, g_rends[r].info.height, g_rends[r].info.video_frame_size);
+    if (dcmv_rendition_count(g_dcmv) > 1 && g_interleaved)
+        printf("   Renditions ignored: interleaved layout\n");
+
+    // The widest horizon and the frame on screen, or a whole packet, must always fit
+    g_preload_window = MAX(2, MIN(G_DECODED_AHEAD, PRELOAD_WINDOW));
+    load_sched_init(&g_sched, frame_duration, 2, g_preload_window);
+    seek_state_init(&g_seek);
+    if (preload_queue_init(&g_preload, num_unique_frames) < 0) {
+        printf("PANIC: No memory for the preload queue\n");
+        exit(1);
+    }
+    int min_slots = g_interleaved ? DCMV_MAX_PACKET_FRAMES + 1 : g_preload_window + 2;
+    frame_cache_init(&g_frames, MAX(G_FRAME_SLOTS, min_slots));
+    // frame_slots= may ask for more than fits: keep what was allocated, as
+    // long as that is the minimum
+    for (int i = 0; i < g_frames.slots; i++) {
+        frame_buffer[i] = memalign(32, slot_size);
+        if (frame_buffer[i]) continue;
+        if (i < min_slots) {
+            printf("PANIC: No memory for %d frame slots of %d bytes\n", min_slots, slot_size);
+            exit(1);
+        }
+        printf("   Frame cache: only %d of %d slots fit\n", i, g_frames.slots);
+        frame_cache_init(&g_frames, i);
+    }
+    for (int i = 0; i < NUM_BUFFERS; i++)
+        slot_rend[i] = 0;
+    printf("   Frame cache: %d slots of %d bytes (%d KB), up to %d decoded ahead\n", g_frames.slots, slot_size,
+           g_frames.slots * slot_size / 1024, g_preload_window);
+    if (dcmv_max_block_frames(g_dcmv) > 1) {
+        g_block_scratch = memalign(32, video_frame_size);
+        if (!g_block_scratch) {
+            printf("PANIC: No memory for the block scratch frame\n");
+            exit(1);
+        }
+        printf("   Blocks: %d blocks, up to %d frames each\n",
+               dcmv_block_count(g_dcmv), dcmv_max_block_frames(g_dcmv));
+    }
+    g_has_deltas = dcmv_has_deltas(g_dcmv);
     for (int i = 0; i < NUM_BUFFERS; i++) {
-        frame_buffer[i] = memalign(32, video_frame_size);
-        atomic_store(&buf_state[i], BUF_EMPTY);
+        slot_run_count[i] = -1;
+        slot_codebook[i] = -1;
     }
+    if (dcmv_codebook_runs(g_dcmv) > 0)
+        printf("   Codebooks: %d runs\n", dcmv_codebook_runs(g_dcmv));
+    if (g_has_deltas)
+        printf("   Delta frames: partial texture uploads enabled\n");
+    hints_load(videopath);
+    hint_pool_init(slot_size);
+    prefetch_init();
+    readahead_init();
+    trace_open(videopath);
     // printf("   Allocated %d buffers of %d bytes each\n", NUM_BUFFERS, video_frame_size);
     // Initialize PVR
     pvr_init_defaults();
-    
-    int use_strided = (!is_pow2(video_width) || !is_pow2(video_height));
-    int pot_w = 1, pot_h = 1;
-    while (pot_w < video_width) pot_w <<= 1;
-    while (pot_h < video_height) pot_h <<= 1;
-    
-    pvr_txr = pvr_mem_malloc(pot_w * pot_h * 2);
-    
-    pvr_poly_cxt_t cxt;
-    uint32_t fmt = (frame_type == 1) ? PVR_TXRFMT_YUV422 : PVR_TXRFMT_RGB565 | PVR_TXRFMT_VQ_ENABLE;
-    if (use_strided) fmt |= PVR_TXRFMT_NONTWIDDLED | (1 << 25) | PVR_TXRFMT_VQ_ENABLE;
-    else fmt |= PVR_TXRFMT_TWIDDLED | PVR_TXRFMT_VQ_ENABLE;
-    
-    pvr_poly_cxt_txr(&cxt, PVR_LIST_OP_POLY, fmt, pot_w, pot_h, pvr_txr, PVR_FILTER_NONE);
-    pvr_poly_compile(&hdr, &cxt);
-    // hdr.mode3 &= ~(0x3f<<21);
-    // if (use_strided) pvr_txr_set_stride(video_width);
-    if (use_strided) PVR_SET(PVR_TEXTURE_MODULO, (video_width / 32));
-    
-    float u1 = (float)content_width / (float)pot_w;
-    float v1 = (float)content_height / (float)pot_h;
-    
-    vert[0] = (pvr_vertex_t){.flags=PVR_CMD_VERTEX, .x=0, .y=0, .z=1, .u=0, .v=0, .argb=0xFFFFFFFF};
-    vert[1] = (pvr_vertex_t){.flags=PVR_CMD_VERTEX, .x=g_display_w, .y=0, .z=1, .u=u1, .v=0, .argb=0xFFFFFFFF};
-    vert[2] = (pvr_vertex_t){.flags=PVR_CMD_VERTEX, .x=0, .y=g_display_h, .z=1, .u=0, .v=v1, .argb=0xFFFFFFFF};
-    vert[3] = (pvr_vertex_t){.flags=PVR_CMD_VERTEX_EOL, .x=g_display_w, .y=g_display_h, .z=1, .u=u1, .v=v1, .argb=0xFFFFFFFF};
+
+    // One texture big enough for every rendition; each gets its own header
+    // and quad, swapped in by upload_frame
+    int txr_bytes = 0;
+    for (int r = 0; r < g_rend_count; r++) {
+        rend_view_t *v = &g_rends[r];
+        int w = v->info.width, h = v->info.height;
+        v->strided = (!is_pow2(w) || !is_pow2(h));
+        int pot_w = 1, pot_h = 1;
+        while (pot_w < w) pot_w <<= 1;
+        while (pot_h < h) pot_h <<= 1;
+        txr_bytes = MAX(txr_bytes, pot_w * pot_h * 2);
+    }
+    pvr_txr = pvr_mem_malloc(txr_bytes);
+
+    for (int r = 0; r < g_rend_count; r++) {
+        rend_view_t *v = &g_rends[r];
+        int pot_w = 1, pot_h = 1;
+        while (pot_w < v->info.width) pot_w <<= 1;
+        while (pot_h < v->info.height) pot_h <<= 1;
+
+        pvr_poly_cxt_t cxt;
+        uint32_t fmt = (v->info.frame_type == 1) ? PVR_TXRFMT_YUV422 : PVR_TXRFMT_RGB565 | PVR_TXRFMT_VQ_ENABLE;
+        if (v->strided) fmt |= PVR_TXRFMT_NONTWIDDLED | (1 << 25) | PVR_TXRFMT_VQ_ENABLE;
+        else fmt |= PVR_TXRFMT_TWIDDLED | PVR_TXRFMT_VQ_ENABLE;
+
+        // Smaller renditions are stretched to the display: filter them
+        int filter = v->info.content_width < g_display_w ? PVR_FILTER_BILINEAR : PVR_FILTER_NONE;
+        pvr_poly_cxt_txr(&cxt, PVR_LIST_OP_POLY, fmt, pot_w, pot_h, pvr_txr, r ? filter : PVR_FILTER_NONE);
+        pvr_poly_compile(&v->hdr, &cxt);
+        // hdr.mode3 &= ~(0x3f<<21);
+        // if (use_strided) pvr_txr_set_stride(video_width);
+
+        float u1 = (float)v->info.content_width / (float)pot_w;
+        float v1 = (float)v->info.content_height / (float)pot_h;
+
+        v->vert[0] = (pvr_vertex_t){.flags=PVR_CMD_VERTEX, .x=0, .y=0, .z=1, .u=0, .v=0, .argb=0xFFFFFFFF};
+        v->vert[1] = (pvr_vertex_t){.flags=PVR_CMD_VERTEX, .x=g_display_w, .y=0, .z=1, .u=u1, .v=0, .argb=0xFFFFFFFF};
+        v->vert[2] = (pvr_vertex_t){.flags=PVR_CMD_VERTEX, .x=0, .y=g_display_h, .z=1, .u=0, .v=v1, .argb=0xFFFFFFFF};
+        v->vert[3] = (pvr_vertex_t){.flags=PVR_CMD_VERTEX_EOL, .x=g_display_w, .y=g_display_h, .z=1, .u=u1, .v=v1, .argb=0xFFFFFFFF};
+    }
+    hdr = g_rends[0].hdr;
+    memcpy(vert, g_rends[0].vert, sizeof(vert));
+    g_txr_rend = 0;
+    if (g_rends[0].strided) PVR_SET(PVR_TEXTURE_MODULO, (video_width / 32));
     
 
         
@@ -4599,20 +6204,44 @@ void singe_startup(const char *gamedir, const char *videopath) {
     // }
     sep_music_init();
 
-    // Initialize audio
-    snd_stream_init_ex(audio_channels, soundbufferalloc);
-    stream = snd_stream_alloc(NULL, soundbufferalloc);
-    snd_stream_set_callback_direct(stream, audio_cb);
-    snd_stream_start_adpcm(stream, sample_rate, audio_channels == 2 ? 1 : 0);
+    // Initialize audio: our own AICA channels if asked for, else snd_stream
     atomic_store(&audio_muted, 1);
+    if (G_AUDIO_DIRECT_KB > 0 && sample_rate > 0 && aica_direct_init() == 0) {
+        // Late once the poll misses the ring minus the refill in flight
+        g_audio_svc.budget_us = (uint32_t)((uint64_t)(g_aica.ring.size - g_aica.ring.chunk) * 2 * 1000000ULL /
+                                           (uint32_t)sample_rate);
+        printf("   Audio: direct AICA, %u KB SPU RAM ring per channel, %u KB refills%s\n",
+               g_aica.ring.size / 1024, g_aica.ring.chunk / 1024,
+               G_AUDIO_DIRECT_KB > AICA_DIRECT_MAX_KB ? " (the most a channel can loop over)" : "");
+    } else {
+        if (G_AUDIO_DIRECT_KB > 0)
+            printf("   Audio: no SPU RAM or channels for direct streaming, using snd_stream\n");
+        snd_stream_init_ex(audio_channels, soundbufferalloc);
+        stream = snd_stream_alloc(NULL, soundbufferalloc);
+        snd_stream_set_callback_direct(stream, audio_cb);
+        snd_stream_start_adpcm(stream, sample_rate, audio_channels == 2 ? 1 : 0);
+        if (sample_rate > 0)
+            g_audio_svc.budget_us = (uint32_t)((uint64_t)soundbufferalloc * 1000000ULL / (uint32_t)sample_rate);
+    }
+    g_audio_thread = thd_create(0, audio_thread, NULL);
+    if (g_audio_thread)
+        thd_set_prio(g_audio_thread, AUDIO_THREAD_PRIO);
+    if (!g_interleaved) {
+        g_audio_reader = thd_create(0, audio_reader_thread, NULL);
+        if (g_audio_reader)
+            thd_set_prio(g_audio_reader, AUDIO_THREAD_PRIO + 1);
+    }
     worker_thread_id = thd_create(0, worker_thread, NULL);
+    if (g_ra_enabled)
+        g_reader_thread = thd_create(0, reader_thread, NULL);
 
 
     // ✅ Initialize timing but don't start clocks
     frame_timer_anchor = 0.0;  // Will be set when playback actually starts
     atomic_store(&audio_start_time_ms, 0.0);
     atomic_store(&audio_muted, 1);
-    printf("   Decoder thread started\n");
+    printf("   Decoder and audio threads started (audio polled every %d ms, underrun past %.1f ms)\n",
+           g_aica.enabled ? AICA_DIRECT_SERVICE_MS : AUDIO_SERVICE_MS, g_audio_svc.budget_us / 1000.0);
     g_is_paused = 1;
     preload_paused = 1;
     atomic_store(&audio_muted, 1);       
@@ -4672,6 +6301,24 @@ static void load_config(void) {
                 strncpy(G_SCRIPT_FILE, eq, sizeof(G_SCRIPT_FILE));
             else if (strcmp(line, "chunk_name") == 0)
                 strncpy(G_CHUNK_NAME, eq, sizeof(G_CHUNK_NAME));
+            else if (strcmp(line, "read_trace") == 0)
+                strncpy(G_READ_TRACE, eq, sizeof(G_READ_TRACE));
+            else if (strcmp(line, "seek_cache") == 0)
+                G_SEEK_CACHE = atoi(eq);
+            else if (strcmp(line, "prefetch_kb") == 0)
+                G_PREFETCH_KB = atoi(eq);
+            else if (strcmp(line, "frame_slots") == 0)
+                G_FRAME_SLOTS = atoi(eq);
+            else if (strcmp(line, "readahead_kb") == 0)
+                G_READAHEAD_KB = atoi(eq);
+            else if (strcmp(line, "readahead_s") == 0)
+                G_READAHEAD_S = atoi(eq);
+            else if (strcmp(line, "decoded_ahead") == 0)
+                G_DECODED_AHEAD = atoi(eq);
+            else if (strcmp(line, "worker_poll") == 0)
+                G_WORKER_POLL = atoi(eq);
+            else if (strcmp(line, "audio_direct_kb") == 0)
+                G_AUDIO_DIRECT_KB = atoi(eq);
             else if (strcmp(line, "btn_a") == 0)
                 MAP_A = parse_button(eq);
             else if (strcmp(line, "btn_b") == 0)
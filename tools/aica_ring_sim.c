@@ -0,0 +1,176 @@
+// aica_ring_sim.c - check the SPU RAM ring bookkeeping against a simulated channel
+//
+// Plays an ADPCM channel in simulated time over a byte-exact copy of its
+// ring and services it the way the engine's audio thread does: read the play
+// position, aica_ring_advance, then write every refill aica_ring_next allows.
+// Each byte written carries a pattern of its position in the stream, so when
+// the channel plays a byte that is not the one due it is either a counted
+// underrun (the service was too late) or a bookkeeping bug that overwrote
+// unplayed data, which fails the run. The service runs every period with
+// some jitter and now and then stalls, as the SH4 does under a Lua garbage
+// collection or a drive retry.
+//
+// It runs twice: once shaped like snd_stream (a 4 KB buffer refilled a half
+// at a time, polled every 4 ms) and once like direct AICA mode (--kb per
+// channel, 16 at most as the loop registers are 16-bit sample counts,
+// refilled a quarter at a time, every 50 ms), and compares refills and
+// underruns.
+//
+//   aica-ring-sim [--seconds S] [--rate HZ] [--kb K] [--stall-ms MS] [--stall-odds N] [--seed S]
+
+#include "aica_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    uint32_t size, chunk;
+    double period_ms;
+} sim_config_t;
+
+typedef struct {
+    uint64_t services, refills, stale;
+    uint32_t underruns;
+    double worst_gap_ms;
+    int failed;
+} sim_result_t;
+
+static uint32_t rng_state = 0x2545f491u;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint8_t pattern(uint32_t n) {
+    return (uint8_t)((n * 2654435761u) >> 24);
+}
+
+static void sim_run(const sim_config_t *cfg, double seconds, uint32_t rate, double stall_ms, uint32_t stall_odds,
+                    uint32_t seed, sim_result_t *res) {
+    aica_ring_t r;
+    uint8_t *spu = malloc(cfg->size);
+    memset(res, 0, sizeof(*res));
+    if (!spu || aica_ring_init(&r, cfg->size, cfg->chunk) < 0) {
+        printf("FAIL: %s: bad ring %u/%u\n", cfg->name, cfg->size, cfg->chunk);
+        res->failed = 1;
+        free(spu);
+        return;
+    }
+    rng_state = seed;
+    double bytes_per_ms = rate / 2.0 / 1000.0;       // 4-bit ADPCM
+
+    // Prime as the engine does before starting the channel
+    uint32_t off, len;
+    while ((len = aica_ring_next(&r, &off)) > 0) {
+        for (uint32_t i = 0; i < len; i++) spu[off + i] = pattern(r.written + i);
+        aica_ring_commit(&r, len);
+    }
+
+    double now = 0;
+    uint64_t played = 0;                              // bytes the channel has played
+    uint64_t resumed = 0;                             // where writing picked up after the last underrun
+    while (now < seconds * 1000.0 && !res->failed) {
+        double gap = cfg->period_ms * (0.8 + (rng_next() % 400) / 1000.0);
+        if (stall_odds && rng_next() % stall_odds == 0) gap += stall_ms;
+        now += gap;
+        if (gap > res->worst_gap_ms) res->worst_gap_ms = gap;
+
+        // The channel plays on; check what it played since the last service.
+        // Up to the aligned byte writing resumed at, an underrun runs on.
+        uint64_t target = (uint64_t)(now * bytes_per_ms);
+        uint32_t before = r.underruns, stale = 0, late = 0;
+        for (uint64_t p = played; p < target; p++) {
+            if (spu[p % cfg->size] != pattern((uint32_t)p)) {
+                if (p < resumed) late++;
+                else stale++;
+            }
+        }
+        res->stale += late;
+
+        // The engine's clock and the position read disagree by up to 2 ms
+        double skew = ((double)(rng_next() % 4001) / 1000.0 - 2.0) * bytes_per_ms;
+        uint32_t elapsed = (uint32_t)((double)(target - played) + skew > 0 ? (double)(target - played) + skew : 0);
+        played = target;
+        aica_ring_advance(&r, (uint32_t)(played % cfg->size), elapsed);
+        res->services++;
+        if (r.underruns != before) resumed = played + (r.written - r.played);
+        if (stale) {
+            res->stale += stale;
+            if (r.underruns == before) {
+                printf("FAIL: %s: %u bytes played that were not the ones due, with no underrun "
+                       "counted (%.1f ms)\n", cfg->name, stale, now);
+                res->failed = 1;
+            }
+        }
+
+        while ((len = aica_ring_next(&r, &off)) > 0) {
+            if (off + len > cfg->size || (off | len) % AICA_RING_ALIGN) {
+                printf("FAIL: %s: refill %u+%u outside the ring or unaligned\n", cfg->name, off, len);
+                res->failed = 1;
+                break;
+            }
+            // A refill may only cover bytes already played
+            if (r.written + len - r.played > cfg->size) {
+                printf("FAIL: %s: refill %u+%u overwrites unplayed data\n", cfg->name, off, len);
+                res->failed = 1;
+                break;
+            }
+            for (uint32_t i = 0; i < len; i++) spu[off + i] = pattern(r.written + i);
+            aica_ring_commit(&r, len);
+        }
+    }
+    res->refills = r.refills;
+    res->underruns = r.underruns;
+    free(spu);
+}
+
+int main(int argc, char **argv) {
+    double seconds = 600, stall_ms = 150;
+    uint32_t rate = 44100, kb = 16, stall_odds = 200, seed = 0x2545f491u;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--rate") && i + 1 < argc) rate = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--kb") && i + 1 < argc) kb = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--stall-ms") && i + 1 < argc) stall_ms = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--stall-odds") && i + 1 < argc) stall_odds = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else {
+            printf("usage: aica-ring-sim [--seconds S] [--rate HZ] [--kb K] [--stall-ms MS] "
+                   "[--stall-odds N] [--seed S]\n");
+            return 1;
+        }
+    }
+    if (rate < 8000 || seconds <= 0 || !seed) {
+        printf("aica-ring-sim: rate of at least 8000 Hz, positive duration, nonzero seed\n");
+        return 1;
+    }
+    if (kb * 1024 * 2 > 0xffff) {
+        printf("aica-ring-sim: --kb 16 at most, a channel loops over 65535 samples\n");
+        return 1;
+    }
+
+    sim_config_t configs[2] = {
+        { "snd_stream", 4096, 2048, 4.0 },
+        { "direct", kb * 1024, kb * 1024 / 4, 50.0 },
+    };
+    printf("%.0f s of %u Hz ADPCM, service jitter +-20%%, 1 in %u services %.0f ms late\n", seconds, rate,
+           stall_odds, stall_ms);
+    printf("%-11s %8s %8s %9s %9s %10s %10s %12s\n", "mode", "ring KB", "refill", "services", "refills",
+           "refills/s", "underruns", "stale bytes");
+    int failed = 0;
+    for (int c = 0; c < 2; c++) {
+        sim_result_t res;
+        sim_run(&configs[c], seconds, rate, stall_ms, stall_odds, seed, &res);
+        failed |= res.failed;
+        printf("%-11s %8u %8u %9llu %9llu %10.2f %10u %12llu\n", configs[c].name, configs[c].size / 1024,
+               configs[c].chunk, (unsigned long long)res.services, (unsigned long long)res.refills,
+               res.refills / seconds, res.underruns, (unsigned long long)res.stale);
+    }
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
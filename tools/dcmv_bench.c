@@ -0,0 +1,1729 @@
+// dcmv_bench.c - host decode-throughput benchmark for .dcmv files
+//
+// Decodes unique frames through the same reader the engine uses and reports
+// frames/s, MB/s and latency percentiles for sequential and random access,
+// plus how that compares with the movie's own frame rate. Sequential passes
+// decode a whole block per call, as the engine does. Movies with renditions
+// get the same passes for each of them.
+//
+// --codec-report re-encodes the movie (per-frame Zstd, + dictionary, blocks,
+// blocks + dictionary) into temporary files and prints size and decode time
+// for each next to the source layout.
+//
+// --codebook-report measures how many consecutive frames could share one VQ
+// codebook: exactly (what dcmv-remux --codebooks stores) and within a few
+// PSNR budgets, mapping each codebook entry to the nearest one of the run's.
+//
+// --map-bench checks dcmv_total_to_unique against a flat per-total-frame
+// table and times it in the pattern the engine's preload scheduling uses,
+// then looks frames up from several threads at once, sharing an io lock as
+// the engine does, and checks every answer. Meanwhile a play head walks the
+// movie with the main thread's lookups, which never read: with its pages
+// pinned as the worker pins them, none may miss.
+//
+// --sector-report replays the engine's reads (playback front to back, then
+// random seeks) of one or more movies through a model of the GD-ROM driver
+// and counts the device commands and sectors they cost. Each file is compared
+// with the first one of the same layout, e.g. a movie and its dcmv-remux
+// --sector-align copy.
+//
+// --seek-replay feeds the seeks of engine read traces (read_trace= in
+// singe.cfg), or of a synthetic branching game when none are given, through
+// the engine's learned seek model and reports how often the target was among
+// the frames the seek cache would hold, and what decoding them costs a miss.
+//
+// --cache-bench plays a game along the segments and jumps of a singe-hints
+// file, one frame per tick with a decode budget per tick and a drive seek
+// for every discontiguous load, and compares the engine's frame cache at
+// several sizes with the old slot-per-frame-modulo scheme: frames shown
+// again without a reload, loads, evictions and display stalls.
+//
+// --pipeline-bench plays the movie front to back from a simulated slow drive
+// (a fixed cost per command plus a transfer rate) twice: reading and
+// decompressing each block in turn, as the engine's worker used to, and with
+// a reader thread streaming runs of blocks into a bounded compressed ring
+// while a second thread decompresses out of it, as it does with readahead_kb.
+// --decode-ms adds time per frame decoded, for the SH4's slower decompression.
+// Both sides use the engine's read-ahead ring index, and a fixed case checks
+// it across a wrap first; a small --ring makes the pipelined run wrap too.
+//
+// --sched-bench plays a branching game (jumps to random frames) in simulated
+// time with the same drive model, frame cache and preload queue as the engine,
+// and compares the deadline scheduler's adaptive horizon with the fixed
+// windows it replaced (16 frames from the worker, 8 from fmv_tick, loaded
+// first in, first out): display underruns, stall time, loads and the horizon.
+//
+// --seek-storm plays the same game with the script skipping at random, in
+// bursts now and then, and compares the old seek, which reopened the files
+// and slept on the main thread, with the engine's asynchronous one
+// (seek_state.h): seek latency and its histogram, and the overlay frames the
+// main thread missed. --frames is the number of seeks.
+//
+//   dcmv-bench [--mmap] [--mode seq|random|both] [--frames N] [--seed S] movie.dcmv
+//   dcmv-bench --codec-report [--block N] [--dict BYTES] [--level L] [--tmp DIR] movie.dcmv
+//   dcmv-bench --codebook-report movie.dcmv
+//   dcmv-bench --map-bench movie.dcmv
+//   dcmv-bench --sector-report [--frames N] [--seed S] movie.dcmv [aligned.dcmv ...]
+//   dcmv-bench --seek-replay [--frames N] [--seed S] movie.dcmv [trace ...]
+//   dcmv-bench --cache-bench [--frames N] [--seed S] movie.dcmv game.hints
+//   dcmv-bench --pipeline-bench [--frames N] [--latency MS] [--rate KB/s] [--decode-ms MS] [--ring KB]
+//                                         movie.dcmv
+//   dcmv-bench --sched-bench [--frames N] [--seed S] [--latency MS] [--rate KB/s] [--decode-ms MS]
+//                                        movie.dcmv
+//   dcmv-bench --seek-storm [--frames N] [--seed S] [--latency MS] [--rate KB/s] [--decode-ms MS]
+//                                       movie.dcmv
+
+#define _GNU_SOURCE
+#include "dcmv.h"
+#include "dcmv_transcode.h"
+#include "seek_model.h"
+#include "frame_cache.h"
+#include "preload_queue.h"
+#include "load_sched.h"
+#include "seek_state.h"
+#include "readahead_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <malloc.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t percentile(const uint64_t *sorted, int n, double p) {
+    int i = (int)(p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+// xorshift so runs are repeatable for a given seed
+static uint32_t rng_state = 0x12345678u;
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// One read + decompress of the block starting at u, as the engine's
+// sequential path does it.
+static int decode_block_at(dcmv_t *d, int u, int count, uint8_t **dst) {
+    if (dcmv_has_deltas(d)) return dcmv_decode_frame(d, u, dst[0], NULL, 0, NULL);
+
+    const uint8_t *data;
+    uint32_t n;
+    if (dcmv_read_frame(d, u, &data, &n) < 0) return -1;
+    if (count == 1) return dcmv_decompress_frame(d, u, data, n, dst[0], 0);
+    return dcmv_decompress_block(d, data, n, (void *const *)dst, count);
+}
+
+// Sequential: one read + decompress per block, latency spread over its frames.
+// Random: one frame at a time through dcmv_decode_into. Renditions other than
+// the primary decode one frame per call either way.
+static int run_pass(dcmv_t *d, int rend, const char *name, int random, int frames, uint8_t **dst) {
+    const dcmv_header_t *h = dcmv_header(d);
+    dcmv_rendition_t info;
+    dcmv_rendition_info(d, rend, &info);
+    uint64_t *lat = malloc(sizeof(uint64_t) * frames);
+    uint64_t in_bytes = 0;
+    int failures = 0;
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < frames; ) {
+        int u = random ? (int)(rng_next() % (uint32_t)h->num_unique_frames)
+                       : i % h->num_unique_frames;
+        uint32_t off, size;
+        dcmv_frame_range(d, u, &off, &size);
+
+        // Sequential walks start on block boundaries, so u is always first
+        int first = u, count = 1;
+        uint64_t s = now_ns();
+        if (rend) {
+            if (dcmv_decode_rendition(d, rend, u, dst[0]) < 0) failures++;
+            size = (uint32_t)(info.bytes / (uint64_t)h->num_unique_frames);
+        } else if (random) {
+            if (dcmv_decode_into(d, u, dst[0]) < 0) failures++;
+        } else {
+            dcmv_block_of(d, u, &first, &count);
+            if (decode_block_at(d, u, count, dst) < 0) failures++;
+        }
+        if (count > frames - i) count = frames - i;
+        uint64_t per = (now_ns() - s) / (uint64_t)count;
+        for (int k = 0; k < count; k++) lat[i + k] = per;
+        in_bytes += size;
+        i += count;
+    }
+    double secs = (now_ns() - t0) / 1e9;
+
+    qsort(lat, frames, sizeof(uint64_t), cmp_u64);
+    double fps = frames / secs;
+    double out_mb = (double)frames * info.video_frame_size / (1024.0 * 1024.0) / secs;
+    double in_mb = (double)in_bytes / (1024.0 * 1024.0) / secs;
+
+    printf("%-7s %8d frames  %9.1f frames/s  %7.1f MB/s out  %7.1f MB/s in  "
+           "p50 %6.3f ms  p99 %6.3f ms  max %6.3f ms  %5.1fx realtime%s\n",
+           name, frames, fps, out_mb, in_mb,
+           percentile(lat, frames, 0.50) / 1e6, percentile(lat, frames, 0.99) / 1e6,
+           lat[frames - 1] / 1e6, fps / h->fps,
+           failures ? "  (DECODE FAILURES)" : "");
+    if (failures) printf("        %d frames failed to decode\n", failures);
+
+    free(lat);
+    return failures ? -1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Codec report
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint64_t video_bytes;
+    uint64_t file_bytes;
+    double seq_us;                // per frame, whole-block decode
+    double rand_p50_us, rand_p99_us;
+} codec_result_t;
+
+static int measure(const char *path, int rand_frames, uint8_t **dst, codec_result_t *r) {
+    dcmv_t *d = dcmv_open(path, DCMV_BACKEND_MMAP);
+    if (!d) return -1;
+    const dcmv_header_t *h = dcmv_header(d);
+    int n = h->num_unique_frames;
+    int failures = 0;
+    memset(r, 0, sizeof(*r));
+    r->file_bytes = h->file_size;
+
+    // Best of three sequential passes
+    r->seq_us = 1e30;
+    for (int pass = 0; pass < 3; pass++) {
+        uint64_t video = 0;
+        uint64_t t0 = now_ns();
+        for (int u = 0; u < n; ) {
+            int first, count;
+            uint32_t off, size;
+            dcmv_block_of(d, u, &first, &count);
+            if (dcmv_frame_range(d, u, &off, &size) < 0 || decode_block_at(d, u, count, dst) < 0)
+                failures++;
+            video += size;
+            u = first + count;
+        }
+        double us = (now_ns() - t0) / 1e3 / n;
+        if (us < r->seq_us) r->seq_us = us;
+        r->video_bytes = video;
+    }
+
+    uint64_t *lat = malloc(sizeof(uint64_t) * rand_frames);
+    rng_state = 0x12345678u;
+    for (int i = 0; i < rand_frames; i++) {
+        int u = (int)(rng_next() % (uint32_t)n);
+        uint64_t s = now_ns();
+        if (dcmv_decode_into(d, u, dst[0]) < 0) failures++;
+        lat[i] = now_ns() - s;
+    }
+    qsort(lat, rand_frames, sizeof(uint64_t), cmp_u64);
+    r->rand_p50_us = percentile(lat, rand_frames, 0.50) / 1e3;
+    r->rand_p99_us = percentile(lat, rand_frames, 0.99) / 1e3;
+    free(lat);
+    dcmv_close(d);
+    if (failures) printf("%s: %d decode failures\n", path, failures);
+    return failures ? -1 : 0;
+}
+
+static void print_result(const char *name, const codec_result_t *r, const codec_result_t *base, float fps) {
+    printf("%-16s %10.2f MB %7.1f%% %10.2f MB %9.1f us %7.1fx rt %9.1f us %9.1f us\n",
+           name, r->video_bytes / (1024.0 * 1024.0), 100.0 * r->video_bytes / base->video_bytes,
+           r->file_bytes / (1024.0 * 1024.0), r->seq_us, 1e6 / r->seq_us / fps,
+           r->rand_p50_us, r->rand_p99_us);
+}
+
+static int codec_report(const char *path, int block, uint32_t dict, int level, const char *tmpdir) {
+    dcmv_t *d = dcmv_open(path, DCMV_BACKEND_FILE);
+    if (!d) return 1;
+    const dcmv_header_t *h = dcmv_header(d);
+    float fps = h->fps;
+    int frame_size = h->video_frame_size;
+    int rand_frames = h->num_unique_frames < 2000 ? h->num_unique_frames : 2000;
+    printf("%s: %d unique frames of %d bytes, source %s, level %d, block %d, dict %u\n",
+           path, h->num_unique_frames, frame_size,
+           h->compression == DCMV_COMPRESSION_ZSTD ? "zstd" : "lz4", level, block, dict);
+    dcmv_close(d);
+
+    uint8_t *dst[DCMV_MAX_PACKET_FRAMES];
+    for (int i = 0; i < DCMV_MAX_PACKET_FRAMES; i++) dst[i] = memalign(32, frame_size);
+
+    struct { const char *name; int block; uint32_t dict; } variants[] = {
+        { "frame",        1,     0    },
+        { "frame+dict",   1,     dict },
+        { "block",        block, 0    },
+        { "block+dict",   block, dict },
+    };
+
+    printf("%-16s %13s %8s %13s %12s %10s %12s %12s\n",
+           "layout", "video", "vs src", "file", "seq/frame", "seq", "rand p50", "rand p99");
+    codec_result_t base;
+    int rc = measure(path, rand_frames, dst, &base);
+    if (rc == 0) print_result("source", &base, &base, fps);
+
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]) && rc == 0; v++) {
+        char tmp[512];
+        snprintf(tmp, sizeof(tmp), "%s/dcmv-bench-%d-%zu.dcmv", tmpdir, (int)getpid(), v);
+
+        dcmv_transcode_opts_t o;
+        dcmv_transcode_defaults(&o);
+        o.interleave = 0;
+        o.recompress = 1;
+        o.level = level;
+        o.block_frames = variants[v].block;
+        o.dict_size = variants[v].dict;
+        o.quiet = 1;
+
+        codec_result_t r;
+        if (dcmv_transcode(path, tmp, &o) < 0 || measure(tmp, rand_frames, dst, &r) < 0) {
+            printf("%s: failed\n", variants[v].name);
+            rc = 1;
+        } else {
+            print_result(variants[v].name, &r, &base, fps);
+        }
+        unlink(tmp);
+    }
+
+    for (int i = 0; i < DCMV_MAX_PACKET_FRAMES; i++) free(dst[i]);
+    return rc;
+}
+
+// ---------------------------------------------------------------------------
+// Codebook report
+// ---------------------------------------------------------------------------
+#define CB_ENTRIES 256
+#define CB_COMPS   12             // 4 texels x RGB, or 8 YUV422 bytes
+
+typedef struct {
+    double min_psnr;              // 0 = exact matches only
+    int cb[CB_ENTRIES][CB_COMPS]; // codebook of the current run
+    int runs, longest, frames_in_run;
+} cb_tracker_t;
+
+// Codebook entries as comparable components
+static void expand_codebook(const uint8_t *frame, int frame_type, int (*out)[CB_COMPS]) {
+    for (int e = 0; e < CB_ENTRIES; e++) {
+        const uint8_t *p = frame + e * 8;
+        for (int t = 0; t < 4; t++) {
+            if (frame_type == 1) {
+                out[e][t * 2] = p[t * 2];
+                out[e][t * 2 + 1] = p[t * 2 + 1];
+                out[e][8 + t] = 0;
+            } else {
+                int v = p[t * 2] | (p[t * 2 + 1] << 8);
+                out[e][t * 3]     = ((v >> 11) & 0x1F) << 3;
+                out[e][t * 3 + 1] = ((v >> 5) & 0x3F) << 2;
+                out[e][t * 3 + 2] = (v & 0x1F) << 3;
+            }
+        }
+    }
+}
+
+// PSNR of drawing the frame with codebook `cb`, each entry replaced by its
+// nearest neighbour and weighted by how often the index data uses it.
+static double reuse_psnr(int (*cur)[CB_COMPS], const uint32_t *usage, uint64_t total,
+                         int (*cb)[CB_COMPS], int comps) {
+    double sse = 0.0;
+    for (int e = 0; e < CB_ENTRIES; e++) {
+        if (!usage[e]) continue;
+        int64_t best = INT64_MAX;
+        for (int k = 0; k < CB_ENTRIES && best; k++) {
+            int64_t dist = 0;
+            for (int c = 0; c < comps; c++) {
+                int diff = cur[e][c] - cb[k][c];
+                dist += diff * diff;
+            }
+            if (dist < best) best = dist;
+        }
+        sse += (double)best * usage[e];
+    }
+    double mse = sse / ((double)total * comps);
+    return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+static int codebook_report(const char *path) {
+    dcmv_t *d = dcmv_open(path, DCMV_BACKEND_FILE);
+    if (!d) return 1;
+    const dcmv_header_t *h = dcmv_header(d);
+    int n = h->num_unique_frames;
+    int comps = h->frame_type == 1 ? 8 : 12;
+    if (h->video_frame_size <= DCMV_CODEBOOK_SIZE) {
+        dcmv_close(d);
+        return 1;
+    }
+
+    static cb_tracker_t trackers[] = { { .min_psnr = 0.0 }, { .min_psnr = 45.0 },
+                                       { .min_psnr = 40.0 }, { .min_psnr = 35.0 } };
+    enum { NT = sizeof(trackers) / sizeof(trackers[0]) };
+    static int cur[CB_ENTRIES][CB_COMPS];
+    uint8_t *frame = memalign(32, h->video_frame_size);
+    uint8_t *prev = malloc(DCMV_CODEBOOK_SIZE);
+    int failures = 0;
+
+    for (int u = 0; u < n; u++) {
+        if (dcmv_decode_into(d, u, frame) < 0) {
+            failures++;
+            continue;
+        }
+        uint32_t usage[CB_ENTRIES] = { 0 };
+        for (int i = DCMV_CODEBOOK_SIZE; i < h->video_frame_size; i++) usage[frame[i]]++;
+        uint64_t total = (uint64_t)(h->video_frame_size - DCMV_CODEBOOK_SIZE) * 4;
+        for (int e = 0; e < CB_ENTRIES; e++) usage[e] *= 4;   // texels per entry
+        expand_codebook(frame, h->frame_type, cur);
+
+        for (int t = 0; t < NT; t++) {
+            cb_tracker_t *k = &trackers[t];
+            int same;
+            if (u == 0) same = 0;
+            else if (k->min_psnr == 0.0) same = !memcmp(prev, frame, DCMV_CODEBOOK_SIZE);
+            else same = reuse_psnr(cur, usage, total, k->cb, comps) >= k->min_psnr;
+
+            if (same) {
+                k->frames_in_run++;
+            } else {
+                // New run with this frame's codebook
+                k->runs++;
+                k->frames_in_run = 1;
+                memcpy(k->cb, cur, sizeof(cur));
+            }
+            if (k->frames_in_run > k->longest) k->longest = k->frames_in_run;
+        }
+        memcpy(prev, frame, DCMV_CODEBOOK_SIZE);
+    }
+
+    printf("%s: %d unique frames, %s VQ, codebook %d of %d bytes per frame\n",
+           path, n, h->frame_type == 1 ? "YUV422" : "RGB565", DCMV_CODEBOOK_SIZE, h->video_frame_size);
+    printf("%-12s %8s %14s %10s %14s %12s\n",
+           "reuse", "runs", "frames/run", "longest", "codebook MB", "upload saved");
+    for (int t = 0; t < NT; t++) {
+        cb_tracker_t *k = &trackers[t];
+        char name[32];
+        if (k->min_psnr == 0.0) snprintf(name, sizeof(name), "exact");
+        else snprintf(name, sizeof(name), ">= %.0f dB", k->min_psnr);
+        double saved = (double)(n - k->runs) * DCMV_CODEBOOK_SIZE;
+        printf("%-12s %8d %14.2f %10d %11.2f MB %11.2f%%\n", name, k->runs,
+               k->runs ? (double)n / k->runs : 0.0, k->longest,
+               (double)k->runs * DCMV_CODEBOOK_SIZE / (1024.0 * 1024.0),
+               100.0 * saved / ((double)n * h->video_frame_size));
+    }
+    if (failures) printf("%d frames failed to decode\n", failures);
+
+    free(frame);
+    free(prev);
+    dcmv_close(d);
+    return failures ? 1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Total -> unique map
+// ---------------------------------------------------------------------------
+#define MAP_WINDOW 16             // worker preload window per tick
+#define MAP_RING   24             // queued jobs scanned by each schedule call
+
+#define MAP_THREADS 4             // reader, worker, main thread, audio reader
+#define MAP_THREAD_LOOKUPS 200000
+#define MAP_PIN_EVERY 16          // total frames the play head moves between pins
+
+static volatile int map_sink;
+
+// Threads looking frames up at random, as the engine's do, against tables
+// built single-threaded. With paged tables every few lookups load a page.
+typedef struct {
+    dcmv_t *d;
+    const int *flat, *first;      // total -> unique, unique -> first total
+    const uint32_t *offsets;
+    uint32_t rng;
+    int bad;
+} map_thread_t;
+
+static pthread_mutex_t map_io = PTHREAD_MUTEX_INITIALIZER;
+static void map_lock(void *arg)   { pthread_mutex_lock(arg); }
+static void map_unlock(void *arg) { pthread_mutex_unlock(arg); }
+
+static void *map_thread(void *arg) {
+    map_thread_t *m = arg;
+    const dcmv_header_t *h = dcmv_header(m->d);
+    for (int i = 0; i < MAP_THREAD_LOOKUPS; i++) {
+        m->rng ^= m->rng << 13;
+        m->rng ^= m->rng >> 17;
+        m->rng ^= m->rng << 5;
+        int t = (int)(m->rng % (uint32_t)h->num_total_frames), u = m->flat[t];
+        uint32_t off, size;
+        if (dcmv_total_to_unique(m->d, t) != u) m->bad++;
+        if (dcmv_unique_to_total(m->d, u) != m->first[u]) m->bad++;
+        if (dcmv_frame_range(m->d, u, &off, &size) < 0 || off != m->offsets[u]) m->bad++;
+    }
+    return NULL;
+}
+
+static int map_threaded(dcmv_t *d, const int *flat) {
+    const dcmv_header_t *h = dcmv_header(d);
+    int n = h->num_unique_frames;
+    int *first = malloc(sizeof(int) * (size_t)n);
+    uint32_t *offsets = malloc(sizeof(uint32_t) * (size_t)n);
+    for (int u = 0; u < n; u++) {
+        uint32_t size;
+        first[u] = dcmv_unique_to_total(d, u);
+        if (dcmv_frame_range(d, u, &offsets[u], &size) < 0) offsets[u] = UINT32_MAX;
+    }
+    dcmv_set_io_lock(d, map_lock, map_unlock, &map_io);
+    uint32_t loads = dcmv_table_page_loads(d);
+
+    pthread_t threads[MAP_THREADS];
+    map_thread_t state[MAP_THREADS];
+    for (int i = 0; i < MAP_THREADS; i++) {
+        state[i] = (map_thread_t){ d, flat, first, offsets, 0x9e3779b9u * (uint32_t)(i + 1), 0 };
+        pthread_create(&threads[i], NULL, map_thread, &state[i]);
+    }
+    // The play head, as fmv_tick maps it, while the others churn the pages
+    int bad = 0, misses = 0;
+    for (int t = 0; t < h->num_total_frames; t++) {
+        if (t % MAP_PIN_EVERY == 0) dcmv_pin_pages(d, t);
+        int u = dcmv_total_to_unique_nowait(d, t);
+        if (u < 0) misses++;
+        else if (u != flat[t]) bad++;
+    }
+    for (int i = 0; i < MAP_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        bad += state[i].bad;
+    }
+    dcmv_set_io_lock(d, NULL, NULL, NULL);
+    printf("%d threads, %d lookups each: %u table pages loaded, %d wrong answers; "
+           "play head: %d lookups, %d missed a pinned page\n", MAP_THREADS, MAP_THREAD_LOOKUPS * 3,
+           dcmv_table_page_loads(d) - loads, bad, h->num_total_frames, misses);
+    bad += misses;
+    free(first);
+    free(offsets);
+    return bad;
+}
+
+static int map_bench(const char *path) {
+    dcmv_t *d = dcmv_open(path, DCMV_BACKEND_FILE);
+    if (!d) return 1;
+    const dcmv_header_t *h = dcmv_header(d);
+    int total = h->num_total_frames, n = h->num_unique_frames;
+
+    // The table the engine used to keep
+    int *flat = malloc(sizeof(int) * (size_t)total);
+    int t = 0;
+    for (int u = 0; u < n; u++)
+        for (int i = 0; i < dcmv_frame_duration(d, u) && t < total; i++) flat[t++] = u;
+    for (; t < total; t++) flat[t] = n - 1;
+
+    int bad = 0;
+    for (t = 0; t < total; t++) {
+        if (dcmv_total_to_unique(d, t) != flat[t]) {
+            if (bad++ < 8) printf("map: total %d -> %d, expected %d\n", t, dcmv_total_to_unique(d, t), flat[t]);
+        }
+    }
+    for (int u = 0; u < n; u++) {
+        if (dcmv_frame_duration(d, u) && dcmv_total_to_unique(d, dcmv_unique_to_total(d, u)) != u) {
+            if (bad++ < 8) printf("map: unique %d does not round-trip\n", u);
+        }
+    }
+
+    // One schedule tick: every window target looked up, plus a ring scan each
+    enum { TICKS = 20000 };
+    uint64_t lookups = (uint64_t)TICKS * MAP_WINDOW * (1 + MAP_RING);
+    double ns[2];
+    for (int impl = 0; impl < 2; impl++) {
+        rng_state = 0x12345678u;
+        int sink = 0;
+        uint64_t t0 = now_ns();
+        for (int tick = 0; tick < TICKS; tick++) {
+            int cur = (int)(rng_next() % (uint32_t)total);
+            for (int i = 1; i <= MAP_WINDOW; i++) {
+                for (int k = 0; k <= MAP_RING; k++) {
+                    int f = cur + i + k;
+                    if (f >= total) f = total - 1;
+                    sink += impl ? flat[f] : dcmv_total_to_unique(d, f);
+                }
+            }
+        }
+        ns[impl] = (double)(now_ns() - t0) / lookups;
+        map_sink = sink;
+    }
+
+    printf("%s: %d total / %d unique frames, %s tables\n", path, total, n,
+           (h->flags & DCMV_FLAG_PAGED_TABLES) ? "paged" : "inline");
+    printf("flat table   %8zu bytes  %6.1f ns/lookup  %8.2f us/tick\n",
+           sizeof(int) * (size_t)total, ns[1], ns[1] * MAP_WINDOW * (1 + MAP_RING) / 1e3);
+    printf("reader       %8d bytes  %6.1f ns/lookup  %8.2f us/tick  (all tables, 1 sample per %d frames)\n",
+           dcmv_table_bytes(d), ns[0], ns[0] * MAP_WINDOW * (1 + MAP_RING) / 1e3, DCMV_TOTAL_SAMPLE);
+    printf("frame budget %.0f us at %.3f fps; tick = %d lookups; mapping %s\n",
+           1e6 / h->fps, h->fps, MAP_WINDOW * (1 + MAP_RING), bad ? "MISMATCH" : "identical");
+    bad += map_threaded(d, flat);
+
+    free(flat);
+    dcmv_close(d);
+    return bad ? 1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Sector-granular I/O
+// ---------------------------------------------------------------------------
+// The driver DMAs whole sectors at a sector-aligned file position straight
+// into a 32-byte aligned buffer (the reader's staging and the engine's packet
+// buffer both are), one command per call. Any other sector goes through its
+// cache: one command per miss, then a copy of the part that was asked for.
+#define SECTOR_CACHE 16           // cache blocks, LRU
+#define SECTOR_CHUNK (32 * 1024)  // engine packet reads (IL_READ_CHUNK)
+
+typedef struct {
+    uint32_t cached[SECTOR_CACHE];
+    uint32_t stamp[SECTOR_CACHE];
+    uint32_t clock;
+    uint64_t calls, commands, sectors, bytes, bounced;
+} sector_model_t;
+
+static int sector_cached(sector_model_t *m, uint32_t sector) {
+    int victim = 0;
+    for (int i = 0; i < SECTOR_CACHE; i++) {
+        if (m->stamp[i] && m->cached[i] == sector) {
+            m->stamp[i] = ++m->clock;
+            return 1;
+        }
+        if (m->stamp[i] < m->stamp[victim]) victim = i;
+    }
+    m->cached[victim] = sector;
+    m->stamp[victim] = ++m->clock;
+    return 0;
+}
+
+static void sector_read(void *arg, uint64_t offset, uint32_t size) {
+    sector_model_t *m = arg;
+    uint64_t end = offset + size;
+    m->calls++;
+    m->bytes += size;
+    for (uint64_t pos = offset; pos < end; ) {
+        uint32_t in = (uint32_t)(pos % DCMV_SECTOR_SIZE);
+        if (in == 0 && end - pos >= DCMV_SECTOR_SIZE) {
+            uint64_t n = (end - pos) / DCMV_SECTOR_SIZE;
+            m->commands++;
+            m->sectors += n;
+            pos += n * DCMV_SECTOR_SIZE;
+            continue;
+        }
+        uint32_t take = DCMV_SECTOR_SIZE - in;
+        if (take > end - pos) take = (uint32_t)(end - pos);
+        if (!sector_cached(m, (uint32_t)(pos / DCMV_SECTOR_SIZE))) {
+            m->commands++;
+            m->sectors++;
+        }
+        m->bounced += take;
+        pos += take;
+    }
+}
+
+// The engine's read of unique frame u: its packet, or the frame itself
+static int sector_read_frame(dcmv_t *d, int u, uint8_t *buf) {
+    if (!dcmv_packet_count(d)) {
+        const uint8_t *data;
+        uint32_t size;
+        return dcmv_read_frame(d, u, &data, &size);
+    }
+    dcmv_packet_t pk;
+    if (dcmv_packet_info(d, dcmv_find_packet(d, u), &pk) < 0) return -1;
+    for (uint32_t done = 0; done < pk.read_size; done += SECTOR_CHUNK) {
+        uint32_t n = pk.read_size - done < SECTOR_CHUNK ? pk.read_size - done : SECTOR_CHUNK;
+        if (dcmv_read_range(d, pk.offset + done, buf + done, n) < 0) return -1;
+    }
+    return 0;
+}
+
+static void sector_print(const char *name, const sector_model_t *m, const sector_model_t *base) {
+    printf("  %-6s %8llu calls %8llu commands %9llu sectors (%7.1f MB) for %7.1f MB, %6.1f MB copied",
+           name, (unsigned long long)m->calls, (unsigned long long)m->commands,
+           (unsigned long long)m->sectors, m->sectors * (double)DCMV_SECTOR_SIZE / 1048576.0,
+           m->bytes / 1048576.0, m->bounced / 1048576.0);
+    if (base && base->commands && base->sectors)
+        printf("  commands %+.1f%%, sectors %+.1f%%",
+               100.0 * ((double)m->commands - (double)base->commands) / base->commands,
+               100.0 * ((double)m->sectors - (double)base->sectors) / base->sectors);
+    printf("\n");
+}
+
+static int sector_report(const char **paths, int count, int seeks) {
+    sector_model_t base[2][2];    // first planar / interleaved file
+    int have_base[2] = { 0, 0 };
+    int failures = 0;
+    uint32_t seed = rng_state;
+    for (int f = 0; f < count; f++) {
+        dcmv_t *d = dcmv_open(paths[f], DCMV_BACKEND_FILE);
+        if (!d) return 1;
+        const dcmv_header_t *h = dcmv_header(d);
+        int n = h->num_unique_frames;
+        uint8_t *buf = memalign(32, dcmv_packet_count(d) ? dcmv_max_packet_size(d) : 32);
+        printf("%s: %s, %s\n", paths[f], dcmv_packet_count(d) ? "interleaved" : "planar",
+               (h->flags & DCMV_FLAG_SECTOR_ALIGNED) ? "sector aligned" : "unaligned");
+
+        // Playback front to back, then the same random seeks for every file
+        sector_model_t m[2];
+        memset(m, 0, sizeof(m));
+        dcmv_set_read_hook(d, sector_read, &m[0]);
+        if (dcmv_packet_count(d)) {
+            for (int k = 0; k < dcmv_packet_count(d); k++) {
+                dcmv_packet_t pk;
+                if (dcmv_packet_info(d, k, &pk) < 0 || sector_read_frame(d, pk.first_unique, buf) < 0) failures++;
+            }
+        } else {
+            for (int u = 0; u < n; ) {
+                int first, count;
+                dcmv_block_of(d, u, &first, &count);
+                if (sector_read_frame(d, u, buf) < 0) failures++;
+                u = first + count;
+            }
+        }
+        dcmv_set_read_hook(d, sector_read, &m[1]);
+        rng_state = seed;
+        for (int i = 0; i < seeks && n > 0; i++) {
+            if (sector_read_frame(d, (int)(rng_next() % (uint32_t)n), buf) < 0) failures++;
+        }
+        dcmv_set_read_hook(d, NULL, NULL);
+
+        // Savings against the first file with the same layout
+        int il = dcmv_packet_count(d) > 0;
+        sector_print("play", &m[0], have_base[il] ? &base[il][0] : NULL);
+        sector_print("seek", &m[1], have_base[il] ? &base[il][1] : NULL);
+        if (!have_base[il]) memcpy(base[il], m, sizeof(m));
+        have_base[il] = 1;
+        free(buf);
+        dcmv_close(d);
+    }
+    printf("model: %d-byte sectors, %d-block LRU cache, whole aligned sectors DMAed directly; %d seeks\n",
+           DCMV_SECTOR_SIZE, SECTOR_CACHE, seeks);
+    if (failures) printf("%d reads failed\n", failures);
+    return failures ? 1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Seek cache replay
+// ---------------------------------------------------------------------------
+#define REPLAY_TARGETS 4          // HINT_POOL_FRAMES / HINT_TARGET_FRAMES in the engine
+#define REPLAY_FRAMES  2          // HINT_TARGET_FRAMES
+#define REPLAY_SCENES  16         // synthetic game
+
+typedef struct {
+    int *seeks;                   // total frames
+    int count, cap;
+} replay_session_t;
+
+static void replay_add(replay_session_t *s, int frame) {
+    if (s->count == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 256;
+        s->seeks = realloc(s->seeks, sizeof(int) * (size_t)s->cap);
+    }
+    s->seeks[s->count++] = frame;
+}
+
+static int replay_load(const char *path, replay_session_t *s) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("seek-replay: cannot open %s\n", path);
+        return -1;
+    }
+    char line[256];
+    int frame;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "seek %d", &frame) == 1) replay_add(s, frame);
+    fclose(f);
+    return 0;
+}
+
+// Scenes that branch to one of three successors, 70/20/10
+static void replay_synthetic(replay_session_t *s, int total, int seeks) {
+    int start[REPLAY_SCENES], next[REPLAY_SCENES][3];
+    for (int i = 0; i < REPLAY_SCENES; i++) {
+        start[i] = (int)((int64_t)total * i / REPLAY_SCENES);
+        for (int k = 0; k < 3; k++) next[i][k] = (int)(rng_next() % REPLAY_SCENES);
+    }
+    int scene = 0;
+    for (int i = 0; i < seeks; i++) {
+        uint32_t r = rng_next() % 10;
+        scene = next[scene][r < 7 ? 0 : r < 9 ? 1 : 2];
+        replay_add(s, start[scene]);
+    }
+}
+
+static int seek_replay(const char **paths, int count, int seeks) {
+    dcmv_t *d = dcmv_open(paths[0], DCMV_BACKEND_FILE);
+    if (!d) return 1;
+    const dcmv_header_t *h = dcmv_header(d);
+    int sessions = count > 1 ? count - 1 : 1;
+    replay_session_t *ss = calloc((size_t)sessions, sizeof(replay_session_t));
+    int rc = 0;
+    for (int i = 1; i < count && rc == 0; i++) rc = replay_load(paths[i], &ss[i - 1]);
+    if (count == 1) replay_synthetic(&ss[0], h->num_total_frames, seeks);
+
+    // A fresh model per session, as the engine starts one per boot
+    uint32_t predicted = 0, unpredicted = 0, top1 = 0, total_seeks = 0;
+    for (int i = 0; i < sessions && rc == 0; i++) {
+        seek_model_t m;
+        seek_model_init(&m);
+        for (int k = 0; k < ss[i].count; k++) {
+            int best;
+            if (seek_model_predict(&m, &best, 1) == 1 && best == ss[i].seeks[k]) top1++;
+            seek_model_record(&m, ss[i].seeks[k], REPLAY_TARGETS);
+        }
+        predicted += m.predicted;
+        unpredicted += m.unpredicted;
+        total_seeks += (uint32_t)ss[i].count;
+    }
+
+    // What a miss pays before the first frame, on top of the drive seek
+    int timed = 0;
+    uint64_t *ns = malloc(sizeof(uint64_t) * 1024);
+    uint8_t *buf = memalign(32, h->video_frame_size);
+    for (int i = 0; i < sessions && rc == 0; i++) {
+        for (int k = 0; k < ss[i].count && timed < 1024; k++) {
+            int u = dcmv_total_to_unique(d, ss[i].seeks[k]);
+            if (u < 0) continue;
+            uint64_t t0 = now_ns();
+            for (int f = 0; f < REPLAY_FRAMES && u + f < h->num_unique_frames; f++)
+                if (dcmv_decode_into(d, u + f, buf) < 0) rc = -1;
+            ns[timed++] = now_ns() - t0;
+        }
+    }
+    qsort(ns, (size_t)timed, sizeof(uint64_t), cmp_u64);
+
+    if (rc == 0) {
+        uint32_t ranked = predicted + unpredicted;
+        printf("%s: %d session(s)%s, %u seeks, %u after the first of a session\n", paths[0], sessions,
+               count == 1 ? " (synthetic)" : "", total_seeks, ranked);
+        printf("learned targets: top %d %u (%.1f%%), top 1 %u (%.1f%%)\n", REPLAY_TARGETS, predicted,
+               ranked ? 100.0 * predicted / ranked : 0.0, top1, ranked ? 100.0 * top1 / ranked : 0.0);
+        if (timed)
+            printf("cold start: %d frames decoded in p50 %.3f ms, p99 %.3f ms per seek (%.1f ms frame budget)\n",
+                   REPLAY_FRAMES, percentile(ns, timed, 0.5) / 1e6, percentile(ns, timed, 0.99) / 1e6,
+                   1000.0 / h->fps);
+    } else {
+        printf("seek-replay failed\n");
+    }
+    for (int i = 0; i < sessions; i++) free(ss[i].seeks);
+    free(ss);
+    free(ns);
+    free(buf);
+    dcmv_close(d);
+    return rc ? 1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Frame cache replay
+// ---------------------------------------------------------------------------
+#define CACHE_WINDOW     16       // PRELOAD_WINDOW in the engine
+#define CACHE_OLD_SLOTS  24       // the modulo scheme's NUM_BUFFERS
+#define CACHE_LOAD_RATE  2.0      // frame decodes per displayed frame
+#define CACHE_SEEK_COST  6.0      // decodes' worth of time a drive seek costs
+#define CACHE_MAX_ITEMS  256
+
+typedef struct {
+    int seg_start[CACHE_MAX_ITEMS], seg_end[CACHE_MAX_ITEMS], segs;
+    int from[CACHE_MAX_ITEMS], to[CACHE_MAX_ITEMS], weight[CACHE_MAX_ITEMS], jumps;
+} cache_game_t;
+
+typedef struct {
+    uint32_t shown, hits, loads, seeks, evictions, stalls;
+} cache_result_t;
+
+static int cache_load_hints(const char *path, int total, cache_game_t *g) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("cache-bench: cannot open %s\n", path);
+        return -1;
+    }
+    char line[256];
+    int a, b, c;
+    memset(g, 0, sizeof(*g));
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "segment %d %d", &a, &b) == 2 && g->segs < CACHE_MAX_ITEMS && a < total) {
+            g->seg_start[g->segs] = a;
+            g->seg_end[g->segs++] = b < 0 || b >= total ? total - 1 : b;
+        } else if (sscanf(line, "jump %d %d %d", &a, &b, &c) == 3 && g->jumps < CACHE_MAX_ITEMS &&
+                   b >= 0 && b < total && a < total) {
+            g->from[g->jumps] = a;
+            g->to[g->jumps] = b;
+            g->weight[g->jumps++] = c > 0 ? c : 1;
+        }
+    }
+    fclose(f);
+    if (!g->jumps) {
+        printf("cache-bench: %s has no jumps inside the movie\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// A jump out of `from`, weighted by how often the script has it; -1 if none
+static int cache_pick_jump(const cache_game_t *g, int from) {
+    int sum = 0;
+    for (int j = 0; j < g->jumps; j++) sum += g->from[j] == from ? g->weight[j] : 0;
+    if (!sum) return -1;
+    int r = (int)(rng_next() % (uint32_t)sum);
+    for (int j = 0; j < g->jumps; j++) {
+        if (g->from[j] != from) continue;
+        if ((r -= g->weight[j]) < 0) return g->to[j];
+    }
+    return -1;
+}
+
+// Total frame played after `cur`. A jump out of a segment's last frame is
+// always taken, one tested for inside a segment half of the time; off the end
+// of every segment the game starts over.
+static int cache_next(const cache_game_t *g, int cur) {
+    int inside = 0;
+    for (int s = 0; s < g->segs; s++)
+        inside |= g->seg_start[s] <= cur && cur < g->seg_end[s];
+    int to = (!inside || rng_next() % 2) ? cache_pick_jump(g, cur) : -1;
+    if (to >= 0) return to;
+    if (inside) return cur + 1;
+    to = cache_pick_jump(g, -1);
+    return to >= 0 ? to : g->segs ? g->seg_start[0] : 0;
+}
+
+// slots > 0: the frame cache with that many slots; 0: slot u % CACHE_OLD_SLOTS,
+// freed once shown and all flushed on a jump, as the engine did before
+static void cache_play(dcmv_t *d, const cache_game_t *g, int frames, int slots, uint32_t seed,
+                       cache_result_t *r) {
+    frame_cache_t c;
+    frame_cache_init(&c, slots > 0 ? slots : CACHE_OLD_SLOTS);
+    int old_unique[CACHE_OLD_SLOTS];
+    for (int s = 0; s < CACHE_OLD_SLOTS; s++) old_unique[s] = -1;
+
+    memset(r, 0, sizeof(*r));
+    rng_state = seed;
+    int cur = cache_next(g, -1), last_shown = -1, last_load = -2;
+    double budget = 0;
+    for (int tick = 0; (int)r->shown < frames && tick < frames * 8; tick++) {
+        // Worker: the window ahead, nearest first
+        budget += CACHE_LOAD_RATE;
+        if (budget > CACHE_LOAD_RATE) budget = CACHE_LOAD_RATE;
+        for (int i = 0, path = cur; i < CACHE_WINDOW && budget > 0; i++, path++) {
+            int u = dcmv_total_to_unique(d, path);
+            if (u < 0) break;
+            int slot;
+            if (slots > 0) {
+                if ((slot = frame_cache_claim(&c, u)) < 0) continue;
+                frame_cache_done(&c, slot, 1);
+            } else {
+                slot = u % CACHE_OLD_SLOTS;
+                if (old_unique[slot] >= 0) continue;
+                old_unique[slot] = u;
+            }
+            r->loads++;
+            budget -= 1.0;
+            // Skipping over a few cached frames is read through, not seeked
+            if (u <= last_load || u > last_load + CACHE_WINDOW) {
+                r->seeks++;
+                budget -= CACHE_SEEK_COST;
+            }
+            last_load = u;
+        }
+
+        // Renderer: show the frame or wait for it
+        int u = dcmv_total_to_unique(d, cur);
+        int ready;
+        if (slots > 0) {
+            frame_cache_set_playhead(&c, u);
+            int slot = frame_cache_acquire(&c, u);
+            ready = slot >= 0;
+            if (ready && u != last_shown) frame_cache_show(&c, slot);
+        } else {
+            ready = old_unique[u % CACHE_OLD_SLOTS] == u;
+        }
+        if (!ready) {
+            r->stalls++;
+            continue;
+        }
+        if (u != last_shown) r->shown++;
+        last_shown = u;
+
+        int next = cache_next(g, cur);
+        if (slots == 0 && dcmv_total_to_unique(d, next) != u) {
+            old_unique[u % CACHE_OLD_SLOTS] = -1;
+            if (next != cur + 1)
+                for (int s = 0; s < CACHE_OLD_SLOTS; s++) old_unique[s] = -1;
+        }
+        cur = next;
+    }
+    if (slots > 0) {
+        r->hits = atomic_load(&c.hits);
+        r->evictions = atomic_load(&c.evictions);
+    }
+}
+
+static int cache_bench(const char **paths, int count, int frames) {
+    if (count < 2) {
+        printf("cache-bench: needs a movie and a .hints file\n");
+        return 1;
+    }
+    dcmv_t *d = dcmv_open(paths[0], DCMV_BACKEND_FILE);
+    if (!d) return 1;
+    cache_game_t *g = malloc(sizeof(cache_game_t));
+    if (cache_load_hints(paths[1], dcmv_header(d)->num_total_frames, g) < 0) {
+        free(g);
+        dcmv_close(d);
+        return 1;
+    }
+    uint32_t seed = rng_state;
+    printf("%s: %d segments, %d jumps from %s, %d frames shown, window %d, %.0f decodes/frame, "
+           "seek = %.0f decodes\n", paths[0], g->segs, g->jumps, paths[1], frames, CACHE_WINDOW,
+           CACHE_LOAD_RATE, CACHE_SEEK_COST);
+    printf("%-12s %8s %8s %8s %8s %8s %8s\n", "slots", "shown", "cached", "hit %", "loads", "evicted", "stalls");
+
+    static const int sizes[] = { 0, 24, 32, 48, 64 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        cache_result_t r;
+        cache_play(d, g, frames, sizes[i], seed, &r);
+        char name[32];
+        if (sizes[i]) snprintf(name, sizeof(name), "cache %d", sizes[i]);
+        else snprintf(name, sizeof(name), "modulo %d", CACHE_OLD_SLOTS);
+        printf("%-12s %8u %8u %8.1f %8u %8u %8u\n", name, r.shown, r.hits,
+               r.shown ? 100.0 * r.hits / r.shown : 0.0, r.loads, r.evictions, r.stalls);
+    }
+    free(g);
+    dcmv_close(d);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Read / decompress pipeline
+// ---------------------------------------------------------------------------
+#define PIPE_READ_MAX   (32 * 1024)   // READAHEAD_READ_MAX in the engine
+
+typedef struct {
+    double latency_ms, rate_kbs;      // per command, transfer
+    double decode_ms;                 // added per frame decoded, for a slower CPU
+    uint64_t device_ns;               // time the drive was busy
+} pipe_device_t;
+
+typedef struct {
+    dcmv_t *d;
+    const pipe_device_t *dev;
+    int frames;                       // unique frames to play
+    uint8_t *buf;
+    readahead_ring_t ring;            // the engine's read-ahead index over buf
+    int done, failed;
+    pthread_mutex_t lock;
+    pthread_cond_t more, room;        // reader -> decoder, decoder -> reader
+    uint32_t reads, wraps, reader_waits, decoder_waits;
+    uint64_t decode_ns;
+} pipe_state_t;
+
+static pthread_mutex_t pipe_io = PTHREAD_MUTEX_INITIALIZER;
+static void pipe_lock(void *arg)   { pthread_mutex_lock(arg); }
+static void pipe_unlock(void *arg) { pthread_mutex_unlock(arg); }
+
+static void pipe_sleep(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+    nanosleep(&ts, NULL);
+}
+
+// Read hook, called with the io lock held: the drive is busy for the command
+static void pipe_device(void *arg, uint64_t offset, uint32_t size) {
+    pipe_device_t *dev = arg;
+    (void)offset;
+    uint64_t ns = (uint64_t)(dev->latency_ms * 1e6 + size / (dev->rate_kbs * 1024.0) * 1e9);
+    pipe_sleep(ns);
+    dev->device_ns += ns;
+}
+
+static int pipe_decompress(dcmv_t *d, const pipe_device_t *dev, int u, int count, const uint8_t *src,
+                           uint32_t size, uint8_t **dst) {
+    if (dev->decode_ms > 0) pipe_sleep((uint64_t)(dev->decode_ms * 1e6 * count));
+    if (count == 1) return dcmv_decompress_frame(d, u, src, size, dst[0], 0);
+    return dcmv_decompress_block(d, src, size, (void *const *)dst, count);
+}
+
+// The ring's bookkeeping across a wrap, where the head is behind the oldest
+// block: a run that does not fit before it must get -1, not a huge offset.
+// Returns the number of wrong answers.
+static int pipe_wrap_case(void) {
+    static readahead_ring_t r;
+    int bad = 0;
+    readahead_ring_init(&r, 1000);
+    readahead_ring_push(&r, 0, 1, 0, 400);
+    readahead_ring_push(&r, 1, 1, 400, 400);
+    bad += readahead_ring_space(&r, 300) != -1;          // no room at either end
+    readahead_ring_pop(&r);
+    bad += readahead_ring_space(&r, 300) != 0;           // wraps to the start
+    readahead_ring_push(&r, 2, 1, 0, 300);
+    bad += readahead_ring_space(&r, 100) != 300;         // head behind the tail
+    bad += readahead_ring_space(&r, 101) != -1;
+    bad += readahead_ring_find(&r, 2) == NULL || readahead_ring_find(&r, 2)->pos != 0;
+    readahead_ring_pop(&r);
+    bad += readahead_ring_space(&r, 700) != 300;         // unwrapped again
+    bad += readahead_ring_space(&r, 701) != -1;
+    readahead_ring_pop(&r);
+    bad += r.head != 0 || readahead_ring_space(&r, 1000) != 0 || readahead_ring_space(&r, 1001) != -1;
+    printf("ring wrap-around case: %s\n", bad ? "FAILED" : "ok");
+    return bad;
+}
+
+static void *pipe_reader(void *arg) {
+    pipe_state_t *p = arg;
+    int next = 0;
+    while (next < p->frames) {
+        // Plan a run of contiguous blocks that fits, waiting for room
+        pthread_mutex_lock(&p->lock);
+        uint32_t start = 0, size = 0;
+        int n = 0, end = next;
+        for (;;) {
+            while (p->ring.count + n < READAHEAD_RING_MAX_BLOCKS && end < p->frames) {
+                uint32_t off, len;
+                int first, count;
+                dcmv_frame_range(p->d, end, &off, &len);
+                if (n == 0) start = off;
+                else if (off != start + size || size + len > PIPE_READ_MAX) break;
+                if (readahead_ring_space(&p->ring, size + len) < 0) break;
+                dcmv_block_of(p->d, end, &first, &count);
+                size += len;
+                end = first + count;
+                n++;
+            }
+            if (n > 0 || p->failed) break;
+            if (p->ring.count == 0) {         // nothing to wait for: the block is bigger than the ring
+                printf("pipeline-bench: unique frame %d does not fit a %u KB ring\n", end, p->ring.cap / 1024);
+                p->failed = 1;
+                break;
+            }
+            p->reader_waits++;
+            pthread_cond_wait(&p->room, &p->lock);
+        }
+        uint32_t pos = n ? (uint32_t)readahead_ring_space(&p->ring, size) : 0;
+        if (n && p->ring.count && pos < p->ring.head) p->wraps++;
+        pthread_mutex_unlock(&p->lock);
+        if (n == 0) break;
+
+        int res = dcmv_read_range(p->d, start, p->buf + pos, size);
+        pthread_mutex_lock(&p->lock);
+        p->reads++;
+        if (res < 0) p->failed = 1;
+        for (int u = next, k = 0; k < n && res >= 0; k++) {
+            int first, count;
+            uint32_t off, len;
+            dcmv_block_of(p->d, u, &first, &count);
+            dcmv_frame_range(p->d, u, &off, &len);
+            readahead_ring_push(&p->ring, first, count, pos + (off - start), len);
+            u = first + count;
+        }
+        pthread_cond_signal(&p->more);
+        pthread_mutex_unlock(&p->lock);
+        if (res < 0) break;
+        next = end;
+    }
+    pthread_mutex_lock(&p->lock);
+    p->done = 1;
+    pthread_cond_signal(&p->more);
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+// Decoder side: the calling thread. Returns frames decoded.
+static int pipe_decoder(pipe_state_t *p, uint8_t **dst) {
+    int decoded = 0;
+    for (;;) {
+        pthread_mutex_lock(&p->lock);
+        while (p->ring.count == 0 && !p->done) {
+            p->decoder_waits++;
+            pthread_cond_wait(&p->more, &p->lock);
+        }
+        if (p->ring.count == 0) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        readahead_block_t b = *readahead_ring_oldest(&p->ring);
+        pthread_mutex_unlock(&p->lock);
+
+        uint64_t t = now_ns();
+        if (pipe_decompress(p->d, p->dev, b.first, b.count, p->buf + b.pos, b.size, dst) < 0) p->failed = 1;
+        p->decode_ns += now_ns() - t;
+        decoded += b.count;
+
+        // Shown: its bytes go back to the reader
+        pthread_mutex_lock(&p->lock);
+        readahead_ring_pop(&p->ring);
+        pthread_cond_signal(&p->room);
+        pthread_mutex_unlock(&p->lock);
+    }
+    return decoded;
+}
+
+static void pipe_print(const char *name, int frames, double secs, double fps, const pipe_device_t *dev,
+                       uint64_t decode_ns, double base) {
+    printf("%-10s %8d frames %8.2f s %9.1f frames/s %5.1fx realtime  drive busy %5.1f%%  "
+           "decode busy %5.1f%%", name, frames, secs, frames / secs, frames / secs / fps,
+           100.0 * dev->device_ns / 1e9 / secs, 100.0 * decode_ns / 1e9 / secs);
+    if (base > 0) printf("  %.2fx faster", base / secs);
+    printf("\n");
+}
+
+static int pipeline_bench(const char *path, int frames, double latency_ms, double rate_kbs,
+                          double decode_ms, int ring_kb) {
+    pipe_device_t dev = { latency_ms, rate_kbs, decode_ms, 0 };
+    dcmv_t *d = dcmv_open(path, DCMV_BACKEND_FILE);
+    if (!d) return 1;
+    const dcmv_header_t *h = dcmv_header(d);
+    if (dcmv_has_deltas(d) || dcmv_packet_count(d)) {
+        printf("pipeline-bench: planar movies without delta frames only, as the engine's read-ahead\n");
+        dcmv_close(d);
+        return 1;
+    }
+    if (frames <= 0 || frames > h->num_unique_frames) frames = h->num_unique_frames;
+    dcmv_set_io_lock(d, pipe_lock, pipe_unlock, &pipe_io);
+    dcmv_set_read_hook(d, pipe_device, &dev);
+    uint8_t *dst[DCMV_MAX_PACKET_FRAMES];
+    for (int i = 0; i < DCMV_MAX_PACKET_FRAMES; i++) dst[i] = memalign(32, h->video_frame_size);
+    printf("%s: %d unique frames, drive %.1f ms per command + %.0f KB/s, +%.1f ms per frame decoded, "
+           "ring %d KB\n", path, frames, latency_ms, rate_kbs, decode_ms, ring_kb);
+
+    int failures = pipe_wrap_case();
+
+    // Serial: read a block, decompress it, next block
+    uint64_t decode_ns = 0, t0 = now_ns();
+    for (int u = 0; u < frames; ) {
+        int first, count;
+        const uint8_t *data;
+        uint32_t size;
+        dcmv_block_of(d, u, &first, &count);
+        if (dcmv_read_frame(d, u, &data, &size) < 0) { failures++; break; }
+        uint64_t t = now_ns();
+        if (pipe_decompress(d, &dev, u, count, data, size, dst) < 0) failures++;
+        decode_ns += now_ns() - t;
+        u = first + count;
+    }
+    double serial = (now_ns() - t0) / 1e9;
+    pipe_print("serial", frames, serial, h->fps, &dev, decode_ns, 0);
+
+    // Pipelined: reader thread -> compressed ring -> decoder
+    pipe_state_t *p = calloc(1, sizeof(pipe_state_t));
+    p->d = d;
+    p->dev = &dev;
+    p->frames = frames;
+    readahead_ring_init(&p->ring, (uint32_t)ring_kb * 1024u);
+    p->buf = memalign(32, p->ring.cap);
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->more, NULL);
+    pthread_cond_init(&p->room, NULL);
+    dev.device_ns = 0;
+    pthread_t reader;
+    t0 = now_ns();
+    pthread_create(&reader, NULL, pipe_reader, p);
+    int decoded = pipe_decoder(p, dst);
+    pthread_join(reader, NULL);
+    double piped = (now_ns() - t0) / 1e9;
+    pipe_print("pipelined", decoded, piped, h->fps, &dev, p->decode_ns, serial);
+    printf("           %u reads, %u wrapped to the start of the ring, reader waited for room %u times, "
+           "decoder waited for data %u times\n", p->reads, p->wraps, p->reader_waits, p->decoder_waits);
+    if (p->failed || decoded != frames) failures++;
+    if (failures) printf("pipeline-bench: read or decode failures\n");
+
+    pthread_cond_destroy(&p->room);
+    pthread_cond_destroy(&p->more);
+    pthread_mutex_destroy(&p->lock);
+    free(p->buf);
+    free(p);
+    for (int i = 0; i < DCMV_MAX_PACKET_FRAMES; i++) free(dst[i]);
+    dcmv_close(d);
+    return failures ? 1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Preload scheduling replay
+// ---------------------------------------------------------------------------
+#define SCHED_SLOTS      24       // DEFAULT_FRAME_SLOTS in the engine
+#define SCHED_WINDOW     16       // PRELOAD_WINDOW
+#define SCHED_TICK_MS    1.0
+#define SCHED_SEEK_MS    80.0     // a load that does not follow the last one
+#define SCHED_SPIKE_MS   150.0    // a drive retry, one read in SCHED_SPIKE_ODDS
+#define SCHED_SPIKE_ODDS 100
+
+typedef struct {
+    uint32_t shown, underruns, loads, late, dropped, stale;
+    double stall_ms, horizon_sum;
+    uint32_t horizon_samples;
+} sched_result_t;
+
+// Time the worker spends on unique frame u
+static double sched_cost(dcmv_t *d, const pipe_device_t *dev, int u, int last) {
+    uint32_t off, size;
+    dcmv_frame_range(d, u, &off, &size);
+    double ms = dev->latency_ms + size / (dev->rate_kbs * 1024.0) * 1000.0 + dev->decode_ms;
+    if (u != last + 1) ms += SCHED_SEEK_MS;
+    if (rng_next() % SCHED_SPIKE_ODDS == 0) ms += SCHED_SPIKE_MS;
+    return ms;
+}
+
+// Queue the window [from, from + frames) in frame order, as the old code did
+static void sched_window(dcmv_t *d, preload_queue_t *q, frame_cache_t *c, int from, int frames, int total, int gen) {
+    for (int t = from; t < from + frames && t < total; t++) {
+        int u = dcmv_total_to_unique(d, t);
+        if (frame_cache_find(c, u) < 0) preload_queue_push(q, t, u, gen);
+    }
+}
+
+// The engine's sched_plan
+static void sched_deadlines(dcmv_t *d, preload_queue_t *q, frame_cache_t *c, load_sched_t *s, int cur,
+                            int gen) {
+    int horizon = load_sched_horizon(s), unique = dcmv_header(d)->num_unique_frames;
+    for (int u = dcmv_total_to_unique(d, cur); u < unique; u++) {
+        int due = dcmv_unique_to_total(d, u);
+        if (due < cur) due = cur;
+        if (due - cur >= horizon) break;
+        if (frame_cache_find(c, u) < 0) preload_queue_push(q, due, u, gen);
+    }
+}
+
+static void sched_play(dcmv_t *d, const pipe_device_t *dev, int frames, int adaptive, uint32_t seed,
+                       sched_result_t *r) {
+    const dcmv_header_t *h = dcmv_header(d);
+    int total = h->num_total_frames;
+    double frame_ms = 1000.0 / h->fps;
+    frame_cache_t c;
+    preload_queue_t q;
+    load_sched_t s;
+    frame_cache_init(&c, SCHED_SLOTS);
+    preload_queue_init(&q, h->num_unique_frames);
+    load_sched_init(&s, (float)frame_ms, 2, SCHED_WINDOW);
+    memset(r, 0, sizeof(*r));
+    rng_state = seed;
+
+    int cur = 0, gen = 0, segment = 60 + (int)(rng_next() % 540);
+    int loading = -1, slot = -1, last = -2, underrun_frame = -1, jumped = 0;
+    double now = 0, due = frame_ms, busy_until = 0, started = 0;
+    if (adaptive) sched_deadlines(d, &q, &c, &s, cur, gen);
+    else sched_window(d, &q, &c, cur, SCHED_WINDOW, total, gen);
+
+    while ((int)r->shown < frames) {
+        now += SCHED_TICK_MS;
+        int playhead = dcmv_total_to_unique(d, cur);
+        frame_cache_set_playhead(&c, playhead);
+
+        // Worker: finish the load in progress, plan, start the next one
+        if (loading >= 0 && now >= busy_until) {
+            frame_cache_done(&c, slot, 1);
+            load_sched_loaded(&s, (float)(now - started), playhead >= loading);
+            if (playhead >= loading) r->late++;
+            loading = -1;
+        }
+        if (loading < 0) {
+            if (adaptive) sched_deadlines(d, &q, &c, &s, cur, gen);
+            else sched_window(d, &q, &c, cur + 1, SCHED_WINDOW, total, gen);
+            preload_job_t job;
+            while (loading < 0 && preload_queue_pop(&q, &job)) {
+                if (job.generation != gen) { r->stale++; continue; }
+                if (adaptive && job.unique < playhead) { r->dropped++; continue; }
+                if ((slot = frame_cache_claim(&c, job.unique)) < 0) continue;
+                loading = job.unique;
+                started = now;
+                busy_until = now + sched_cost(d, dev, job.unique, last);
+                last = job.unique;
+                r->loads++;
+            }
+        }
+
+        // Renderer: show the frame when it is due, or wait for it
+        if (now < due) continue;
+        int ready = frame_cache_acquire(&c, playhead);
+        if (ready < 0) {
+            if (cur != underrun_frame) {
+                underrun_frame = cur;
+                r->underruns++;
+                if (adaptive) load_sched_underrun(&s, cur == jumped);
+            }
+            r->stall_ms += SCHED_TICK_MS;
+            due = now;
+            continue;
+        }
+        frame_cache_show(&c, ready);
+        r->shown++;
+        if (adaptive) load_sched_shown(&s);
+        r->horizon_sum += adaptive ? load_sched_horizon(&s) : SCHED_WINDOW;
+        r->horizon_samples++;
+        due += frame_ms;
+
+        // Next frame, or a jump at the end of the segment
+        if (--segment <= 0 || cur + 1 >= total) {
+            cur = jumped = (int)(rng_next() % (uint32_t)total);
+            segment = 60 + (int)(rng_next() % 540);
+            gen++;
+            frame_cache_set_playhead(&c, dcmv_total_to_unique(d, cur));
+            if (adaptive) sched_deadlines(d, &q, &c, &s, cur, gen);
+            else sched_window(d, &q, &c, cur, SCHED_WINDOW, total, gen);
+        } else {
+            cur++;
+            if (!adaptive) sched_window(d, &q, &c, cur, SCHED_WINDOW / 2, total, gen);   // fmv_tick's window
+        }
+    }
+    r->dropped += atomic_load(&s.dropped);
+    preload_queue_destroy(&q);
+}
+
+static int sched_bench(const char *path, int frames, double latency_ms, double rate_kbs, double decode_ms) {
+    pipe_device_t dev = { latency_ms, rate_kbs, decode_ms, 0 };
+    dcmv_t *d = dcmv_open(path, DCMV_BACKEND_FILE);
+    if (!d) return 1;
+    const dcmv_header_t *h = dcmv_header(d);
+    uint32_t seed = rng_state;
+    printf("%s: %d frames shown at %.2f fps, jumps every 60-600 frames, drive %.1f ms per command + "
+           "%.0f KB/s, seek %.0f ms, 1 in %d reads +%.0f ms, +%.1f ms per frame decoded, %d slots\n",
+           path, frames, h->fps, latency_ms, rate_kbs, SCHED_SEEK_MS, SCHED_SPIKE_ODDS, SCHED_SPIKE_MS,
+           decode_ms, SCHED_SLOTS);
+    printf("%-10s %8s %9s %9s %8s %8s %8s %8s\n", "scheduler", "shown", "underruns", "stall s",
+           "loads", "late", "dropped", "horizon");
+    for (int adaptive = 0; adaptive < 2; adaptive++) {
+        sched_result_t r;
+        sched_play(d, &dev, frames, adaptive, seed, &r);
+        printf("%-10s %8u %9u %9.2f %8u %8u %8u %8.1f\n", adaptive ? "deadline" : "fixed", r.shown,
+               r.underruns, r.stall_ms / 1000.0, r.loads, r.late, r.dropped,
+               r.horizon_samples ? r.horizon_sum / r.horizon_samples : 0.0);
+    }
+    dcmv_close(d);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Seek storm
+// ---------------------------------------------------------------------------
+#define STORM_OVERLAY_MS  (1000.0 / 60.0)  // one overlay frame per vblank
+#define STORM_SLEEP_MS    60.0             // thd_sleep(10) + thd_sleep(50) in the old seek
+#define STORM_STORM_MAX   6                // skips in one burst
+
+typedef struct {
+    uint32_t requested, overlay_missed, underruns, loads;
+    double freeze_ms;                      // longest the overlay went without a frame
+    seek_state_t seek;
+} storm_result_t;
+
+// Drive time to close and reopen the movie and audio fds at a new place
+static double storm_reopen_ms(const pipe_device_t *dev, int audio_fds) {
+    return (audio_fds + 1) * dev->latency_ms + SCHED_SEEK_MS;
+}
+
+// Where the script skips to next, and when. Mostly a jump after a scene; now
+// and then a hop back into frames just played, or a burst of skips a few
+// ticks apart (a menu mashed, or scripts chaining discSkipToFrame). Its own
+// generator, so both seeks see the same script.
+typedef struct {
+    uint32_t rng;
+    int storm;                             // skips left in the burst
+    double at;                             // when the next one comes
+    int target, back;                      // where to, or frames back from the play head
+} storm_script_t;
+
+static uint32_t storm_rand(storm_script_t *k) {
+    k->rng ^= k->rng << 13;
+    k->rng ^= k->rng >> 17;
+    k->rng ^= k->rng << 5;
+    return k->rng;
+}
+
+static void storm_next(storm_script_t *k, int total, double frame_ms) {
+    k->back = 0;
+    if (k->storm > 0) {
+        k->storm--;
+        k->at += storm_rand(k) % 100;
+        k->target = (int)(storm_rand(k) % (uint32_t)total);
+        return;
+    }
+    k->at += (30 + storm_rand(k) % 270) * frame_ms;
+    uint32_t kind = storm_rand(k) % 10;
+    if (kind < 2) {
+        k->back = 1 + (int)(storm_rand(k) % 60);
+    } else {
+        if (kind >= 7) k->storm = 1 + (int)(storm_rand(k) % (STORM_STORM_MAX - 1));
+        k->target = (int)(storm_rand(k) % (uint32_t)total);
+    }
+}
+
+static void storm_play(dcmv_t *d, const pipe_device_t *dev, int seeks, int async, uint32_t seed,
+                       storm_result_t *r) {
+    const dcmv_header_t *h = dcmv_header(d);
+    int total = h->num_total_frames;
+    int audio_fds = h->audio_channels == 2 ? 2 : 1;
+    double frame_ms = 1000.0 / h->fps;
+    frame_cache_t c;
+    preload_queue_t q;
+    load_sched_t s;
+    frame_cache_init(&c, SCHED_SLOTS);
+    preload_queue_init(&q, h->num_unique_frames);
+    load_sched_init(&s, (float)frame_ms, 2, SCHED_WINDOW);
+    memset(r, 0, sizeof(*r));
+    seek_state_init(&r->seek);
+    rng_state = seed;
+
+    int cur = 0, gen = 0, request = -1, target = -1, holding = 0, io = -1;
+    int loading = -1, slot = -1, last = -2, underrun_frame = -1;
+    double now = 0, due = frame_ms, busy_until = 0, started = 0, blocked_until = 0;
+    double overlay_due = STORM_OVERLAY_MS, overlay_last = 0;
+    storm_script_t script = { seed * 2654435761u | 1u, 0, 0, 0, 0 };
+    storm_next(&script, total, frame_ms);
+    sched_deadlines(d, &q, &c, &s, cur, gen);
+
+    while (r->seek.seeks < (uint32_t)seeks) {
+        now += SCHED_TICK_MS;
+        int playhead = dcmv_total_to_unique(d, cur);
+        frame_cache_set_playhead(&c, playhead);
+
+        // The script asks; the latest request wins, as with seek_request
+        if (now >= script.at) {
+            request = script.back ? (cur > script.back ? cur - script.back : 0) : script.target;
+            r->requested++;
+            storm_next(&script, total, frame_ms);
+        }
+
+        // Worker: finish the load or the seek I/O in progress, then take a
+        // seek, or plan and start the next load. The old seek paused it.
+        if (now >= busy_until) {
+            if (loading >= 0) {
+                frame_cache_done(&c, slot, 1);
+                load_sched_loaded(&s, (float)(now - started), playhead >= loading);
+                loading = -1;
+            }
+            if (io >= 0) {
+                seek_state_io_done(&r->seek, (uint64_t)(now * 1000.0));
+                io = -1;
+                last = -2;
+            }
+            if (async && (io = seek_state_take(&r->seek)) >= 0) {
+                busy_until = now + storm_reopen_ms(dev, audio_fds);
+            } else if (now >= blocked_until) {
+                sched_deadlines(d, &q, &c, &s, cur, gen);
+                preload_job_t job;
+                while (loading < 0 && preload_queue_pop(&q, &job)) {
+                    if (job.generation != gen || job.unique < playhead) continue;
+                    if ((slot = frame_cache_claim(&c, job.unique)) < 0) continue;
+                    loading = job.unique;
+                    started = now;
+                    busy_until = now + sched_cost(d, dev, job.unique, last);
+                    last = job.unique;
+                    r->loads++;
+                }
+            }
+        }
+
+        // Main thread: frozen inside the old seek, otherwise an overlay frame
+        // every vblank
+        if (now < blocked_until) continue;
+        if (now >= overlay_due) {
+            int vblanks = 0;
+            for (; overlay_due <= now; overlay_due += STORM_OVERLAY_MS) vblanks++;
+            r->overlay_missed += vblanks - 1;
+            if (now - overlay_last > r->freeze_ms) r->freeze_ms = now - overlay_last;
+            overlay_last = now;
+        }
+
+        // fmv_tick: take the request
+        if (request >= 0) {
+            target = cur = request;
+            request = -1;
+            seek_state_post(&r->seek, target, (uint64_t)(now * 1000.0));
+            holding = 1;
+            gen++;
+            playhead = dcmv_total_to_unique(d, cur);
+            frame_cache_set_playhead(&c, playhead);
+            sched_deadlines(d, &q, &c, &s, cur, gen);
+            if (!async) {
+                // Reopen on the main thread once the read in flight is done
+                seek_state_take(&r->seek);
+                blocked_until = (now > busy_until ? now : busy_until) + storm_reopen_ms(dev, audio_fds) +
+                                STORM_SLEEP_MS;
+                seek_state_io_done(&r->seek, (uint64_t)(blocked_until * 1000.0));
+                due = blocked_until;
+                last = -2;
+                continue;
+            }
+        }
+
+        // The last frame stays up and the clock holds until the seek lands.
+        // The old seek restarted the clock on return and counted on the frame.
+        if (holding && async) {
+            int ready = frame_cache_ready(&c, playhead) >= 0;
+            if (!seek_state_land(&r->seek, ready, (uint64_t)(now * 1000.0))) continue;
+            holding = 0;
+            due = now;
+        }
+        if (now < due) continue;
+        int buf = frame_cache_acquire(&c, playhead);
+        if (buf < 0) {
+            if (cur != underrun_frame && cur != target) {
+                r->underruns++;
+                load_sched_underrun(&s, 0);
+            }
+            underrun_frame = cur;
+            due = now;
+            continue;
+        }
+        frame_cache_show(&c, buf);
+        load_sched_shown(&s);
+        if (holding) {
+            seek_state_land(&r->seek, 1, (uint64_t)(now * 1000.0));
+            holding = 0;
+        }
+        target = -1;
+        due += frame_ms;
+        cur = cur + 1 < total ? cur + 1 : 0;
+    }
+    preload_queue_destroy(&q);
+}
+
+static int seek_storm(const char *path, int seeks, double latency_ms, double rate_kbs, double decode_ms) {
+    pipe_device_t dev = { latency_ms, rate_kbs, decode_ms, 0 };
+    dcmv_t *d = dcmv_open(path, DCMV_BACKEND_FILE);
+    if (!d) return 1;
+    const dcmv_header_t *h = dcmv_header(d);
+    uint32_t seed = rng_state;
+    printf("%s: %d seeks at %.2f fps, a skip every 30-300 frames, 2 in 10 back into the last 60, 3 in 10 "
+           "followed by up to %d more 0-100 ms apart; drive %.1f ms per command + %.0f KB/s, seek %.0f ms, "
+           "+%.1f ms per frame decoded, %d slots\n", path, seeks, h->fps, STORM_STORM_MAX - 1, latency_ms,
+           rate_kbs, SCHED_SEEK_MS, decode_ms, SCHED_SLOTS);
+    printf("%-9s %9s %8s %9s %9s %8s %14s %12s %9s\n", "seek", "requested", "replaced", "mean ms", "worst ms",
+           "bounded", "overlay missed", "longest gap", "underruns");
+    storm_result_t res[2];
+    for (int async = 0; async < 2; async++) {
+        storm_result_t *r = &res[async];
+        storm_play(d, &dev, seeks, async, seed, r);
+        printf("%-9s %9u %8u %9.1f %9.1f %8u %14u %9.1f ms %9u\n", async ? "async" : "blocking", r->requested,
+               r->seek.replaced, r->seek.total_us / 1000.0 / r->seek.seeks, r->seek.worst_us / 1000.0,
+               r->seek.bounded, r->overlay_missed, r->freeze_ms, r->underruns);
+    }
+    for (int async = 0; async < 2; async++) {
+        char hist[256];
+        seek_state_hist_str(&res[async].seek, hist, sizeof(hist));
+        printf("%-9s latency ms: %s\n", async ? "async" : "blocking", hist);
+    }
+    dcmv_close(d);
+    return 0;
+}
+
+static void usage(void) {
+    printf("usage: dcmv-bench [--mmap] [--mode seq|random|both] [--frames N] [--seed S] movie.dcmv\n"
+           "       dcmv-bench --codec-report [--block N] [--dict BYTES] [--level L] [--tmp DIR] movie.dcmv\n"
+           "       dcmv-bench --codebook-report movie.dcmv\n"
+           "       dcmv-bench --map-bench movie.dcmv\n"
+           "       dcmv-bench --sector-report [--frames N] [--seed S] movie.dcmv [aligned.dcmv ...]\n"
+           "       dcmv-bench --seek-replay [--frames N] [--seed S] movie.dcmv [trace ...]\n"
+           "       dcmv-bench --cache-bench [--frames N] [--seed S] movie.dcmv game.hints\n"
+           "       dcmv-bench --pipeline-bench [--frames N] [--latency MS] [--rate KB/s] [--decode-ms MS]\n"
+           "                                   [--ring KB] movie.dcmv\n"
+           "       dcmv-bench --sched-bench [--frames N] [--seed S] [--latency MS] [--rate KB/s] [--decode-ms MS]\n"
+           "                                movie.dcmv\n"
+           "       dcmv-bench --seek-storm [--frames N] [--seed S] [--latency MS] [--rate KB/s] [--decode-ms MS]\n"
+           "                               movie.dcmv\n");
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *paths[8];
+    int path_count = 0;
+    const char *mode = "both";
+    int backend = DCMV_BACKEND_FILE;
+    int frames = 0;
+    int report = 0, block = 4, level = 19;
+    uint32_t dict = 64 * 1024;
+    double latency_ms = 2.0, rate_kbs = 1800.0, decode_ms = 0.0;
+    int ring_kb = 512;
+    const char *tmpdir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--mmap")) backend = DCMV_BACKEND_MMAP;
+        else if (!strcmp(argv[i], "--codec-report")) report = 1;
+        else if (!strcmp(argv[i], "--codebook-report")) report = 2;
+        else if (!strcmp(argv[i], "--map-bench")) report = 3;
+        else if (!strcmp(argv[i], "--sector-report")) report = 4;
+        else if (!strcmp(argv[i], "--seek-replay")) report = 5;
+        else if (!strcmp(argv[i], "--cache-bench")) report = 6;
+        else if (!strcmp(argv[i], "--pipeline-bench")) report = 7;
+        else if (!strcmp(argv[i], "--sched-bench")) report = 8;
+        else if (!strcmp(argv[i], "--seek-storm")) report = 9;
+        else if (!strcmp(argv[i], "--latency") && i + 1 < argc) latency_ms = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--rate") && i + 1 < argc) rate_kbs = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--decode-ms") && i + 1 < argc) decode_ms = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--ring") && i + 1 < argc) ring_kb = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--block") && i + 1 < argc) block = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--dict") && i + 1 < argc) dict = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--level") && i + 1 < argc) level = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--tmp") && i + 1 < argc) tmpdir = argv[++i];
+        else if (!strcmp(argv[i], "--mode") && i + 1 < argc) mode = argv[++i];
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) rng_state = (uint32_t)strtoul(argv[++i], NULL, 0) | 1u;
+        else if (argv[i][0] == '-') { usage(); return 1; }
+        else if (path_count < 8) path = paths[path_count++] = argv[i];
+    }
+    if (!path) { usage(); return 1; }
+    if (report == 1) return codec_report(path, block, dict, level, tmpdir);
+    if (report == 2) return codebook_report(path);
+    if (report == 3) return map_bench(path);
+    if (report == 4) return sector_report(paths, path_count, frames > 0 ? frames : 1000);
+    if (report == 5) return seek_replay(paths, path_count, frames > 0 ? frames : 1000);
+    if (report == 6) return cache_bench(paths, path_count, frames > 0 ? frames : 20000);
+    if (report == 7) {
+        if (latency_ms < 0 || rate_kbs <= 0 || decode_ms < 0 || ring_kb < 64) {
+            printf("pipeline-bench: --latency >= 0, --rate > 0, --decode-ms >= 0, --ring >= 64\n");
+            return 1;
+        }
+        return pipeline_bench(path, frames, latency_ms, rate_kbs, decode_ms, ring_kb);
+    }
+    if (report == 8)
+        return sched_bench(path, frames > 0 ? frames : 20000, latency_ms, rate_kbs, decode_ms);
+    if (report == 9)
+        return seek_storm(path, frames > 0 ? frames : 500, latency_ms, rate_kbs, decode_ms);
+
+    uint64_t t_open = now_ns();
+    dcmv_t *d = dcmv_open(path, backend);
+    if (!d) return 1;
+    t_open = now_ns() - t_open;
+    const dcmv_header_t *h = dcmv_header(d);
+
+    printf("%s: v%u %dx%d %s, %.3f fps, %d unique / %d total frames, %s, frame %d bytes, backend %s\n",
+           path, h->version, h->width, h->height, h->frame_type == 1 ? "YUV422" : "RGB565",
+           h->fps, h->num_unique_frames, h->num_total_frames,
+           h->compression == DCMV_COMPRESSION_ZSTD ? "zstd" : "lz4", h->video_frame_size,
+           backend == DCMV_BACKEND_MMAP ? "mmap" : "read");
+    printf("tables: %s, %d bytes resident, open %.3f ms\n",
+           (h->flags & DCMV_FLAG_PAGED_TABLES) ? "paged" : "inline", dcmv_table_bytes(d), t_open / 1e6);
+
+    if (frames <= 0) frames = h->num_unique_frames;
+    int frame_size = h->video_frame_size;
+    for (int r = 1; r < dcmv_rendition_count(d); r++) {
+        dcmv_rendition_t info;
+        dcmv_rendition_info(d, r, &info);
+        if (info.video_frame_size > frame_size) frame_size = info.video_frame_size;
+    }
+    uint8_t *dst[DCMV_MAX_PACKET_FRAMES];
+    for (int i = 0; i < DCMV_MAX_PACKET_FRAMES; i++) dst[i] = memalign(32, frame_size);
+
+    // Every rendition, so their headroom can be compared
+    int rc = 0;
+    for (int r = 0; r < dcmv_rendition_count(d); r++) {
+        if (r > 0) {
+            dcmv_rendition_t info;
+            dcmv_rendition_info(d, r, &info);
+            printf("rendition %d: %dx%d, frame %d bytes, %.1f MB compressed\n", r, info.width, info.height,
+                   info.video_frame_size, info.bytes / 1048576.0);
+        }
+        if (!strcmp(mode, "seq") || !strcmp(mode, "both"))
+            rc |= run_pass(d, r, "seq", 0, frames, dst);
+        if (!strcmp(mode, "random") || !strcmp(mode, "both"))
+            rc |= run_pass(d, r, "random", 1, frames, dst);
+    }
+    if (h->flags & DCMV_FLAG_PAGED_TABLES)
+        printf("table pages loaded: %u\n", dcmv_table_page_loads(d));
+
+    for (int i = 0; i < DCMV_MAX_PACKET_FRAMES; i++) free(dst[i]);
+    dcmv_close(d);
+    return rc ? 1 : 0;
+}
@@ -0,0 +1,283 @@
+// dcmv_relayout.c - reorder the frames of a .dcmv after recorded play sessions
+//
+// The player writes a read trace when singe.cfg has read_trace=/pc/file: the
+// unique frames the worker loaded, in order. Every time the reads leave the
+// sequential path (a jump in the script, a seek) the file is cut before the
+// target and after the source; the pieces in between are then ordered so that
+// the transitions the traces take most often run straight on, greedily
+// joining chains of pieces by the heaviest edge first (Pettis-Hansen). The
+// frames keep their numbers; only their place in the file changes (ORDR).
+//
+// Pieces start on block boundaries, so copied payloads are never split; a
+// forward skip of up to --gap blocks still counts as sequential, as the
+// drive reads past it faster than it seeks. Sources with delta frames,
+// codebook runs or a dictionary are re-encoded with the same features.
+//
+//   dcmv-relayout [--gap N] [--level L] [--delta N] [--dict BYTES] [--verify]
+//                 in.dcmv out.dcmv trace...
+
+#include "dcmv_transcode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int *frames;             // unique frames in read order
+    int count, cap;
+    int seeks;
+} trace_t;
+
+typedef struct {
+    int from, to, weight;    // pieces
+} edge_t;
+
+static void usage(void) {
+    printf("usage: dcmv-relayout [--gap N] [--level L] [--delta N] [--dict BYTES] [--verify]\n"
+           "                     in.dcmv out.dcmv trace...\n");
+}
+
+// "# dcmv-trace 1 movie", then one unique frame or "seek <total frame>" per line
+static int load_trace(const char *path, int num_unique, trace_t *t) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("relayout: cannot open %s\n", path);
+        return -1;
+    }
+    char line[256];
+    int bad = 0;
+    while (fgets(line, sizeof(line), f)) {
+        int v;
+        if (line[0] == '#' || line[0] == '\n') continue;
+        if (!strncmp(line, "seek ", 5)) {
+            t->seeks++;
+            continue;
+        }
+        if (sscanf(line, "%d", &v) != 1 || v < 0 || v >= num_unique) {
+            bad++;
+            continue;
+        }
+        if (t->count == t->cap) {
+            t->cap = t->cap ? t->cap * 2 : 4096;
+            t->frames = realloc(t->frames, sizeof(int) * (size_t)t->cap);
+        }
+        t->frames[t->count++] = v;
+    }
+    fclose(f);
+    if (bad) printf("relayout: %s: %d lines skipped (not frames of this movie)\n", path, bad);
+    return 0;
+}
+
+static int cmp_edge(const void *a, const void *b) {
+    const edge_t *x = a, *y = b;
+    if (x->from != y->from) return x->from < y->from ? -1 : 1;
+    return x->to < y->to ? -1 : x->to > y->to;
+}
+
+static int cmp_weight(const void *a, const void *b) {
+    const edge_t *x = a, *y = b;
+    if (x->weight != y->weight) return x->weight > y->weight ? -1 : 1;
+    return cmp_edge(a, b);
+}
+
+// Block reads the traces cause on d, and how many of them do not start where
+// the previous one ended (within a sector)
+static void replay(dcmv_t *d, const trace_t *traces, int trace_count,
+                   long *reads, long *jumps, double *distance) {
+    *reads = *jumps = 0;
+    *distance = 0;
+    for (int t = 0; t < trace_count; t++) {
+        int prev = -1;
+        uint32_t end = 0;
+        for (int i = 0; i < traces[t].count; i++) {
+            int first, count;
+            uint32_t off, size;
+            dcmv_block_of(d, traces[t].frames[i], &first, &count);
+            if (first == prev || dcmv_frame_range(d, first, &off, &size) < 0) continue;
+            if (prev >= 0 && (off < end || off - end >= DCMV_SECTOR_SIZE)) {
+                (*jumps)++;
+                *distance += off < end ? (double)(end - off) : (double)(off - end);
+            }
+            (*reads)++;
+            prev = first;
+            end = off + size;
+        }
+    }
+}
+
+static void report(const char *name, dcmv_t *d, const trace_t *traces, int trace_count) {
+    long reads, jumps;
+    double distance;
+    replay(d, traces, trace_count, &reads, &jumps, &distance);
+    printf("%-8s %8ld reads, %6ld discontiguous (%.1f%%), %.1f MB seek distance\n", name, reads, jumps,
+           reads ? 100.0 * jumps / reads : 0.0, distance / (1024.0 * 1024.0));
+}
+
+int main(int argc, char **argv) {
+    const char *src = NULL, *dst = NULL;
+    const char *trace_paths[64];
+    int trace_count = 0, gap = 2, do_verify = 0;
+    int level = -1, key_interval = -1;
+    long dict_size = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--gap") && i + 1 < argc) gap = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--level") && i + 1 < argc) level = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--delta") && i + 1 < argc) key_interval = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--dict") && i + 1 < argc) dict_size = strtol(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--verify")) do_verify = 1;
+        else if (argv[i][0] == '-') { usage(); return 1; }
+        else if (!src) src = argv[i];
+        else if (!dst) dst = argv[i];
+        else if (trace_count < 64) trace_paths[trace_count++] = argv[i];
+    }
+    if (!src || !dst || !trace_count || gap < 0) { usage(); return 1; }
+
+    dcmv_t *in = dcmv_open(src, DCMV_BACKEND_FILE);
+    if (!in) return 1;
+    const dcmv_header_t *h = dcmv_header(in);
+    if (h->flags & DCMV_FLAG_INTERLEAVED) {
+        printf("relayout: %s is interleaved; remux it with --interleave 0 first\n", src);
+        dcmv_close(in);
+        return 1;
+    }
+    int n = h->num_unique_frames;
+    int blocks = dcmv_block_count(in);
+
+    trace_t traces[64];
+    memset(traces, 0, sizeof(traces));
+    int rc = 0;
+    for (int t = 0; t < trace_count && rc == 0; t++) rc = load_trace(trace_paths[t], n, &traces[t]);
+
+    // Source block of every frame, and the frame each block starts with
+    int *block_of = malloc(sizeof(int) * (size_t)n);
+    int *block_first = malloc(sizeof(int) * ((size_t)blocks + 1));
+    for (int u = 0; u < n; ) {
+        int first, count;
+        int b = dcmv_block_of(in, u, &first, &count);
+        block_first[b] = first;
+        for (int k = 0; k < count; k++) block_of[u + k] = b;
+        u = first + count;
+    }
+    block_first[blocks] = n;
+
+    // Cut before every jump target and after every jump source
+    uint8_t *cut = calloc((size_t)blocks + 1, 1);
+    cut[0] = 1;
+    long transitions = 0, jumps = 0, seeks = 0;
+    for (int t = 0; t < trace_count; t++) {
+        seeks += traces[t].seeks;
+        for (int i = 1; i < traces[t].count; i++) {
+            int a = block_of[traces[t].frames[i - 1]], b = block_of[traces[t].frames[i]];
+            if (a == b) continue;
+            transitions++;
+            if (b > a && b - a <= gap + 1) continue;
+            jumps++;
+            cut[b] = 1;
+            cut[a + 1] = 1;
+        }
+    }
+    int *piece_of = malloc(sizeof(int) * (size_t)blocks);
+    int *piece_start = malloc(sizeof(int) * ((size_t)blocks + 1));
+    int pieces = 0;
+    for (int b = 0; b < blocks; b++) {
+        if (cut[b]) piece_start[pieces++] = b;
+        piece_of[b] = pieces - 1;
+    }
+
+    // Transitions between pieces, summed per ordered pair
+    edge_t *edges = malloc(sizeof(edge_t) * (size_t)(transitions + 1));
+    int edge_count = 0;
+    for (int t = 0; t < trace_count; t++) {
+        for (int i = 1; i < traces[t].count; i++) {
+            int a = piece_of[block_of[traces[t].frames[i - 1]]];
+            int b = piece_of[block_of[traces[t].frames[i]]];
+            if (a != b) edges[edge_count++] = (edge_t){ a, b, 1 };
+        }
+    }
+    qsort(edges, (size_t)edge_count, sizeof(edge_t), cmp_edge);
+    int merged = 0;
+    for (int i = 0; i < edge_count; i++) {
+        if (merged && edges[merged - 1].from == edges[i].from && edges[merged - 1].to == edges[i].to)
+            edges[merged - 1].weight++;
+        else
+            edges[merged++] = edges[i];
+    }
+    edge_count = merged;
+    qsort(edges, (size_t)edge_count, sizeof(edge_t), cmp_weight);
+
+    // Join chains where the tail of one is followed by the head of another,
+    // heaviest transitions first
+    int *next = malloc(sizeof(int) * (size_t)pieces);
+    int *head = malloc(sizeof(int) * (size_t)pieces);   // chain head of every piece
+    int *tail = malloc(sizeof(int) * (size_t)pieces);   // valid for heads
+    for (int p = 0; p < pieces; p++) {
+        next[p] = -1;
+        head[p] = tail[p] = p;
+    }
+    for (int i = 0; i < edge_count; i++) {
+        int a = edges[i].from, b = edges[i].to;
+        int ha = head[a], hb = head[b];
+        if (ha == hb || tail[ha] != a || hb != b) continue;
+        next[a] = b;
+        tail[ha] = tail[hb];
+        for (int p = b; p >= 0; p = next[p]) head[p] = ha;
+    }
+
+    // Chains in the order of their lowest piece, so the one holding frame 0 leads
+    int *layout = malloc(sizeof(int) * (size_t)pieces);
+    uint8_t *placed = calloc((size_t)pieces, 1);
+    int runs = 0, prev = -2;
+    for (int p = 0; p < pieces; p++) {
+        if (placed[head[p]]) continue;
+        placed[head[p]] = 1;
+        for (int q = head[p]; q >= 0; q = next[q]) {
+            if (q != prev + 1) layout[runs++] = block_first[piece_start[q]];
+            prev = q;
+        }
+    }
+    printf("relayout: %d traces, %ld transitions, %ld jumps, %ld seeks -> %d pieces, %d runs\n",
+           trace_count, transitions, jumps, seeks, pieces, runs);
+
+    // Same features as the source; only the frame order changes
+    dcmv_transcode_opts_t o;
+    dcmv_transcode_defaults(&o);
+    o.interleave = 0;
+    o.sector_align = (h->flags & DCMV_FLAG_SECTOR_ALIGNED) != 0;
+    if (h->flags & DCMV_FLAG_PAGED_TABLES) o.page_frames = DCMV_PAGE_FRAMES;
+    if (dcmv_max_block_frames(in) > 1) o.block_frames = dcmv_max_block_frames(in);
+    if (dcmv_codebook_runs(in)) o.codebooks = 1;
+    if (dcmv_has_deltas(in)) o.key_interval = 30;
+    if (dcmv_has_dictionary(in)) o.dict_size = 64 * 1024;
+    if (key_interval >= 0) o.key_interval = key_interval;
+    if (dict_size >= 0) o.dict_size = (uint32_t)dict_size;
+    if (level >= 0) { o.level = level; o.recompress = 1; }
+    o.layout = layout;
+    o.layout_runs = runs;
+
+    if (rc == 0) rc = dcmv_transcode(src, dst, &o);
+    if (rc == 0) {
+        dcmv_t *out = dcmv_open(dst, DCMV_BACKEND_FILE);
+        if (out) {
+            report("before:", in, traces, trace_count);
+            report("after:", out, traces, trace_count);
+            dcmv_close(out);
+        }
+    }
+    if (rc == 0 && do_verify) rc = dcmv_verify(src, dst);
+
+    for (int t = 0; t < trace_count; t++) free(traces[t].frames);
+    free(block_of);
+    free(block_first);
+    free(cut);
+    free(piece_of);
+    free(piece_start);
+    free(edges);
+    free(next);
+    free(head);
+    free(tail);
+    free(layout);
+    free(placed);
+    dcmv_close(in);
+    return rc < 0 ? 1 : 0;
+}
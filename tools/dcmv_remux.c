@@ -0,0 +1,84 @@
+// dcmv_remux.c - rewrite a .dcmv into another layout or codec setup
+//
+// By default compressed frames are copied as-is and only their placement
+// changes: each packet carries --interleave unique frames followed by the left
+// and right ADPCM for the time those frames cover, so playback reads the file
+// front to back instead of bouncing between the video area and two audio
+// regions. --interleave 0 keeps the planar v2 audio layout.
+//
+// --block N re-encodes N consecutive frames as one Zstd frame, --dict BYTES
+// trains a Zstd dictionary on the movie and embeds it; both imply --level.
+//
+// --delta N stores frames as the 32-byte spans that changed since the previous
+// frame, with a key frame at least every N frames; the player then uploads
+// only those spans. --delta-gap G joins runs split by up to G unchanged spans.
+//
+// --codebooks stores each VQ codebook once per run of consecutive frames that
+// use the same one; the player then skips the codebook upload inside a run.
+//
+// --paged-tables N replaces the offset/duration tables after the header with
+// pages of N frames behind a small index, loaded as playback reaches them.
+//
+// --sector-align starts every frame (planar) or packet on a 2048-byte GD-ROM
+// sector, so the player's reads are whole sectors the driver can DMA directly.
+//
+// --add-rendition small.dcmv stores another encode of the same timeline (e.g.
+// 320x240) as a REND chunk; the player drops to it when it falls behind.
+// Repeatable; planar layout only. --verify also checks each added rendition.
+//
+//   dcmv-remux [--interleave N] [--audio-cap BYTES] [--block N] [--dict BYTES]
+//              [--level L] [--delta N] [--delta-gap G] [--codebooks]
+//              [--paged-tables N] [--sector-align] [--add-rendition movie.dcmv]
+//              [--verify] in.dcmv out.dcmv
+
+#include "dcmv_transcode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(void) {
+    printf("usage: dcmv-remux [--interleave N] [--audio-cap BYTES] [--block N] [--dict BYTES]\n"
+           "                  [--level L] [--delta N] [--delta-gap G] [--codebooks]\n"
+           "                  [--paged-tables N] [--sector-align] [--add-rendition movie.dcmv]\n"
+           "                  [--verify] in.dcmv out.dcmv\n");
+}
+
+int main(int argc, char **argv) {
+    const char *src = NULL, *dst = NULL;
+    dcmv_transcode_opts_t o;
+    dcmv_transcode_defaults(&o);
+    int do_verify = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--interleave") && i + 1 < argc) o.interleave = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--audio-cap") && i + 1 < argc) o.audio_cap = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--block") && i + 1 < argc) o.block_frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--dict") && i + 1 < argc) o.dict_size = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--level") && i + 1 < argc) { o.level = atoi(argv[++i]); o.recompress = 1; }
+        else if (!strcmp(argv[i], "--delta") && i + 1 < argc) o.key_interval = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--delta-gap") && i + 1 < argc) o.delta_gap = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--codebooks")) o.codebooks = 1;
+        else if (!strcmp(argv[i], "--paged-tables") && i + 1 < argc) o.page_frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--sector-align")) o.sector_align = 1;
+        else if (!strcmp(argv[i], "--add-rendition") && i + 1 < argc &&
+                 o.rendition_count < DCMV_MAX_RENDITIONS - 1) o.renditions[o.rendition_count++] = argv[++i];
+        else if (!strcmp(argv[i], "--verify")) do_verify = 1;
+        else if (argv[i][0] == '-') { usage(); return 1; }
+        else if (!src) src = argv[i];
+        else dst = argv[i];
+    }
+    if (!src || !dst) { usage(); return 1; }
+
+    if (dcmv_transcode(src, dst, &o) < 0) return 1;
+    if (do_verify && dcmv_verify(src, dst) < 0) return 1;
+    if (do_verify && o.rendition_count) {
+        // Added renditions come after the ones the source already had
+        dcmv_t *in = dcmv_open(src, DCMV_BACKEND_FILE);
+        int first = in ? dcmv_rendition_count(in) : 1;
+        dcmv_close(in);
+        for (int i = 0; i < o.rendition_count; i++)
+            if (dcmv_verify_rendition(o.renditions[i], dst, first + i) < 0) return 1;
+    }
+    return 0;
+}
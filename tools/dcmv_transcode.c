@@ -0,0 +1,796 @@
+// dcmv_transcode.c - .dcmv layout/codec rewriter (see dcmv_transcode.h)
+
+#define _GNU_SOURCE
+#include "dcmv_transcode.h"
+#include "dcmv.h"
+#include "dcmv_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd/zstd.h>
+#include <zdict.h>
+
+// Window for multi-frame blocks. The Dreamcast decoder keeps a window buffer
+// of this size while streaming a block into the frame slots.
+#define BLOCK_WINDOW_LOG 17
+
+// Dictionary training input: evenly spaced frames cut into small samples
+#define DICT_SAMPLE_SIZE   8192
+#define DICT_SAMPLE_BUDGET (8u * 1024 * 1024)
+
+typedef struct {
+    dcmv_t *in;
+    const dcmv_transcode_opts_t *o;
+    int frame_size;
+    ZSTD_CCtx *cctx;
+    uint8_t *raw;                 // block_frames decoded frames
+    uint8_t *out;
+    size_t out_cap;
+    uint8_t *dict;
+    size_t dict_len;
+    // Delta frames
+    uint8_t *prev;                // previous decoded frame
+    uint8_t *delta;
+    uint8_t *delta_bits;
+    int since_key;
+    int deltas;
+    // Codebook runs: first frame of each run
+    uint32_t *cb_runs;
+    int cb_count, cb_cap;
+    int next_unique;              // frames written out of order restart both chains
+} encoder_t;
+
+typedef struct {
+    uint32_t *words;              // 4 per packet + sentinel
+    int count, cap;
+    uint32_t max_size;
+} packet_index_t;
+
+void dcmv_transcode_defaults(dcmv_transcode_opts_t *o) {
+    memset(o, 0, sizeof(*o));
+    o->interleave = 8;
+    o->audio_cap = 16 * 1024;
+    o->level = 19;
+    o->block_frames = 1;
+    o->delta_gap = 4;
+}
+
+// ---------------------------------------------------------------------------
+// Frame encoding
+// ---------------------------------------------------------------------------
+static int train_dictionary(encoder_t *e) {
+    const dcmv_header_t *h = dcmv_header(e->in);
+    uint32_t budget = e->o->dict_size * 100u;
+    if (budget > DICT_SAMPLE_BUDGET) budget = DICT_SAMPLE_BUDGET;
+    int frames = (int)(budget / (uint32_t)h->video_frame_size);
+    if (frames < 1) frames = 1;
+    if (frames > h->num_unique_frames) frames = h->num_unique_frames;
+
+    size_t total = (size_t)frames * h->video_frame_size;
+    int pieces = (h->video_frame_size + DICT_SAMPLE_SIZE - 1) / DICT_SAMPLE_SIZE;
+    uint8_t *samples = malloc(total);
+    size_t *sizes = malloc(sizeof(size_t) * (size_t)frames * pieces);
+    int n = 0;
+
+    for (int i = 0; i < frames; i++) {
+        int u = (int)((long long)i * h->num_unique_frames / frames);
+        uint8_t *dst = samples + (size_t)i * h->video_frame_size;
+        if (dcmv_decode_into(e->in, u, dst) < 0) {
+            printf("dictionary: failed to decode frame %d\n", u);
+            free(samples);
+            free(sizes);
+            return -1;
+        }
+        for (int off = 0; off < h->video_frame_size; off += DICT_SAMPLE_SIZE)
+            sizes[n++] = (size_t)(h->video_frame_size - off < DICT_SAMPLE_SIZE ? h->video_frame_size - off : DICT_SAMPLE_SIZE);
+    }
+
+    e->dict = malloc(e->o->dict_size);
+    size_t r = ZDICT_trainFromBuffer(e->dict, e->o->dict_size, samples, sizes, (unsigned)n);
+    free(samples);
+    free(sizes);
+    if (ZDICT_isError(r)) {
+        printf("dictionary: training failed: %s\n", ZDICT_getErrorName(r));
+        return -1;
+    }
+    e->dict_len = r;
+    if (!e->o->quiet)
+        printf("dictionary: %zu bytes from %d frames (%d samples)\n", r, frames, n);
+    return 0;
+}
+
+static int encoder_init(encoder_t *e, dcmv_t *in, const dcmv_transcode_opts_t *o) {
+    memset(e, 0, sizeof(*e));
+    e->in = in;
+    e->o = o;
+    e->frame_size = dcmv_header(in)->video_frame_size;
+    e->next_unique = -1;
+    if (!o->recompress) return 0;
+
+    e->raw = malloc((size_t)e->frame_size * o->block_frames);
+    e->out_cap = ZSTD_compressBound((size_t)e->frame_size * o->block_frames) + DCMV_CODEBOOK_SIZE;
+    e->out = malloc(e->out_cap);
+    e->cctx = ZSTD_createCCtx();
+    if (!e->raw || !e->out || !e->cctx) return -1;
+
+    ZSTD_CCtx_setParameter(e->cctx, ZSTD_c_format, ZSTD_f_zstd1_magicless);
+    ZSTD_CCtx_setParameter(e->cctx, ZSTD_c_compressionLevel, o->level);
+    ZSTD_CCtx_setParameter(e->cctx, ZSTD_c_checksumFlag, 0);
+    ZSTD_CCtx_setParameter(e->cctx, ZSTD_c_dictIDFlag, 0);
+    if (o->block_frames > 1)
+        ZSTD_CCtx_setParameter(e->cctx, ZSTD_c_windowLog, BLOCK_WINDOW_LOG);
+
+    if (o->codebooks) {
+        e->prev = malloc(DCMV_CODEBOOK_SIZE);
+        if (!e->prev) return -1;
+    }
+
+    if (o->key_interval) {
+        int n = dcmv_header(in)->num_unique_frames;
+        e->prev = malloc((size_t)e->frame_size);
+        e->delta = malloc((size_t)e->frame_size);
+        e->delta_bits = calloc(1, 4 + ((size_t)n + 7) / 8);
+        if (!e->prev || !e->delta || !e->delta_bits) return -1;
+        memcpy(e->delta_bits, &n, 4);
+    }
+
+    if (o->dict_size) {
+        if (train_dictionary(e) < 0) return -1;
+        if (ZSTD_isError(ZSTD_CCtx_loadDictionary(e->cctx, e->dict, e->dict_len))) return -1;
+    }
+    return 0;
+}
+
+static void encoder_free(encoder_t *e) {
+    if (e->cctx) ZSTD_freeCCtx(e->cctx);
+    free(e->raw);
+    free(e->out);
+    free(e->dict);
+    free(e->prev);
+    free(e->delta);
+    free(e->delta_bits);
+    free(e->cb_runs);
+}
+
+// Index data of e->raw to compress; starts a new codebook run (and sets
+// *codebook) when the codebook differs from the previous frame's, or the
+// frame starts a run written out of order.
+static size_t codebook_frame(encoder_t *e, int u, const uint8_t **src, int *codebook) {
+    *codebook = u != e->next_unique || memcmp(e->prev, e->raw, DCMV_CODEBOOK_SIZE) != 0;
+    if (*codebook) {
+        if (e->cb_count + 2 > e->cb_cap) {
+            e->cb_cap = e->cb_cap ? e->cb_cap * 2 : 256;
+            e->cb_runs = realloc(e->cb_runs, sizeof(uint32_t) * (size_t)e->cb_cap);
+        }
+        e->cb_runs[e->cb_count++] = (uint32_t)u;
+        memcpy(e->prev, e->raw, DCMV_CODEBOOK_SIZE);
+    }
+    *src = e->raw + DCMV_CODEBOOK_SIZE;
+    return (size_t)e->frame_size - DCMV_CODEBOOK_SIZE;
+}
+
+// Delta against the previous frame when it is due and smaller than the frame
+// itself; returns the bytes to compress. The first frame of a run written out
+// of order is a key frame, so reading the run never reaches outside it.
+static size_t delta_frame(encoder_t *e, int u, const uint8_t **src) {
+    size_t n = (size_t)e->frame_size;
+    *src = e->raw;
+    if (u == e->next_unique && ++e->since_key < e->o->key_interval) {
+        uint32_t d = dcmv_delta_encode(e->prev, e->raw, e->frame_size, e->delta,
+                                       (uint32_t)e->frame_size, e->o->delta_gap);
+        if (d) {
+            e->delta_bits[4 + (u >> 3)] |= (uint8_t)(1u << (u & 7));
+            e->deltas++;
+            *src = e->delta;
+            n = d;
+        }
+    }
+    if (*src == e->raw) e->since_key = 0;
+    memcpy(e->prev, e->raw, (size_t)e->frame_size);
+    return n;
+}
+
+// Compressed payload for frames [first, first + count).
+static int encode_block(encoder_t *e, int first, int count, const uint8_t **data, uint32_t *size) {
+    if (!e->o->recompress)
+        return dcmv_read_frame(e->in, first, data, size);
+
+    for (int i = 0; i < count; i++) {
+        if (dcmv_decode_into(e->in, first + i, e->raw + (size_t)i * e->frame_size) < 0) {
+            printf("decode failed for frame %d\n", first + i);
+            return -1;
+        }
+    }
+    const uint8_t *src = e->raw;
+    size_t n = (size_t)count * e->frame_size;
+    int codebook = 0;
+    if (e->o->codebooks) n = codebook_frame(e, first, &src, &codebook);
+    else if (e->prev) n = delta_frame(e, first, &src);
+    e->next_unique = first + count;
+
+    size_t r = ZSTD_compress2(e->cctx, e->out, e->out_cap, src, n);
+    if (ZSTD_isError(r)) {
+        printf("compression failed: %s\n", ZSTD_getErrorName(r));
+        return -1;
+    }
+    if (codebook) {
+        // A run's first frame carries the codebook raw after its indices
+        memcpy(e->out + r, e->raw, DCMV_CODEBOOK_SIZE);
+        r += DCMV_CODEBOOK_SIZE;
+    }
+    *data = e->out;
+    *size = (uint32_t)r;
+    return 0;
+}
+
+// Span of the output block starting at `first`.
+static int next_block(encoder_t *e, int first) {
+    int n = dcmv_header(e->in)->num_unique_frames;
+    if (e->o->recompress)
+        return first + e->o->block_frames < n ? e->o->block_frames : n - first;
+    int f, count;
+    dcmv_block_of(e->in, first, &f, &count);
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// Layout
+// ---------------------------------------------------------------------------
+static int index_add(packet_index_t *ix, uint32_t offset, int first_unique, uint32_t audio_start,
+                     uint32_t video_bytes) {
+    if (ix->count + 2 > ix->cap) {
+        ix->cap = ix->cap ? ix->cap * 2 : 256;
+        ix->words = realloc(ix->words, sizeof(uint32_t) * 4 * (size_t)ix->cap);
+        if (!ix->words) return -1;
+    }
+    uint32_t *e = ix->words + ix->count * 4;
+    e[0] = offset;
+    e[1] = (uint32_t)first_unique;
+    e[2] = audio_start;
+    e[3] = video_bytes;
+    ix->count++;
+    return 0;
+}
+
+// Copy per-channel audio [pos, pos + size) of every channel to the output.
+static int copy_audio(dcmv_t *in, dcmv_writer_t *w, int channels, uint32_t pos, uint32_t size,
+                      uint8_t *tmp, uint32_t tmp_size) {
+    for (int ch = 0; ch < channels; ch++) {
+        for (uint32_t done = 0; done < size; ) {
+            uint32_t n = size - done < tmp_size ? size - done : tmp_size;
+            if (dcmv_read_audio(in, ch, pos + done, tmp, n) != (long)n) {
+                printf("audio read failed (ch %d, pos %u, %u bytes)\n", ch, pos + done, n);
+                return -1;
+            }
+            if (dcmv_writer_write(w, tmp, n) < 0) return -1;
+            done += n;
+        }
+    }
+    return 0;
+}
+
+static int write_blocks(encoder_t *e, dcmv_writer_t *w, int u0, int u1) {
+    // Aligned planar files start every block on a sector; packets are aligned
+    // as a whole by write_interleaved
+    int align = e->o->sector_align && !e->o->interleave;
+    for (int u = u0; u < u1; ) {
+        int count = next_block(e, u);
+        if (e->o->recompress && u + count > u1) count = u1 - u;   // blocks stay inside a run
+        const uint8_t *data;
+        uint32_t size;
+        if (encode_block(e, u, count, &data, &size) < 0) return -1;
+        if (align && dcmv_writer_align(w) < 0) return -1;
+        if (dcmv_writer_block(w, u, count, data, size) < 0) return -1;
+        u += count;
+    }
+    return 0;
+}
+
+static int write_interleaved(encoder_t *e, dcmv_writer_t *w, const uint32_t *apos, uint8_t *tmp) {
+    dcmv_t *in = e->in;
+    const dcmv_header_t *h = dcmv_header(in);
+    const dcmv_transcode_opts_t *o = e->o;
+    int n = h->num_unique_frames;
+    int channels = h->audio_channels == 2 ? 2 : 1;
+    packet_index_t ix = { 0 };
+    int rc = 0;
+
+    for (int u0 = 0; u0 < n && rc == 0; ) {
+        // Whole blocks only, at least one, up to `interleave` frames
+        int u1 = u0 + next_block(e, u0);
+        while (u1 < n && u1 - u0 + next_block(e, u1) <= o->interleave)
+            u1 += next_block(e, u1);
+        uint32_t a0 = apos[u0], a1 = apos[u1];
+
+        // Video packet: the frames plus the first audio_cap bytes of their audio
+        if (o->sector_align) rc = dcmv_writer_align(w);
+        uint32_t start = dcmv_writer_tell(w);
+        uint32_t take = a1 - a0 < o->audio_cap ? a1 - a0 : o->audio_cap;
+        if (rc == 0) rc = write_blocks(e, w, u0, u1);
+        if (rc == 0) rc = index_add(&ix, start, u0, a0, dcmv_writer_tell(w) - start);
+        if (rc == 0) rc = copy_audio(in, w, channels, a0, take, tmp, o->audio_cap);
+        if (dcmv_writer_tell(w) - start > ix.max_size) ix.max_size = dcmv_writer_tell(w) - start;
+
+        // Audio-only continuation packets; they index as the next video packet
+        for (uint32_t a = a0 + take; a < a1 && rc == 0; a += take) {
+            take = a1 - a < o->audio_cap ? a1 - a : o->audio_cap;
+            if (o->sector_align) rc = dcmv_writer_align(w);
+            start = dcmv_writer_tell(w);
+            if (rc == 0) rc = index_add(&ix, start, u1, a, 0);
+            if (rc == 0) rc = copy_audio(in, w, channels, a, take, tmp, o->audio_cap);
+            if (dcmv_writer_tell(w) - start > ix.max_size) ix.max_size = dcmv_writer_tell(w) - start;
+        }
+        u0 = u1;
+    }
+
+    if (rc == 0) {
+        // Sentinel, then the AVIL chunk. audio_offset points past the packets
+        // so v2-only readers see no planar audio.
+        if (o->sector_align) rc = dcmv_writer_align(w);
+        uint32_t end = dcmv_writer_tell(w);
+        rc = index_add(&ix, end, n, h->audio_channel_size, 0);
+        ix.count--;
+        dcmv_writer_set_audio_offset(w, end);
+
+        uint32_t bytes = 8 + (uint32_t)(ix.count + 1) * 16;
+        uint8_t *chunk = malloc(bytes);
+        memcpy(chunk, &ix.count, 4);
+        memcpy(chunk + 4, &ix.max_size, 4);
+        memcpy(chunk + 8, ix.words, bytes - 8);
+        if (rc == 0) rc = dcmv_writer_add_chunk(w, DCMV_CHUNK_AVIL, chunk, bytes);
+        free(chunk);
+        if (!o->quiet)
+            printf("packets: %d, max packet %u bytes, interleave %d, audio cap %u\n",
+                   ix.count, ix.max_size, o->interleave, o->audio_cap);
+    }
+    free(ix.words);
+    return rc;
+}
+
+static int write_planar(encoder_t *e, dcmv_writer_t *w, uint8_t *tmp) {
+    const dcmv_header_t *h = dcmv_header(e->in);
+    int channels = h->audio_channels == 2 ? 2 : 1;
+
+    if (!e->o->layout_runs && write_blocks(e, w, 0, h->num_unique_frames) < 0) return -1;
+    for (int r = 0; r < e->o->layout_runs; r++) {
+        // A run goes up to the next larger run start
+        int u0 = e->o->layout[r], u1 = h->num_unique_frames;
+        for (int k = 0; k < e->o->layout_runs; k++)
+            if (e->o->layout[k] > u0 && e->o->layout[k] < u1) u1 = e->o->layout[k];
+        if (write_blocks(e, w, u0, u1) < 0) return -1;
+    }
+    if (e->o->sector_align && dcmv_writer_align(w) < 0) return -1;
+    dcmv_writer_set_audio_offset(w, dcmv_writer_tell(w));
+    for (int ch = 0; ch < channels; ch++) {
+        for (uint32_t pos = 0; pos < h->audio_channel_size; ) {
+            uint32_t n = h->audio_channel_size - pos < e->o->audio_cap ? h->audio_channel_size - pos : e->o->audio_cap;
+            if (dcmv_read_audio(e->in, ch, pos, tmp, n) != (long)n) return -1;
+            if (dcmv_writer_write(w, tmp, n) < 0) return -1;
+            pos += n;
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Renditions
+// ---------------------------------------------------------------------------
+static void wr16(uint8_t *p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void wr32(uint8_t *p, uint32_t v) { wr16(p, v); wr16(p + 2, v >> 16); }
+
+// The movie must be frame-for-frame the primary's timeline
+static int same_timeline(dcmv_t *a, dcmv_t *b) {
+    const dcmv_header_t *ha = dcmv_header(a), *hb = dcmv_header(b);
+    if (ha->num_unique_frames != hb->num_unique_frames || ha->num_total_frames != hb->num_total_frames ||
+        ha->fps != hb->fps)
+        return 0;
+    for (int u = 0; u < ha->num_unique_frames; u++)
+        if (dcmv_frame_duration(a, u) != dcmv_frame_duration(b, u)) return 0;
+    return 1;
+}
+
+// One REND chunk from rendition r of src. Plain single-frame payloads are
+// copied; anything that needs the source's chunks to decode is re-encoded.
+static int write_rendition(dcmv_writer_t *w, dcmv_t *src, int r, const dcmv_transcode_opts_t *o) {
+    const dcmv_header_t *h = dcmv_header(src);
+    int n = h->num_unique_frames;
+    dcmv_rendition_t info;
+    dcmv_rendition_info(src, r, &info);
+    int copy = r > 0 || (dcmv_max_block_frames(src) == 1 && !dcmv_has_deltas(src) &&
+                         !dcmv_codebook_runs(src) && !dcmv_has_dictionary(src));
+
+    uint32_t *offsets = malloc(sizeof(uint32_t) * ((size_t)n + 1));
+    uint8_t *raw = copy ? NULL : memalign(32, (size_t)info.video_frame_size);
+    size_t cap = ZSTD_compressBound((size_t)info.video_frame_size);
+    uint8_t *out = copy ? NULL : malloc(cap);
+    ZSTD_CCtx *cctx = copy ? NULL : ZSTD_createCCtx();
+    int rc = offsets && (copy || (raw && out && cctx)) ? dcmv_writer_begin_chunk(w, DCMV_CHUNK_REND) : -1;
+    if (cctx) {
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_format, ZSTD_f_zstd1_magicless);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, o->level);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 0);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_dictIDFlag, 0);
+        info.compression = DCMV_COMPRESSION_ZSTD;
+    }
+
+    uint32_t max = 0;
+    for (int u = 0; u < n && rc == 0; u++) {
+        const uint8_t *data;
+        uint32_t size;
+        if (copy) {
+            rc = dcmv_read_rendition_frame(src, r, u, &data, &size);
+        } else {
+            rc = dcmv_decode_rendition(src, r, u, raw);
+            size_t c = rc == 0 ? ZSTD_compress2(cctx, out, cap, raw, (size_t)info.video_frame_size) : 0;
+            if (rc == 0 && ZSTD_isError(c)) rc = -1;
+            data = out;
+            size = (uint32_t)c;
+        }
+        if (rc < 0) {
+            printf("rendition: frame %d failed\n", u);
+            break;
+        }
+        offsets[u] = dcmv_writer_tell(w);
+        rc = dcmv_writer_write(w, data, size);
+        if (size > max) max = size;
+    }
+
+    if (rc == 0) {
+        offsets[n] = dcmv_writer_tell(w);
+        uint8_t desc[DCMV_REND_DESC_SIZE] = { 0 };
+        wr16(desc, (uint32_t)info.width);
+        wr16(desc + 2, (uint32_t)info.height);
+        wr16(desc + 4, (uint32_t)info.content_width);
+        wr16(desc + 6, (uint32_t)info.content_height);
+        desc[8] = (uint8_t)info.frame_type;
+        desc[9] = info.compression == DCMV_COMPRESSION_ZSTD ? 1 : 0;
+        wr32(desc + 12, (uint32_t)info.video_frame_size);
+        wr32(desc + 16, max);
+        rc = dcmv_writer_write(w, desc, sizeof(desc));
+        for (int u = 0; u <= n && rc == 0; u++) {
+            uint8_t e[4];
+            wr32(e, offsets[u]);
+            rc = dcmv_writer_write(w, e, 4);
+        }
+        dcmv_writer_end_chunk(w);
+        if (!o->quiet)
+            printf("rendition: %dx%d %s, %.1f MB (%s)\n", info.width, info.height,
+               info.compression == DCMV_COMPRESSION_ZSTD ? "zstd" : "lz4",
+               (offsets[n] - offsets[0]) / 1048576.0, copy ? "copied" : "re-encoded");
+    }
+    if (cctx) ZSTD_freeCCtx(cctx);
+    free(out);
+    free(raw);
+    free(offsets);
+    return rc;
+}
+
+// The source's own renditions, then the added movies
+static int write_renditions(dcmv_writer_t *w, dcmv_t *in, const dcmv_transcode_opts_t *o) {
+    int count = dcmv_rendition_count(in);
+    for (int r = 1; r < count; r++) {
+        if (write_rendition(w, in, r, o) < 0) return -1;
+    }
+    for (int i = 0; i < o->rendition_count; i++) {
+        dcmv_t *add = dcmv_open(o->renditions[i], DCMV_BACKEND_FILE);
+        if (!add) return -1;
+        int rc = -1;
+        if (!same_timeline(in, add))
+            printf("rendition: %s does not have the same frames and durations\n", o->renditions[i]);
+        else
+            rc = write_rendition(w, add, 0, o);
+        dcmv_close(add);
+        if (rc < 0) return -1;
+    }
+    return 0;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Every run start once, frame 0 among them; copied frames keep the source's
+// blocks, so runs must start on one
+static int check_layout(dcmv_t *in, const dcmv_transcode_opts_t *o) {
+    int n = dcmv_header(in)->num_unique_frames;
+    if (o->interleave) {
+        printf("transcode: a frame layout needs the planar layout (--interleave 0)\n");
+        return -1;
+    }
+    uint32_t *sorted = malloc(sizeof(uint32_t) * (size_t)o->layout_runs);
+    int rc = 0;
+    for (int r = 0; r < o->layout_runs; r++) {
+        int first, count;
+        if (o->layout[r] < 0 || o->layout[r] >= n) { rc = -1; break; }
+        dcmv_block_of(in, o->layout[r], &first, &count);
+        if (!o->recompress && first != o->layout[r]) {
+            printf("transcode: layout run at frame %d splits a block\n", o->layout[r]);
+            rc = -1;
+            break;
+        }
+        sorted[r] = (uint32_t)o->layout[r];
+    }
+    if (rc == 0) {
+        qsort(sorted, (size_t)o->layout_runs, sizeof(uint32_t), cmp_u32);
+        for (int r = 1; r < o->layout_runs; r++) if (sorted[r] == sorted[r - 1]) rc = -1;
+        if (sorted[0] != 0) rc = -1;
+        if (rc < 0) printf("transcode: layout runs must start at distinct frames, one at 0\n");
+    }
+    free(sorted);
+    return rc;
+}
+
+int dcmv_transcode(const char *src, const char *dst, const dcmv_transcode_opts_t *opts) {
+    dcmv_transcode_opts_t o = *opts;
+    if (o.block_frames > 1 || o.dict_size || o.key_interval || o.codebooks) o.recompress = 1;
+    if (o.key_interval && o.block_frames > 1) {
+        printf("transcode: delta frames cannot be combined with blocks\n");
+        return -1;
+    }
+    if (o.codebooks && (o.block_frames > 1 || o.key_interval)) {
+        printf("transcode: codebook runs cannot be combined with blocks or deltas\n");
+        return -1;
+    }
+    if (o.block_frames < 1 || o.block_frames > DCMV_MAX_PACKET_FRAMES || o.key_interval < 0 || o.delta_gap < 0 ||
+        o.page_frames < 0 || o.page_frames > 0xFFFF ||
+        o.interleave < 0 || o.interleave > DCMV_MAX_PACKET_FRAMES || o.audio_cap < 16) {
+        printf("transcode: bad options\n");
+        return -1;
+    }
+    o.audio_cap &= ~0xFu;   // keep packets on ADPCM block boundaries
+
+    dcmv_t *in = dcmv_open(src, DCMV_BACKEND_FILE);
+    if (!in) return -1;
+    const dcmv_header_t *h = dcmv_header(in);
+    int n = h->num_unique_frames;
+
+    int renditions = dcmv_rendition_count(in) + o.rendition_count;
+    if (renditions > 1 && o.interleave) {
+        printf("transcode: renditions need the planar layout (--interleave 0)\n");
+        dcmv_close(in);
+        return -1;
+    }
+    if (renditions > DCMV_MAX_RENDITIONS) {
+        printf("transcode: at most %d renditions\n", DCMV_MAX_RENDITIONS);
+        dcmv_close(in);
+        return -1;
+    }
+
+    // Payloads that need a chunk of the source to decode cannot be copied
+    if (dcmv_has_dictionary(in) || dcmv_has_deltas(in) || dcmv_codebook_runs(in)) o.recompress = 1;
+
+    if (o.layout_runs && check_layout(in, &o) < 0) {
+        dcmv_close(in);
+        return -1;
+    }
+
+    encoder_t enc;
+    if (encoder_init(&enc, in, &o) < 0) {
+        encoder_free(&enc);
+        dcmv_close(in);
+        return -1;
+    }
+
+    dcmv_header_t oh = *h;
+    if (oh.version >= DCMV_VERSION_EXT) oh.version = 2;   // bumped again if chunks are added
+    if (o.recompress) oh.compression = DCMV_COMPRESSION_ZSTD;
+    oh.flags = o.interleave ? DCMV_FLAG_INTERLEAVED : 0;
+    if (o.page_frames) oh.flags |= DCMV_FLAG_PAGED_TABLES;
+    if (o.sector_align) oh.flags |= DCMV_FLAG_SECTOR_ALIGNED;
+    dcmv_writer_t *w = dcmv_writer_create(dst, &oh);
+    if (!w) {
+        encoder_free(&enc);
+        dcmv_close(in);
+        return -1;
+    }
+    if (o.page_frames) dcmv_writer_set_page_frames(w, o.page_frames);
+
+    // Audio stream position at the start of every unique frame
+    uint32_t *apos = malloc(sizeof(uint32_t) * ((size_t)n + 1));
+    int total = 0;
+    for (int u = 0; u < n; u++) {
+        apos[u] = dcmv_audio_stream_pos(in, total);
+        total += dcmv_frame_duration(in, u);
+        dcmv_writer_set_duration(w, u, dcmv_frame_duration(in, u));
+    }
+    apos[0] = 0;
+    apos[n] = h->audio_channel_size;
+
+    uint8_t *tmp = malloc(o.audio_cap);
+    int rc = o.interleave ? write_interleaved(&enc, w, apos, tmp) : write_planar(&enc, w, tmp);
+    if (rc == 0 && enc.dict)
+        rc = dcmv_writer_add_chunk(w, DCMV_CHUNK_ZDIC, enc.dict, (uint32_t)enc.dict_len);
+    if (rc == 0 && renditions > 1)
+        rc = write_renditions(w, in, &o);
+    if (rc == 0 && enc.cb_runs) {
+        int runs = enc.cb_count;
+        qsort(enc.cb_runs, (size_t)runs, sizeof(uint32_t), cmp_u32);   // written in file order
+        enc.cb_runs[runs] = (uint32_t)n;
+        uint8_t *chunk = malloc(4 + ((size_t)runs + 1) * 4);
+        memcpy(chunk, &runs, 4);
+        memcpy(chunk + 4, enc.cb_runs, ((size_t)runs + 1) * 4);
+        rc = dcmv_writer_add_chunk(w, DCMV_CHUNK_CBTB, chunk, 4 + ((uint32_t)runs + 1) * 4);
+        free(chunk);
+        if (!o.quiet)
+            printf("codebooks: %d runs for %d frames (%.1f frames per codebook)\n",
+                   runs, n, (double)n / runs);
+    }
+    if (rc == 0 && enc.delta_bits) {
+        rc = dcmv_writer_add_chunk(w, DCMV_CHUNK_DLTA, enc.delta_bits, 4 + ((uint32_t)n + 7) / 8);
+        if (!o.quiet)
+            printf("deltas: %d of %d frames, key interval %d, merge gap %d\n",
+                   enc.deltas, n, o.key_interval, o.delta_gap);
+    }
+
+    if (dcmv_writer_finish(w) < 0) rc = -1;
+    free(apos);
+    free(tmp);
+    encoder_free(&enc);
+    dcmv_close(in);
+    return rc;
+}
+
+// ---------------------------------------------------------------------------
+// Verification
+// ---------------------------------------------------------------------------
+int dcmv_verify(const char *a_path, const char *b_path) {
+    dcmv_t *a = dcmv_open(a_path, DCMV_BACKEND_FILE);
+    dcmv_t *b = dcmv_open(b_path, DCMV_BACKEND_FILE);
+    if (!a || !b) { dcmv_close(a); dcmv_close(b); return -1; }
+    const dcmv_header_t *ha = dcmv_header(a), *hb = dcmv_header(b);
+    int bad = 0;
+
+    if (ha->num_unique_frames != hb->num_unique_frames || ha->num_total_frames != hb->num_total_frames ||
+        ha->video_frame_size != hb->video_frame_size || ha->audio_channel_size != hb->audio_channel_size) {
+        printf("verify: header mismatch\n");
+        dcmv_close(a); dcmv_close(b);
+        return -1;
+    }
+
+    // Sequential pass. b's frames also go through a simulated texture the way
+    // the player uploads them: only the runs of a delta frame that follows the
+    // one on screen, only the indices of a frame that keeps its codebook.
+    int fs = ha->video_frame_size;
+    uint8_t *fa = memalign(32, fs), *fb = memalign(32, fs), *vram = memalign(32, fs);
+    dcmv_span_t runs[DCMV_DELTA_MAX_RUNS];
+    uint64_t uploaded = 0;
+    for (int u = 0; u < ha->num_unique_frames; u++) {
+        int run_count = -1;
+        if (dcmv_frame_duration(a, u) != dcmv_frame_duration(b, u) ||
+            dcmv_decode_into(a, u, fa) < 0 ||
+            dcmv_decode_frame(b, u, fb, runs, DCMV_DELTA_MAX_RUNS, &run_count) < 0 ||
+            memcmp(fa, fb, fs) != 0) {
+            if (bad++ < 8) printf("verify: frame %d differs\n", u);
+            continue;
+        }
+        if (u > 0 && dcmv_codebook_run(b, u) >= 0 && dcmv_codebook_run(b, u) == dcmv_codebook_run(b, u - 1)) {
+            // Same codebook as the texture: indices only
+            memcpy(vram + DCMV_CODEBOOK_SIZE, fb + DCMV_CODEBOOK_SIZE, fs - DCMV_CODEBOOK_SIZE);
+            uploaded += (uint64_t)(fs - DCMV_CODEBOOK_SIZE);
+        } else if (run_count < 0 || u == 0) {
+            memcpy(vram, fb, fs);
+            uploaded += (uint64_t)fs;
+        }
+        for (int i = 0; i < run_count && u > 0; i++) {
+            int off = runs[i].first * DCMV_DELTA_SPAN;
+            int len = runs[i].count * DCMV_DELTA_SPAN;
+            if (off + len > fs) len = fs - off;
+            memcpy(vram + off, fb + off, (size_t)len);
+            uploaded += (uint64_t)len;
+        }
+        if (memcmp(vram, fa, fs) != 0) {
+            if (bad++ < 8) printf("verify: texture differs after frame %d\n", u);
+            memcpy(vram, fa, fs);
+        }
+    }
+
+    // Out-of-order access (seeks) must rebuild delta chains correctly
+    uint32_t seed = 12345;
+    for (int i = 0; i < 64 && ha->num_unique_frames > 0; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int u = (int)((seed >> 8) % (uint32_t)ha->num_unique_frames);
+        if (dcmv_decode_into(a, u, fa) < 0 || dcmv_decode_into(b, u, fb) < 0 || memcmp(fa, fb, fs) != 0) {
+            if (bad++ < 8) printf("verify: frame %d differs on random access\n", u);
+        }
+    }
+    if ((dcmv_has_deltas(b) || dcmv_codebook_runs(b)) && ha->num_unique_frames > 0)
+        printf("verify: texture uploads %.1f MB, %.1f%% of full frames\n", uploaded / 1048576.0,
+               100.0 * uploaded / ((double)fs * ha->num_unique_frames));
+
+    enum { STEP = 4096 };
+    uint8_t xa[STEP], xb[STEP];
+    int channels = ha->audio_channels == 2 ? 2 : 1;
+    for (int ch = 0; ch < channels; ch++) {
+        for (uint32_t pos = 0; pos < ha->audio_channel_size; pos += STEP) {
+            long ra = dcmv_read_audio(a, ch, pos, xa, STEP);
+            long rb = dcmv_read_audio(b, ch, pos, xb, STEP);
+            if (ra < 0 || ra != rb || memcmp(xa, xb, (size_t)ra) != 0) {
+                if (bad++ < 8) printf("verify: audio ch %d differs at %u\n", ch, pos);
+            }
+        }
+    }
+
+    // Renditions carried over from a
+    for (int r = 1; r < dcmv_rendition_count(a); r++) {
+        dcmv_rendition_t ra, rb;
+        dcmv_rendition_info(a, r, &ra);
+        if (dcmv_rendition_info(b, r, &rb) < 0 || ra.video_frame_size != rb.video_frame_size) {
+            if (bad++ < 8) printf("verify: rendition %d missing\n", r);
+            continue;
+        }
+        uint8_t *ra_buf = memalign(32, ra.video_frame_size), *rb_buf = memalign(32, ra.video_frame_size);
+        for (int u = 0; u < ha->num_unique_frames; u++) {
+            if (dcmv_decode_rendition(a, r, u, ra_buf) < 0 || dcmv_decode_rendition(b, r, u, rb_buf) < 0 ||
+                memcmp(ra_buf, rb_buf, ra.video_frame_size) != 0) {
+                if (bad++ < 8) printf("verify: rendition %d frame %d differs\n", r, u);
+            }
+        }
+        free(ra_buf);
+        free(rb_buf);
+    }
+
+    // Every packet must describe its own bytes exactly
+    for (int k = 0; k < dcmv_packet_count(b); k++) {
+        dcmv_packet_t pk;
+        if (dcmv_packet_info(b, k, &pk) < 0) {
+            if (bad++ < 8) printf("verify: packet %d is inconsistent\n", k);
+        }
+    }
+
+    // Aligned planar files: every block starts on a sector (packets are
+    // checked by dcmv_packet_info)
+    if ((hb->flags & DCMV_FLAG_SECTOR_ALIGNED) && !dcmv_packet_count(b)) {
+        for (int u = 0; u < hb->num_unique_frames; ) {
+            int first, count;
+            uint32_t off, size;
+            dcmv_block_of(b, u, &first, &count);
+            if (dcmv_frame_range(b, u, &off, &size) < 0 || off % DCMV_SECTOR_SIZE) {
+                if (bad++ < 8) printf("verify: block at frame %d is not sector aligned\n", u);
+            }
+            u = first + count;
+        }
+        if (hb->audio_offset % DCMV_SECTOR_SIZE && bad++ < 8)
+            printf("verify: audio is not sector aligned\n");
+    }
+
+    printf("verify: %d frames, %u audio bytes/ch, %d packets, %d blocks: %s\n",
+           ha->num_unique_frames, ha->audio_channel_size, dcmv_packet_count(b), dcmv_block_count(b),
+           bad ? "MISMATCH" : "identical");
+    free(fa);
+    free(fb);
+    free(vram);
+    dcmv_close(a);
+    dcmv_close(b);
+    return bad ? -1 : 0;
+}
+
+int dcmv_verify_rendition(const char *a_path, const char *b_path, int r) {
+    dcmv_t *a = dcmv_open(a_path, DCMV_BACKEND_FILE);
+    dcmv_t *b = dcmv_open(b_path, DCMV_BACKEND_FILE);
+    dcmv_rendition_t info;
+    if (!a || !b || dcmv_rendition_info(b, r, &info) < 0 ||
+        info.video_frame_size != dcmv_header(a)->video_frame_size) {
+        printf("verify: %s is not rendition %d of %s\n", a_path, r, b_path);
+        dcmv_close(a); dcmv_close(b);
+        return -1;
+    }
+    int fs = info.video_frame_size, bad = 0;
+    uint8_t *fa = memalign(32, fs), *fb = memalign(32, fs);
+    for (int u = 0; u < dcmv_header(a)->num_unique_frames; u++) {
+        if (dcmv_decode_into(a, u, fa) < 0 || dcmv_decode_rendition(b, r, u, fb) < 0 || memcmp(fa, fb, fs) != 0) {
+            if (bad++ < 8) printf("verify: rendition %d frame %d differs\n", r, u);
+        }
+    }
+    printf("verify: rendition %d (%dx%d), %d frames: %s\n", r, info.width, info.height,
+           dcmv_header(a)->num_unique_frames, bad ? "MISMATCH" : "identical");
+    free(fa);
+    free(fb);
+    dcmv_close(a);
+    dcmv_close(b);
+    return bad ? -1 : 0;
+}
@@ -0,0 +1,47 @@
+// dcmv_transcode.h - rewrite a .dcmv with a different layout or codec setup
+//
+// Shared by dcmv-remux and dcmv-bench --codec-report. Frames are copied as-is
+// unless re-encoding is requested (Zstd level, multi-frame blocks, trained
+// dictionary, delta frames, codebook runs); audio is always copied bit-exact.
+// Renditions of the source are carried over and more can be added.
+#ifndef DCMV_TRANSCODE_H
+#define DCMV_TRANSCODE_H
+
+#include "dcmv.h"
+
+#include <stdint.h>
+
+typedef struct {
+    int interleave;          // unique frames per A/V packet, 0 = planar audio
+    uint32_t audio_cap;      // per channel, per packet; the rest spills over
+    int recompress;          // re-encode frames with Zstd (implied below)
+    int level;               // Zstd level when re-encoding
+    int block_frames;        // frames per Zstd block, 1 = one frame each
+    uint32_t dict_size;      // train and embed a dictionary, 0 = none
+    int key_interval;        // delta frames with a key frame at least this often, 0 = off
+    int delta_gap;           // unchanged spans merged into a delta run
+    int codebooks;           // share identical codebooks of consecutive frames (CBTB)
+    int page_frames;         // paged offset/duration tables (PTBL), 0 = inline
+    int sector_align;        // frames (planar) or packets start on GD-ROM sectors
+    const char *renditions[DCMV_MAX_RENDITIONS - 1];   // movies to add as REND chunks
+    int rendition_count;     // (same timeline, planar layout only)
+    const int *layout;       // first frame of each run, in file order (ORDR), NULL = unique order
+    int layout_runs;         // (planar layout only; runs start on source blocks)
+    int quiet;
+} dcmv_transcode_opts_t;
+
+void dcmv_transcode_defaults(dcmv_transcode_opts_t *o);
+
+int dcmv_transcode(const char *src, const char *dst, const dcmv_transcode_opts_t *o);
+
+// Decode every frame and all audio of both files and compare. 0 if identical.
+// When b has delta frames or codebook runs, also replays its partial uploads
+// into a simulated texture and checks that against a; when b is sector
+// aligned, checks that every block or packet starts on a sector.
+int dcmv_verify(const char *a_path, const char *b_path);
+
+// Compare every frame of rendition r of b with the primary of a (a movie
+// added with opts.renditions). 0 if identical.
+int dcmv_verify_rendition(const char *a_path, const char *b_path, int r);
+
+#endif // DCMV_TRANSCODE_H
@@ -0,0 +1,355 @@
+// dcmv_writer.c - host-side .dcmv writer (see dcmv_writer.h)
+
+#include "dcmv_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t fourcc, offset, size;
+} chunk_entry_t;
+
+struct dcmv_writer {
+    FILE *f;
+    char *path;
+    dcmv_header_t hdr;
+    uint32_t pos;
+
+    uint32_t *frame_offsets;      // num_unique + 1
+    uint16_t *frame_durations;
+    int paged, page_frames;       // PTBL instead of inline tables
+    int next_unique;
+    uint32_t frames_end;
+    uint32_t frame_pad;           // sector-aligned planar: padding after the last block
+
+    uint32_t *block_first;        // first unique of each block
+    int block_count;
+    int max_block_frames;
+
+    uint32_t *run_first, *run_end; // runs of consecutive frames, in file order (ORDR)
+    int run_count;
+    int written;                  // frames written so far
+
+    chunk_entry_t *chunks;
+    int chunk_count;
+};
+
+static inline void wr16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void wr32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+void dcmv_write_header(uint8_t *p, const dcmv_header_t *h) {
+    memset(p, 0, DCMV_HEADER_SIZE);
+    memcpy(p, DCMV_MAGIC, 4);
+    wr32(p + 4, h->version);
+    p[8] = (uint8_t)h->frame_type;
+    wr16(p + 9, (uint16_t)h->width);
+    wr16(p + 11, (uint16_t)h->height);
+    wr16(p + 13, (uint16_t)h->content_width);
+    wr16(p + 15, (uint16_t)h->content_height);
+    uint32_t fps_bits;
+    memcpy(&fps_bits, &h->fps, sizeof(float));
+    wr32(p + 17, fps_bits);
+    wr16(p + 21, (uint16_t)h->sample_rate);
+    wr16(p + 23, (uint16_t)h->audio_channels);
+    wr32(p + 25, (uint32_t)h->num_unique_frames);
+    wr32(p + 29, (uint32_t)h->num_total_frames);
+    wr32(p + 33, (uint32_t)h->video_frame_size);
+    wr32(p + 37, (uint32_t)h->max_compressed_size);
+    wr32(p + 41, h->audio_offset);
+    p[45] = (h->compression == DCMV_COMPRESSION_ZSTD) ? 1 : 0;
+    if (h->version >= DCMV_VERSION_EXT)
+        wr32(p + 46, h->ext_offset);
+}
+
+static uint32_t tables_size(int num_unique) {
+    return (uint32_t)(num_unique + 1) * 4 + (uint32_t)num_unique * 2;
+}
+
+dcmv_writer_t *dcmv_writer_create(const char *path, const dcmv_header_t *hdr) {
+    dcmv_writer_t *w = calloc(1, sizeof(*w));
+    if (!w) return NULL;
+    w->hdr = *hdr;
+    w->hdr.max_compressed_size = 0;
+    w->hdr.ext_offset = 0;
+    w->path = strdup(path);
+
+    int n = hdr->num_unique_frames;
+    w->frame_offsets = calloc((size_t)n + 1, sizeof(uint32_t));
+    w->frame_durations = calloc((size_t)n, sizeof(uint16_t));
+    w->block_first = calloc((size_t)n + 1, sizeof(uint32_t));
+    w->run_first = calloc((size_t)n + 1, sizeof(uint32_t));
+    w->run_end = calloc((size_t)n + 1, sizeof(uint32_t));
+    w->f = fopen(path, "wb");
+    if (!w->f || !w->frame_offsets || !w->frame_durations || !w->block_first || !w->run_first || !w->run_end) {
+        printf("[DCMV] %s: cannot create\n", path);
+        goto fail;
+    }
+    for (int u = 0; u < n; u++) w->frame_durations[u] = 1;
+
+    // Placeholder header + tables, patched in finish
+    w->paged = (hdr->flags & DCMV_FLAG_PAGED_TABLES) != 0;
+    w->page_frames = DCMV_PAGE_FRAMES;
+    uint32_t reserve = DCMV_HEADER_SIZE + (w->paged ? 0 : tables_size(n));
+    uint8_t zero[256] = { 0 };
+    while (w->pos < reserve) {
+        uint32_t k = reserve - w->pos < sizeof(zero) ? reserve - w->pos : (uint32_t)sizeof(zero);
+        if (dcmv_writer_write(w, zero, k) < 0) goto fail;
+    }
+    w->frames_end = w->pos;
+    return w;
+
+fail:
+    if (w->f) fclose(w->f);
+    free(w->frame_offsets);
+    free(w->frame_durations);
+    free(w->block_first);
+    free(w->run_first);
+    free(w->run_end);
+    free(w->path);
+    free(w);
+    return NULL;
+}
+
+uint32_t dcmv_writer_tell(const dcmv_writer_t *w) {
+    return w->pos;
+}
+
+int dcmv_writer_write(dcmv_writer_t *w, const void *data, uint32_t size) {
+    if (size && fwrite(data, 1, size, w->f) != size) {
+        printf("[DCMV] %s: write failed\n", w->path);
+        return -1;
+    }
+    w->pos += size;
+    return 0;
+}
+
+int dcmv_writer_block(dcmv_writer_t *w, int first, int count, const void *data, uint32_t size) {
+    int bad = first < 0 || count < 1 || count > DCMV_MAX_PACKET_FRAMES || first + count > w->hdr.num_unique_frames;
+    for (int i = 0; i < count && !bad; i++) bad = w->frame_offsets[first + i] != 0;
+    if (bad) {
+        printf("[DCMV] %s: frames %d..%d written twice or out of range\n", w->path, first, first + count - 1);
+        return -1;
+    }
+    if (w->run_count == 0 || first != w->next_unique) {
+        // A new run; the previous one ends where the next offset would say
+        if (w->run_count) w->run_end[w->run_count - 1] = w->frames_end | w->frame_pad;
+        w->run_first[w->run_count++] = (uint32_t)first;
+        w->frame_pad = 0;
+    }
+    for (int i = 0; i < count; i++)
+        w->frame_offsets[first + i] = w->pos | w->frame_pad;
+    w->frame_pad = 0;
+    w->written += count;
+    if (dcmv_writer_write(w, data, size) < 0) return -1;
+    if ((int)size > w->hdr.max_compressed_size) w->hdr.max_compressed_size = (int)size;
+    if (count > w->max_block_frames) w->max_block_frames = count;
+    w->block_first[w->block_count++] = (uint32_t)first;
+    w->frames_end = w->pos;
+    w->next_unique = first + count;
+    return 0;
+}
+
+int dcmv_writer_frame(dcmv_writer_t *w, int unique, const void *data, uint32_t size) {
+    return dcmv_writer_block(w, unique, 1, data, size);
+}
+
+int dcmv_writer_align(dcmv_writer_t *w) {
+    static const uint8_t zero[DCMV_SECTOR_SIZE];
+    uint32_t pad = (DCMV_SECTOR_SIZE - w->pos % DCMV_SECTOR_SIZE) % DCMV_SECTOR_SIZE;
+    if (dcmv_writer_write(w, zero, pad) < 0) return -1;
+
+    // Padding right after a block of a planar file is recorded in the low
+    // bits of the next frame offset
+    if ((w->hdr.flags & DCMV_FLAG_SECTOR_ALIGNED) && !(w->hdr.flags & DCMV_FLAG_INTERLEAVED) &&
+        w->written > 0 && w->frames_end + pad == w->pos) {
+        w->frame_pad = pad;
+        w->frames_end = w->pos;
+    }
+    return 0;
+}
+
+void dcmv_writer_set_duration(dcmv_writer_t *w, int unique, int duration) {
+    if ((unsigned)unique < (unsigned)w->hdr.num_unique_frames)
+        w->frame_durations[unique] = (uint16_t)duration;
+}
+
+void dcmv_writer_set_audio_offset(dcmv_writer_t *w, uint32_t offset) {
+    w->hdr.audio_offset = offset;
+}
+
+void dcmv_writer_set_flags(dcmv_writer_t *w, uint32_t flags) {
+    // The table layout was fixed at create
+    w->hdr.flags = (flags & ~DCMV_FLAG_PAGED_TABLES) | (w->paged ? DCMV_FLAG_PAGED_TABLES : 0);
+}
+
+void dcmv_writer_set_page_frames(dcmv_writer_t *w, int frames) {
+    if (frames >= 1 && frames <= 0xFFFF) w->page_frames = frames;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t put_varint(uint8_t *p, uint32_t v) {
+    uint32_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// PTBL: page index, then the pages back to back
+static int write_paged_tables(dcmv_writer_t *w) {
+    int n = w->hdr.num_unique_frames;
+    int pf = w->page_frames;
+    int pages = (n + pf - 1) / pf;
+    uint32_t index_bytes = 8 + (uint32_t)(pages + 1) * 12;
+    uint8_t *buf = malloc(index_bytes + (size_t)n * 8);
+    if (!buf) return -1;
+
+    uint32_t base = w->pos;
+    uint32_t pos = index_bytes, total = 0;
+    wr32(buf, (uint32_t)pf);
+    wr32(buf + 4, (uint32_t)pages);
+    for (int p = 0; p <= pages; p++) {
+        uint8_t *e = buf + 8 + p * 12;
+        int first = p * pf < n ? p * pf : n;
+        wr32(e, base + pos);
+        wr32(e + 4, w->frame_offsets[first]);
+        wr32(e + 8, total);
+        for (int u = first; u < first + pf && u < n && p < pages; u++) {
+            pos += put_varint(buf + pos, w->frame_offsets[u + 1] - w->frame_offsets[u]);
+            pos += put_varint(buf + pos, w->frame_durations[u]);
+            total += w->frame_durations[u];
+        }
+    }
+    int rc = dcmv_writer_add_chunk(w, DCMV_CHUNK_PTBL, buf, pos);
+    free(buf);
+    return rc;
+}
+
+int dcmv_writer_begin_chunk(dcmv_writer_t *w, uint32_t fourcc) {
+    chunk_entry_t *c = realloc(w->chunks, sizeof(*c) * (size_t)(w->chunk_count + 1));
+    if (!c) return -1;
+    w->chunks = c;
+    c[w->chunk_count].fourcc = fourcc;
+    c[w->chunk_count].offset = w->pos;
+    c[w->chunk_count].size = 0;
+    w->chunk_count++;
+    return 0;
+}
+
+void dcmv_writer_end_chunk(dcmv_writer_t *w) {
+    chunk_entry_t *c = &w->chunks[w->chunk_count - 1];
+    c->size = w->pos - c->offset;
+}
+
+int dcmv_writer_add_chunk(dcmv_writer_t *w, uint32_t fourcc, const void *data, uint32_t size) {
+    if (dcmv_writer_begin_chunk(w, fourcc) < 0 || dcmv_writer_write(w, data, size) < 0) return -1;
+    dcmv_writer_end_chunk(w);
+    return 0;
+}
+
+int dcmv_writer_finish(dcmv_writer_t *w) {
+    int n = w->hdr.num_unique_frames;
+    int rc = 0;
+
+    if (w->written != n) {
+        printf("[DCMV] %s: only %d of %d frames written\n", w->path, w->written, n);
+        rc = -1;
+    }
+    w->frame_offsets[n] = w->frames_end | w->frame_pad;
+    if (w->run_count) w->run_end[w->run_count - 1] = w->frame_offsets[n];
+    if ((w->hdr.flags & DCMV_FLAG_SECTOR_ALIGNED) && !(w->hdr.flags & DCMV_FLAG_INTERLEAVED) &&
+        w->frames_end % DCMV_SECTOR_SIZE) {
+        printf("[DCMV] %s: frames do not end on a sector\n", w->path);
+        rc = -1;
+    }
+
+    if (rc == 0 && w->run_count > 1) {
+        // Written out of unique order: ORDR, runs sorted by first frame
+        uint32_t bytes = 4 + (uint32_t)w->run_count * 8;
+        uint8_t *ordr = malloc(bytes);
+        uint32_t *pairs = malloc(sizeof(uint32_t) * 2 * (size_t)w->run_count);
+        for (int r = 0; r < w->run_count; r++) {
+            pairs[r * 2] = w->run_first[r];
+            pairs[r * 2 + 1] = w->run_end[r];
+        }
+        qsort(pairs, (size_t)w->run_count, sizeof(uint32_t) * 2, cmp_u32);
+        wr32(ordr, (uint32_t)w->run_count);
+        for (int i = 0; i < w->run_count * 2; i++) wr32(ordr + 4 + i * 4, pairs[i]);
+        w->frame_offsets[n] = pairs[w->run_count * 2 - 1];
+        rc = dcmv_writer_add_chunk(w, DCMV_CHUNK_ORDR, ordr, bytes);
+        free(ordr);
+        free(pairs);
+
+        // BLKS lists blocks in unique order
+        qsort(w->block_first, (size_t)w->block_count, sizeof(uint32_t), cmp_u32);
+    }
+
+    if (rc == 0 && w->max_block_frames > 1) {
+        uint32_t bytes = 8 + (uint32_t)(w->block_count + 1) * 4;
+        uint8_t *blks = malloc(bytes);
+        wr32(blks, (uint32_t)w->block_count);
+        wr32(blks + 4, (uint32_t)w->max_block_frames);
+        for (int i = 0; i < w->block_count; i++) wr32(blks + 8 + i * 4, w->block_first[i]);
+        wr32(blks + 8 + w->block_count * 4, (uint32_t)n);
+        rc = dcmv_writer_add_chunk(w, DCMV_CHUNK_BLKS, blks, bytes);
+        free(blks);
+    }
+
+    if (rc == 0 && w->paged) rc = write_paged_tables(w);
+
+    // Extension block at the tail; v2 files stay byte-compatible
+    if (rc == 0 && (w->chunk_count || w->hdr.flags)) {
+        uint32_t bytes = 12 + (uint32_t)w->chunk_count * 12;
+        uint8_t *ext = malloc(bytes);
+        memcpy(ext, DCMV_EXT_MAGIC, 4);
+        wr32(ext + 4, w->hdr.flags);
+        wr32(ext + 8, (uint32_t)w->chunk_count);
+        for (int i = 0; i < w->chunk_count; i++) {
+            wr32(ext + 12 + i * 12, w->chunks[i].fourcc);
+            wr32(ext + 16 + i * 12, w->chunks[i].offset);
+            wr32(ext + 20 + i * 12, w->chunks[i].size);
+        }
+        w->hdr.ext_offset = w->pos;
+        if (w->hdr.version < DCMV_VERSION_EXT) w->hdr.version = DCMV_VERSION_EXT;
+        rc = dcmv_writer_write(w, ext, bytes);
+        free(ext);
+    }
+
+    if (rc == 0) {
+        uint8_t raw[DCMV_HEADER_SIZE];
+        dcmv_write_header(raw, &w->hdr);
+
+        uint32_t tsize = w->paged ? 0 : tables_size(n);
+        uint8_t *tables = malloc(tsize ? tsize : 1);
+        for (int u = 0; u <= n && tsize; u++) wr32(tables + u * 4, w->frame_offsets[u]);
+        for (int u = 0; u < n && tsize; u++) wr16(tables + (n + 1) * 4 + u * 2, w->frame_durations[u]);
+
+        if (fseek(w->f, 0, SEEK_SET) != 0 ||
+            fwrite(raw, 1, sizeof(raw), w->f) != sizeof(raw) ||
+            fwrite(tables, 1, tsize, w->f) != tsize) {
+            printf("[DCMV] %s: failed to write header\n", w->path);
+            rc = -1;
+        }
+        free(tables);
+    }
+
+    if (fclose(w->f) != 0) rc = -1;
+    free(w->frame_offsets);
+    free(w->frame_durations);
+    free(w->block_first);
+    free(w->run_first);
+    free(w->run_end);
+    free(w->chunks);
+    free(w->path);
+    free(w);
+    return rc;
+}
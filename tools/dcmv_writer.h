@@ -0,0 +1,65 @@
+// dcmv_writer.h - host-side .dcmv writer
+//
+// Counterpart of src/dcmv.h for the tools. Payload is written front to back;
+// frame offsets, durations and the header are patched in by dcmv_writer_finish,
+// along with the v3 extension block when chunks or flags were added.
+//
+//   w = dcmv_writer_create(path, &hdr);      // reserves header + tables
+//   dcmv_writer_frame(w, u, data, size);     // each frame once, anywhere
+//   dcmv_writer_write(w, audio, n);          // raw bytes (audio, packets, ...)
+//   dcmv_writer_add_chunk(w, DCMV_CHUNK_AVIL, buf, len);
+//   dcmv_writer_finish(w);
+#ifndef DCMV_WRITER_H
+#define DCMV_WRITER_H
+
+#include "dcmv.h"
+
+#include <stdint.h>
+
+typedef struct dcmv_writer dcmv_writer_t;
+
+// hdr supplies everything but the tables, max_compressed_size and ext_offset,
+// which the writer computes. audio_offset must be set (or set later). With
+// DCMV_FLAG_PAGED_TABLES in hdr->flags no inline tables are reserved and
+// finish writes a PTBL chunk instead.
+dcmv_writer_t *dcmv_writer_create(const char *path, const dcmv_header_t *hdr);
+
+// Current write position (absolute file offset).
+uint32_t dcmv_writer_tell(const dcmv_writer_t *w);
+
+int dcmv_writer_write(dcmv_writer_t *w, const void *data, uint32_t size);
+
+// Write a compressed frame at the current position and record its offset.
+// Frames are normally written in unique order and the end of the last one
+// becomes frame_offsets[num_unique]. Any other order works on planar files:
+// finish then records the runs of consecutive frames in an ORDR chunk.
+int dcmv_writer_frame(dcmv_writer_t *w, int unique, const void *data, uint32_t size);
+
+// Same for a multi-frame Zstd block holding frames [first, first + count).
+// A BLKS chunk is emitted by finish if any block has more than one frame.
+int dcmv_writer_block(dcmv_writer_t *w, int first, int count, const void *data, uint32_t size);
+
+// Zero-pad to the next DCMV_SECTOR_SIZE boundary. With DCMV_FLAG_SECTOR_ALIGNED
+// on a planar file, call it before every block and once after the last.
+int dcmv_writer_align(dcmv_writer_t *w);
+
+void dcmv_writer_set_duration(dcmv_writer_t *w, int unique, int duration);
+void dcmv_writer_set_audio_offset(dcmv_writer_t *w, uint32_t offset);
+void dcmv_writer_set_flags(dcmv_writer_t *w, uint32_t flags);
+void dcmv_writer_set_page_frames(dcmv_writer_t *w, int frames);   // default DCMV_PAGE_FRAMES
+
+// Append an extension chunk at the current position.
+int dcmv_writer_add_chunk(dcmv_writer_t *w, uint32_t fourcc, const void *data, uint32_t size);
+
+// Same for a chunk too big to build in memory: everything written between
+// begin and end (dcmv_writer_write) becomes its contents.
+int  dcmv_writer_begin_chunk(dcmv_writer_t *w, uint32_t fourcc);
+void dcmv_writer_end_chunk(dcmv_writer_t *w);
+
+// Patch tables and header, write the extension block, close. Frees w.
+int dcmv_writer_finish(dcmv_writer_t *w);
+
+// Serialise a header (DCMV_HEADER_SIZE bytes).
+void dcmv_write_header(uint8_t *out, const dcmv_header_t *h);
+
+#endif // DCMV_WRITER_H
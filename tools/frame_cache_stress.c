@@ -0,0 +1,200 @@
+// frame_cache_stress.c - hammer the frame cache's slot lifecycle from several threads
+//
+// Loader threads claim slots for frames around the play head and fill them
+// with a pattern derived from the frame number, as the worker decodes into
+// them. The renderer (main thread) walks the play head with random jumps,
+// acquires the frame due, checks its pattern and hands it to a fake DMA
+// thread, which reads the buffer twice with a delay in between and then
+// calls frame_cache_dma_done, as the engine's completion callback does. Any
+// change to a buffer while the renderer or the DMA holds it, or a claim of a
+// held slot, fails the run; at the end no slot may keep a reference. Build
+// the host tools with -DSINGE_HOST_SANITIZER=thread to run it under
+// ThreadSanitizer.
+//
+//   frame-cache-stress [--loaders N] [--seconds S] [--slots K] [--unique U]
+
+#include "frame_cache.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STRESS_MAX_LOADERS 16
+#define STRESS_WORDS       1024          // per slot
+#define STRESS_AHEAD       24            // loaders pick frames up to this far ahead
+
+static frame_cache_t g_c;
+static int g_unique = 256;
+static atomic_uint g_buf[FRAME_CACHE_MAX][STRESS_WORDS];
+static atomic_int g_holders[FRAME_CACHE_MAX];       // renderer + DMA, as the test sees them
+static atomic_int g_stop = 0;
+static atomic_int g_failed = 0;
+static atomic_int g_dma_slot = -1;                  // slot handed to the DMA thread
+static atomic_int g_dma_unique = -1;
+static atomic_ulong g_claimed = 0, g_refused = 0, g_dmas = 0;
+
+typedef struct {
+    uint32_t rng;
+} loader_t;
+
+static uint32_t xorshift(uint32_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+static uint32_t pattern(int unique, int i) {
+    return (uint32_t)unique * 2654435761u + (uint32_t)i;
+}
+
+static void fail(const char *what, int slot, int unique) {
+    if (!atomic_exchange(&g_failed, 1))
+        printf("FAIL: %s (slot %d, frame %d)\n", what, slot, unique);
+    atomic_store(&g_stop, 1);
+}
+
+// Nonzero if slot holds `unique` intact
+static int check_buf(int slot, int unique) {
+    for (int i = 0; i < STRESS_WORDS; i++) {
+        if (atomic_load_explicit(&g_buf[slot][i], memory_order_relaxed) != pattern(unique, i))
+            return 0;
+    }
+    return 1;
+}
+
+static void *loader(void *arg) {
+    loader_t *l = arg;
+    while (!atomic_load(&g_stop)) {
+        int head = atomic_load(&g_c.playhead);
+        int u = head + (int)(xorshift(&l->rng) % STRESS_AHEAD);
+        if (u >= g_unique) u -= g_unique;
+        int slot = frame_cache_claim(&g_c, u);
+        if (slot < 0) {
+            atomic_fetch_add(&g_refused, 1);
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_add(&g_claimed, 1);
+        if (atomic_load(&g_holders[slot]) != 0 || frame_cache_refs(&g_c, slot) != 0)
+            fail("claimed a slot the renderer or a DMA holds", slot, u);
+        for (int i = 0; i < STRESS_WORDS; i++)
+            atomic_store_explicit(&g_buf[slot][i], pattern(u, i), memory_order_relaxed);
+        // Now and then a failed load, which hands the slot back empty
+        frame_cache_done(&g_c, slot, xorshift(&l->rng) % 64 != 0);
+    }
+    return NULL;
+}
+
+static void *dma(void *arg) {
+    (void)arg;
+    while (!atomic_load(&g_stop) || atomic_load(&g_dma_slot) >= 0) {
+        int slot = atomic_load(&g_dma_slot);
+        if (slot < 0) {
+            sched_yield();
+            continue;
+        }
+        int u = atomic_load(&g_dma_unique);
+        if (!check_buf(slot, u)) fail("buffer changed under a DMA", slot, u);
+        struct timespec ts = { 0, 20000 };
+        nanosleep(&ts, NULL);
+        if (!check_buf(slot, u)) fail("buffer changed under a DMA", slot, u);
+        atomic_fetch_sub(&g_holders[slot], 1);
+        frame_cache_dma_done(&g_c, slot);
+        atomic_fetch_add(&g_dmas, 1);
+        atomic_store(&g_dma_slot, -1);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int loaders = 2, slots = 8;
+    double seconds = 2.0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--loaders") && i + 1 < argc) loaders = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--slots") && i + 1 < argc) slots = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--unique") && i + 1 < argc) g_unique = atoi(argv[++i]);
+        else {
+            printf("usage: frame-cache-stress [--loaders N] [--seconds S] [--slots K] [--unique U]\n");
+            return 1;
+        }
+    }
+    if (loaders < 1 || loaders > STRESS_MAX_LOADERS || slots < 2 || slots > FRAME_CACHE_MAX ||
+        g_unique < STRESS_AHEAD) {
+        printf("frame-cache-stress: 1-%d loaders, 2-%d slots, at least %d unique frames\n",
+               STRESS_MAX_LOADERS, FRAME_CACHE_MAX, STRESS_AHEAD);
+        return 1;
+    }
+    frame_cache_init(&g_c, slots);
+
+    pthread_t threads[STRESS_MAX_LOADERS], dma_thread;
+    loader_t state[STRESS_MAX_LOADERS];
+    for (int i = 0; i < loaders; i++) {
+        state[i] = (loader_t){ 0x9e3779b9u * (uint32_t)(i + 1) };
+        pthread_create(&threads[i], NULL, loader, &state[i]);
+    }
+    pthread_create(&dma_thread, NULL, dma, NULL);
+
+    // Renderer: show the frame due, upload it, move on or jump
+    uint32_t rng = 0x12345678u;
+    unsigned long shown = 0, underruns = 0, jumps = 0;
+    int cur = 0, held = -1;
+    struct timespec t0, t;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (!atomic_load(&g_stop)) {
+        frame_cache_set_playhead(&g_c, cur);
+        if (held >= 0) atomic_fetch_sub(&g_holders[held], 1);
+        held = frame_cache_acquire(&g_c, cur);
+        if (held < 0) {
+            underruns++;
+            sched_yield();
+        } else {
+            atomic_fetch_add(&g_holders[held], 1);
+            if (!check_buf(held, cur)) fail("acquired a frame that is not decoded", held, cur);
+            frame_cache_show(&g_c, held);
+            shown++;
+            // One upload at a time, as upload_wait does
+            while (atomic_load(&g_dma_slot) >= 0 && !atomic_load(&g_stop))
+                sched_yield();
+            if (!check_buf(held, cur)) fail("buffer changed while on screen", held, cur);
+            atomic_fetch_add(&g_holders[held], 1);
+            frame_cache_dma_begin(&g_c, held);
+            atomic_store(&g_dma_unique, cur);
+            atomic_store(&g_dma_slot, held);
+            if (xorshift(&rng) % 200 == 0) {
+                cur = (int)(xorshift(&rng) % (uint32_t)g_unique);
+                jumps++;
+            } else {
+                cur = (cur + 1) % g_unique;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        if ((double)(t.tv_sec - t0.tv_sec) + (t.tv_nsec - t0.tv_nsec) / 1e9 >= seconds)
+            atomic_store(&g_stop, 1);
+    }
+    atomic_store(&g_stop, 1);
+    for (int i = 0; i < loaders; i++) pthread_join(threads[i], NULL);
+    pthread_join(dma_thread, NULL);
+    if (held >= 0) atomic_fetch_sub(&g_holders[held], 1);
+    frame_cache_acquire(&g_c, -1);                 // drops the last frame on screen
+
+    int failed = atomic_load(&g_failed);
+    for (int s = 0; s < slots && !failed; s++) {
+        int w = atomic_load(&g_c.state[s]);
+        if (FRAME_REFS(w) != 0 || (FRAME_PHASE(w) != FRAME_EMPTY && FRAME_PHASE(w) != FRAME_READY)) {
+            printf("FAIL: slot %d left with %d references in phase %d\n", s, FRAME_REFS(w), FRAME_PHASE(w));
+            failed = 1;
+        }
+    }
+
+    printf("%d loaders, %d slots, %d unique frames, %.1f s: %lu frames shown (%lu jumps, %lu underruns), "
+           "%lu uploads, %lu claims, %lu refused, %u evictions\n", loaders, slots, g_unique, seconds, shown,
+           jumps, underruns, atomic_load(&g_dmas), atomic_load(&g_claimed), atomic_load(&g_refused),
+           atomic_load(&g_c.evictions));
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
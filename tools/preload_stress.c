@@ -0,0 +1,163 @@
+// preload_stress.c - hammer the engine's preload queue from several threads
+//
+// Producer threads push jobs for a small set of unique frames, so most pushes
+// hit the "already queued" bitmap or a full queue, while one consumer pops
+// and now and then drains, as the worker's stall recovery does. Every job
+// carries its producer and a sequence number; the consumer checks the fields
+// belong together and that each producer's jobs come out in order. At the
+// end every frame must have been popped exactly as often as it was pushed,
+// and no bit may be left set. Build the host tools with
+// -DSINGE_HOST_SANITIZER=thread to run it under ThreadSanitizer.
+//
+//   preload-stress [--producers N] [--seconds S] [--unique U]
+
+#include "preload_queue.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STRESS_MAX_PRODUCERS 16
+#define STRESS_MAX_UNIQUE    4096
+#define STRESS_SEQ_BITS      20          // generation = producer << bits | seq
+
+static preload_queue_t g_q;
+static int g_unique = 64;
+static atomic_int g_stop = 0;
+static atomic_int g_producers_left = 0;
+static atomic_uint g_pushed[STRESS_MAX_UNIQUE];
+static unsigned g_popped[STRESS_MAX_UNIQUE];          // consumer only
+static atomic_ulong g_rejected = 0;
+
+typedef struct {
+    int id;
+    uint32_t rng;
+    unsigned long pushes;
+} producer_t;
+
+static uint32_t xorshift(uint32_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+static void *producer(void *arg) {
+    producer_t *p = arg;
+    unsigned seq = 0;
+    while (!atomic_load(&g_stop)) {
+        int u = (int)(xorshift(&p->rng) % (uint32_t)g_unique);
+        int frame = u * 3 + (int)(xorshift(&p->rng) % 3);
+        int gen = (p->id << STRESS_SEQ_BITS) | (int)(seq & ((1u << STRESS_SEQ_BITS) - 1));
+        if (preload_queue_push(&g_q, frame, u, gen)) {
+            atomic_fetch_add(&g_pushed[u], 1);
+            p->pushes++;
+            seq++;
+        } else {
+            atomic_fetch_add(&g_rejected, 1);
+            sched_yield();               // let the consumer in on small machines
+        }
+    }
+    atomic_fetch_sub(&g_producers_left, 1);
+    return NULL;
+}
+
+static int check_job(const preload_job_t *job, unsigned *next_seq, int producers) {
+    int id = job->generation >> STRESS_SEQ_BITS;
+    unsigned seq = (unsigned)job->generation & ((1u << STRESS_SEQ_BITS) - 1);
+    if (job->unique < 0 || job->unique >= g_unique || job->frame / 3 != job->unique ||
+        id < 0 || id >= producers) {
+        printf("FAIL: torn job frame=%d unique=%d generation=%d\n", job->frame, job->unique, job->generation);
+        return -1;
+    }
+    if (seq != (next_seq[id] & ((1u << STRESS_SEQ_BITS) - 1))) {
+        printf("FAIL: producer %d job %u out of order (expected %u)\n", id, seq, next_seq[id]);
+        return -1;
+    }
+    next_seq[id]++;
+    g_popped[job->unique]++;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int producers = 3;
+    double seconds = 2.0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--producers") && i + 1 < argc) producers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--unique") && i + 1 < argc) g_unique = atoi(argv[++i]);
+        else {
+            printf("usage: preload-stress [--producers N] [--seconds S] [--unique U]\n");
+            return 1;
+        }
+    }
+    if (producers < 1 || producers > STRESS_MAX_PRODUCERS || g_unique < 1 || g_unique > STRESS_MAX_UNIQUE) {
+        printf("preload-stress: 1-%d producers, 1-%d unique frames\n", STRESS_MAX_PRODUCERS, STRESS_MAX_UNIQUE);
+        return 1;
+    }
+    if (preload_queue_init(&g_q, g_unique) < 0) return 1;
+
+    pthread_t threads[STRESS_MAX_PRODUCERS];
+    producer_t state[STRESS_MAX_PRODUCERS];
+    atomic_store(&g_producers_left, producers);
+    for (int i = 0; i < producers; i++) {
+        state[i] = (producer_t){ i, 0x9e3779b9u * (uint32_t)(i + 1), 0 };
+        pthread_create(&threads[i], NULL, producer, &state[i]);
+    }
+
+    // Consumer: pop, and drain every so often. Drained jobs are checked too.
+    unsigned next_seq[STRESS_MAX_PRODUCERS] = { 0 };
+    unsigned long pops = 0, drains = 0;
+    int failed = 0;
+    struct timespec t0, t;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (;;) {
+        preload_job_t job;
+        int producing = atomic_load(&g_producers_left) > 0;
+        if (preload_queue_pop(&g_q, &job)) {
+            if (check_job(&job, next_seq, producers) < 0) { failed = 1; break; }
+            if (++pops % 4096 == 0) {
+                drains++;
+                while (preload_queue_pop(&g_q, &job)) {
+                    pops++;
+                    if (check_job(&job, next_seq, producers) < 0) { failed = 1; break; }
+                }
+                if (failed) break;
+            }
+        } else if (!producing) {
+            break;                       // producers gone and the queue is empty
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        if (!atomic_load(&g_stop) &&
+            (double)(t.tv_sec - t0.tv_sec) + (t.tv_nsec - t0.tv_nsec) / 1e9 >= seconds)
+            atomic_store(&g_stop, 1);
+    }
+    atomic_store(&g_stop, 1);
+    for (int i = 0; i < producers; i++) pthread_join(threads[i], NULL);
+
+    unsigned long pushes = 0;
+    for (int i = 0; i < producers; i++) pushes += state[i].pushes;
+    for (int u = 0; u < g_unique && !failed; u++) {
+        if (atomic_load(&g_pushed[u]) != g_popped[u]) {
+            printf("FAIL: frame %d pushed %u times, popped %u\n", u, atomic_load(&g_pushed[u]), g_popped[u]);
+            failed = 1;
+        } else if (preload_queue_is_queued(&g_q, u)) {
+            printf("FAIL: frame %d still marked queued\n", u);
+            failed = 1;
+        }
+    }
+    if (!failed && preload_queue_count(&g_q) != 0) {
+        printf("FAIL: %d jobs left in the queue\n", preload_queue_count(&g_q));
+        failed = 1;
+    }
+
+    printf("%d producers, %d unique frames, %.1f s: %lu jobs pushed, %lu popped (%lu drains), "
+           "%lu pushes refused (queued or full)\n", producers, g_unique, seconds, pushes, pops, drains,
+           atomic_load(&g_rejected));
+    printf("%s\n", failed ? "FAILED" : "OK");
+    preload_queue_destroy(&g_q);
+    return failed;
+}
@@ -0,0 +1,571 @@
+// singe_hints.c - extract the segment-jump graph of a .singe script
+//
+// Singe games branch with discSkipToFrame/discSearch calls whose targets are
+// constants, or names assigned constants elsewhere (iFrameStart tables and
+// the like), usually inside "if currentFrame == N then" tests. This tool
+// tokenizes the Lua source (following dofile), resolves those targets and
+// writes a sidecar the engine loads next to the movie:
+//
+//   # singe-hints 1
+//   segment START END        frames a jump target plays through (END -1: open)
+//   jump FROM TO COUNT       FROM -1 = not tied to a frame test
+//
+// Only segments and jumps reachable from frame 0 or an untied jump are kept.
+// Without -o the hints go to stdout; the summary always goes to stderr.
+// The engine pre-decodes the first frames of the targets ahead of the
+// current segment's jumps, so the seek finds them already decoded.
+//
+//   singe-hints [--movie movie.dcmv] [-o movie.hints] game.singe [more.singe ...]
+
+#include "dcmv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_NAME   48
+#define MAX_CONDS  16
+#define MAX_DEPTH  64
+#define MAX_FILES  16
+
+// --- Lexer ---
+
+enum { T_NAME, T_NUM, T_STR, T_OP };
+
+typedef struct {
+    int type;
+    char text[MAX_NAME];          // name, operator or (truncated) string
+    long num;
+    int line;
+} token_t;
+
+typedef struct {
+    token_t *v;
+    int count, cap;
+} tokens_t;
+
+static void push_token(tokens_t *t, int type, const char *s, int len, long num, int line) {
+    if (t->count == t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 4096;
+        t->v = realloc(t->v, sizeof(token_t) * t->cap);
+    }
+    token_t *k = &t->v[t->count++];
+    k->type = type;
+    if (len >= MAX_NAME) len = MAX_NAME - 1;
+    memcpy(k->text, s, (size_t)len);
+    k->text[len] = '\0';
+    k->num = num;
+    k->line = line;
+}
+
+// [[ ... ]] / [==[ ... ]==] at p; returns the end, or NULL if p is not one
+static const char *skip_long_bracket(const char *p, int *line) {
+    if (*p != '[') return NULL;
+    int level = 0;
+    const char *q = p + 1;
+    while (*q == '=') { level++; q++; }
+    if (*q != '[') return NULL;
+    for (q++; *q; q++) {
+        if (*q == '\n') (*line)++;
+        if (*q == ']') {
+            const char *e = q + 1;
+            int n = 0;
+            while (*e == '=') { n++; e++; }
+            if (n == level && *e == ']') return e + 1;
+        }
+    }
+    return q;
+}
+
+static void lex(const char *src, tokens_t *t) {
+    int line = 1;
+    const char *p = src;
+    while (*p) {
+        if (*p == '\n') { line++; p++; continue; }
+        if (isspace((unsigned char)*p)) { p++; continue; }
+
+        if (p[0] == '-' && p[1] == '-') {
+            const char *e = skip_long_bracket(p + 2, &line);
+            if (e) { p = e; continue; }
+            while (*p && *p != '\n') p++;
+            continue;
+        }
+        if (*p == '[') {
+            const char *e = skip_long_bracket(p, &line);
+            if (e) { push_token(t, T_STR, p, (int)(e - p), 0, line); p = e; continue; }
+        }
+        if (*p == '"' || *p == '\'') {
+            char quote = *p++;
+            const char *s = p;
+            while (*p && *p != quote && *p != '\n') {
+                if (*p == '\\' && p[1]) p++;
+                p++;
+            }
+            push_token(t, T_STR, s, (int)(p - s), 0, line);
+            if (*p == quote) p++;
+            continue;
+        }
+        if (isdigit((unsigned char)*p) || (*p == '.' && isdigit((unsigned char)p[1]))) {
+            char *e;
+            double v = strtod(p, &e);
+            if (e == p) e = (char *)p + 1;
+            push_token(t, T_NUM, p, (int)(e - p), (long)v, line);
+            p = e;
+            continue;
+        }
+        if (isalpha((unsigned char)*p) || *p == '_') {
+            const char *s = p;
+            while (isalnum((unsigned char)*p) || *p == '_') p++;
+            push_token(t, T_NAME, s, (int)(p - s), 0, line);
+            continue;
+        }
+        static const char *ops2[] = { "==", "~=", "<=", ">=", "..", "::", "//" };
+        int len = 1;
+        for (size_t i = 0; i < sizeof(ops2) / sizeof(ops2[0]); i++)
+            if (p[0] == ops2[i][0] && p[1] == ops2[i][1]) len = 2;
+        push_token(t, T_OP, p, len, 0, line);
+        p += len;
+    }
+}
+
+static int is_name(const token_t *k, const char *s) { return k->type == T_NAME && !strcmp(k->text, s); }
+static int is_op(const token_t *k, const char *s)   { return k->type == T_OP && !strcmp(k->text, s); }
+
+static int contains_ci(const char *s, const char *sub) {
+    for (; *s; s++) {
+        int i = 0;
+        while (sub[i] && tolower((unsigned char)s[i]) == sub[i]) i++;
+        if (!sub[i]) return 1;
+    }
+    return 0;
+}
+
+// --- Values: a frame constant, or a name resolved once the whole script is read ---
+
+typedef struct {
+    long num;
+    char name[MAX_NAME];          // empty: num is the value
+} ref_t;
+
+typedef struct {
+    char name[MAX_NAME];
+    long *v;
+    int count, cap;
+} constant_t;
+
+static constant_t *g_consts;
+static int g_const_count, g_const_cap;
+
+static constant_t *find_const(const char *name, int create) {
+    for (int i = 0; i < g_const_count; i++)
+        if (!strcmp(g_consts[i].name, name)) return &g_consts[i];
+    if (!create) return NULL;
+    if (g_const_count == g_const_cap) {
+        g_const_cap = g_const_cap ? g_const_cap * 2 : 256;
+        g_consts = realloc(g_consts, sizeof(constant_t) * g_const_cap);
+    }
+    constant_t *c = &g_consts[g_const_count++];
+    memset(c, 0, sizeof(*c));
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    return c;
+}
+
+static void add_const(const char *name, long v) {
+    constant_t *c = find_const(name, 1);
+    for (int i = 0; i < c->count; i++)
+        if (c->v[i] == v) return;
+    if (c->count == c->cap) {
+        c->cap = c->cap ? c->cap * 2 : 8;
+        c->v = realloc(c->v, sizeof(long) * c->cap);
+    }
+    c->v[c->count++] = v;
+}
+
+// Values of a ref; `one` receives a literal so callers can iterate uniformly
+static const long *resolve(const ref_t *r, long *one, int *count) {
+    if (!r->name[0]) { *one = r->num; *count = 1; return one; }
+    constant_t *c = find_const(r->name, 0);
+    *count = c ? c->count : 0;
+    return c ? c->v : NULL;
+}
+
+// --- Jump calls ---
+
+typedef struct {
+    ref_t target;
+    ref_t from[MAX_CONDS];
+    int from_count;               // 0: not under a frame test
+    int line, file;
+} call_t;
+
+static call_t *g_calls;
+static int g_call_count, g_call_cap, g_unresolved;
+static const char *g_files[MAX_FILES];
+static int g_file_count;
+
+static int is_jump_fn(const token_t *k) {
+    return is_name(k, "discSkipToFrame") || is_name(k, "discSearch") || is_name(k, "discSearchBlanking");
+}
+
+// Names the script stores the disc position in (currentFrame = discGetFrame())
+static char g_frame_vars[16][MAX_NAME];
+static int g_frame_var_count;
+
+static int is_frame_value(const token_t *k, int i) {
+    if (k[i].type != T_NAME) return 0;
+    if (!strcmp(k[i].text, "discGetFrame")) return 1;
+    for (int v = 0; v < g_frame_var_count; v++)
+        if (!strcmp(g_frame_vars[v], k[i].text)) return 1;
+    return 0;
+}
+
+// The frame a condition token at i compares the disc position against, e.g.
+// "currentFrame == 224", "discGetFrame() >= N" or "N == currentFrame".
+// Returns 1 and fills *r.
+static int frame_test_at(const token_t *k, int i, int n, ref_t *r) {
+    const token_t *op = &k[i];
+    if (!(is_op(op, "==") || is_op(op, ">=") || is_op(op, ">"))) return 0;
+    if (i < 1 || i + 1 >= n) return 0;
+
+    int lhs = i - 1;
+    if (is_op(&k[lhs], ")") && i >= 3 && is_op(&k[i - 2], "(")) lhs = i - 3;
+    const token_t *val = is_frame_value(k, lhs) ? &k[i + 1] : is_frame_value(k, i + 1) ? &k[i - 1] : NULL;
+    if (!val || (val->type != T_NUM && val->type != T_NAME) || is_frame_value(val, 0)) return 0;
+
+    memset(r, 0, sizeof(*r));
+    if (val->type == T_NUM) r->num = val->num + (is_op(op, ">") ? 1 : 0);
+    else snprintf(r->name, sizeof(r->name), "%s", val->text);
+    return 1;
+}
+
+// Argument of a jump call starting after '(' at i: a number or a name
+// (the last field of a.b[i].c). Returns 1 and fills *r.
+static int jump_target(const token_t *k, int i, int n, ref_t *r) {
+    memset(r, 0, sizeof(*r));
+    if (i + 1 < n && k[i].type == T_NUM && is_op(&k[i + 1], ")")) {
+        r->num = k[i].num;
+        return 1;
+    }
+    int last = -1;
+    for (; i < n && !is_op(&k[i], ")"); i++) {
+        if (is_op(&k[i], "[")) {
+            for (int nest = 0; i < n; i++) {
+                if (is_op(&k[i], "[")) nest++;
+                else if (is_op(&k[i], "]") && --nest == 0) break;
+            }
+        } else if (k[i].type == T_NAME) {
+            last = i;
+        } else if (!is_op(&k[i], ".")) {
+            return 0;
+        }
+    }
+    if (last < 0) return 0;
+    snprintf(r->name, sizeof(r->name), "%s", k[last].text);
+    return 1;
+}
+
+typedef struct {
+    int is_if;
+    ref_t conds[MAX_CONDS];
+    int cond_count;
+} block_t;
+
+static int load_file(const char *path, char **out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc((size_t)size + 1);
+    if (fread(buf, 1, (size_t)size, f) != (size_t)size) { fclose(f); free(buf); return -1; }
+    buf[size] = '\0';
+    fclose(f);
+    *out = buf;
+    return 0;
+}
+
+static int analyze_file(const char *path);
+
+// dofile(MYDIR .. "game.singe"): the last string, next to the including script
+static void follow_dofile(const char *from, const char *name) {
+    char path[512];
+    const char *slash = strrchr(from, '/');
+    const char *base = strrchr(name, '/');
+    int dir = slash ? (int)(slash - from + 1) : 0;
+    snprintf(path, sizeof(path), "%.*s%s", dir, from, base ? base + 1 : name);
+    for (int i = 0; i < g_file_count; i++)
+        if (!strcmp(g_files[i], path)) return;
+    if (analyze_file(path) < 0)
+        fprintf(stderr, "  %s: dofile(\"%s\") not found next to it, skipped\n", from, name);
+}
+
+static int analyze_file(const char *path) {
+    if (g_file_count == MAX_FILES) return -1;
+    char *src;
+    if (load_file(path, &src) < 0) return -1;
+    int file = g_file_count;
+    g_files[g_file_count++] = strdup(path);
+
+    tokens_t t = {0};
+    lex(src, &t);
+    free(src);
+
+    block_t stack[MAX_DEPTH];
+    int depth = 0, swallow_do = 0, in_cond = 0;
+    const token_t *k = t.v;
+    int n = t.count;
+
+    for (int i = 0; i + 2 < n; i++) {
+        if (k[i].type == T_NAME && is_op(&k[i + 1], "=") && is_name(&k[i + 2], "discGetFrame") &&
+            !is_frame_value(k, i) && g_frame_var_count < 16)
+            snprintf(g_frame_vars[g_frame_var_count++], MAX_NAME, "%s", k[i].text);
+    }
+
+    for (int i = 0; i < n; i++) {
+        // --- Blocks, so a jump knows which frame tests guard it ---
+        if (k[i].type == T_NAME) {
+            if (is_name(&k[i], "if") || is_name(&k[i], "elseif")) {
+                if (is_name(&k[i], "if") && depth < MAX_DEPTH) {
+                    memset(&stack[depth], 0, sizeof(block_t));
+                    stack[depth++].is_if = 1;
+                }
+                if (depth) stack[depth - 1].cond_count = 0;
+                in_cond = 1;
+                continue;
+            }
+            if (is_name(&k[i], "then")) { in_cond = 0; continue; }
+            if (is_name(&k[i], "else")) { if (depth) stack[depth - 1].cond_count = 0; continue; }
+            if (is_name(&k[i], "for") || is_name(&k[i], "while")) swallow_do = 1;
+            if (is_name(&k[i], "for") || is_name(&k[i], "while") || is_name(&k[i], "function") ||
+                is_name(&k[i], "repeat") || (is_name(&k[i], "do") && !swallow_do)) {
+                if (depth < MAX_DEPTH) memset(&stack[depth++], 0, sizeof(block_t));
+                continue;
+            }
+            if (is_name(&k[i], "do")) { swallow_do = 0; continue; }
+            if (is_name(&k[i], "end") || is_name(&k[i], "until")) {
+                if (depth) depth--;
+                continue;
+            }
+        }
+
+        if (in_cond && depth) {
+            ref_t r;
+            if (frame_test_at(k, i, n, &r)) {
+                block_t *b = &stack[depth - 1];
+                if (b->cond_count < MAX_CONDS) b->conds[b->cond_count++] = r;
+            }
+            continue;
+        }
+
+        // --- Constants: NAME = N, NAME = { N, N, ... } ---
+        if (k[i].type == T_NAME && i + 2 < n && is_op(&k[i + 1], "=")) {
+            if (k[i + 2].type == T_NUM) {
+                add_const(k[i].text, k[i + 2].num);
+            } else if (is_op(&k[i + 2], "{")) {
+                int nest = 0;
+                for (int j = i + 2; j < n; j++) {
+                    if (is_op(&k[j], "{")) nest++;
+                    else if (is_op(&k[j], "}") && --nest == 0) break;
+                    else if (nest == 1 && k[j].type == T_NUM && !is_op(&k[j - 1], "=") &&
+                             !is_op(&k[j - 1], "-") && (is_op(&k[j + 1], ",") || is_op(&k[j + 1], "}")))
+                        add_const(k[i].text, k[j].num);
+                }
+            }
+            continue;
+        }
+
+        // --- Jumps and includes ---
+        if (is_jump_fn(&k[i]) && i + 1 < n && is_op(&k[i + 1], "(")) {
+            call_t c;
+            memset(&c, 0, sizeof(c));
+            if (!jump_target(k, i + 2, n, &c.target)) {
+                g_unresolved++;
+                fprintf(stderr, "  %s:%d: %s target is an expression, skipped\n", path, k[i].line, k[i].text);
+                continue;
+            }
+            for (int d = depth - 1; d >= 0; d--) {
+                if (stack[d].is_if && stack[d].cond_count) {
+                    memcpy(c.from, stack[d].conds, sizeof(ref_t) * stack[d].cond_count);
+                    c.from_count = stack[d].cond_count;
+                    break;
+                }
+            }
+            c.line = k[i].line;
+            c.file = file;
+            if (g_call_count == g_call_cap) {
+                g_call_cap = g_call_cap ? g_call_cap * 2 : 256;
+                g_calls = realloc(g_calls, sizeof(call_t) * g_call_cap);
+            }
+            g_calls[g_call_count++] = c;
+            continue;
+        }
+        if (is_name(&k[i], "dofile") && i + 1 < n && is_op(&k[i + 1], "(")) {
+            const char *name = NULL;
+            for (int j = i + 2; j < n && !is_op(&k[j], ")"); j++)
+                if (k[j].type == T_STR) name = k[j].text;
+            if (name) follow_dofile(path, name);
+        }
+    }
+    free(t.v);
+    return 0;
+}
+
+// --- Graph ---
+
+typedef struct { long start, end; int reachable; } segment_t;
+typedef struct { long from, to; int count, reachable; } edge_t;
+
+static int cmp_long(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_edge(const void *a, const void *b) {
+    const edge_t *x = a, *y = b;
+    if (x->from != y->from) return x->from < y->from ? -1 : 1;
+    return x->to < y->to ? -1 : x->to > y->to;
+}
+
+static void usage(void) {
+    printf("usage: singe-hints [--movie movie.dcmv] [-o movie.hints] game.singe [more.singe ...]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = NULL, *movie = NULL;
+    const char *scripts[MAX_FILES];
+    int script_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) out_path = argv[++i];
+        else if (!strcmp(argv[i], "--movie") && i + 1 < argc) movie = argv[++i];
+        else if (argv[i][0] == '-') { usage(); return 1; }
+        else if (script_count < MAX_FILES) scripts[script_count++] = argv[i];
+    }
+    if (!script_count) { usage(); return 1; }
+
+    for (int i = 0; i < script_count; i++) {
+        if (analyze_file(scripts[i]) < 0) {
+            printf("Cannot read %s\n", scripts[i]);
+            return 1;
+        }
+    }
+
+    long total_frames = -1;
+    if (movie) {
+        dcmv_t *d = dcmv_open(movie, DCMV_BACKEND_FILE);
+        if (!d) return 1;
+        total_frames = dcmv_header(d)->num_total_frames;
+        dcmv_close(d);
+    }
+
+    // Edges: every (test, target) pair of every call
+    edge_t *edges = NULL;
+    int edge_count = 0, edge_cap = 0, out_of_range = 0;
+    for (int c = 0; c < g_call_count; c++) {
+        const call_t *call = &g_calls[c];
+        long one_to, one_from;
+        int nto;
+        const long *to = resolve(&call->target, &one_to, &nto);
+        if (!nto) {
+            g_unresolved++;
+            fprintf(stderr, "  %s:%d: %s is never assigned a constant, skipped\n",
+                   g_files[call->file], call->line, call->target.name);
+        }
+        for (int a = 0; a < (call->from_count ? call->from_count : 1); a++) {
+            int nfrom = 1;
+            const long *from = &one_from;
+            one_from = -1;
+            if (call->from_count) from = resolve(&call->from[a], &one_from, &nfrom);
+            for (int f = 0; f < nfrom; f++) {
+                for (int t = 0; t < nto; t++) {
+                    if (to[t] < 0 || (total_frames >= 0 && to[t] >= total_frames)) { out_of_range++; continue; }
+                    int e = 0;
+                    while (e < edge_count && !(edges[e].from == from[f] && edges[e].to == to[t])) e++;
+                    if (e == edge_count) {
+                        if (edge_count == edge_cap) {
+                            edge_cap = edge_cap ? edge_cap * 2 : 256;
+                            edges = realloc(edges, sizeof(edge_t) * edge_cap);
+                        }
+                        edges[edge_count++] = (edge_t){ from[f], to[t], 0, 0 };
+                    }
+                    edges[e].count++;
+                }
+            }
+        }
+    }
+    qsort(edges, (size_t)edge_count, sizeof(edge_t), cmp_edge);
+
+    // Segment ends: frames some jump is tested for, and names like iFrameEnd
+    long *ends = malloc(sizeof(long) * (edge_count + 1));
+    int end_count = 0;
+    for (int e = 0; e < edge_count; e++)
+        if (edges[e].from >= 0) ends[end_count++] = edges[e].from;
+    for (int i = 0; i < g_const_count; i++) {
+        const constant_t *c = &g_consts[i];
+        if (!contains_ci(c->name, "frame") || !contains_ci(c->name, "end")) continue;
+        ends = realloc(ends, sizeof(long) * (end_count + c->count));
+        for (int j = 0; j < c->count; j++) ends[end_count++] = c->v[j];
+    }
+    qsort(ends, (size_t)end_count, sizeof(long), cmp_long);
+
+    // Segments: frame 0 (where the script starts playing) and every target,
+    // each running to the first end at or after it
+    segment_t *segs = malloc(sizeof(segment_t) * (edge_count + 1));
+    int seg_count = 0;
+    for (int e = -1; e < edge_count; e++) {
+        long start = e < 0 ? 0 : edges[e].to;
+        int s = 0;
+        while (s < seg_count && segs[s].start != start) s++;
+        if (s < seg_count) continue;
+        long end = -1;
+        for (int i = 0; i < end_count; i++)
+            if (ends[i] >= start) { end = ends[i]; break; }
+        segs[seg_count++] = (segment_t){ start, end, e < 0 };
+    }
+
+    // Reachable: untied jumps, and jumps tested for inside a reachable segment
+    for (int changed = 1; changed; ) {
+        changed = 0;
+        for (int e = 0; e < edge_count; e++) {
+            if (edges[e].reachable) continue;
+            int ok = edges[e].from < 0;
+            for (int s = 0; s < seg_count && !ok; s++)
+                ok = segs[s].reachable && edges[e].from >= segs[s].start &&
+                     (segs[s].end < 0 || edges[e].from <= segs[s].end);
+            if (!ok) continue;
+            edges[e].reachable = 1;
+            for (int s = 0; s < seg_count; s++)
+                if (segs[s].start == edges[e].to && !segs[s].reachable) segs[s].reachable = changed = 1;
+            changed = 1;
+        }
+    }
+
+    FILE *out = stdout;
+    if (out_path && !(out = fopen(out_path, "w"))) {
+        printf("Cannot create %s\n", out_path);
+        return 1;
+    }
+    fprintf(out, "# singe-hints 1: %s\n", scripts[0]);
+    int seg_kept = 0, edge_kept = 0;
+    for (int s = 0; s < seg_count; s++) {
+        for (int m = s + 1; m < seg_count; m++) {
+            if (segs[m].start < segs[s].start) { segment_t t = segs[s]; segs[s] = segs[m]; segs[m] = t; }
+        }
+        if (!segs[s].reachable) continue;
+        fprintf(out, "segment %ld %ld\n", segs[s].start, segs[s].end);
+        seg_kept++;
+    }
+    for (int e = 0; e < edge_count; e++) {
+        if (!edges[e].reachable) continue;
+        fprintf(out, "jump %ld %ld %d\n", edges[e].from, edges[e].to, edges[e].count);
+        edge_kept++;
+    }
+    if (out != stdout) fclose(out);
+
+    fprintf(stderr, "%d script(s): %d jump calls (%d unresolved), %d segments (%d reachable), "
+           "%d jumps (%d reachable)", g_file_count, g_call_count, g_unresolved, seg_count, seg_kept,
+           edge_count, edge_kept);
+    if (out_of_range) fprintf(stderr, ", %d targets outside the movie", out_of_range);
+    fprintf(stderr, "\n");
+    return 0;
+}